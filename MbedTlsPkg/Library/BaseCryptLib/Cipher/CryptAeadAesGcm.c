@@ -12,6 +12,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "InternalCryptLib.h"
 #include <mbedtls/gcm.h>
 
+///
+/// Streaming AES-GCM context returned by AeadAesGcmNew().
+///
+typedef struct {
+  mbedtls_gcm_context    Gcm;
+  BOOLEAN                Encrypt;
+} MBEDTLS_AES_GCM_CONTEXT;
+
 /**
   Performs AEAD AES-GCM authenticated encryption on a data buffer and additional authenticated data (AAD).
 
@@ -225,3 +233,281 @@ AeadAesGcmDecrypt (
 
   return TRUE;
 }
+
+/**
+  Allocates and initializes one AES-GCM context for streaming authenticated
+  encryption and decryption.
+
+  The AES key schedule and the GHASH tables are computed once here and reused
+  by every message started with AeadAesGcmInit(), so a caller protecting many
+  records under the same key pays the key setup only once. Use
+  AeadAesGcmFree() to release the context.
+
+  KeySize must be 16, 24 or 32, otherwise NULL is returned.
+
+  @param[in]  Key      Pointer to the encryption key.
+  @param[in]  KeySize  Size of the encryption key in bytes.
+
+  @return  Pointer to the AES-GCM context that has been initialized.
+           If the allocation fails, AeadAesGcmNew() returns NULL.
+
+**/
+VOID *
+EFIAPI
+AeadAesGcmNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  MBEDTLS_AES_GCM_CONTEXT  *Ctx;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  switch (KeySize) {
+    case 16:
+    case 24:
+    case 32:
+      break;
+    default:
+      return NULL;
+  }
+
+  Ctx = AllocateZeroPool (sizeof (MBEDTLS_AES_GCM_CONTEXT));
+  if (Ctx == NULL) {
+    return NULL;
+  }
+
+  mbedtls_gcm_init (&Ctx->Gcm);
+  if (mbedtls_gcm_setkey (&Ctx->Gcm, MBEDTLS_CIPHER_ID_AES, Key, (UINT32)(KeySize * 8)) != 0) {
+    AeadAesGcmFree (Ctx);
+    return NULL;
+  }
+
+  return (VOID *)Ctx;
+}
+
+/**
+  Release the specified AES-GCM context.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context to be released.
+
+**/
+VOID
+EFIAPI
+AeadAesGcmFree (
+  IN  VOID  *AesGcmContext
+  )
+{
+  if (AesGcmContext == NULL) {
+    return;
+  }
+
+  mbedtls_gcm_free (&((MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext)->Gcm);
+  FreePool (AesGcmContext);
+}
+
+/**
+  Starts a new AES-GCM message on a context returned by AeadAesGcmNew().
+
+  Any message in progress on the context is abandoned. The key set by
+  AeadAesGcmNew() is kept. The message is then processed with
+  AeadAesGcmUpdateAad(), AeadAesGcmUpdate() and AeadAesGcmEncryptFinal() or
+  AeadAesGcmDecryptFinal().
+
+  IvSize must be 12, otherwise FALSE is returned.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  Iv             Pointer to the IV value.
+  @param[in]  IvSize         Size of the IV value in bytes.
+  @param[in]  Encrypt        TRUE to encrypt the message, FALSE to decrypt it.
+
+  @retval TRUE   The message was started.
+  @retval FALSE  The message could not be started.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmInit (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize,
+  IN  BOOLEAN      Encrypt
+  )
+{
+  MBEDTLS_AES_GCM_CONTEXT  *Ctx;
+
+  if ((AesGcmContext == NULL) || (Iv == NULL) || (IvSize != 12)) {
+    return FALSE;
+  }
+
+  Ctx          = (MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext;
+  Ctx->Encrypt = Encrypt;
+
+  return (BOOLEAN)(mbedtls_gcm_starts (&Ctx->Gcm, Encrypt ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT, Iv, IvSize) == 0);
+}
+
+/**
+  Feeds additional authenticated data (AAD) to the current AES-GCM message.
+
+  This function may be called several times to pass successive parts of the
+  AAD, but all of it must be passed before the first call to
+  AeadAesGcmUpdate().
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  AData          Pointer to the additional authenticated data (AAD).
+  @param[in]  ADataSize      Size of the additional authenticated data (AAD) in bytes.
+
+  @retval TRUE   The AAD was processed.
+  @retval FALSE  The AAD could not be processed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdateAad (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *AData,
+  IN  UINTN        ADataSize
+  )
+{
+  if ((AesGcmContext == NULL) || ((AData == NULL) && (ADataSize != 0))) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(mbedtls_gcm_update_ad (&((MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext)->Gcm, AData, ADataSize) == 0);
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-GCM message.
+
+  The data may be passed in parts of any size; DataOut receives exactly
+  DataInSize bytes.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]   DataIn         Pointer to the input data buffer.
+  @param[in]   DataInSize     Size of the input data buffer in bytes.
+  @param[out]  DataOut        Pointer to a buffer of DataInSize bytes that
+                              receives the output.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The data could not be processed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdate (
+  IN   VOID         *AesGcmContext,
+  IN   CONST UINT8  *DataIn,
+  IN   UINTN        DataInSize,
+  OUT  UINT8        *DataOut
+  )
+{
+  UINTN  OutSize;
+
+  if ((AesGcmContext == NULL) || (((DataIn == NULL) || (DataOut == NULL)) && (DataInSize != 0))) {
+    return FALSE;
+  }
+
+  if (mbedtls_gcm_update (&((MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext)->Gcm, DataIn, DataInSize, DataOut, DataInSize, &OutSize) != 0) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(OutSize == DataInSize);
+}
+
+/**
+  Completes the current AES-GCM encryption and retrieves the authentication tag.
+
+  TagSize must be 12, 13, 14, 15, 16, otherwise FALSE is returned.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context started for encryption.
+  @param[out]  TagOut         Pointer to a buffer that receives the authentication tag output.
+  @param[in]   TagSize        Size of the authentication tag in bytes.
+
+  @retval TRUE   AEAD AES-GCM authenticated encryption succeeded.
+  @retval FALSE  AEAD AES-GCM authenticated encryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmEncryptFinal (
+  IN   VOID   *AesGcmContext,
+  OUT  UINT8  *TagOut,
+  IN   UINTN  TagSize
+  )
+{
+  MBEDTLS_AES_GCM_CONTEXT  *Ctx;
+  UINTN                    OutSize;
+
+  if ((AesGcmContext == NULL) || (TagOut == NULL) ||
+      ((TagSize != 12) && (TagSize != 13) && (TagSize != 14) && (TagSize != 15) && (TagSize != 16)))
+  {
+    return FALSE;
+  }
+
+  Ctx = (MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext;
+  if (!Ctx->Encrypt) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(mbedtls_gcm_finish (&Ctx->Gcm, NULL, 0, &OutSize, TagOut, TagSize) == 0);
+}
+
+/**
+  Completes the current AES-GCM decryption and verifies the authentication tag.
+
+  The plaintext returned by AeadAesGcmUpdate() must not be trusted unless this
+  function returns TRUE.
+
+  TagSize must be 12, 13, 14, 15, 16, otherwise FALSE is returned.
+  If additional authenticated data verification fails, FALSE is returned.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context started for decryption.
+  @param[in]  Tag            Pointer to a buffer that contains the authentication tag.
+  @param[in]  TagSize        Size of the authentication tag in bytes.
+
+  @retval TRUE   AEAD AES-GCM authenticated decryption succeeded.
+  @retval FALSE  AEAD AES-GCM authenticated decryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmDecryptFinal (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Tag,
+  IN  UINTN        TagSize
+  )
+{
+  MBEDTLS_AES_GCM_CONTEXT  *Ctx;
+  UINT8                    ExpectedTag[16];
+  UINTN                    OutSize;
+  UINTN                    Index;
+  UINT8                    Diff;
+
+  if ((AesGcmContext == NULL) || (Tag == NULL) ||
+      ((TagSize != 12) && (TagSize != 13) && (TagSize != 14) && (TagSize != 15) && (TagSize != 16)))
+  {
+    return FALSE;
+  }
+
+  Ctx = (MBEDTLS_AES_GCM_CONTEXT *)AesGcmContext;
+  if (Ctx->Encrypt) {
+    return FALSE;
+  }
+
+  if (mbedtls_gcm_finish (&Ctx->Gcm, NULL, 0, &OutSize, ExpectedTag, TagSize) != 0) {
+    return FALSE;
+  }
+
+  //
+  // Compare the tags in constant time.
+  //
+  Diff = 0;
+  for (Index = 0; Index < TagSize; Index++) {
+    Diff |= ExpectedTag[Index] ^ Tag[Index];
+  }
+
+  ZeroMem (ExpectedTag, sizeof (ExpectedTag));
+  return (BOOLEAN)(Diff == 0);
+}
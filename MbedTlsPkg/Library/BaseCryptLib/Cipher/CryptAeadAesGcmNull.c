@@ -98,3 +98,168 @@ AeadAesGcmDecrypt (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Allocates and initializes one AES-GCM context for streaming authenticated
+  encryption and decryption.
+
+  Return NULL to indicate this interface is not supported.
+
+  @param[in]  Key      Pointer to the encryption key.
+  @param[in]  KeySize  Size of the encryption key in bytes.
+
+  @retval NULL  This interface is not supported.
+
+**/
+VOID *
+EFIAPI
+AeadAesGcmNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Release the specified AES-GCM context.
+
+  This function will do nothing.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context to be released.
+
+**/
+VOID
+EFIAPI
+AeadAesGcmFree (
+  IN  VOID  *AesGcmContext
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Starts a new AES-GCM message on a context returned by AeadAesGcmNew().
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  Iv             Pointer to the IV value.
+  @param[in]  IvSize         Size of the IV value in bytes.
+  @param[in]  Encrypt        TRUE to encrypt the message, FALSE to decrypt it.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmInit (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize,
+  IN  BOOLEAN      Encrypt
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Feeds additional authenticated data (AAD) to the current AES-GCM message.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  AData          Pointer to the additional authenticated data (AAD).
+  @param[in]  ADataSize      Size of the additional authenticated data (AAD) in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdateAad (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *AData,
+  IN  UINTN        ADataSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-GCM message.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]   DataIn         Pointer to the input data buffer.
+  @param[in]   DataInSize     Size of the input data buffer in bytes.
+  @param[out]  DataOut        Pointer to a buffer of DataInSize bytes that
+                              receives the output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdate (
+  IN   VOID         *AesGcmContext,
+  IN   CONST UINT8  *DataIn,
+  IN   UINTN        DataInSize,
+  OUT  UINT8        *DataOut
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Completes the current AES-GCM encryption and retrieves the authentication tag.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context started for encryption.
+  @param[out]  TagOut         Pointer to a buffer that receives the authentication tag output.
+  @param[in]   TagSize        Size of the authentication tag in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmEncryptFinal (
+  IN   VOID   *AesGcmContext,
+  OUT  UINT8  *TagOut,
+  IN   UINTN  TagSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Completes the current AES-GCM decryption and verifies the authentication tag.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context started for decryption.
+  @param[in]  Tag            Pointer to a buffer that contains the authentication tag.
+  @param[in]  TagSize        Size of the authentication tag in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmDecryptFinal (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Tag,
+  IN  UINTN        TagSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
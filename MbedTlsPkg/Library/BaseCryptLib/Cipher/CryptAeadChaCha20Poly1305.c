@@ -0,0 +1,204 @@
+/** @file
+  AEAD (ChaCha20-Poly1305) Wrapper Implementation over MbedTLS.
+
+  RFC 8439 - ChaCha20 and Poly1305 for IETF Protocols
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalCryptLib.h"
+#include <mbedtls/chachapoly.h>
+
+/**
+  Performs AEAD ChaCha20-Poly1305 authenticated encryption on a data buffer and additional authenticated data (AAD).
+
+  ChaCha20-Poly1305 runs in constant time without hardware support, so it is
+  the preferred AEAD on platforms that lack AES instructions.
+
+  KeySize must be 32, otherwise FALSE is returned.
+  IvSize must be 12, otherwise FALSE is returned.
+  TagSize must be 16, otherwise FALSE is returned.
+
+  @param[in]   Key         Pointer to the encryption key.
+  @param[in]   KeySize     Size of the encryption key in bytes.
+  @param[in]   Iv          Pointer to the IV (nonce) value.
+  @param[in]   IvSize      Size of the IV value in bytes.
+  @param[in]   AData       Pointer to the additional authenticated data (AAD).
+  @param[in]   ADataSize   Size of the additional authenticated data (AAD) in bytes.
+  @param[in]   DataIn      Pointer to the input data buffer to be encrypted.
+  @param[in]   DataInSize  Size of the input data buffer in bytes.
+  @param[out]  TagOut      Pointer to a buffer that receives the authentication tag output.
+  @param[in]   TagSize     Size of the authentication tag in bytes.
+  @param[out]  DataOut     Pointer to a buffer that receives the encryption output.
+  @param[out]  DataOutSize Size of the output data buffer in bytes.
+
+  @retval TRUE   AEAD ChaCha20-Poly1305 authenticated encryption succeeded.
+  @retval FALSE  AEAD ChaCha20-Poly1305 authenticated encryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadChaCha20Poly1305Encrypt (
+  IN   CONST UINT8  *Key,
+  IN   UINTN        KeySize,
+  IN   CONST UINT8  *Iv,
+  IN   UINTN        IvSize,
+  IN   CONST UINT8  *AData,
+  IN   UINTN        ADataSize,
+  IN   CONST UINT8  *DataIn,
+  IN   UINTN        DataInSize,
+  OUT  UINT8        *TagOut,
+  IN   UINTN        TagSize,
+  OUT  UINT8        *DataOut,
+  OUT  UINTN        *DataOutSize
+  )
+{
+  mbedtls_chachapoly_context  Ctx;
+  INT32                       Ret;
+
+  if (DataInSize > INT_MAX) {
+    return FALSE;
+  }
+
+  if (ADataSize > INT_MAX) {
+    return FALSE;
+  }
+
+  if ((Key == NULL) || (KeySize != 32) || (Iv == NULL) || (IvSize != 12)) {
+    return FALSE;
+  }
+
+  if ((TagOut == NULL) || (TagSize != 16)) {
+    return FALSE;
+  }
+
+  if (DataOutSize != NULL) {
+    if ((*DataOutSize > INT_MAX) || (*DataOutSize < DataInSize)) {
+      return FALSE;
+    }
+  }
+
+  mbedtls_chachapoly_init (&Ctx);
+
+  Ret = mbedtls_chachapoly_setkey (&Ctx, Key);
+  if (Ret == 0) {
+    Ret = mbedtls_chachapoly_encrypt_and_tag (
+            &Ctx,
+            DataInSize,
+            Iv,
+            AData,
+            ADataSize,
+            DataIn,
+            DataOut,
+            TagOut
+            );
+  }
+
+  mbedtls_chachapoly_free (&Ctx);
+  if (Ret != 0) {
+    return FALSE;
+  }
+
+  if (DataOutSize != NULL) {
+    *DataOutSize = DataInSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Performs AEAD ChaCha20-Poly1305 authenticated decryption on a data buffer and additional authenticated data (AAD).
+
+  KeySize must be 32, otherwise FALSE is returned.
+  IvSize must be 12, otherwise FALSE is returned.
+  TagSize must be 16, otherwise FALSE is returned.
+  If additional authenticated data verification fails, FALSE is returned.
+
+  @param[in]   Key         Pointer to the encryption key.
+  @param[in]   KeySize     Size of the encryption key in bytes.
+  @param[in]   Iv          Pointer to the IV (nonce) value.
+  @param[in]   IvSize      Size of the IV value in bytes.
+  @param[in]   AData       Pointer to the additional authenticated data (AAD).
+  @param[in]   ADataSize   Size of the additional authenticated data (AAD) in bytes.
+  @param[in]   DataIn      Pointer to the input data buffer to be decrypted.
+  @param[in]   DataInSize  Size of the input data buffer in bytes.
+  @param[in]   Tag         Pointer to a buffer that contains the authentication tag.
+  @param[in]   TagSize     Size of the authentication tag in bytes.
+  @param[out]  DataOut     Pointer to a buffer that receives the decryption output.
+  @param[out]  DataOutSize Size of the output data buffer in bytes.
+
+  @retval TRUE   AEAD ChaCha20-Poly1305 authenticated decryption succeeded.
+  @retval FALSE  AEAD ChaCha20-Poly1305 authenticated decryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadChaCha20Poly1305Decrypt (
+  IN   CONST UINT8  *Key,
+  IN   UINTN        KeySize,
+  IN   CONST UINT8  *Iv,
+  IN   UINTN        IvSize,
+  IN   CONST UINT8  *AData,
+  IN   UINTN        ADataSize,
+  IN   CONST UINT8  *DataIn,
+  IN   UINTN        DataInSize,
+  IN   CONST UINT8  *Tag,
+  IN   UINTN        TagSize,
+  OUT  UINT8        *DataOut,
+  OUT  UINTN        *DataOutSize
+  )
+{
+  mbedtls_chachapoly_context  Ctx;
+  INT32                       Ret;
+
+  if (DataInSize > INT_MAX) {
+    return FALSE;
+  }
+
+  if (ADataSize > INT_MAX) {
+    return FALSE;
+  }
+
+  if ((Key == NULL) || (KeySize != 32) || (Iv == NULL) || (IvSize != 12)) {
+    return FALSE;
+  }
+
+  if ((Tag == NULL) || (TagSize != 16)) {
+    return FALSE;
+  }
+
+  if (DataOutSize != NULL) {
+    if ((*DataOutSize > INT_MAX) || (*DataOutSize < DataInSize)) {
+      return FALSE;
+    }
+  }
+
+  mbedtls_chachapoly_init (&Ctx);
+
+  Ret = mbedtls_chachapoly_setkey (&Ctx, Key);
+  if (Ret == 0) {
+    Ret = mbedtls_chachapoly_auth_decrypt (
+            &Ctx,
+            DataInSize,
+            Iv,
+            AData,
+            ADataSize,
+            Tag,
+            DataIn,
+            DataOut
+            );
+  }
+
+  mbedtls_chachapoly_free (&Ctx);
+  if (Ret != 0) {
+    return FALSE;
+  }
+
+  if (DataOutSize != NULL) {
+    *DataOutSize = DataInSize;
+  }
+
+  return TRUE;
+}
@@ -9,6 +9,25 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "InternalCryptLib.h"
 #include <mbedtls/aes.h>
 
+///
+/// AES-CTR context returned by AesCtrNew(). The counter, the current key
+/// stream block and the offset into it carry the stream across calls.
+///
+typedef struct {
+  mbedtls_aes_context    Aes;
+  UINT8                  Counter[AES_BLOCK_SIZE];
+  UINT8                  StreamBlock[AES_BLOCK_SIZE];
+  size_t                 Offset;
+} MBEDTLS_AES_CTR_CONTEXT;
+
+///
+/// AES-XTS context returned by AesXtsNew(), keyed once for each direction.
+///
+typedef struct {
+  mbedtls_aes_xts_context    Encrypt;
+  mbedtls_aes_xts_context    Decrypt;
+} MBEDTLS_AES_XTS_CONTEXT;
+
 /**
   Retrieves the size, in bytes, of the context buffer required for AES operations.
 
@@ -223,3 +242,449 @@ AesCbcDecrypt (
     return TRUE;
   }
 }
+
+/**
+  Allocates and initializes one AES-CTR context for subsequent use.
+
+  The key schedule is expanded once here and reused by every stream started
+  with AesCtrInit(). Use AesCtrFree() to release the context.
+
+  KeySize must be 16, 24 or 32, otherwise NULL is returned.
+
+  @param[in]  Key      Pointer to the user-supplied AES key.
+  @param[in]  KeySize  Size of the AES key in bytes.
+
+  @return  Pointer to the AES-CTR context that has been initialized.
+           If the allocation fails, AesCtrNew() returns NULL.
+
+**/
+
+VOID *
+EFIAPI
+AesCtrNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  MBEDTLS_AES_CTR_CONTEXT  *Ctx;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  switch (KeySize) {
+    case 16:
+    case 24:
+    case 32:
+      break;
+    default:
+      return NULL;
+  }
+
+  Ctx = AllocateZeroPool (sizeof (MBEDTLS_AES_CTR_CONTEXT));
+  if (Ctx == NULL) {
+    return NULL;
+  }
+
+  mbedtls_aes_init (&Ctx->Aes);
+  if (mbedtls_aes_setkey_enc (&Ctx->Aes, Key, (UINT32)(KeySize * 8)) != 0) {
+    AesCtrFree (Ctx);
+    return NULL;
+  }
+
+  return (VOID *)Ctx;
+}
+
+/**
+  Release the specified AES-CTR context.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context to be released.
+
+**/
+
+VOID
+EFIAPI
+AesCtrFree (
+  IN  VOID  *AesCtrContext
+  )
+{
+  MBEDTLS_AES_CTR_CONTEXT  *Ctx;
+
+  if (AesCtrContext == NULL) {
+    return;
+  }
+
+  Ctx = (MBEDTLS_AES_CTR_CONTEXT *)AesCtrContext;
+  mbedtls_aes_free (&Ctx->Aes);
+  ZeroMem (Ctx, sizeof (MBEDTLS_AES_CTR_CONTEXT));
+  FreePool (Ctx);
+}
+
+/**
+  Starts a new AES-CTR key stream on a context returned by AesCtrNew().
+
+  Iv is the initial 16-byte counter block. It is incremented as a 128-bit
+  big-endian integer for every block of key stream.
+
+  IvSize must be 16, otherwise FALSE is returned.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]  Iv             Pointer to the initial counter block.
+  @param[in]  IvSize         Size of the initial counter block in bytes.
+
+  @retval TRUE   The key stream was started.
+  @retval FALSE  The key stream could not be started.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesCtrInit (
+  IN  VOID         *AesCtrContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize
+  )
+{
+  MBEDTLS_AES_CTR_CONTEXT  *Ctx;
+
+  if ((AesCtrContext == NULL) || (Iv == NULL) || (IvSize != AES_BLOCK_SIZE)) {
+    return FALSE;
+  }
+
+  Ctx = (MBEDTLS_AES_CTR_CONTEXT *)AesCtrContext;
+  CopyMem (Ctx->Counter, Iv, AES_BLOCK_SIZE);
+  ZeroMem (Ctx->StreamBlock, AES_BLOCK_SIZE);
+  Ctx->Offset = 0;
+
+  return TRUE;
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-CTR stream.
+
+  The data may be passed in parts of any size; the key stream continues from
+  where the previous call stopped. Encryption and decryption are the same
+  operation.
+
+  @param[in]   AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]   Input          Pointer to the input data buffer.
+  @param[in]   InputSize      Size of the input data buffer in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the output.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The data could not be processed.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesCtrUpdate (
+  IN   VOID         *AesCtrContext,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  MBEDTLS_AES_CTR_CONTEXT  *Ctx;
+
+  if ((AesCtrContext == NULL) || (((Input == NULL) || (Output == NULL)) && (InputSize != 0))) {
+    return FALSE;
+  }
+
+  if (InputSize == 0) {
+    return TRUE;
+  }
+
+  //
+  // The counter, the unused part of the last key stream block and its offset
+  // carry the stream across calls.
+  //
+  Ctx = (MBEDTLS_AES_CTR_CONTEXT *)AesCtrContext;
+  return (BOOLEAN)(mbedtls_aes_crypt_ctr (&Ctx->Aes, InputSize, &Ctx->Offset, Ctx->Counter, Ctx->StreamBlock, Input, Output) == 0);
+}
+
+/**
+  Allocates and initializes one AES-XTS context for subsequent use.
+
+  Key holds the data key followed by the tweak key, as defined by IEEE Std
+  1619. Both key schedules are expanded once here for encryption and for
+  decryption. Use AesXtsFree() to release the context.
+
+  KeySize must be 32 (AES-128-XTS) or 64 (AES-256-XTS), otherwise NULL is
+  returned. If the data key and the tweak key are equal, NULL is returned.
+
+  @param[in]  Key      Pointer to the concatenated data and tweak keys.
+  @param[in]  KeySize  Size of Key in bytes.
+
+  @return  Pointer to the AES-XTS context that has been initialized.
+           If the allocation fails, AesXtsNew() returns NULL.
+
+**/
+
+VOID *
+EFIAPI
+AesXtsNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  MBEDTLS_AES_XTS_CONTEXT  *Ctx;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  if ((KeySize != 32) && (KeySize != 64)) {
+    return NULL;
+  }
+
+  if (CompareMem (Key, Key + KeySize / 2, KeySize / 2) == 0) {
+    return NULL;
+  }
+
+  Ctx = AllocateZeroPool (sizeof (MBEDTLS_AES_XTS_CONTEXT));
+  if (Ctx == NULL) {
+    return NULL;
+  }
+
+  mbedtls_aes_xts_init (&Ctx->Encrypt);
+  mbedtls_aes_xts_init (&Ctx->Decrypt);
+  if ((mbedtls_aes_xts_setkey_enc (&Ctx->Encrypt, Key, (UINT32)(KeySize * 8)) != 0) ||
+      (mbedtls_aes_xts_setkey_dec (&Ctx->Decrypt, Key, (UINT32)(KeySize * 8)) != 0))
+  {
+    AesXtsFree (Ctx);
+    return NULL;
+  }
+
+  return (VOID *)Ctx;
+}
+
+/**
+  Release the specified AES-XTS context.
+
+  @param[in]  AesXtsContext  Pointer to the AES-XTS context to be released.
+
+**/
+
+VOID
+EFIAPI
+AesXtsFree (
+  IN  VOID  *AesXtsContext
+  )
+{
+  MBEDTLS_AES_XTS_CONTEXT  *Ctx;
+
+  if (AesXtsContext == NULL) {
+    return;
+  }
+
+  Ctx = (MBEDTLS_AES_XTS_CONTEXT *)AesXtsContext;
+  mbedtls_aes_xts_free (&Ctx->Encrypt);
+  mbedtls_aes_xts_free (&Ctx->Decrypt);
+  FreePool (Ctx);
+}
+
+/**
+  Encrypts or decrypts consecutive AES-XTS sectors.
+
+  @param[in]   Ctx          AES-XTS key context for the direction.
+  @param[in]   Mode         MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT.
+  @param[in]   StartSector  Number of the first sector.
+  @param[in]   SectorSize   Size of one sector in bytes.
+  @param[in]   Input        Pointer to the sectors.
+  @param[in]   InputSize    Size of Input in bytes, a multiple of SectorSize.
+  @param[out]  Output       Pointer to a buffer that receives the output.
+
+  @retval TRUE   The sectors were processed.
+  @retval FALSE  The sectors could not be processed.
+
+**/
+STATIC
+BOOLEAN
+AesXtsCryptSectors (
+  IN   mbedtls_aes_xts_context  *Ctx,
+  IN   INT32                    Mode,
+  IN   UINT64                   StartSector,
+  IN   UINTN                    SectorSize,
+  IN   CONST UINT8              *Input,
+  IN   UINTN                    InputSize,
+  OUT  UINT8                    *Output
+  )
+{
+  UINT8   Tweak[AES_BLOCK_SIZE];
+  UINT64  Sector;
+  UINTN   Index;
+
+  if ((SectorSize < AES_BLOCK_SIZE) || ((InputSize % SectorSize) != 0)) {
+    return FALSE;
+  }
+
+  for (Sector = StartSector; InputSize > 0; Sector++) {
+    //
+    // The tweak is the sector number as a 128-bit little-endian integer.
+    //
+    ZeroMem (Tweak, sizeof (Tweak));
+    for (Index = 0; Index < sizeof (UINT64); Index++) {
+      Tweak[Index] = (UINT8)RShiftU64 (Sector, Index * 8);
+    }
+
+    if (mbedtls_aes_crypt_xts (Ctx, Mode, SectorSize, Tweak, Input, Output) != 0) {
+      return FALSE;
+    }
+
+    Input     += SectorSize;
+    Output    += SectorSize;
+    InputSize -= SectorSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Performs AES-XTS encryption of one data unit.
+
+  The data unit may be any size from one block (16 bytes) up to 16 MiB; a
+  partial last block is handled by ciphertext stealing.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be encrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval TRUE   AES-XTS encryption succeeded.
+  @retval FALSE  AES-XTS encryption failed.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesXtsEncrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Tweak == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(mbedtls_aes_crypt_xts (&((MBEDTLS_AES_XTS_CONTEXT *)AesXtsContext)->Encrypt, MBEDTLS_AES_ENCRYPT, InputSize, Tweak, Input, Output) == 0);
+}
+
+/**
+  Performs AES-XTS decryption of one data unit.
+
+  The data unit may be any size from one block (16 bytes) up to 16 MiB; a
+  partial last block is handled by ciphertext stealing.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be decrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval TRUE   AES-XTS decryption succeeded.
+  @retval FALSE  AES-XTS decryption failed.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesXtsDecrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Tweak == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(mbedtls_aes_crypt_xts (&((MBEDTLS_AES_XTS_CONTEXT *)AesXtsContext)->Decrypt, MBEDTLS_AES_DECRYPT, InputSize, Tweak, Input, Output) == 0);
+}
+
+/**
+  Performs AES-XTS encryption of consecutive sectors.
+
+  Each sector is one data unit whose tweak is its sector number as a 128-bit
+  little-endian integer, as used by IEEE Std 1619 storage encryption.
+
+  If InputSize is not a multiple of SectorSize, then return FALSE.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be encrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval TRUE   AES-XTS encryption succeeded.
+  @retval FALSE  AES-XTS encryption failed.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesXtsEncryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptSectors (&((MBEDTLS_AES_XTS_CONTEXT *)AesXtsContext)->Encrypt, MBEDTLS_AES_ENCRYPT, StartSector, SectorSize, Input, InputSize, Output);
+}
+
+/**
+  Performs AES-XTS decryption of consecutive sectors.
+
+  Each sector is one data unit whose tweak is its sector number as a 128-bit
+  little-endian integer, as used by IEEE Std 1619 storage encryption.
+
+  If InputSize is not a multiple of SectorSize, then return FALSE.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be decrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval TRUE   AES-XTS decryption succeeded.
+  @retval FALSE  AES-XTS decryption failed.
+
+**/
+
+BOOLEAN
+EFIAPI
+AesXtsDecryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptSectors (&((MBEDTLS_AES_XTS_CONTEXT *)AesXtsContext)->Decrypt, MBEDTLS_AES_DECRYPT, StartSector, SectorSize, Input, InputSize, Output);
+}
@@ -0,0 +1,373 @@
+/** @file
+  Hash midstate export/import Wrapper Implementation over MbedTLS.
+
+  The exported state is a backend-independent serialization of a hash context
+  part way through a message: the chaining value, the number of bytes hashed
+  so far and the pending partial block. It can be stored or handed over to
+  another boot phase and imported into a fresh context, by either crypto
+  backend, to continue the same hash without reprocessing the prefix.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+//
+// The midstate lives in fields that MbedTLS marks private. This must be
+// defined before any MbedTLS header is included.
+//
+#define MBEDTLS_ALLOW_PRIVATE_ACCESS
+
+#include "InternalCryptLib.h"
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/sha512.h>
+
+#define HASH_EXPORTED_STATE_SIGNATURE  SIGNATURE_32 ('H', 'S', 'T', '1')
+
+///
+/// Exported hash state. All fields are little-endian except ChainingValue,
+/// which holds the state words in big-endian order as in the digest output.
+/// Only MessageLength modulo the block size bytes of Block are meaningful.
+///
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Algorithm;
+  UINT64    MessageLength;
+  UINT8     ChainingValue[SHA512_DIGEST_SIZE];
+  UINT8     Block[128];
+} HASH_EXPORTED_STATE;
+#pragma pack()
+
+///
+/// Backend-independent view of a hash context, used between the context and
+/// the exported state.
+///
+typedef struct {
+  UINT64    MessageLength;
+  UINT64    Words[8];
+  UINT8     *Block;
+  UINTN     WordCount;
+  UINTN     WordSize;
+  UINTN     BlockSize;
+} HASH_MIDSTATE;
+
+/**
+  Serializes the chaining value words of a midstate into big-endian bytes.
+
+  @param[in]   Midstate  Midstate holding the words.
+  @param[out]  Output    Buffer of Midstate->WordCount * Midstate->WordSize bytes.
+
+**/
+STATIC
+VOID
+HashMidstateStoreWords (
+  IN  CONST HASH_MIDSTATE  *Midstate,
+  OUT UINT8                *Output
+  )
+{
+  UINTN  Index;
+  UINTN  Byte;
+
+  for (Index = 0; Index < Midstate->WordCount; Index++) {
+    for (Byte = 0; Byte < Midstate->WordSize; Byte++) {
+      *Output++ = (UINT8)RShiftU64 (Midstate->Words[Index], (UINTN)(8 * (Midstate->WordSize - 1 - Byte)));
+    }
+  }
+}
+
+/**
+  Deserializes big-endian chaining value bytes into the words of a midstate.
+
+  @param[in, out]  Midstate  Midstate receiving the words.
+  @param[in]       Input     Buffer of Midstate->WordCount * Midstate->WordSize bytes.
+
+**/
+STATIC
+VOID
+HashMidstateLoadWords (
+  IN OUT HASH_MIDSTATE  *Midstate,
+  IN     CONST UINT8    *Input
+  )
+{
+  UINTN  Index;
+  UINTN  Byte;
+
+  for (Index = 0; Index < Midstate->WordCount; Index++) {
+    Midstate->Words[Index] = 0;
+    for (Byte = 0; Byte < Midstate->WordSize; Byte++) {
+      Midstate->Words[Index] = LShiftU64 (Midstate->Words[Index], 8) | *Input++;
+    }
+  }
+}
+
+/**
+  Describes the layout of a hash context of the given algorithm.
+
+  @param[in]   HashAlg   CRYPTO_HASH_MASK_* bit of the algorithm.
+  @param[out]  Midstate  Midstate receiving the word and block layout.
+
+  @retval TRUE   The algorithm is supported.
+  @retval FALSE  The algorithm is not supported. SM3 is not provided by MbedTLS.
+
+**/
+STATIC
+BOOLEAN
+HashMidstateLayout (
+  IN  UINT32         HashAlg,
+  OUT HASH_MIDSTATE  *Midstate
+  )
+{
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      Midstate->WordCount = 5;
+      Midstate->WordSize  = sizeof (UINT32);
+      Midstate->BlockSize = 64;
+      return TRUE;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+      Midstate->WordCount = 8;
+      Midstate->WordSize  = sizeof (UINT32);
+      Midstate->BlockSize = 64;
+      return TRUE;
+    case CRYPTO_HASH_MASK_SHA384:
+    case CRYPTO_HASH_MASK_SHA512:
+      Midstate->WordCount = 8;
+      Midstate->WordSize  = sizeof (UINT64);
+      Midstate->BlockSize = 128;
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/**
+  Exports the midstate of a hash context in a portable, backend-independent
+  format.
+
+  The exported state captures everything needed to continue the hash: the
+  chaining value, the number of bytes hashed so far and the pending partial
+  block. It can be imported with HashImportState() into a context of the same
+  algorithm, in another boot phase or by the other crypto backend, so that an
+  already-hashed prefix never has to be reprocessed. The hash context itself
+  is not modified.
+
+  If HashContext or StateSize is NULL, then return FALSE.
+  If State is NULL or *StateSize is too small, then *StateSize is set to the
+  required size and FALSE is returned.
+
+  @param[in]       HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm of
+                                HashContext: SHA-1, SHA-256, SHA-384, SHA-512 or SM3.
+  @param[in]       HashContext  Pointer to the hash context to export.
+  @param[out]      State        Pointer to the buffer receiving the exported state.
+  @param[in, out]  StateSize    On input, the size of State in bytes. On output,
+                                the size of the exported state in bytes.
+
+  @retval TRUE   The state was exported.
+  @retval FALSE  A parameter is invalid, State is too small, or the algorithm
+                 is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashExportState (
+  IN      UINT32      HashAlg,
+  IN      CONST VOID  *HashContext,
+  OUT     VOID        *State,
+  IN OUT  UINTN       *StateSize
+  )
+{
+  HASH_EXPORTED_STATE  *Exported;
+  HASH_MIDSTATE        Midstate;
+  UINTN                Index;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashContext == NULL) || (StateSize == NULL)) {
+    return FALSE;
+  }
+
+  if ((State == NULL) || (*StateSize < sizeof (HASH_EXPORTED_STATE))) {
+    *StateSize = sizeof (HASH_EXPORTED_STATE);
+    return FALSE;
+  }
+
+  if (!HashMidstateLayout (HashAlg, &Midstate)) {
+    return FALSE;
+  }
+
+  //
+  // Pull the chaining value, the message byte count and the pending block out
+  // of the MbedTLS context.
+  //
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        Midstate.Words[Index] = ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index];
+      }
+
+      Midstate.MessageLength = LShiftU64 (((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (total)[1], 32) |
+                               ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (total)[0];
+      Midstate.Block = ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (buffer);
+      break;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+ #if defined (MBEDTLS_SHA224_C)
+      if (((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (is224) != 0) {
+        return FALSE;
+      }
+
+ #endif
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        Midstate.Words[Index] = ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index];
+      }
+
+      Midstate.MessageLength = LShiftU64 (((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (total)[1], 32) |
+                               ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (total)[0];
+      Midstate.Block = ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (buffer);
+      break;
+    default:
+ #if defined (MBEDTLS_SHA384_C)
+      if (((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (is384) != (HashAlg == CRYPTO_HASH_MASK_SHA384)) {
+        return FALSE;
+      }
+
+ #endif
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        Midstate.Words[Index] = ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index];
+      }
+
+      //
+      // SHA-512 keeps a 128-bit byte count; only counts that fit in 64 bits
+      // are representable.
+      //
+      if (((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (total)[1] != 0) {
+        return FALSE;
+      }
+
+      Midstate.MessageLength = ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (total)[0];
+      Midstate.Block         = ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (buffer);
+      break;
+  }
+
+  Exported = (HASH_EXPORTED_STATE *)State;
+  ZeroMem (Exported, sizeof (HASH_EXPORTED_STATE));
+  Exported->Signature     = HASH_EXPORTED_STATE_SIGNATURE;
+  Exported->Algorithm     = HashAlg;
+  Exported->MessageLength = Midstate.MessageLength;
+  HashMidstateStoreWords (&Midstate, Exported->ChainingValue);
+  CopyMem (Exported->Block, Midstate.Block, (UINTN)(Midstate.MessageLength & (Midstate.BlockSize - 1)));
+
+  *StateSize = sizeof (HASH_EXPORTED_STATE);
+  return TRUE;
+}
+
+/**
+  Imports a midstate exported by HashExportState() into a hash context, so
+  that subsequent Update and Final calls continue the exported hash.
+
+  HashContext must be a buffer of at least the size returned by the
+  GetContextSize function of the algorithm; any previous content is replaced.
+
+  If HashContext or State is NULL, then return FALSE.
+  If State is not a valid exported state for HashAlg, then return FALSE.
+
+  @param[in]   HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm:
+                            SHA-1, SHA-256, SHA-384, SHA-512 or SM3.
+  @param[out]  HashContext  Pointer to the hash context to initialize.
+  @param[in]   State        Pointer to the exported state.
+  @param[in]   StateSize    Size of State in bytes.
+
+  @retval TRUE   The state was imported.
+  @retval FALSE  A parameter is invalid, State is malformed or was exported
+                 for another algorithm, or the algorithm is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashImportState (
+  IN   UINT32      HashAlg,
+  OUT  VOID        *HashContext,
+  IN   CONST VOID  *State,
+  IN   UINTN       StateSize
+  )
+{
+  CONST HASH_EXPORTED_STATE  *Exported;
+  HASH_MIDSTATE              Midstate;
+  UINTN                      Buffered;
+  UINTN                      Index;
+  BOOLEAN                    Status;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashContext == NULL) || (State == NULL) || (StateSize < sizeof (HASH_EXPORTED_STATE))) {
+    return FALSE;
+  }
+
+  Exported = (CONST HASH_EXPORTED_STATE *)State;
+  if ((Exported->Signature != HASH_EXPORTED_STATE_SIGNATURE) || (Exported->Algorithm != HashAlg)) {
+    return FALSE;
+  }
+
+  if (!HashMidstateLayout (HashAlg, &Midstate)) {
+    return FALSE;
+  }
+
+  //
+  // The 32-bit word hashes count message bits in 64 bits.
+  //
+  if ((Midstate.WordSize == sizeof (UINT32)) && (RShiftU64 (Exported->MessageLength, 61) != 0)) {
+    return FALSE;
+  }
+
+  Midstate.MessageLength = Exported->MessageLength;
+  HashMidstateLoadWords (&Midstate, Exported->ChainingValue);
+  Buffered = (UINTN)(Midstate.MessageLength & (Midstate.BlockSize - 1));
+
+  //
+  // Start from a freshly initialized context so that the fields not carried
+  // in the exported state (such as the SHA-384 flag) are set, then overwrite
+  // the chaining value, byte count and partial block.
+  //
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      Status = Sha1Init (HashContext);
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index] = (UINT32)Midstate.Words[Index];
+      }
+
+      ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (total)[0] = (UINT32)Midstate.MessageLength;
+      ((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (total)[1] = (UINT32)RShiftU64 (Midstate.MessageLength, 32);
+      CopyMem (((mbedtls_sha1_context *)HashContext)->MBEDTLS_PRIVATE (buffer), Exported->Block, Buffered);
+      break;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+      Status = Sha256Init (HashContext);
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index] = (UINT32)Midstate.Words[Index];
+      }
+
+      ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (total)[0] = (UINT32)Midstate.MessageLength;
+      ((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (total)[1] = (UINT32)RShiftU64 (Midstate.MessageLength, 32);
+      CopyMem (((mbedtls_sha256_context *)HashContext)->MBEDTLS_PRIVATE (buffer), Exported->Block, Buffered);
+      break;
+    default:
+      Status = (HashAlg == CRYPTO_HASH_MASK_SHA384) ? Sha384Init (HashContext) : Sha512Init (HashContext);
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (state)[Index] = Midstate.Words[Index];
+      }
+
+      ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (total)[0] = Midstate.MessageLength;
+      ((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (total)[1] = 0;
+      CopyMem (((mbedtls_sha512_context *)HashContext)->MBEDTLS_PRIVATE (buffer), Exported->Block, Buffered);
+      break;
+  }
+
+  return Status;
+}
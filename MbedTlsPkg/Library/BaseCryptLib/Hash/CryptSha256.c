@@ -216,3 +216,64 @@ Sha256HashAll (
 
   return TRUE;
 }
+
+/**
+  Computes the SHA-256 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha256Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-256 digest
+                              value (32 bytes).
+
+  @retval TRUE   SHA-256 digest computation succeeded.
+  @retval FALSE  SHA-256 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha256HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  mbedtls_sha256_context  Context;
+  UINTN                   Index;
+  INT32                   Ret;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashValue == NULL) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  mbedtls_sha256_init (&Context);
+
+  Ret = mbedtls_sha256_starts (&Context, FALSE);
+  for (Index = 0; (Ret == 0) && (Index < FragmentCount); Index++) {
+    Ret = mbedtls_sha256_update (&Context, Fragments[Index].Data, Fragments[Index].DataSize);
+  }
+
+  if (Ret == 0) {
+    Ret = mbedtls_sha256_finish (&Context, HashValue);
+  }
+
+  mbedtls_sha256_free (&Context);
+
+  return (BOOLEAN)(Ret == 0);
+}
@@ -219,6 +219,67 @@ Sha384HashAll (
   return TRUE;
 }
 
+/**
+  Computes the SHA-384 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha384Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-384 digest
+                              value (48 bytes).
+
+  @retval TRUE   SHA-384 digest computation succeeded.
+  @retval FALSE  SHA-384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha384HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  mbedtls_sha512_context  Context;
+  UINTN                   Index;
+  INT32                   Ret;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashValue == NULL) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  mbedtls_sha512_init (&Context);
+
+  Ret = mbedtls_sha512_starts (&Context, TRUE);
+  for (Index = 0; (Ret == 0) && (Index < FragmentCount); Index++) {
+    Ret = mbedtls_sha512_update (&Context, Fragments[Index].Data, Fragments[Index].DataSize);
+  }
+
+  if (Ret == 0) {
+    Ret = mbedtls_sha512_finish (&Context, HashValue);
+  }
+
+  mbedtls_sha512_free (&Context);
+
+  return (BOOLEAN)(Ret == 0);
+}
+
 /**
   Retrieves the size, in bytes, of the context buffer required for SHA-512 hash operations.
 
@@ -428,3 +489,64 @@ Sha512HashAll (
 
   return TRUE;
 }
+
+/**
+  Computes the SHA-512 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha512Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-512 digest
+                              value (64 bytes).
+
+  @retval TRUE   SHA-512 digest computation succeeded.
+  @retval FALSE  SHA-512 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha512HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  mbedtls_sha512_context  Context;
+  UINTN                   Index;
+  INT32                   Ret;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashValue == NULL) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  mbedtls_sha512_init (&Context);
+
+  Ret = mbedtls_sha512_starts (&Context, FALSE);
+  for (Index = 0; (Ret == 0) && (Index < FragmentCount); Index++) {
+    Ret = mbedtls_sha512_update (&Context, Fragments[Index].Data, Fragments[Index].DataSize);
+  }
+
+  if (Ret == 0) {
+    Ret = mbedtls_sha512_finish (&Context, HashValue);
+  }
+
+  mbedtls_sha512_free (&Context);
+
+  return (BOOLEAN)(Ret == 0);
+}
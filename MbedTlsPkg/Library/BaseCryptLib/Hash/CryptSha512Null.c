@@ -141,6 +141,38 @@ Sha384HashAll (
   return FALSE;
 }
 
+/**
+  Computes the SHA-384 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha384Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-384 digest
+                              value (48 bytes).
+
+  @retval TRUE   SHA-384 digest computation succeeded.
+  @retval FALSE  SHA-384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha384HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
 /**
   Retrieves the size, in bytes, of the context buffer required for SHA-512 hash operations.
 
@@ -273,3 +305,35 @@ Sha512HashAll (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Computes the SHA-512 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha512Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-512 digest
+                              value (64 bytes).
+
+  @retval TRUE   SHA-512 digest computation succeeded.
+  @retval FALSE  SHA-512 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha512HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
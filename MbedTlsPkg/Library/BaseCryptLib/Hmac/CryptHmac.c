@@ -327,6 +327,69 @@ HmacMdAll (
   return TRUE;
 }
 
+/**
+  Computes the HMAC digest of data held in several buffers.
+
+  @param[in]   MdType         Message Digest Type.
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC digest value.
+
+  @retval TRUE   HMAC digest computation succeeded.
+  @retval FALSE  HMAC digest computation failed.
+
+**/
+STATIC
+BOOLEAN
+HmacMdAllSg (
+  IN   mbedtls_md_type_t      MdType,
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  const mbedtls_md_info_t  *md_info;
+  mbedtls_md_context_t     Ctx;
+  UINTN                    Index;
+  INT32                    Ret;
+
+  if ((Key == NULL) || (HmacValue == NULL) || (KeySize > INT_MAX) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  md_info = mbedtls_md_info_from_type (MdType);
+  ASSERT (md_info != NULL);
+
+  mbedtls_md_init (&Ctx);
+
+  Ret = mbedtls_md_setup (&Ctx, md_info, 1);
+  if (Ret == 0) {
+    Ret = mbedtls_md_hmac_starts (&Ctx, Key, KeySize);
+  }
+
+  for (Index = 0; (Ret == 0) && (Index < FragmentCount); Index++) {
+    Ret = mbedtls_md_hmac_update (&Ctx, Fragments[Index].Data, Fragments[Index].DataSize);
+  }
+
+  if (Ret == 0) {
+    Ret = mbedtls_md_hmac_finish (&Ctx, HmacValue);
+  }
+
+  mbedtls_md_free (&Ctx);
+
+  return (BOOLEAN)(Ret == 0);
+}
+
 /**
   Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA256 use.
 
@@ -498,6 +561,40 @@ HmacSha256All (
   return HmacMdAll (MBEDTLS_MD_SHA256, Data, DataSize, Key, KeySize, HmacValue);
 }
 
+/**
+  Computes the HMAC-SHA256 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA256 digest
+                              value (32 bytes).
+
+  @retval TRUE   HMAC-SHA256 digest computation succeeded.
+  @retval FALSE  HMAC-SHA256 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha256AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  return HmacMdAllSg (MBEDTLS_MD_SHA256, Fragments, FragmentCount, Key, KeySize, HmacValue);
+}
+
 /**
   Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA384 use.
 
@@ -676,3 +773,37 @@ HmacSha384All (
 {
   return HmacMdAll (MBEDTLS_MD_SHA384, Data, DataSize, Key, KeySize, HmacValue);
 }
+
+/**
+  Computes the HMAC-SHA384 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA384 digest
+                              value (48 bytes).
+
+  @retval TRUE   HMAC-SHA384 digest computation succeeded.
+  @retval FALSE  HMAC-SHA384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha384AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  return HmacMdAllSg (MBEDTLS_MD_SHA384, Fragments, FragmentCount, Key, KeySize, HmacValue);
+}
@@ -11,6 +11,21 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "InternalCryptLib.h"
 #include <mbedtls/hkdf.h>
 
+///
+/// Maximum size of an HKDF-Expand-Label HkdfLabel structure:
+/// uint16 length, label<7..255>, context<0..255>.
+///
+#define HKDF_LABEL_MAX_SIZE  (2 + 1 + 255 + 1 + 255)
+
+///
+/// HKDF context created by HkdfNew(). The HMAC key schedule for the PRK is
+/// computed once; each output block resets the context back to it.
+///
+typedef struct {
+  mbedtls_md_context_t    MdCtx;
+  UINTN                   MdSize;
+} HKDF_CTX;
+
 /**
   Derive HMAC-based Extract-and-Expand Key Derivation Function (HKDF).
 
@@ -370,3 +385,263 @@ HkdfSha384Expand (
 {
   return HkdfMdExpand (MBEDTLS_MD_SHA384, Prk, PrkSize, Info, InfoSize, Out, OutSize);
 }
+
+/**
+  Allocates and initializes one HKDF context holding a pseudorandom key (PRK)
+  for subsequent HKDF-Expand operations.
+
+  The HMAC key schedule for the PRK is computed once here, so a key schedule
+  that derives several secrets from one PRK does not redo it per expansion.
+
+  @param[in]   HashNid          Hash algorithm: CRYPTO_NID_SHA256, CRYPTO_NID_SHA384
+                                or CRYPTO_NID_SHA512.
+  @param[in]   Prk              Pointer to the pseudorandom key.
+  @param[in]   PrkSize          PRK size in bytes.
+
+  @return  Pointer to the HKDF context, or NULL on failure. The context must be
+           released with HkdfFree().
+
+**/
+VOID *
+EFIAPI
+HkdfNew (
+  IN   UINTN        HashNid,
+  IN   CONST UINT8  *Prk,
+  IN   UINTN        PrkSize
+  )
+{
+  HKDF_CTX                 *HkdfCtx;
+  mbedtls_md_type_t        MdType;
+  const mbedtls_md_info_t  *md;
+
+  switch (HashNid) {
+    case CRYPTO_NID_SHA256:
+      MdType = MBEDTLS_MD_SHA256;
+      break;
+    case CRYPTO_NID_SHA384:
+      MdType = MBEDTLS_MD_SHA384;
+      break;
+    case CRYPTO_NID_SHA512:
+      MdType = MBEDTLS_MD_SHA512;
+      break;
+    default:
+      return NULL;
+  }
+
+  if ((Prk == NULL) || (PrkSize == 0) || (PrkSize > INT_MAX)) {
+    return NULL;
+  }
+
+  md = mbedtls_md_info_from_type (MdType);
+  if (md == NULL) {
+    return NULL;
+  }
+
+  HkdfCtx = AllocateZeroPool (sizeof (HKDF_CTX));
+  if (HkdfCtx == NULL) {
+    return NULL;
+  }
+
+  mbedtls_md_init (&HkdfCtx->MdCtx);
+  HkdfCtx->MdSize = mbedtls_md_get_size (md);
+
+  if ((mbedtls_md_setup (&HkdfCtx->MdCtx, md, 1) != 0) ||
+      (mbedtls_md_hmac_starts (&HkdfCtx->MdCtx, Prk, PrkSize) != 0))
+  {
+    HkdfFree (HkdfCtx);
+    return NULL;
+  }
+
+  return HkdfCtx;
+}
+
+/**
+  Release the specified HKDF context.
+
+  @param[in]   HkdfContext      Pointer to the HKDF context to be released.
+
+**/
+VOID
+EFIAPI
+HkdfFree (
+  IN   VOID  *HkdfContext
+  )
+{
+  HKDF_CTX  *HkdfCtx;
+
+  if (HkdfContext == NULL) {
+    return;
+  }
+
+  HkdfCtx = (HKDF_CTX *)HkdfContext;
+  mbedtls_md_free (&HkdfCtx->MdCtx);
+  FreePool (HkdfCtx);
+}
+
+/**
+  HKDF-Expand (RFC 5869) on the keyed HMAC state of an HKDF context.
+
+  @param[in]   HkdfCtx          Pointer to the HKDF context.
+  @param[in]   Info             Pointer to the application specific info.
+  @param[in]   InfoSize         Info size in bytes.
+  @param[out]  Out              Pointer to buffer to receive hkdf value.
+  @param[in]   OutSize          Size of hkdf bytes to generate.
+
+  @retval TRUE   Hkdf generated successfully.
+  @retval FALSE  Hkdf generation failed.
+
+**/
+STATIC
+BOOLEAN
+HkdfCtxExpand (
+  IN   HKDF_CTX     *HkdfCtx,
+  IN   CONST UINT8  *Info,
+  IN   UINTN        InfoSize,
+  OUT  UINT8        *Out,
+  IN   UINTN        OutSize
+  )
+{
+  UINT8    Block[MBEDTLS_MD_MAX_SIZE];
+  UINTN    BlockSize;
+  UINTN    Done;
+  UINTN    CopySize;
+  UINT8    Counter;
+  BOOLEAN  Result;
+
+  if (((Info == NULL) && (InfoSize != 0)) || (Out == NULL) ||
+      (InfoSize > INT_MAX) || (OutSize > 255 * HkdfCtx->MdSize))
+  {
+    return FALSE;
+  }
+
+  Result    = TRUE;
+  BlockSize = 0;
+  Done      = 0;
+
+  //
+  // T(i) = HMAC-Hash (PRK, T(i-1) | info | i), OKM = first OutSize bytes of T(1) | T(2) | ...
+  //
+  for (Counter = 1; Result && (Done < OutSize); Counter++) {
+    Result = (mbedtls_md_hmac_reset (&HkdfCtx->MdCtx) == 0) &&
+             (mbedtls_md_hmac_update (&HkdfCtx->MdCtx, Block, BlockSize) == 0) &&
+             ((InfoSize == 0) || (mbedtls_md_hmac_update (&HkdfCtx->MdCtx, Info, InfoSize) == 0)) &&
+             (mbedtls_md_hmac_update (&HkdfCtx->MdCtx, &Counter, 1) == 0) &&
+             (mbedtls_md_hmac_finish (&HkdfCtx->MdCtx, Block) == 0);
+
+    if (Result) {
+      BlockSize = HkdfCtx->MdSize;
+      CopySize  = MIN (BlockSize, OutSize - Done);
+      CopyMem (Out + Done, Block, CopySize);
+      Done += CopySize;
+    }
+  }
+
+  ZeroMem (Block, sizeof (Block));
+  return Result;
+}
+
+/**
+  Derive HKDF-Expand-Label as defined in RFC 8446 section 7.1 from the PRK held
+  by an HKDF context.
+
+  The info passed to HKDF-Expand is the HkdfLabel structure: the output length
+  as a big-endian UINT16, then Label and Context, each preceded by a one byte
+  length. Label must include any protocol prefix, e.g. "tls13 key".
+
+  @param[in]   HkdfContext      Pointer to the HKDF context created by HkdfNew().
+  @param[in]   Label            Pointer to the label, including its prefix.
+  @param[in]   LabelSize        Label size in bytes, at most 255.
+  @param[in]   Context          Pointer to the context value. May be NULL if
+                                ContextSize is 0.
+  @param[in]   ContextSize      Context size in bytes, at most 255.
+  @param[out]  Out              Pointer to buffer to receive hkdf value.
+  @param[in]   OutSize          Size of hkdf bytes to generate, at most 0xFFFF.
+
+  @retval TRUE   Hkdf generated successfully.
+  @retval FALSE  Hkdf generation failed.
+
+**/
+BOOLEAN
+EFIAPI
+HkdfExpandLabel (
+  IN   VOID         *HkdfContext,
+  IN   CONST UINT8  *Label,
+  IN   UINTN        LabelSize,
+  IN   CONST UINT8  *Context,
+  IN   UINTN        ContextSize,
+  OUT  UINT8        *Out,
+  IN   UINTN        OutSize
+  )
+{
+  UINT8    HkdfLabel[HKDF_LABEL_MAX_SIZE];
+  UINTN    HkdfLabelSize;
+  BOOLEAN  Result;
+
+  if ((HkdfContext == NULL) || (Label == NULL) || (LabelSize > 255) ||
+      ((Context == NULL) && (ContextSize != 0)) || (ContextSize > 255) ||
+      (OutSize > 0xFFFF))
+  {
+    return FALSE;
+  }
+
+  HkdfLabelSize              = 0;
+  HkdfLabel[HkdfLabelSize++] = (UINT8)(OutSize >> 8);
+  HkdfLabel[HkdfLabelSize++] = (UINT8)OutSize;
+  HkdfLabel[HkdfLabelSize++] = (UINT8)LabelSize;
+  CopyMem (HkdfLabel + HkdfLabelSize, Label, LabelSize);
+  HkdfLabelSize             += LabelSize;
+  HkdfLabel[HkdfLabelSize++] = (UINT8)ContextSize;
+  if (ContextSize != 0) {
+    CopyMem (HkdfLabel + HkdfLabelSize, Context, ContextSize);
+    HkdfLabelSize += ContextSize;
+  }
+
+  Result = HkdfCtxExpand ((HKDF_CTX *)HkdfContext, HkdfLabel, HkdfLabelSize, Out, OutSize);
+
+  ZeroMem (HkdfLabel, sizeof (HkdfLabel));
+  return Result;
+}
+
+/**
+  Derive several HKDF-Expand outputs from the PRK held by an HKDF context.
+
+  Output i is HKDF-Expand (PRK, Infos[i], OutSizes[i]) written to Outs[i].
+
+  @param[in]   HkdfContext      Pointer to the HKDF context created by HkdfNew().
+  @param[in]   Count            Number of expansions.
+  @param[in]   Infos            Array of Count pointers to application specific info.
+  @param[in]   InfoSizes        Array of Count info sizes in bytes.
+  @param[out]  Outs             Array of Count pointers to buffers receiving hkdf values.
+  @param[in]   OutSizes         Array of Count output sizes in bytes.
+
+  @retval TRUE   All hkdf values generated successfully.
+  @retval FALSE  Hkdf generation failed.
+
+**/
+BOOLEAN
+EFIAPI
+HkdfExpandMany (
+  IN   VOID         *HkdfContext,
+  IN   UINTN        Count,
+  IN   CONST UINT8  **Infos,
+  IN   CONST UINTN  *InfoSizes,
+  OUT  UINT8        **Outs,
+  IN   CONST UINTN  *OutSizes
+  )
+{
+  UINTN  Index;
+
+  if ((HkdfContext == NULL) || (Infos == NULL) || (InfoSizes == NULL) ||
+      (Outs == NULL) || (OutSizes == NULL))
+  {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if (!HkdfCtxExpand ((HKDF_CTX *)HkdfContext, Infos[Index], InfoSizes[Index], Outs[Index], OutSizes[Index])) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
@@ -190,3 +190,114 @@ HkdfSha384Expand (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Allocates and initializes one HKDF context holding a pseudorandom key (PRK)
+  for subsequent HKDF-Expand operations.
+
+  The HMAC key schedule for the PRK is computed once here, so a key schedule
+  that derives several secrets from one PRK does not redo it per expansion.
+
+  @param[in]   HashNid          Hash algorithm: CRYPTO_NID_SHA256, CRYPTO_NID_SHA384
+                                or CRYPTO_NID_SHA512.
+  @param[in]   Prk              Pointer to the pseudorandom key.
+  @param[in]   PrkSize          PRK size in bytes.
+
+  @return  Pointer to the HKDF context, or NULL on failure. The context must be
+           released with HkdfFree().
+
+**/
+VOID *
+EFIAPI
+HkdfNew (
+  IN   UINTN        HashNid,
+  IN   CONST UINT8  *Prk,
+  IN   UINTN        PrkSize
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Release the specified HKDF context.
+
+  @param[in]   HkdfContext      Pointer to the HKDF context to be released.
+
+**/
+VOID
+EFIAPI
+HkdfFree (
+  IN   VOID  *HkdfContext
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Derive HKDF-Expand-Label as defined in RFC 8446 section 7.1 from the PRK held
+  by an HKDF context.
+
+  The info passed to HKDF-Expand is the HkdfLabel structure: the output length
+  as a big-endian UINT16, then Label and Context, each preceded by a one byte
+  length. Label must include any protocol prefix, e.g. "tls13 key".
+
+  @param[in]   HkdfContext      Pointer to the HKDF context created by HkdfNew().
+  @param[in]   Label            Pointer to the label, including its prefix.
+  @param[in]   LabelSize        Label size in bytes, at most 255.
+  @param[in]   Context          Pointer to the context value. May be NULL if
+                                ContextSize is 0.
+  @param[in]   ContextSize      Context size in bytes, at most 255.
+  @param[out]  Out              Pointer to buffer to receive hkdf value.
+  @param[in]   OutSize          Size of hkdf bytes to generate, at most 0xFFFF.
+
+  @retval TRUE   Hkdf generated successfully.
+  @retval FALSE  Hkdf generation failed.
+
+**/
+BOOLEAN
+EFIAPI
+HkdfExpandLabel (
+  IN   VOID         *HkdfContext,
+  IN   CONST UINT8  *Label,
+  IN   UINTN        LabelSize,
+  IN   CONST UINT8  *Context,
+  IN   UINTN        ContextSize,
+  OUT  UINT8        *Out,
+  IN   UINTN        OutSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Derive several HKDF-Expand outputs from the PRK held by an HKDF context.
+
+  Output i is HKDF-Expand (PRK, Infos[i], OutSizes[i]) written to Outs[i].
+
+  @param[in]   HkdfContext      Pointer to the HKDF context created by HkdfNew().
+  @param[in]   Count            Number of expansions.
+  @param[in]   Infos            Array of Count pointers to application specific info.
+  @param[in]   InfoSizes        Array of Count info sizes in bytes.
+  @param[out]  Outs             Array of Count pointers to buffers receiving hkdf values.
+  @param[in]   OutSizes         Array of Count output sizes in bytes.
+
+  @retval TRUE   All hkdf values generated successfully.
+  @retval FALSE  Hkdf generation failed.
+
+**/
+BOOLEAN
+EFIAPI
+HkdfExpandMany (
+  IN   VOID         *HkdfContext,
+  IN   UINTN        Count,
+  IN   CONST UINT8  **Infos,
+  IN   CONST UINTN  *InfoSizes,
+  OUT  UINT8        **Outs,
+  IN   CONST UINTN  *OutSizes
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
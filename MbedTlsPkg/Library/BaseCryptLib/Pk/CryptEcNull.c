@@ -429,6 +429,44 @@ EcGenerateKey (
   return FALSE;
 }
 
+/**
+  Pre-generates EC key pairs for the given curve, to be handed out by later
+  EcGenerateKey() calls on contexts of that curve.
+
+  @param[in]  Nid    Identifying number for the ECC curve (Defined in
+                     BaseCryptLib.h).
+  @param[in]  Count  Maximum number of key pairs to generate.
+
+  @retval TRUE   The pool was refilled, or was already full.
+  @retval FALSE  The curve is not supported, or key generation failed.
+  @retval FALSE  This interface is not supported.
+**/
+BOOLEAN
+EFIAPI
+EcRefillKeyPool (
+  IN UINTN  Nid,
+  IN UINTN  Count
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Releases every key pair pre-generated by EcRefillKeyPool().
+
+  There is no key pool in this instance, so there is nothing to release. The
+  function does not assert, so that it can be called unconditionally, e.g.
+  from an ExitBootServices event.
+**/
+VOID
+EFIAPI
+EcFreeKeyPool (
+  VOID
+  )
+{
+}
+
 /**
   Gets the public key component from the established EC context.
   The Ec context should be correctly initialized by EcNewByNid, and successfully
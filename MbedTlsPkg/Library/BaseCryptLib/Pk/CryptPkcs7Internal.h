@@ -32,6 +32,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MBEDTLS_OID_PKCS7_DIGESTED_DATA              MBEDTLS_OID_PKCS7 "\x05"
 #define MBEDTLS_OID_PKCS7_ENCRYPTED_DATA             MBEDTLS_OID_PKCS7 "\x06"
 
+///
+/// PKCS9 messageDigest attribute OID
+///
+#define MBEDTLS_OID_PKCS9_MESSAGE_DIGEST  MBEDTLS_OID_PKCS9 "\x04"
+
 ///
 /// PKCS7 SignerInfo type
 /// https://tools.ietf.org/html/rfc2315#section-9.2
@@ -77,6 +82,14 @@ typedef struct MbedtlsPkcs7 {
   struct MbedtlsPkcs7SignedData    SignedData;
 } MbedtlsPkcs7;
 
+///
+/// Parsed PKCS7 context returned by Pkcs7Parse(). The decoded structure keeps
+/// pointers into the caller's DER buffer, which is never copied.
+///
+typedef struct MbedtlsPkcs7Context {
+  MbedtlsPkcs7    Pkcs7;
+} MbedtlsPkcs7Context;
+
 #define EDKII_ASN1_CHK_ADD(g, f)                        \
     do                                                  \
     {                                                   \
@@ -86,4 +99,18 @@ typedef struct MbedtlsPkcs7 {
             (g) += Ret;                                 \
     } while( 0 )
 
+/**
+  Find signer cert in MbedtlsPkcs7SignerInfo.
+
+  @param[in]  SignerInfo   MbedtlsPkcs7 SignerInfo.
+  @param[in]  Certs        MbedtlsPkcs7 SignerInfo certs.
+
+  @retval cert             Signer Cert.
+**/
+mbedtls_x509_crt *
+MbedTlsPkcs7FindSignerCert (
+  MbedtlsPkcs7SignerInfo  *SignerInfo,
+  mbedtls_x509_crt        *Certs
+  );
+
 #endif
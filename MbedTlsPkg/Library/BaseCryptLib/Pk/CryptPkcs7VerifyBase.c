@@ -6,7 +6,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
 
-#include "InternalCryptLib.h"
+#include "CryptPkcs7Internal.h"
 #include <mbedtls/pkcs7.h>
 
 /**
@@ -19,6 +19,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
   Caution: This function may receive untrusted input. So this function will do
            basic check for PKCS#7 data structure.
 
+  The content is located with Pkcs7GetAttachedContentInPlace() and copied, so
+  both functions accept the same input.
+
   @param[in]   P7Data       Pointer to the PKCS#7 signed data to process.
   @param[in]   P7Length     Length of the PKCS#7 signed data in bytes.
   @param[out]  Content      Pointer to the extracted content from the PKCS#7 signedData.
@@ -37,6 +40,216 @@ Pkcs7GetAttachedContent (
   OUT VOID        **Content,
   OUT UINTN       *ContentSize
   )
+{
+  CONST UINT8  *InPlace;
+
+  //
+  // Check input parameter.
+  //
+  if ((P7Data == NULL) || (P7Length > INT_MAX) || (Content == NULL) || (ContentSize == NULL)) {
+    return FALSE;
+  }
+
+  *Content = NULL;
+
+  if (!Pkcs7GetAttachedContentInPlace (P7Data, P7Length, &InPlace, ContentSize)) {
+    return FALSE;
+  }
+
+  if (InPlace == NULL) {
+    //
+    // No Content supplied for PKCS7 detached signedData
+    //
+    return TRUE;
+  }
+
+  *Content = AllocateCopyPool (*ContentSize, InPlace);
+  if (*Content == NULL) {
+    *ContentSize = 0;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Extracts the attached content from a PKCS#7 context returned by Pkcs7Parse()
+  if existed.
+
+  If Pkcs7Context, Content, or ContentSize is NULL, then return FALSE.
+
+  @param[in]   Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out]  Content      Pointer to the extracted content from the PKCS#7 signedData.
+                            It's caller's responsibility to free the buffer with FreePool().
+  @param[out]  ContentSize  The size of the extracted content in bytes.
+
+  @retval     TRUE          The content was extracted successfully.
+  @retval     FALSE         The content could not be extracted.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetAttachedContent (
+  IN VOID    *Pkcs7Context,
+  OUT VOID   **Content,
+  OUT UINTN  *ContentSize
+  )
 {
   return FALSE;
 }
+
+///
+/// PKCS#7 content types whose content is a structure rather than an OCTET
+/// STRING. As in the OpenSSL instance, Pkcs7GetAttachedContentInPlace()
+/// returns content only for id-data, or for another content type encoded as
+/// an OCTET STRING.
+///
+STATIC CONST struct {
+  CONST CHAR8    *Oid;
+  UINTN          OidSize;
+} mPkcs7NonOctetContentTypes[] = {
+  { MBEDTLS_OID_PKCS7_SIGNED_DATA,               sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1               },
+  { MBEDTLS_OID_PKCS7_ENVELOPED_DATA,            sizeof (MBEDTLS_OID_PKCS7_ENVELOPED_DATA) - 1            },
+  { MBEDTLS_OID_PKCS7_SIGNED_AND_ENVELOPED_DATA, sizeof (MBEDTLS_OID_PKCS7_SIGNED_AND_ENVELOPED_DATA) - 1 },
+  { MBEDTLS_OID_PKCS7_DIGESTED_DATA,             sizeof (MBEDTLS_OID_PKCS7_DIGESTED_DATA) - 1             },
+  { MBEDTLS_OID_PKCS7_ENCRYPTED_DATA,            sizeof (MBEDTLS_OID_PKCS7_ENCRYPTED_DATA) - 1            },
+};
+
+/**
+  Locates the attached content of a PKCS#7 signed data without copying it. The
+  input signed data could be wrapped in a ContentInfo structure.
+
+  On success Content points into P7Data, so it stays valid as long as P7Data
+  does and must not be freed. Only the path down to the content is decoded;
+  the content must be a DER (primitive) OCTET STRING. Attached content of a
+  signedData, envelopedData, signedAndEnvelopedData, digestedData or
+  encryptedData content type is rejected.
+
+  If P7Data, Content, or ContentSize is NULL, then return FALSE. If P7Length overflow,
+  then return FALSE. If the P7Data is not correctly formatted, then return FALSE.
+
+  Caution: This function may receive untrusted input. So this function will do
+           basic check for PKCS#7 data structure.
+
+  @param[in]   P7Data       Pointer to the PKCS#7 signed data to process.
+  @param[in]   P7Length     Length of the PKCS#7 signed data in bytes.
+  @param[out]  Content      Pointer to the attached content inside P7Data, or NULL
+                            for detached signedData.
+  @param[out]  ContentSize  The size of the attached content in bytes.
+
+  @retval     TRUE          The P7Data was correctly formatted for processing.
+  @retval     FALSE         The P7Data was not correctly formatted for processing.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetAttachedContentInPlace (
+  IN CONST UINT8   *P7Data,
+  IN UINTN         P7Length,
+  OUT CONST UINT8  **Content,
+  OUT UINTN        *ContentSize
+  )
+{
+  UINT8  *Ptr;
+  UINT8  *End;
+  UINTN  Len;
+  UINT8  *ContentType;
+  UINTN  ContentTypeLen;
+  UINTN  Index;
+
+  //
+  // Check input parameter.
+  //
+  if ((P7Data == NULL) || (P7Length > INT_MAX) || (Content == NULL) || (ContentSize == NULL)) {
+    return FALSE;
+  }
+
+  *Content     = NULL;
+  *ContentSize = 0;
+
+  Ptr = (UINT8 *)P7Data;
+  End = Ptr + P7Length;
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
+    return FALSE;
+  }
+
+  End = Ptr + Len;
+
+  //
+  // Step into the signedData content of a ContentInfo wrapper, if present.
+  //
+  if ((Ptr < End) && (*Ptr == MBEDTLS_ASN1_OID)) {
+    if ((mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_OID) != 0) ||
+        (Len != sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1) ||
+        (CompareMem (Ptr, MBEDTLS_OID_PKCS7_SIGNED_DATA, Len) != 0))
+    {
+      return FALSE;
+    }
+
+    Ptr += Len;
+    if ((mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC) != 0) ||
+        (mbedtls_asn1_get_tag (&Ptr, Ptr + Len, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0))
+    {
+      return FALSE;
+    }
+
+    End = Ptr + Len;
+  }
+
+  //
+  // SignedData: skip version and digestAlgorithms, then enter contentInfo.
+  //
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_INTEGER) != 0) {
+    return FALSE;
+  }
+
+  Ptr += Len;
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET) != 0) {
+    return FALSE;
+  }
+
+  Ptr += Len;
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
+    return FALSE;
+  }
+
+  End = Ptr + Len;
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_OID) != 0) {
+    return FALSE;
+  }
+
+  ContentType    = Ptr;
+  ContentTypeLen = Len;
+
+  Ptr += Len;
+  if (Ptr == End) {
+    //
+    // No Content supplied for PKCS7 detached signedData
+    //
+    return TRUE;
+  }
+
+  //
+  // Reject the content types whose content is not an OCTET STRING.
+  //
+  for (Index = 0; Index < ARRAY_SIZE (mPkcs7NonOctetContentTypes); Index++) {
+    if ((ContentTypeLen == mPkcs7NonOctetContentTypes[Index].OidSize) &&
+        (CompareMem (ContentType, mPkcs7NonOctetContentTypes[Index].Oid, ContentTypeLen) == 0))
+    {
+      return FALSE;
+    }
+  }
+
+  if ((mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC) != 0) ||
+      (mbedtls_asn1_get_tag (&Ptr, Ptr + Len, &Len, MBEDTLS_ASN1_OCTET_STRING) != 0))
+  {
+    return FALSE;
+  }
+
+  if (Len > 0) {
+    *Content     = Ptr;
+    *ContentSize = Len;
+  }
+
+  return TRUE;
+}
@@ -650,107 +650,206 @@ Out:
 }
 
 /**
-  MbedtlsPkcs7 verify MbedtlsPkcs7SignerInfo.
-  @param[in]  SignerInfo   MbedtlsPkcs7 SignerInfo.
-  @param[in]  Cert         cert.
-  @param[in]  Data         Pointer for data.
-  @param[in]  DataLen      The len the buffer.
+  Hash the authenticated attributes of a signer as they are signed: the DER of
+  the [0] IMPLICIT attributes with the tag replaced by SET OF. The tag is fed
+  to the digest separately so the PKCS#7 buffer is never modified.
+
+  @param[in]  MdInfo       Digest algorithm.
+  @param[in]  SignerInfo   MbedtlsPkcs7 SignerInfo with AuthAttr present.
+  @param[out] Hash         Buffer receiving the digest.
 
   @retval 0                Success.
-  @retval negative         A negative MBEDTLS_ERR_ASN1_XXX error code on failure.
+  @retval negative         A negative MBEDTLS_ERR_MD_XXX error code on failure.
 **/
 STATIC
 INT32
-MbedtlsPkcs7SignedDataVerifySigners (
-  MbedtlsPkcs7SignerInfo  *SignerInfo,
-  mbedtls_x509_crt        *Cert,
-  CONST UINT8             *Data,
-  INTN                    DataLen
+MbedTlsPkcs7HashAuthAttr (
+  CONST mbedtls_md_info_t  *MdInfo,
+  MbedtlsPkcs7SignerInfo   *SignerInfo,
+  UINT8                    *Hash
   )
 {
-  INT32                    Ret;
-  UINT8                    Hash[MBEDTLS_MD_MAX_SIZE];
-  mbedtls_pk_context       Pk;
-  CONST mbedtls_md_info_t  *MdInfo;
-  INTN                     HashLen;
-  UINT8                    TempAuthAttr;
+  mbedtls_md_context_t  MdCtx;
+  UINT8                 SetTag;
+  INT32                 Ret;
 
-  Pk = Cert->pk;
-  ZeroMem (Hash, MBEDTLS_MD_MAX_SIZE);
+  SetTag = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET;
 
-  // all the hash algo
- #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
-  MdInfo  = mbedtls_md_info_from_type (MBEDTLS_MD_SHA1);
-  HashLen = mbedtls_md_get_size (MdInfo);
-  mbedtls_md (MdInfo, Data, DataLen, Hash);
-  if (SignerInfo->AuthAttr.p != NULL) {
-    TempAuthAttr              = *(SignerInfo->AuthAttr.p);
-    *(SignerInfo->AuthAttr.p) = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET;
-    mbedtls_md (MdInfo, SignerInfo->AuthAttr.p, SignerInfo->AuthAttr.len, Hash);
-    // Restore content
-    *(SignerInfo->AuthAttr.p) = TempAuthAttr;
+  mbedtls_md_init (&MdCtx);
+  Ret = mbedtls_md_setup (&MdCtx, MdInfo, 0);
+  if (Ret == 0) {
+    Ret = mbedtls_md_starts (&MdCtx);
   }
 
-  Ret = mbedtls_pk_verify (&Pk, MBEDTLS_MD_SHA1, Hash, HashLen, SignerInfo->Sig.p, SignerInfo->Sig.len);
-
   if (Ret == 0) {
-    return Ret;
+    Ret = mbedtls_md_update (&MdCtx, &SetTag, 1);
   }
 
- #endif
-
-  MdInfo  = mbedtls_md_info_from_type (MBEDTLS_MD_SHA256);
-  HashLen = mbedtls_md_get_size (MdInfo);
-  ZeroMem (Hash, MBEDTLS_MD_MAX_SIZE);
-  mbedtls_md (MdInfo, Data, DataLen, Hash);
-  if (SignerInfo->AuthAttr.p != NULL) {
-    TempAuthAttr              = *(SignerInfo->AuthAttr.p);
-    *(SignerInfo->AuthAttr.p) = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET;
-    mbedtls_md (MdInfo, SignerInfo->AuthAttr.p, SignerInfo->AuthAttr.len, Hash);
-    // Restore content
-    *(SignerInfo->AuthAttr.p) = TempAuthAttr;
+  if (Ret == 0) {
+    Ret = mbedtls_md_update (&MdCtx, SignerInfo->AuthAttr.p + 1, SignerInfo->AuthAttr.len - 1);
   }
 
-  Ret = mbedtls_pk_verify (&Pk, MBEDTLS_MD_SHA256, Hash, HashLen, SignerInfo->Sig.p, SignerInfo->Sig.len);
   if (Ret == 0) {
+    Ret = mbedtls_md_finish (&MdCtx, Hash);
+  }
+
+  mbedtls_md_free (&MdCtx);
+  return Ret;
+}
+
+/**
+  Find the messageDigest value in the authenticated attributes of a signer.
+
+   authenticatedAttributes [0] IMPLICIT Attributes,
+   Attribute ::= SEQUENCE {
+        type AttributeType,
+        values SET OF AttributeValue }.
+
+  @param[in]  SignerInfo   MbedtlsPkcs7 SignerInfo.
+  @param[out] Digest       The messageDigest OCTET STRING value.
+
+  @retval 0                Success.
+  @retval negative         A negative MBEDTLS_ERR_ASN1_XXX error code on failure.
+**/
+STATIC
+INT32
+MbedTlsPkcs7GetMessageDigest (
+  MbedtlsPkcs7SignerInfo  *SignerInfo,
+  mbedtls_asn1_buf        *Digest
+  )
+{
+  UINT8             *Ptr;
+  UINT8             *End;
+  UINT8             *AttrEnd;
+  UINTN             Len;
+  INT32             Ret;
+  mbedtls_asn1_buf  Oid;
+
+  Ptr = SignerInfo->AuthAttr.p;
+  End = Ptr + SignerInfo->AuthAttr.len;
+
+  Ret = mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC);
+  if (Ret != 0) {
     return Ret;
   }
 
-  MdInfo  = mbedtls_md_info_from_type (MBEDTLS_MD_SHA384);
-  HashLen = mbedtls_md_get_size (MdInfo);
-  ZeroMem (Hash, MBEDTLS_MD_MAX_SIZE);
-  mbedtls_md (MdInfo, Data, DataLen, Hash);
-  if (SignerInfo->AuthAttr.p != NULL) {
-    TempAuthAttr              = *(SignerInfo->AuthAttr.p);
-    *(SignerInfo->AuthAttr.p) = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET;
-    mbedtls_md (MdInfo, SignerInfo->AuthAttr.p, SignerInfo->AuthAttr.len, Hash);
-    // Restore content
-    *(SignerInfo->AuthAttr.p) = TempAuthAttr;
+  End = Ptr + Len;
+  while (Ptr < End) {
+    Ret = mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE);
+    if (Ret != 0) {
+      return Ret;
+    }
+
+    AttrEnd = Ptr + Len;
+    Ret     = mbedtls_asn1_get_tag (&Ptr, AttrEnd, &Oid.len, MBEDTLS_ASN1_OID);
+    if (Ret != 0) {
+      return Ret;
+    }
+
+    Oid.p = Ptr;
+    Ptr  += Oid.len;
+    if (MBEDTLS_OID_CMP (MBEDTLS_OID_PKCS9_MESSAGE_DIGEST, &Oid) == 0) {
+      Ret = mbedtls_asn1_get_tag (&Ptr, AttrEnd, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET);
+      if (Ret == 0) {
+        Ret = mbedtls_asn1_get_tag (&Ptr, AttrEnd, &Digest->len, MBEDTLS_ASN1_OCTET_STRING);
+      }
+
+      if (Ret == 0) {
+        Digest->p = Ptr;
+      }
+
+      return Ret;
+    }
+
+    Ptr = AttrEnd;
   }
 
-  Ret = mbedtls_pk_verify (&Pk, MBEDTLS_MD_SHA384, Hash, HashLen, SignerInfo->Sig.p, SignerInfo->Sig.len);
-  if (Ret == 0) {
-    return Ret;
+  return MBEDTLS_ERR_ASN1_OUT_OF_DATA;
+}
+
+/**
+  Get the digest algorithm of a signer from its SignerInfo.
+
+  @param[in]  SignerInfo   MbedtlsPkcs7 SignerInfo.
+  @param[out] MdType       Digest algorithm of the signer.
+
+  @retval TRUE      The digest algorithm is supported.
+  @retval FALSE     The digest algorithm is unknown or disabled.
+**/
+STATIC
+BOOLEAN
+MbedTlsPkcs7GetSignerMdType (
+  MbedtlsPkcs7SignerInfo  *SignerInfo,
+  mbedtls_md_type_t       *MdType
+  )
+{
+  if (mbedtls_oid_get_md_alg (&SignerInfo->AlgIdentifier, MdType) != 0) {
+    return FALSE;
+  }
+
+ #ifdef DISABLE_SHA1_DEPRECATED_INTERFACES
+  if (*MdType == MBEDTLS_MD_SHA1) {
+    return FALSE;
   }
 
-  MdInfo  = mbedtls_md_info_from_type (MBEDTLS_MD_SHA512);
+ #endif
+
+  return mbedtls_md_info_from_type (*MdType) != NULL;
+}
+
+/**
+  Verify the signature of a signer over the digest of the content.
+
+  If the signer has authenticated attributes, the content digest must match
+  the signed messageDigest attribute, and the signature then covers the DER of
+  the attributes re-tagged as SET OF.
+
+  @param[in]      SignerInfo   MbedtlsPkcs7 SignerInfo.
+  @param[in]      SignerCert   Certificate of the signer.
+  @param[in]      MdType       Digest algorithm of the signer.
+  @param[in,out]  Hash         Digest of the content. It is overwritten with the
+                               digest of the authenticated attributes, if any.
+
+  @retval TRUE      The signature is valid.
+  @retval FALSE     The signature is invalid.
+**/
+STATIC
+BOOLEAN
+MbedTlsPkcs7VerifySignerHash (
+  MbedtlsPkcs7SignerInfo  *SignerInfo,
+  mbedtls_x509_crt        *SignerCert,
+  mbedtls_md_type_t       MdType,
+  UINT8                   *Hash
+  )
+{
+  CONST mbedtls_md_info_t  *MdInfo;
+  mbedtls_asn1_buf         MessageDigest;
+  UINTN                    HashLen;
+
+  MdInfo  = mbedtls_md_info_from_type (MdType);
   HashLen = mbedtls_md_get_size (MdInfo);
-  ZeroMem (Hash, MBEDTLS_MD_MAX_SIZE);
-  mbedtls_md (MdInfo, Data, DataLen, Hash);
+
   if (SignerInfo->AuthAttr.p != NULL) {
-    TempAuthAttr              = *(SignerInfo->AuthAttr.p);
-    *(SignerInfo->AuthAttr.p) = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET;
-    mbedtls_md (MdInfo, SignerInfo->AuthAttr.p, SignerInfo->AuthAttr.len, Hash);
-    // Restore content
-    *(SignerInfo->AuthAttr.p) = TempAuthAttr;
-  }
+    if ((MbedTlsPkcs7GetMessageDigest (SignerInfo, &MessageDigest) != 0) ||
+        (MessageDigest.len != HashLen) ||
+        (CompareMem (MessageDigest.p, Hash, HashLen) != 0))
+    {
+      return FALSE;
+    }
 
-  Ret = mbedtls_pk_verify (&Pk, MBEDTLS_MD_SHA512, Hash, HashLen, SignerInfo->Sig.p, SignerInfo->Sig.len);
-  if (Ret == 0) {
-    return Ret;
+    if (MbedTlsPkcs7HashAuthAttr (MdInfo, SignerInfo, Hash) != 0) {
+      return FALSE;
+    }
   }
 
-  return Ret;
+  return mbedtls_pk_verify (
+           &SignerCert->pk,
+           MdType,
+           Hash,
+           HashLen,
+           SignerInfo->Sig.p,
+           SignerInfo->Sig.len
+           ) == 0;
 }
 
 /**
@@ -761,7 +860,6 @@ MbedtlsPkcs7SignedDataVerifySigners (
 
   @retval cert             Signer Cert.
 **/
-STATIC
 mbedtls_x509_crt *
 MbedTlsPkcs7FindSignerCert (
   MbedtlsPkcs7SignerInfo  *SignerInfo,
@@ -867,6 +965,10 @@ MbedTlsPkcs7VerifyCertChain (
 /**
   MbedTlsPkcs7 Verify SignedData.
 
+  As in the streaming Pkcs7VerifyInit() and Pkcs7VerifyFinal(), every signer
+  must chain to TrustCert, and its signature is checked with its own
+  digestAlgorithm, including the messageDigest attribute.
+
   @param[in]  Pkcs7        MbedtlsPkcs7.
   @param[in]  TrustCert    CA cert.
   @param[in]  Data         Pointer for data.
@@ -886,160 +988,223 @@ MbedTlsPkcs7SignedDataVerify (
 {
   MbedtlsPkcs7SignerInfo  *SignerInfo;
   mbedtls_x509_crt        *Cert;
-  mbedtls_x509_crt        *AllCert;
-  BOOLEAN                 Result;
-
-  SignerInfo = &(Pkcs7->SignedData.SignerInfos);
-  Result     = TRUE;
+  mbedtls_md_type_t       MdType;
+  UINT8                   Hash[MBEDTLS_MD_MAX_SIZE];
 
   //
   // Traverse signers and verify each signers
   //
-  while (SignerInfo != NULL) {
-    Result = FALSE;
+  for (SignerInfo = &(Pkcs7->SignedData.SignerInfos); SignerInfo != NULL; SignerInfo = SignerInfo->Next) {
     // 1. Find signers cert
     Cert = MbedTlsPkcs7FindSignerCert (SignerInfo, &(Pkcs7->SignedData.Certificates));
-    if (Cert != NULL) {
-      // 2. Check signer cert is trusted by trustCert
-      if (MbedTlsPkcs7VerifyCert (TrustCert, &(Pkcs7->SignedData.Crls), Cert)) {
-        // root cert verify pass
-        Result = TRUE;
-      } else {
-        if (MbedTlsPkcs7VerifyCertChain (Pkcs7, TrustCert, Cert)) {
-          Result = TRUE;
-        } else {
-          Result = FALSE;
-        }
-      }
-
-      if (Result == TRUE) {
-        // 3. Check signed data
-        AllCert = &(Pkcs7->SignedData.Certificates);
-        while (AllCert != NULL) {
-          if (MbedtlsPkcs7SignedDataVerifySigners (SignerInfo, AllCert, Data, DataLen) == 0) {
-            return TRUE;
-          }
-
-          AllCert = AllCert->next;
-        }
+    if (Cert == NULL) {
+      return FALSE;
+    }
 
-        Result = FALSE;
-      }
+    // 2. Check signer cert is trusted by trustCert
+    if (!MbedTlsPkcs7VerifyCert (TrustCert, &(Pkcs7->SignedData.Crls), Cert) &&
+        !MbedTlsPkcs7VerifyCertChain (Pkcs7, TrustCert, Cert))
+    {
+      return FALSE;
     }
 
-    // move to next
-    SignerInfo = SignerInfo->Next;
+    // 3. Check signed data
+    if (!MbedTlsPkcs7GetSignerMdType (SignerInfo, &MdType) ||
+        (mbedtls_md (mbedtls_md_info_from_type (MdType), Data, DataLen, Hash) != 0) ||
+        !MbedTlsPkcs7VerifySignerHash (SignerInfo, Cert, MdType, Hash))
+    {
+      return FALSE;
+    }
   }
 
-  return Result;
+  return TRUE;
 }
 
 /**
-  Check input P7Data is a wrapped ContentInfo structure or not. If not construct
-  a new structure to wrap P7Data.
+  Check whether input P7Data is a ContentInfo structure, i.e. whether the outer
+  SEQUENCE starts with a contentType OBJECT IDENTIFIER rather than with the
+  version INTEGER of a bare SignedData.
 
   Caution: This function may receive untrusted input.
   UEFI Authenticated Variable is external input, so this function will do basic
   check for PKCS#7 data structure.
 
-  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Data       Pointer to the PKCS#7 message.
   @param[in]  P7Length     Length of the PKCS#7 message in bytes.
-  @param[out] WrapFlag     If TRUE P7Data is a ContentInfo structure, otherwise
-                           return FALSE.
-  @param[out] WrapData     If return status of this function is TRUE:
-                           1) when WrapFlag is TRUE, pointer to P7Data.
-                           2) when WrapFlag is FALSE, pointer to a new ContentInfo
-                           structure. It's caller's responsibility to free this
-                           buffer.
-  @param[out] WrapDataSize Length of ContentInfo structure in bytes.
-
-  @retval     TRUE         The operation is finished successfully.
-  @retval     FALSE        The operation is failed due to lack of resources.
+
+  @retval     TRUE         P7Data is a ContentInfo structure.
+  @retval     FALSE        P7Data is not a ContentInfo structure.
 
 **/
+STATIC
 BOOLEAN
-WrapPkcs7Data (
+MbedTlsPkcs7IsContentInfo (
   IN CONST UINT8  *P7Data,
-  IN UINTN        P7Length,
-  OUT BOOLEAN     *WrapFlag,
-  OUT UINT8       **WrapData,
-  OUT UINTN       *WrapDataSize
+  IN UINTN        P7Length
   )
 {
-  BOOLEAN  Wrapped;
-  UINT8    *SignedData;
+  UINT8  *Ptr;
+  UINT8  *End;
+  UINTN  Len;
+
+  Ptr = (UINT8 *)P7Data;
+  End = Ptr + P7Length;
+
+  if (mbedtls_asn1_get_tag (&Ptr, End, &Len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((Ptr < End) && (*Ptr == MBEDTLS_ASN1_OID));
+}
+
+/**
+  Parses a PKCS#7 signed data as described in "PKCS #7: Cryptographic Message
+  Syntax Standard" into a context that can be shared by the Pkcs7Parsed*()
+  queries. The input signed data could be wrapped in a ContentInfo structure.
+  The signed data is decoded only once, so a caller that needs to
+  verify the signature, retrieve the signers and check EKUs on the same blob
+  should parse it once and issue every query against the returned context.
+
+  If P7Data is NULL, then return NULL. If P7Length overflow, then return NULL.
+
+  Caution: This function may receive untrusted input.
+  UEFI Authenticated Variable is external input, so this function will do basic
+  check for PKCS#7 data structure.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to parse. The buffer
+                           must stay valid and unchanged until the context is
+                           released with Pkcs7ParsedFree().
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+
+  @return  Pointer to the parsed PKCS#7 context, or NULL if P7Data is not a
+           valid PKCS#7 signedData. It's caller's responsibility to release it
+           with Pkcs7ParsedFree().
+
+**/
+VOID *
+EFIAPI
+Pkcs7Parse (
+  IN CONST UINT8  *P7Data,
+  IN UINTN        P7Length
+  )
+{
+  MbedtlsPkcs7Context  *Context;
+  INT32                Ret;
+
+  if ((P7Data == NULL) || (P7Length > INT_MAX)) {
+    return NULL;
+  }
+
+  Context = AllocateZeroPool (sizeof (MbedtlsPkcs7Context));
+  if (Context == NULL) {
+    return NULL;
+  }
+
+  MbedTlsPkcs7Init (&Context->Pkcs7);
 
   //
-  // Check whether input P7Data is a wrapped ContentInfo structure or not.
+  // Parse directly from the caller's buffer. A bare SignedData is parsed as
+  // the content of an implied signedData ContentInfo instead of being copied
+  // behind a synthesized ContentInfo header.
   //
-  Wrapped = FALSE;
-  if ((P7Data[4] == MBEDTLS_ASN1_OID) && (P7Data[5] == sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1)) {
-    if (CompareMem (P7Data + 6, MBEDTLS_OID_PKCS7_SIGNED_DATA, sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1) == 0) {
-      if ((P7Data[15] == (MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC)) && (P7Data[16] == 0x82)) {
-        Wrapped = TRUE;
-      }
-    }
+  if (MbedTlsPkcs7IsContentInfo (P7Data, P7Length)) {
+    Ret = MbedtlsPkcs7ParseDer (P7Data, (INTN)P7Length, &Context->Pkcs7);
+  } else {
+    Context->Pkcs7.ContentTypeOid.tag = MBEDTLS_ASN1_OID;
+    Context->Pkcs7.ContentTypeOid.len = sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1;
+    Context->Pkcs7.ContentTypeOid.p   = (UINT8 *)MBEDTLS_OID_PKCS7_SIGNED_DATA;
+
+    Ret = Pkcs7GetSignedData ((UINT8 *)P7Data, (INTN)P7Length, &Context->Pkcs7.SignedData);
   }
 
-  if (Wrapped) {
-    *WrapData     = (UINT8 *)P7Data;
-    *WrapDataSize = P7Length;
-  } else {
-    //
-    // Wrap PKCS#7 signeddata to a ContentInfo structure - add a header in 19 bytes.
-    //
-    *WrapDataSize = P7Length + 19;
-    *WrapData     = AllocateZeroPool (*WrapDataSize);
-    if (*WrapData == NULL) {
-      *WrapFlag = Wrapped;
-      return FALSE;
-    }
+  if (Ret != 0) {
+    Pkcs7ParsedFree (Context);
+    return NULL;
+  }
 
-    SignedData = *WrapData;
+  return Context;
+}
 
-    //
-    // Part1: 0x30, 0x82.
-    //
-    SignedData[0] = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
-    SignedData[1] = 0x82;
+/**
+  Release the PKCS#7 context returned by Pkcs7Parse().
 
-    //
-    // Part2: Length1 = P7Length + 19 - 4, in big endian.
-    //
-    SignedData[2] = (UINT8)(((UINT16)(*WrapDataSize - 4)) >> 8);
-    SignedData[3] = (UINT8)(((UINT16)(*WrapDataSize - 4)) & 0xff);
+  If Pkcs7Context is NULL, then do nothing.
 
-    //
-    // Part3: 0x06, 0x09.
-    //
-    SignedData[4] = MBEDTLS_ASN1_OID;
-    SignedData[5] = sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1;
+  @param[in]  Pkcs7Context  Pointer to the parsed PKCS#7 context to be released.
 
-    //
-    // Part4: OID value -- 0x2A 0x86 0x48 0x86 0xF7 0x0D 0x01 0x07 0x02.
-    //
-    CopyMem (SignedData + 6, MBEDTLS_OID_PKCS7_SIGNED_DATA, sizeof (MBEDTLS_OID_PKCS7_SIGNED_DATA) - 1);
+**/
+VOID
+EFIAPI
+Pkcs7ParsedFree (
+  IN VOID  *Pkcs7Context
+  )
+{
+  MbedtlsPkcs7Context  *Context;
 
-    //
-    // Part5: 0xA0, 0x82.
-    //
-    SignedData[15] = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC;
-    SignedData[16] = 0x82;
+  if (Pkcs7Context == NULL) {
+    return;
+  }
 
-    //
-    // Part6: Length2 = P7Length, in big endian.
-    //
-    SignedData[17] = (UINT8)(((UINT16)P7Length) >> 8);
-    SignedData[18] = (UINT8)(((UINT16)P7Length) & 0xff);
+  Context = (MbedtlsPkcs7Context *)Pkcs7Context;
 
-    //
-    // Part7: P7Data.
-    //
-    CopyMem (SignedData + 19, P7Data, P7Length);
+  mbedtls_x509_crt_free (&Context->Pkcs7.SignedData.Certificates);
+  FreePool (Context);
+}
+
+/**
+  Verifies the validity of a PKCS#7 context returned by Pkcs7Parse().
+
+  If Pkcs7Context, TrustedCert or InData is NULL, then return FALSE.
+  If CertLength or DataLength overflow, then return FALSE.
+
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+  @param[in]  InData       Pointer to the content to be verified.
+  @param[in]  DataLength   Length of InData in bytes.
+
+  @retval  TRUE  The specified PKCS#7 signed data is valid.
+  @retval  FALSE Invalid PKCS#7 signed data.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedVerify (
+  IN VOID         *Pkcs7Context,
+  IN CONST UINT8  *TrustedCert,
+  IN UINTN        CertLength,
+  IN CONST UINT8  *InData,
+  IN UINTN        DataLength
+  )
+{
+  BOOLEAN           Status;
+  mbedtls_x509_crt  Crt;
+
+  //
+  // Check input parameters.
+  //
+  if ((Pkcs7Context == NULL) || (TrustedCert == NULL) || (InData == NULL) ||
+      (CertLength > INT_MAX) || (DataLength > INT_MAX))
+  {
+    return FALSE;
   }
 
-  *WrapFlag = Wrapped;
-  return TRUE;
+  Status = FALSE;
+  mbedtls_x509_crt_init (&Crt);
+
+  if (mbedtls_x509_crt_parse_der (&Crt, TrustedCert, CertLength) == 0) {
+    Status = MbedTlsPkcs7SignedDataVerify (
+               &((MbedtlsPkcs7Context *)Pkcs7Context)->Pkcs7,
+               &Crt,
+               InData,
+               (INT32)DataLength
+               );
+  }
+
+  mbedtls_x509_crt_free (&Crt);
+
+  return Status;
 }
 
 /**
@@ -1075,14 +1240,8 @@ Pkcs7Verify (
   IN UINTN        DataLength
   )
 {
-  BOOLEAN           Status;
-  UINT8             *WrapData;
-  UINTN             WrapDataSize;
-  BOOLEAN           Wrapped;
-  MbedtlsPkcs7      Pkcs7;
-  INT32             Ret;
-  mbedtls_x509_crt  Crt;
-  mbedtls_x509_crt  *TempCrt;
+  VOID     *Pkcs7Context;
+  BOOLEAN  Status;
 
   //
   // Check input parameters.
@@ -1093,38 +1252,14 @@ Pkcs7Verify (
     return FALSE;
   }
 
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &WrapData, &WrapDataSize);
-
-  if (!Status) {
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
     return FALSE;
   }
 
-  Status = FALSE;
-  MbedTlsPkcs7Init (&Pkcs7);
-  mbedtls_x509_crt_init (&Crt);
-
-  Ret = MbedtlsPkcs7ParseDer (WrapData, (INT32)WrapDataSize, &Pkcs7);
-  if (Ret != 0) {
-    goto Cleanup;
-  }
-
-  Ret = mbedtls_x509_crt_parse_der (&Crt, TrustedCert, CertLength);
-  if (Ret != 0) {
-    goto Cleanup;
-  }
-
-  Status = MbedTlsPkcs7SignedDataVerify (&Pkcs7, &Crt, InData, (INT32)DataLength);
-
-Cleanup:
-  if (&Crt != NULL) {
-    mbedtls_x509_crt_free (&Crt);
-  }
-
-  if (Pkcs7.SignedData.Certificates.next != NULL) {
-    TempCrt = Pkcs7.SignedData.Certificates.next;
-    mbedtls_x509_crt_free (TempCrt);
-  }
+  Status = Pkcs7ParsedVerify (Pkcs7Context, TrustedCert, CertLength, InData, DataLength);
 
+  Pkcs7ParsedFree (Pkcs7Context);
   return Status;
 }
 
@@ -1148,20 +1283,13 @@ Pkcs7FreeSigners (
 }
 
 /**
-  Get the signer's certificates from PKCS#7 signed data as described in "PKCS #7:
-  Cryptographic Message Syntax Standard". The input signed data could be wrapped
-  in a ContentInfo structure.
-
-  If P7Data, CertStack, StackLength, TrustedCert or CertLength is NULL, then
-  return FALSE. If P7Length overflow, then return FALSE.
+  Get the signer's certificates from a PKCS#7 context returned by Pkcs7Parse().
 
-  Caution: This function may receive untrusted input.
-  UEFI Authenticated Variable is external input, so this function will do basic
-  check for PKCS#7 data structure.
+  If Pkcs7Context, CertStack, StackLength, TrustedCert or CertLength is NULL,
+  then return FALSE.
 
-  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
-  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
-  @param[out] CertStack    Pointer to Signer's certificates retrieved from P7Data.
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out] CertStack    Pointer to Signer's certificates retrieved from the context.
                            It's caller's responsibility to free the buffer with
                            Pkcs7FreeSigners().
                            This data structure is EFI_CERT_STACK type.
@@ -1177,23 +1305,18 @@ Pkcs7FreeSigners (
 **/
 BOOLEAN
 EFIAPI
-Pkcs7GetSigners (
-  IN CONST UINT8  *P7Data,
-  IN UINTN        P7Length,
-  OUT UINT8       **CertStack,
-  OUT UINTN       *StackLength,
-  OUT UINT8       **TrustedCert,
-  OUT UINTN       *CertLength
+Pkcs7ParsedGetSigners (
+  IN VOID    *Pkcs7Context,
+  OUT UINT8  **CertStack,
+  OUT UINTN  *StackLength,
+  OUT UINT8  **TrustedCert,
+  OUT UINTN  *CertLength
   )
 {
   MbedtlsPkcs7SignerInfo  *SignerInfo;
   mbedtls_x509_crt        *Cert;
-  MbedtlsPkcs7            Pkcs7;
+  MbedtlsPkcs7            *Pkcs7;
   BOOLEAN                 Status;
-  UINT8                   *WrapData;
-  UINTN                   WrapDataSize;
-  BOOLEAN                 Wrapped;
-  mbedtls_x509_crt        *TempCrt;
 
   UINTN  CertSize;
   UINT8  Index;
@@ -1202,29 +1325,19 @@ Pkcs7GetSigners (
   UINTN  BufferSize;
   UINTN  OldSize;
 
-  if ((P7Data == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
-      (TrustedCert == NULL) || (CertLength == NULL) || (P7Length > INT_MAX))
+  if ((Pkcs7Context == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
+      (TrustedCert == NULL) || (CertLength == NULL))
   {
     return FALSE;
   }
 
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &WrapData, &WrapDataSize);
-
-  if (!Status) {
-    return FALSE;
-  }
-
   Status  = FALSE;
   CertBuf = NULL;
   OldBuf  = NULL;
   Cert    = NULL;
 
-  MbedTlsPkcs7Init (&Pkcs7);
-  if (MbedtlsPkcs7ParseDer (WrapData, (INT32)WrapDataSize, &Pkcs7) != 0) {
-    goto _Exit;
-  }
-
-  SignerInfo = &(Pkcs7.SignedData.SignerInfos);
+  Pkcs7      = &((MbedtlsPkcs7Context *)Pkcs7Context)->Pkcs7;
+  SignerInfo = &(Pkcs7->SignedData.SignerInfos);
 
   //
   // Traverse each signers
@@ -1245,7 +1358,7 @@ Pkcs7GetSigners (
 
   while (SignerInfo != NULL) {
     // Find signers cert
-    Cert = MbedTlsPkcs7FindSignerCert (SignerInfo, &(Pkcs7.SignedData.Certificates));
+    Cert = MbedTlsPkcs7FindSignerCert (SignerInfo, &(Pkcs7->SignedData.Certificates));
     if (Cert == NULL) {
       goto _Exit;
     }
@@ -1302,13 +1415,6 @@ _Exit:
     *CertStack = NULL;
   }
 
-  if (Status) {
-    if (Pkcs7.SignedData.Certificates.next != NULL) {
-      TempCrt = Pkcs7.SignedData.Certificates.next;
-      mbedtls_x509_crt_free (TempCrt);
-    }
-  }
-
   if (OldBuf != NULL) {
     FreePool (OldBuf);
   }
@@ -1316,6 +1422,99 @@ _Exit:
   return Status;
 }
 
+/**
+  Get the signer's certificates from PKCS#7 signed data as described in "PKCS #7:
+  Cryptographic Message Syntax Standard". The input signed data could be wrapped
+  in a ContentInfo structure.
+
+  If P7Data, CertStack, StackLength, TrustedCert or CertLength is NULL, then
+  return FALSE. If P7Length overflow, then return FALSE.
+
+  Caution: This function may receive untrusted input.
+  UEFI Authenticated Variable is external input, so this function will do basic
+  check for PKCS#7 data structure.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[out] CertStack    Pointer to Signer's certificates retrieved from P7Data.
+                           It's caller's responsibility to free the buffer with
+                           Pkcs7FreeSigners().
+                           This data structure is EFI_CERT_STACK type.
+  @param[out] StackLength  Length of signer's certificates in bytes.
+  @param[out] TrustedCert  Pointer to a trusted certificate from Signer's certificates.
+                           It's caller's responsibility to free the buffer with
+                           Pkcs7FreeSigners().
+  @param[out] CertLength   Length of the trusted certificate in bytes.
+
+  @retval  TRUE            The operation is finished successfully.
+  @retval  FALSE           Error occurs during the operation.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetSigners (
+  IN CONST UINT8  *P7Data,
+  IN UINTN        P7Length,
+  OUT UINT8       **CertStack,
+  OUT UINTN       *StackLength,
+  OUT UINT8       **TrustedCert,
+  OUT UINTN       *CertLength
+  )
+{
+  VOID     *Pkcs7Context;
+  BOOLEAN  Status;
+
+  if ((P7Data == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
+      (TrustedCert == NULL) || (CertLength == NULL) || (P7Length > INT_MAX))
+  {
+    return FALSE;
+  }
+
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
+    return FALSE;
+  }
+
+  Status = Pkcs7ParsedGetSigners (Pkcs7Context, CertStack, StackLength, TrustedCert, CertLength);
+
+  Pkcs7ParsedFree (Pkcs7Context);
+  return Status;
+}
+
+/**
+  Retrieves all embedded certificates from a PKCS#7 context returned by
+  Pkcs7Parse(), and outputs two certificate lists chained and unchained to the
+  signer's certificates.
+
+  @param[in]  Pkcs7Context      Pointer to the parsed PKCS#7 context.
+  @param[out] SignerChainCerts  Pointer to the certificates list chained to signer's
+                                certificate. It's caller's responsibility to free the buffer
+                                with Pkcs7FreeSigners().
+                                This data structure is EFI_CERT_STACK type.
+  @param[out] ChainLength       Length of the chained certificates list buffer in bytes.
+  @param[out] UnchainCerts      Pointer to the unchained certificates lists. It's caller's
+                                responsibility to free the buffer with Pkcs7FreeSigners().
+                                This data structure is EFI_CERT_STACK type.
+  @param[out] UnchainLength     Length of the unchained certificates list buffer in bytes.
+
+  @retval  TRUE         The operation is finished successfully.
+  @retval  FALSE        Error occurs during the operation.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetCertificatesList (
+  IN VOID    *Pkcs7Context,
+  OUT UINT8  **SignerChainCerts,
+  OUT UINTN  *ChainLength,
+  OUT UINT8  **UnchainCerts,
+  OUT UINTN  *UnchainLength
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
 /**
   Retrieves all embedded certificates from PKCS#7 signed data as described in "PKCS #7:
   Cryptographic Message Syntax Standard", and outputs two certificate lists chained and
@@ -1352,3 +1551,285 @@ Pkcs7GetCertificatesList (
   ASSERT (FALSE);
   return FALSE;
 }
+
+///
+/// State of one signer in a streaming PKCS#7 verification.
+///
+typedef struct MbedtlsPkcs7VerifySigner {
+  MbedtlsPkcs7SignerInfo    *SignerInfo;
+  mbedtls_x509_crt          *SignerCert;
+  mbedtls_md_type_t         MdType;
+  mbedtls_md_context_t      MdCtx;
+} MbedtlsPkcs7VerifySigner;
+
+///
+/// Context of a streaming PKCS#7 verification started by Pkcs7VerifyInit().
+///
+typedef struct MbedtlsPkcs7VerifyContext {
+  MbedtlsPkcs7Context         *Pkcs7Context;
+  UINTN                       SignerCount;
+  MbedtlsPkcs7VerifySigner    *Signers;
+  BOOLEAN                     Finished;
+} MbedtlsPkcs7VerifyContext;
+
+/**
+  Starts an incremental verification of a PKCS#7 signed data with detached
+  content as described in "PKCS #7: Cryptographic Message Syntax Standard".
+  The input signed data could be wrapped in a ContentInfo structure.
+
+  The certificate of every signer is verified against TrustedCert here. The
+  detached content is then fed in chunks with Pkcs7VerifyUpdate() and hashed
+  as it arrives, so it never has to be resident in one buffer, and the
+  signatures are checked by Pkcs7VerifyFinal().
+
+  If P7Data or TrustedCert is NULL, then return NULL.
+  If P7Length or CertLength overflow, then return NULL.
+
+  Caution: This function may receive untrusted input.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify. The buffer
+                           must stay valid and unchanged until the context is
+                           released with Pkcs7VerifyFree().
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+
+  @return  Pointer to the verification context, or NULL if P7Data is not a valid
+           PKCS#7 signedData or its signers are not trusted. It's caller's
+           responsibility to release it with Pkcs7VerifyFree().
+
+**/
+VOID *
+EFIAPI
+Pkcs7VerifyInit (
+  IN CONST UINT8  *P7Data,
+  IN UINTN        P7Length,
+  IN CONST UINT8  *TrustedCert,
+  IN UINTN        CertLength
+  )
+{
+  MbedtlsPkcs7VerifyContext  *VerifyContext;
+  MbedtlsPkcs7VerifySigner   *Signer;
+  MbedtlsPkcs7               *Pkcs7;
+  MbedtlsPkcs7SignerInfo     *SignerInfo;
+  mbedtls_x509_crt           Crt;
+  CONST mbedtls_md_info_t    *MdInfo;
+  UINTN                      Index;
+
+  if ((P7Data == NULL) || (TrustedCert == NULL) ||
+      (P7Length > INT_MAX) || (CertLength > INT_MAX))
+  {
+    return NULL;
+  }
+
+  VerifyContext = AllocateZeroPool (sizeof (MbedtlsPkcs7VerifyContext));
+  if (VerifyContext == NULL) {
+    return NULL;
+  }
+
+  VerifyContext->Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (VerifyContext->Pkcs7Context == NULL) {
+    goto Error;
+  }
+
+  Pkcs7 = &VerifyContext->Pkcs7Context->Pkcs7;
+
+  for (SignerInfo = &(Pkcs7->SignedData.SignerInfos); SignerInfo != NULL; SignerInfo = SignerInfo->Next) {
+    VerifyContext->SignerCount++;
+  }
+
+  VerifyContext->Signers = AllocateZeroPool (VerifyContext->SignerCount * sizeof (MbedtlsPkcs7VerifySigner));
+  if (VerifyContext->Signers == NULL) {
+    VerifyContext->SignerCount = 0;
+    goto Error;
+  }
+
+  for (Index = 0; Index < VerifyContext->SignerCount; Index++) {
+    mbedtls_md_init (&VerifyContext->Signers[Index].MdCtx);
+  }
+
+  //
+  // As with the OpenSSL backend, every signer must chain to the trusted
+  // certificate, and each one hashes the content with its own digestAlgorithm.
+  //
+  mbedtls_x509_crt_init (&Crt);
+  if (mbedtls_x509_crt_parse_der (&Crt, TrustedCert, CertLength) != 0) {
+    mbedtls_x509_crt_free (&Crt);
+    goto Error;
+  }
+
+  SignerInfo = &(Pkcs7->SignedData.SignerInfos);
+  for (Index = 0; Index < VerifyContext->SignerCount; Index++) {
+    Signer             = &VerifyContext->Signers[Index];
+    Signer->SignerInfo = SignerInfo;
+    Signer->SignerCert = MbedTlsPkcs7FindSignerCert (SignerInfo, &(Pkcs7->SignedData.Certificates));
+    if ((Signer->SignerCert == NULL) ||
+        !(MbedTlsPkcs7VerifyCert (&Crt, &(Pkcs7->SignedData.Crls), Signer->SignerCert) ||
+          MbedTlsPkcs7VerifyCertChain (Pkcs7, &Crt, Signer->SignerCert)))
+    {
+      break;
+    }
+
+    if (!MbedTlsPkcs7GetSignerMdType (SignerInfo, &Signer->MdType)) {
+      break;
+    }
+
+    MdInfo = mbedtls_md_info_from_type (Signer->MdType);
+    if ((mbedtls_md_setup (&Signer->MdCtx, MdInfo, 0) != 0) ||
+        (mbedtls_md_starts (&Signer->MdCtx) != 0))
+    {
+      break;
+    }
+
+    SignerInfo = SignerInfo->Next;
+  }
+
+  mbedtls_x509_crt_free (&Crt);
+
+  if (Index != VerifyContext->SignerCount) {
+    goto Error;
+  }
+
+  return VerifyContext;
+
+Error:
+  Pkcs7VerifyFree (VerifyContext);
+  return NULL;
+}
+
+/**
+  Hashes the next chunk of the detached content into a verification context
+  returned by Pkcs7VerifyInit().
+
+  If Pkcs7VerifyContext is NULL, then return FALSE.
+  If Data is NULL and DataSize is not zero, then return FALSE.
+  If Pkcs7VerifyFinal() was already called on the context, then return FALSE.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+  @param[in]  Data                Pointer to the next chunk of content.
+  @param[in]  DataSize            Size of Data in bytes.
+
+  @retval  TRUE   The content chunk was hashed.
+  @retval  FALSE  The content chunk could not be hashed.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyUpdate (
+  IN VOID        *Pkcs7VerifyContext,
+  IN CONST VOID  *Data,
+  IN UINTN       DataSize
+  )
+{
+  MbedtlsPkcs7VerifyContext  *VerifyContext;
+  UINTN                      Index;
+
+  if ((Pkcs7VerifyContext == NULL) || ((Data == NULL) && (DataSize != 0))) {
+    return FALSE;
+  }
+
+  VerifyContext = (MbedtlsPkcs7VerifyContext *)Pkcs7VerifyContext;
+  if (VerifyContext->Finished) {
+    return FALSE;
+  }
+
+  if (DataSize == 0) {
+    return TRUE;
+  }
+
+  for (Index = 0; Index < VerifyContext->SignerCount; Index++) {
+    if (mbedtls_md_update (&VerifyContext->Signers[Index].MdCtx, Data, DataSize) != 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Completes the verification started by Pkcs7VerifyInit(): checks the signed
+  attributes message digest against the hashed content, and the signature of
+  every signer.
+
+  The context is not released; call Pkcs7VerifyFree() afterwards.
+
+  If Pkcs7VerifyContext is NULL, then return FALSE.
+  If Pkcs7VerifyFinal() was already called on the context, then return FALSE.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+
+  @retval  TRUE  The specified PKCS#7 signed data is valid for the content.
+  @retval  FALSE Invalid PKCS#7 signed data.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyFinal (
+  IN VOID  *Pkcs7VerifyContext
+  )
+{
+  MbedtlsPkcs7VerifyContext  *VerifyContext;
+  MbedtlsPkcs7VerifySigner   *Signer;
+  UINT8                      Hash[MBEDTLS_MD_MAX_SIZE];
+  UINTN                      Index;
+
+  if (Pkcs7VerifyContext == NULL) {
+    return FALSE;
+  }
+
+  VerifyContext = (MbedtlsPkcs7VerifyContext *)Pkcs7VerifyContext;
+  if (VerifyContext->Finished || (VerifyContext->SignerCount == 0)) {
+    return FALSE;
+  }
+
+  //
+  // The digests are finished below, so the context cannot be finalized twice.
+  //
+  VerifyContext->Finished = TRUE;
+
+  for (Index = 0; Index < VerifyContext->SignerCount; Index++) {
+    Signer = &VerifyContext->Signers[Index];
+    if ((mbedtls_md_finish (&Signer->MdCtx, Hash) != 0) ||
+        !MbedTlsPkcs7VerifySignerHash (Signer->SignerInfo, Signer->SignerCert, Signer->MdType, Hash))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Release the verification context returned by Pkcs7VerifyInit().
+
+  If Pkcs7VerifyContext is NULL, then do nothing.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context to be released.
+
+**/
+VOID
+EFIAPI
+Pkcs7VerifyFree (
+  IN VOID  *Pkcs7VerifyContext
+  )
+{
+  MbedtlsPkcs7VerifyContext  *VerifyContext;
+  UINTN                      Index;
+
+  if (Pkcs7VerifyContext == NULL) {
+    return;
+  }
+
+  VerifyContext = (MbedtlsPkcs7VerifyContext *)Pkcs7VerifyContext;
+  for (Index = 0; Index < VerifyContext->SignerCount; Index++) {
+    mbedtls_md_free (&VerifyContext->Signers[Index].MdCtx);
+  }
+
+  if (VerifyContext->Signers != NULL) {
+    FreePool (VerifyContext->Signers);
+  }
+
+  Pkcs7ParsedFree (VerifyContext->Pkcs7Context);
+  FreePool (VerifyContext);
+}
@@ -10,20 +10,12 @@
 **/
 
 #include <Base.h>
-#include "InternalCryptLib.h"
+#include "CryptPkcs7Internal.h"
 #include <mbedtls/pkcs7.h>
 #include <mbedtls/asn1write.h>
 
 GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  EkuOID[] = { 0x55, 0x1D, 0x25 };
 
-/*leaf Cert basic_constraints case1: CA: false and CA object is excluded */
-GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  gBasicConstraintsCase1[] = { 0x30, 0x00 };
-
-/*leaf Cert basic_constraints case2: CA: false */
-GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  gBasicConstraintsCase2[] = { 0x30, 0x06, 0x01, 0x01, 0xFF, 0x02, 0x01, 0x00 };
-
-GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  gOidBasicConstraints[] = { 0x55, 0x1D, 0x13 };
-
 /**
   Find first Extension data match with given OID
 
@@ -378,98 +370,6 @@ GetOidFromTxt (
   *OidLen = OidIndex;
 }
 
-/**
-  Verify the Cert is signer cert
-
-  @param[in]  Start        Pointer to the DER-encoded certificate data Start.
-  @param[in]  End          Pointer to the DER-encoded certificate data End.
-
-  @retval  true            verify pass
-  @retval  false           verify fail
-**/
-STATIC
-BOOLEAN
-IsCertSignerCert (
-  UINT8  *Start,
-  UINT8  *End
-  )
-{
-  BOOLEAN           Status;
-  UINT8             *Buffer;
-  UINTN             Len;
-  mbedtls_x509_crt  Cert;
-  UINTN             ObjLen;
-
-  mbedtls_x509_crt_init (&Cert);
-
-  ObjLen = End - Start;
-
-  if (mbedtls_x509_crt_parse_der (&Cert, Start, ObjLen) != 0) {
-    return FALSE;
-  }
-
-  Len    = 0;
-  Buffer = NULL;
-  Status = GetExtensionData (
-             &Cert,
-             (CONST UINT8 *)gOidBasicConstraints,
-             sizeof (gOidBasicConstraints),
-             NULL,
-             &Len
-             );
-  if (Len == 0) {
-    /* basic constraints is not present in Cert */
-    return TRUE;
-  }
-
-  Buffer = AllocateZeroPool (Len);
-  if (Buffer == NULL) {
-    return FALSE;
-  }
-
-  Status = GetExtensionData (
-             &Cert,
-             (CONST UINT8 *)gOidBasicConstraints,
-             sizeof (gOidBasicConstraints),
-             Buffer,
-             &Len
-             );
-
-  if (Len == 0) {
-    /* basic constraints is not present in Cert */
-    Status = TRUE;
-    goto Exit;
-  } else if (!Status) {
-    Status = FALSE;
-    goto Exit;
-  }
-
-  if ((Len == sizeof (gBasicConstraintsCase1)) &&
-      (!CompareMem (Buffer, gBasicConstraintsCase1, sizeof (gBasicConstraintsCase1))))
-  {
-    Status = TRUE;
-    goto Exit;
-  }
-
-  if ((Len == sizeof (gBasicConstraintsCase2)) &&
-      (!CompareMem (Buffer, gBasicConstraintsCase2, sizeof (gBasicConstraintsCase2))))
-  {
-    Status = TRUE;
-    goto Exit;
-  }
-
-  Status = FALSE;
-
-Exit:
-  mbedtls_x509_crt_free (&Cert);
-
-  if (Buffer != NULL) {
-    FreePool (Buffer);
-  }
-
-  return Status;
-}
-
 /**
   Determines if the specified EKUs are present in a signing certificate.
 
@@ -546,6 +446,64 @@ Exit:
   return Status;
 }
 
+/**
+  This function receives a PKCS#7 context returned by Pkcs7Parse(), and looks
+  for all the required EKUs in the leaf signer. The leaf signer is the
+  certificate matching the issuer and serial number of the SignerInfo, so no
+  further decoding of the signature blob is needed.
+
+  Note that this function does not validate the certificate chain.
+  That needs to be done before using this function.
+
+  @param[in]  Pkcs7Context         Pointer to the parsed PKCS#7 context.
+  @param[in]  RequiredEKUs         Array of null-terminated strings listing OIDs of
+                                   required EKUs that must be present in the signature.
+  @param[in]  RequiredEKUsSize     Number of elements in the RequiredEKUs string array.
+  @param[in]  RequireAllPresent    If this is TRUE, then all of the specified EKU's
+                                   must be present in the leaf signer.  If it is
+                                   FALSE, then we will succeed if we find any
+                                   of the specified EKU's.
+
+  @retval EFI_SUCCESS              The required EKUs were found in the signature.
+  @retval EFI_INVALID_PARAMETER    A parameter was invalid.
+  @retval EFI_NOT_FOUND            One or more EKU's were not found in the signature.
+
+**/
+EFI_STATUS
+EFIAPI
+Pkcs7ParsedVerifyEKUs (
+  IN VOID          *Pkcs7Context,
+  IN CONST CHAR8   *RequiredEKUs[],
+  IN CONST UINT32  RequiredEKUsSize,
+  IN BOOLEAN       RequireAllPresent
+  )
+{
+  MbedtlsPkcs7      *Pkcs7;
+  mbedtls_x509_crt  *SignerCert;
+
+  //
+  // Check input parameter.
+  //
+  if ((Pkcs7Context     == NULL) ||
+      (RequiredEKUs     == NULL) ||
+      (RequiredEKUsSize == 0))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (RequiredEKUsSize == 1) {
+    RequireAllPresent = TRUE;
+  }
+
+  Pkcs7      = &((MbedtlsPkcs7Context *)Pkcs7Context)->Pkcs7;
+  SignerCert = MbedTlsPkcs7FindSignerCert (&Pkcs7->SignedData.SignerInfos, &Pkcs7->SignedData.Certificates);
+  if (SignerCert == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  return CheckEKUs (SignerCert, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
+}
+
 /**
   This function receives a PKCS#7 formatted signature blob,
   looks for the EKU SEQUENCE blob, and if found then looks
@@ -586,103 +544,30 @@ VerifyEKUsInPkcs7Signature (
   IN BOOLEAN       RequireAllPresent
   )
 {
-  EFI_STATUS        Status;
-  mbedtls_x509_crt  Cert;
-  UINT8             *Ptr;
-  UINT8             *End;
-  INT32             Len;
-  UINTN             ObjLen;
-  UINT8             *OldEnd;
+  EFI_STATUS  Status;
+  VOID        *Pkcs7Context;
 
   //
-  // Check input parameter.
+  // Validate the input parameters.
   //
-  if ((RequiredEKUs == NULL) || (Pkcs7Signature == NULL)) {
-    Status = EFI_INVALID_PARAMETER;
-    return Status;
-  }
-
-  mbedtls_x509_crt_init (&Cert);
-
-  Ptr = (UINT8 *)(UINTN)Pkcs7Signature;
-  Len = (UINT32)SignatureSize;
-  End = Ptr + Len;
-
-  // Cert
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
-    return FALSE;
-  }
-
-  // tbscert
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_INTEGER) != 0) {
-    return FALSE;
-  }
-
-  Ptr += ObjLen;
-  // signature algo
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET) != 0) {
-    return FALSE;
-  }
-
-  Ptr += ObjLen;
-  // signature
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
-    return FALSE;
-  }
-
-  Ptr   += ObjLen;
-  OldEnd = Ptr;
-  // Cert
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_CONTEXT_SPECIFIC) != 0) {
-    return FALSE;
-  }
-
-  End = Ptr + ObjLen;
-
-  // leaf Cert
-  if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
-    return FALSE;
-  }
-
-  Ptr += ObjLen;
-
-  while ((Ptr != End) && (Ptr < End)) {
-    if (IsCertSignerCert (OldEnd, Ptr)) {
-      break;
-    }
-
-    OldEnd = Ptr;
-    if (mbedtls_asn1_get_tag (&Ptr, End, &ObjLen, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0) {
-      return FALSE;
-    }
-
-    Ptr += ObjLen;
-  }
-
-  if (Ptr != End) {
-    return FALSE;
-  } else {
-    Ptr = End - ObjLen;
-  }
-
-  // leaf Cert
-  ObjLen += Ptr - OldEnd;
-  Ptr     = OldEnd;
-
-  if (mbedtls_x509_crt_parse_der (&Cert, Ptr, ObjLen) != 0) {
-    return FALSE;
+  if ((Pkcs7Signature   == NULL) ||
+      (SignatureSize    == 0) ||
+      (RequiredEKUs     == NULL) ||
+      (RequiredEKUsSize == 0))
+  {
+    return EFI_INVALID_PARAMETER;
   }
 
-  Status = CheckEKUs (&Cert, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
-  if (Status != EFI_SUCCESS) {
-    goto Exit;
+  Pkcs7Context = Pkcs7Parse (Pkcs7Signature, SignatureSize);
+  if (Pkcs7Context == NULL) {
+    //
+    // Fail to read PKCS7 data.
+    //
+    return EFI_INVALID_PARAMETER;
   }
 
-Exit:
-  //
-  // Release Resources
-  //
-  mbedtls_x509_crt_free (&Cert);
+  Status = Pkcs7ParsedVerifyEKUs (Pkcs7Context, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
 
+  Pkcs7ParsedFree (Pkcs7Context);
   return Status;
 }
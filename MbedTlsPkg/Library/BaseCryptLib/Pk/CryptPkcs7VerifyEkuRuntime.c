@@ -54,3 +54,34 @@ VerifyEKUsInPkcs7Signature (
   ASSERT (FALSE);
   return RETURN_UNSUPPORTED;
 }
+
+/**
+  This function receives a PKCS#7 context returned by Pkcs7Parse(), and looks
+  for all the required EKUs in the leaf signer.
+
+  Return RETURN_UNSUPPORTED to indicate this interface is not supported.
+
+  @param[in]  Pkcs7Context          Pointer to the parsed PKCS#7 context.
+  @param[in]  RequiredEKUs          Array of null-terminated strings listing OIDs of
+                                    required EKUs that must be present in the signature.
+  @param[in]  RequiredEKUsSize      Number of elements in the RequiredEKUs string array.
+  @param[in]  RequireAllPresent     If this is TRUE, then all of the specified EKU's
+                                    must be present in the leaf signer.  If it is
+                                    FALSE, then we will succeed if we find any
+                                    of the specified EKU's.
+
+  @retval RETURN_UNSUPPORTED        The operation is not supported.
+
+**/
+EFI_STATUS
+EFIAPI
+Pkcs7ParsedVerifyEKUs (
+  IN VOID          *Pkcs7Context,
+  IN CONST CHAR8   *RequiredEKUs[],
+  IN CONST UINT32  RequiredEKUsSize,
+  IN BOOLEAN       RequireAllPresent
+  )
+{
+  ASSERT (FALSE);
+  return RETURN_UNSUPPORTED;
+}
@@ -36,3 +36,55 @@ Pkcs7GetAttachedContent (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Extracts the attached content from a PKCS#7 context returned by Pkcs7Parse()
+  if existed.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out]  Content      Pointer to the extracted content from the PKCS#7 signedData.
+                            It's caller's responsibility to free the buffer with FreePool().
+  @param[out]  ContentSize  The size of the extracted content in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetAttachedContent (
+  IN  VOID   *Pkcs7Context,
+  OUT VOID   **Content,
+  OUT UINTN  *ContentSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Locates the attached content of a PKCS#7 signed data without copying it.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   P7Data       Pointer to the PKCS#7 signed data to process.
+  @param[in]   P7Length     Length of the PKCS#7 signed data in bytes.
+  @param[out]  Content      Pointer to the attached content inside P7Data.
+  @param[out]  ContentSize  The size of the attached content in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetAttachedContentInPlace (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  OUT CONST UINT8  **Content,
+  OUT UINTN        *ContentSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
@@ -63,6 +63,7 @@ CryptoInit (
   CryptoProtocol->HmacSha256Update    = HmacSha256Update;
   CryptoProtocol->HmacSha256Final     = HmacSha256Final;
   CryptoProtocol->HmacSha256All       = HmacSha256All;
+  CryptoProtocol->HmacSha256AllSg     = HmacSha256AllSg;
 
   //
   // Initialize HMAC-SHA384 function pointers
@@ -74,6 +75,7 @@ CryptoInit (
   CryptoProtocol->HmacSha384Update    = HmacSha384Update;
   CryptoProtocol->HmacSha384Final     = HmacSha384Final;
   CryptoProtocol->HmacSha384All       = HmacSha384All;
+  CryptoProtocol->HmacSha384AllSg     = HmacSha384AllSg;
 
   //
   // Initialize the Big Num function pointers
@@ -107,12 +109,31 @@ CryptoInit (
   //
   // AES functions
   //
-  CryptoProtocol->AeadAesGcmEncrypt = AeadAesGcmEncrypt;
-  CryptoProtocol->AeadAesGcmDecrypt = AeadAesGcmDecrypt;
-  CryptoProtocol->AesGetContextSize = AesGetContextSize;
-  CryptoProtocol->AesInit           = AesInit;
-  CryptoProtocol->AesCbcEncrypt     = AesCbcEncrypt;
-  CryptoProtocol->AesCbcDecrypt     = AesCbcDecrypt;
+  CryptoProtocol->AeadAesGcmEncrypt           = AeadAesGcmEncrypt;
+  CryptoProtocol->AeadAesGcmDecrypt           = AeadAesGcmDecrypt;
+  CryptoProtocol->AeadAesGcmNew               = AeadAesGcmNew;
+  CryptoProtocol->AeadAesGcmFree              = AeadAesGcmFree;
+  CryptoProtocol->AeadAesGcmInit              = AeadAesGcmInit;
+  CryptoProtocol->AeadAesGcmUpdateAad         = AeadAesGcmUpdateAad;
+  CryptoProtocol->AeadAesGcmUpdate            = AeadAesGcmUpdate;
+  CryptoProtocol->AeadAesGcmEncryptFinal      = AeadAesGcmEncryptFinal;
+  CryptoProtocol->AeadAesGcmDecryptFinal      = AeadAesGcmDecryptFinal;
+  CryptoProtocol->AeadChaCha20Poly1305Encrypt = AeadChaCha20Poly1305Encrypt;
+  CryptoProtocol->AeadChaCha20Poly1305Decrypt = AeadChaCha20Poly1305Decrypt;
+  CryptoProtocol->AesGetContextSize           = AesGetContextSize;
+  CryptoProtocol->AesInit                     = AesInit;
+  CryptoProtocol->AesCbcEncrypt               = AesCbcEncrypt;
+  CryptoProtocol->AesCbcDecrypt               = AesCbcDecrypt;
+  CryptoProtocol->AesCtrNew                   = AesCtrNew;
+  CryptoProtocol->AesCtrFree                  = AesCtrFree;
+  CryptoProtocol->AesCtrInit                  = AesCtrInit;
+  CryptoProtocol->AesCtrUpdate                = AesCtrUpdate;
+  CryptoProtocol->AesXtsNew                   = AesXtsNew;
+  CryptoProtocol->AesXtsFree                  = AesXtsFree;
+  CryptoProtocol->AesXtsEncrypt               = AesXtsEncrypt;
+  CryptoProtocol->AesXtsDecrypt               = AesXtsDecrypt;
+  CryptoProtocol->AesXtsEncryptSectors        = AesXtsEncryptSectors;
+  CryptoProtocol->AesXtsDecryptSectors        = AesXtsDecryptSectors;
 
   CryptoProtocol->Md5GetContextSize = Md5GetContextSize;
   CryptoProtocol->Md5Init           = Md5Init;
@@ -134,6 +155,7 @@ CryptoInit (
   CryptoProtocol->Sha256Final          = Sha256Final;
   CryptoProtocol->Sha256Duplicate      = Sha256Duplicate;
   CryptoProtocol->Sha256HashAll        = Sha256HashAll;
+  CryptoProtocol->Sha256HashAllSg      = Sha256HashAllSg;
 
   CryptoProtocol->Sha384GetContextSize = Sha384GetContextSize;
   CryptoProtocol->Sha384Init           = Sha384Init;
@@ -141,6 +163,7 @@ CryptoInit (
   CryptoProtocol->Sha384Final          = Sha384Final;
   CryptoProtocol->Sha384Duplicate      = Sha384Duplicate;
   CryptoProtocol->Sha384HashAll        = Sha384HashAll;
+  CryptoProtocol->Sha384HashAllSg      = Sha384HashAllSg;
 
   CryptoProtocol->Sha512GetContextSize = Sha512GetContextSize;
   CryptoProtocol->Sha512Init           = Sha512Init;
@@ -148,6 +171,7 @@ CryptoInit (
   CryptoProtocol->Sha512Final          = Sha512Final;
   CryptoProtocol->Sha512Duplicate      = Sha512Duplicate;
   CryptoProtocol->Sha512HashAll        = Sha512HashAll;
+  CryptoProtocol->Sha512HashAllSg      = Sha512HashAllSg;
 
   //
   // SM3 Hash functions
@@ -159,6 +183,13 @@ CryptoInit (
   CryptoProtocol->Sm3Duplicate      = Sm3Duplicate;
   CryptoProtocol->Sm3HashAll        = Sm3HashAll;
 
+  //
+  // Multi-algorithm Hash functions
+  //
+  CryptoProtocol->HashAllMulti    = HashAllMulti;
+  CryptoProtocol->HashExportState = HashExportState;
+  CryptoProtocol->HashImportState = HashImportState;
+
   // ========================================================================================================
   // Key Derivation Functions
   // ========================================================================================================
@@ -168,30 +199,47 @@ CryptoInit (
   CryptoProtocol->HkdfSha384Expand           = HkdfSha384Expand;
   CryptoProtocol->HkdfSha384Extract          = HkdfSha384Extract;
   CryptoProtocol->HkdfSha384ExtractAndExpand = HkdfSha384ExtractAndExpand;
+  CryptoProtocol->HkdfNew                    = HkdfNew;
+  CryptoProtocol->HkdfExpandLabel            = HkdfExpandLabel;
+  CryptoProtocol->HkdfExpandMany             = HkdfExpandMany;
+  CryptoProtocol->HkdfFree                   = HkdfFree;
 
   // ========================================================================================================
   // Public Key Cryptography
   // ========================================================================================================
-  CryptoProtocol->AuthenticodeVerify         = AuthenticodeVerify;
-  CryptoProtocol->DhNew                      = DhNew;
-  CryptoProtocol->DhFree                     = DhFree;
-  CryptoProtocol->DhGenerateParameter        = DhGenerateParameter;
-  CryptoProtocol->DhSetParameter             = DhSetParameter;
-  CryptoProtocol->DhGenerateKey              = DhGenerateKey;
-  CryptoProtocol->DhComputeKey               = DhComputeKey;
-  CryptoProtocol->Pkcs5HashPassword          = Pkcs5HashPassword;
-  CryptoProtocol->Pkcs1v2Encrypt             = Pkcs1v2Encrypt;
-  CryptoProtocol->Pkcs1v2Decrypt             = Pkcs1v2Decrypt;
-  CryptoProtocol->RsaOaepEncrypt             = RsaOaepEncrypt;
-  CryptoProtocol->RsaOaepDecrypt             = RsaOaepDecrypt;
-  CryptoProtocol->Pkcs7GetSigners            = Pkcs7GetSigners;
-  CryptoProtocol->Pkcs7FreeSigners           = Pkcs7FreeSigners;
-  CryptoProtocol->Pkcs7GetCertificatesList   = Pkcs7GetCertificatesList;
-  CryptoProtocol->Pkcs7Verify                = Pkcs7Verify;
-  CryptoProtocol->Pkcs7Sign                  = Pkcs7Sign;
-  CryptoProtocol->Pkcs7Encrypt               = Pkcs7Encrypt;
-  CryptoProtocol->VerifyEKUsInPkcs7Signature = VerifyEKUsInPkcs7Signature;
-  CryptoProtocol->Pkcs7GetAttachedContent    = Pkcs7GetAttachedContent;
+  CryptoProtocol->AuthenticodeVerify             = AuthenticodeVerify;
+  CryptoProtocol->AuthenticodeHashImage          = AuthenticodeHashImage;
+  CryptoProtocol->DhNew                          = DhNew;
+  CryptoProtocol->DhFree                         = DhFree;
+  CryptoProtocol->DhGenerateParameter            = DhGenerateParameter;
+  CryptoProtocol->DhSetParameter                 = DhSetParameter;
+  CryptoProtocol->DhGenerateKey                  = DhGenerateKey;
+  CryptoProtocol->DhComputeKey                   = DhComputeKey;
+  CryptoProtocol->Pkcs5HashPassword              = Pkcs5HashPassword;
+  CryptoProtocol->Pkcs1v2Encrypt                 = Pkcs1v2Encrypt;
+  CryptoProtocol->Pkcs1v2Decrypt                 = Pkcs1v2Decrypt;
+  CryptoProtocol->RsaOaepEncrypt                 = RsaOaepEncrypt;
+  CryptoProtocol->RsaOaepDecrypt                 = RsaOaepDecrypt;
+  CryptoProtocol->Pkcs7GetSigners                = Pkcs7GetSigners;
+  CryptoProtocol->Pkcs7FreeSigners               = Pkcs7FreeSigners;
+  CryptoProtocol->Pkcs7GetCertificatesList       = Pkcs7GetCertificatesList;
+  CryptoProtocol->Pkcs7Verify                    = Pkcs7Verify;
+  CryptoProtocol->Pkcs7Sign                      = Pkcs7Sign;
+  CryptoProtocol->Pkcs7Encrypt                   = Pkcs7Encrypt;
+  CryptoProtocol->VerifyEKUsInPkcs7Signature     = VerifyEKUsInPkcs7Signature;
+  CryptoProtocol->Pkcs7GetAttachedContent        = Pkcs7GetAttachedContent;
+  CryptoProtocol->Pkcs7GetAttachedContentInPlace = Pkcs7GetAttachedContentInPlace;
+  CryptoProtocol->Pkcs7Parse                     = Pkcs7Parse;
+  CryptoProtocol->Pkcs7ParsedFree                = Pkcs7ParsedFree;
+  CryptoProtocol->Pkcs7ParsedVerify              = Pkcs7ParsedVerify;
+  CryptoProtocol->Pkcs7ParsedGetSigners          = Pkcs7ParsedGetSigners;
+  CryptoProtocol->Pkcs7ParsedGetCertificatesList = Pkcs7ParsedGetCertificatesList;
+  CryptoProtocol->Pkcs7ParsedVerifyEKUs          = Pkcs7ParsedVerifyEKUs;
+  CryptoProtocol->Pkcs7ParsedGetAttachedContent  = Pkcs7ParsedGetAttachedContent;
+  CryptoProtocol->Pkcs7VerifyInit                = Pkcs7VerifyInit;
+  CryptoProtocol->Pkcs7VerifyUpdate              = Pkcs7VerifyUpdate;
+  CryptoProtocol->Pkcs7VerifyFinal               = Pkcs7VerifyFinal;
+  CryptoProtocol->Pkcs7VerifyFree                = Pkcs7VerifyFree;
 
   // ========================================================================================================
   // Basic Elliptic Curve Primitives
@@ -219,6 +267,8 @@ CryptoInit (
   CryptoProtocol->EcNewByNid             = EcNewByNid;
   CryptoProtocol->EcFree                 = EcFree;
   CryptoProtocol->EcGenerateKey          = EcGenerateKey;
+  CryptoProtocol->EcRefillKeyPool        = EcRefillKeyPool;
+  CryptoProtocol->EcFreeKeyPool          = EcFreeKeyPool;
   CryptoProtocol->EcGetPubKey            = EcGetPubKey;
   CryptoProtocol->EcDhComputeKey         = EcDhComputeKey;
   CryptoProtocol->EcGetPrivateKeyFromPem = EcGetPrivateKeyFromPem;
@@ -282,6 +332,8 @@ CryptoInit (
   CryptoProtocol->TlsInitialize              = TlsInitialize;
   CryptoProtocol->TlsCtxFree                 = TlsCtxFree;
   CryptoProtocol->TlsCtxNew                  = TlsCtxNew;
+  CryptoProtocol->TlsCaStoreNew              = TlsCaStoreNew;
+  CryptoProtocol->TlsCaStoreFree             = TlsCaStoreFree;
   CryptoProtocol->TlsFree                    = TlsFree;
   CryptoProtocol->TlsNew                     = TlsNew;
   CryptoProtocol->TlsInHandshake             = TlsInHandshake;
@@ -292,27 +344,37 @@ CryptoInit (
   CryptoProtocol->TlsCtrlTrafficIn           = TlsCtrlTrafficIn;
   CryptoProtocol->TlsRead                    = TlsRead;
   CryptoProtocol->TlsWrite                   = TlsWrite;
+  CryptoProtocol->TlsReadDirect              = TlsReadDirect;
+  CryptoProtocol->TlsWriteDirect             = TlsWriteDirect;
   CryptoProtocol->TlsShutdown                = TlsShutdown;
   CryptoProtocol->TlsSetVersion              = TlsSetVersion;
+  CryptoProtocol->TlsSetVersionRange         = TlsSetVersionRange;
   CryptoProtocol->TlsSetConnectionEnd        = TlsSetConnectionEnd;
   CryptoProtocol->TlsSetCipherList           = TlsSetCipherList;
   CryptoProtocol->TlsSetCompressionMethod    = TlsSetCompressionMethod;
   CryptoProtocol->TlsSetVerify               = TlsSetVerify;
   CryptoProtocol->TlsSetVerifyHost           = TlsSetVerifyHost;
   CryptoProtocol->TlsSetSessionId            = TlsSetSessionId;
+  CryptoProtocol->TlsSetSession              = TlsSetSession;
   CryptoProtocol->TlsSetCaCertificate        = TlsSetCaCertificate;
+  CryptoProtocol->TlsCaStoreLoad             = TlsCaStoreLoad;
+  CryptoProtocol->TlsCtxSetCaStore           = TlsCtxSetCaStore;
   CryptoProtocol->TlsSetHostPublicCert       = TlsSetHostPublicCert;
   CryptoProtocol->TlsSetHostPrivateKeyEx     = TlsSetHostPrivateKeyEx;
   CryptoProtocol->TlsSetHostPrivateKey       = TlsSetHostPrivateKey;
   CryptoProtocol->TlsSetCertRevocationList   = TlsSetCertRevocationList;
+  CryptoProtocol->TlsSetOcspStapling         = TlsSetOcspStapling;
+  CryptoProtocol->TlsCtxSetOcspCacheSize     = TlsCtxSetOcspCacheSize;
   CryptoProtocol->TlsSetSignatureAlgoList    = TlsSetSignatureAlgoList;
   CryptoProtocol->TlsSetEcCurve              = TlsSetEcCurve;
+  CryptoProtocol->TlsSetMaxFragmentLength    = TlsSetMaxFragmentLength;
   CryptoProtocol->TlsGetVersion              = TlsGetVersion;
   CryptoProtocol->TlsGetConnectionEnd        = TlsGetConnectionEnd;
   CryptoProtocol->TlsGetCurrentCipher        = TlsGetCurrentCipher;
   CryptoProtocol->TlsGetCurrentCompressionId = TlsGetCurrentCompressionId;
   CryptoProtocol->TlsGetVerify               = TlsGetVerify;
   CryptoProtocol->TlsGetSessionId            = TlsGetSessionId;
+  CryptoProtocol->TlsGetSession              = TlsGetSession;
   CryptoProtocol->TlsGetClientRandom         = TlsGetClientRandom;
   CryptoProtocol->TlsGetServerRandom         = TlsGetServerRandom;
   CryptoProtocol->TlsGetKeyMaterial          = TlsGetKeyMaterial;
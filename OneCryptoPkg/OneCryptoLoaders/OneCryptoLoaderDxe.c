@@ -29,6 +29,8 @@
 #include <Private/OneCryptoDependencySupport.h>
 #include <Guid/OneCryptoFileGuid.h>
 
+#include "OneCryptoLoaderDxeCommon.h"
+
 #define EFI_SECTION_PE32  0x10
 
 //
@@ -397,6 +399,8 @@ DxeEntryPoint (
 
   DEBUG ((DEBUG_INFO, "OneCryptoLoaderDxe: OneCrypto Protocol installed successfully.\n"));
 
+  RegisterKeyPoolCleanup ((ONE_CRYPTO_PROTOCOL *)mOneCryptoProtocol, CryptoSize);
+
   Status = EFI_SUCCESS;
 
 Exit:
@@ -27,6 +27,8 @@
 #include <Protocol/OneCrypto.h>
 #include <Private/OneCryptoDependencySupport.h>
 
+#include "OneCryptoLoaderDxeCommon.h"
+
 //
 // The dependencies of the shared library, must live as long
 // as the shared code is used
@@ -247,6 +249,8 @@ DxeEntryPoint (
     goto Exit;
   }
 
+  RegisterKeyPoolCleanup ((ONE_CRYPTO_PROTOCOL *)OneCryptoProtocol, CryptoSize);
+
   Status = EFI_SUCCESS;
 
 Exit:
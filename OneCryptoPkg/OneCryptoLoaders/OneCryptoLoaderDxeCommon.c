@@ -0,0 +1,85 @@
+/** @file
+  OneCryptoLoaderDxeCommon.c
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  This file contains the code shared by both OneCryptoLoader DXE drivers.
+
+**/
+#include <Uefi.h>
+
+#include <Library/DebugLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Guid/EventGroup.h>
+
+#include "OneCryptoLoaderDxeCommon.h"
+
+//
+// Signalled before ExitBootServices to release the pre-generated key pairs
+//
+STATIC EFI_EVENT  mBeforeExitBootServicesEvent = NULL;
+
+/**
+ * @brief Releases the EC key pairs pre-generated by the crypto binary.
+ *
+ * The key pool of the crypto binary lives in boot services data allocated
+ * through the OneCrypto dependencies. Without this, unused private keys would
+ * be handed to the OS with that memory. Freeing pool memory normally leaves
+ * the memory map unchanged, as the pages stay with the pool allocator.
+ *
+ * @param Event   The event being signalled.
+ * @param Context Pointer to the ONE_CRYPTO_PROTOCOL instance.
+ */
+STATIC
+VOID
+EFIAPI
+OneCryptoBeforeExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  ONE_CRYPTO_PROTOCOL  *Crypto;
+
+  Crypto = (ONE_CRYPTO_PROTOCOL *)Context;
+  if (Crypto->EcFreeKeyPool != NULL) {
+    Crypto->EcFreeKeyPool ();
+  }
+
+  gBS->CloseEvent (Event);
+}
+
+/**
+ * @brief Arranges for the crypto binary's EC key pool to be released before
+ * ExitBootServices.
+ *
+ * A crypto binary whose protocol predates EcFreeKeyPool() has no key pool,
+ * and nothing is registered for it.
+ *
+ * @param Crypto     Pointer to the ONE_CRYPTO_PROTOCOL instance.
+ * @param CryptoSize Size of the ONE_CRYPTO_PROTOCOL instance in bytes.
+ */
+VOID
+RegisterKeyPoolCleanup (
+  IN ONE_CRYPTO_PROTOCOL  *Crypto,
+  IN UINT32               CryptoSize
+  )
+{
+  EFI_STATUS  Status;
+
+  if (CryptoSize < OFFSET_OF (ONE_CRYPTO_PROTOCOL, EcFreeKeyPool) + sizeof (Crypto->EcFreeKeyPool)) {
+    return;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  OneCryptoBeforeExitBootServices,
+                  Crypto,
+                  &gEfiEventBeforeExitBootServicesGuid,
+                  &mBeforeExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "OneCryptoLoaderDxe: Failed to register key pool cleanup: %r\n", Status));
+  }
+}
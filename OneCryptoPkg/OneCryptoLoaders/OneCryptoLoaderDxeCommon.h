@@ -0,0 +1,34 @@
+/** @file
+  Common declarations for the OneCryptoLoader DXE drivers.
+
+  This header declares the shared functions used by both DXE loaders (loading
+  the crypto binary from a firmware volume, and consuming the private
+  constructor protocol).
+
+  Copyright (C) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef ONE_CRYPTO_LOADER_DXE_COMMON_H_
+#define ONE_CRYPTO_LOADER_DXE_COMMON_H_
+
+#include <Uefi.h>
+#include <Protocol/OneCrypto.h>
+
+/**
+  Arranges for the crypto binary's EC key pool to be released before
+  ExitBootServices.
+
+  A crypto binary whose protocol predates EcFreeKeyPool() has no key pool,
+  and nothing is registered for it.
+
+  @param[in]  Crypto      Pointer to the installed ONE_CRYPTO_PROTOCOL instance.
+  @param[in]  CryptoSize  Size of the ONE_CRYPTO_PROTOCOL instance in bytes.
+**/
+VOID
+RegisterKeyPoolCleanup (
+  IN ONE_CRYPTO_PROTOCOL  *Crypto,
+  IN UINT32               CryptoSize
+  );
+
+#endif // ONE_CRYPTO_LOADER_DXE_COMMON_H_
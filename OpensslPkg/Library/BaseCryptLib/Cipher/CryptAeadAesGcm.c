@@ -13,6 +13,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <openssl/aes.h>
 #include <openssl/evp.h>
 
+//
+// EVP takes int lengths, so the streaming API feeds larger buffers in chunks
+// of this many bytes.
+//
+#define AEAD_AES_GCM_CHUNK_SIZE  (INT_MAX & ~0xF)
+
 /**
   Performs AEAD AES-GCM authenticated encryption on a data buffer and additional authenticated data (AAD).
 
@@ -277,3 +283,304 @@ Done:
 
   return RetValue;
 }
+
+/**
+  Allocates and initializes one AES-GCM context for streaming authenticated
+  encryption and decryption.
+
+  The AES key schedule and the GHASH tables are computed once here and reused
+  by every message started with AeadAesGcmInit(), so a caller protecting many
+  records under the same key pays the key setup only once. Use
+  AeadAesGcmFree() to release the context.
+
+  KeySize must be 16, 24 or 32, otherwise NULL is returned.
+
+  @param[in]  Key      Pointer to the encryption key.
+  @param[in]  KeySize  Size of the encryption key in bytes.
+
+  @return  Pointer to the AES-GCM context that has been initialized.
+           If the allocation fails, AeadAesGcmNew() returns NULL.
+
+**/
+VOID *
+EFIAPI
+AeadAesGcmNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  EVP_CIPHER_CTX    *Ctx;
+  CONST EVP_CIPHER  *Cipher;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  switch (KeySize) {
+    case 16:
+      Cipher = EVP_aes_128_gcm ();
+      break;
+    case 24:
+      Cipher = EVP_aes_192_gcm ();
+      break;
+    case 32:
+      Cipher = EVP_aes_256_gcm ();
+      break;
+    default:
+      return NULL;
+  }
+
+  Ctx = EVP_CIPHER_CTX_new ();
+  if (Ctx == NULL) {
+    return NULL;
+  }
+
+  if (!EVP_EncryptInit_ex (Ctx, Cipher, NULL, Key, NULL)) {
+    EVP_CIPHER_CTX_free (Ctx);
+    return NULL;
+  }
+
+  return (VOID *)Ctx;
+}
+
+/**
+  Release the specified AES-GCM context.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context to be released.
+
+**/
+VOID
+EFIAPI
+AeadAesGcmFree (
+  IN  VOID  *AesGcmContext
+  )
+{
+  //
+  // Free OpenSSL cipher context, which also clears the expanded key
+  //
+  EVP_CIPHER_CTX_free ((EVP_CIPHER_CTX *)AesGcmContext);
+}
+
+/**
+  Starts a new AES-GCM message on a context returned by AeadAesGcmNew().
+
+  Any message in progress on the context is abandoned. The key set by
+  AeadAesGcmNew() is kept. The message is then processed with
+  AeadAesGcmUpdateAad(), AeadAesGcmUpdate() and AeadAesGcmEncryptFinal() or
+  AeadAesGcmDecryptFinal().
+
+  IvSize must be 12, otherwise FALSE is returned.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  Iv             Pointer to the IV value.
+  @param[in]  IvSize         Size of the IV value in bytes.
+  @param[in]  Encrypt        TRUE to encrypt the message, FALSE to decrypt it.
+
+  @retval TRUE   The message was started.
+  @retval FALSE  The message could not be started.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmInit (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize,
+  IN  BOOLEAN      Encrypt
+  )
+{
+  EVP_CIPHER_CTX  *Ctx;
+
+  if ((AesGcmContext == NULL) || (Iv == NULL) || (IvSize != 12)) {
+    return FALSE;
+  }
+
+  Ctx = (EVP_CIPHER_CTX *)AesGcmContext;
+  if (!EVP_CIPHER_CTX_ctrl (Ctx, EVP_CTRL_GCM_SET_IVLEN, (INT32)IvSize, NULL)) {
+    return FALSE;
+  }
+
+  //
+  // A NULL key keeps the key schedule already in the context.
+  //
+  return (BOOLEAN)EVP_CipherInit_ex (Ctx, NULL, NULL, NULL, Iv, Encrypt ? 1 : 0);
+}
+
+/**
+  Feeds additional authenticated data (AAD) to the current AES-GCM message.
+
+  This function may be called several times to pass successive parts of the
+  AAD, but all of it must be passed before the first call to
+  AeadAesGcmUpdate().
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]  AData          Pointer to the additional authenticated data (AAD).
+  @param[in]  ADataSize      Size of the additional authenticated data (AAD) in bytes.
+
+  @retval TRUE   The AAD was processed.
+  @retval FALSE  The AAD could not be processed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdateAad (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *AData,
+  IN  UINTN        ADataSize
+  )
+{
+  INT32  TempOutSize;
+  UINTN  ChunkSize;
+
+  if ((AesGcmContext == NULL) || ((AData == NULL) && (ADataSize != 0))) {
+    return FALSE;
+  }
+
+  while (ADataSize > 0) {
+    ChunkSize = MIN (ADataSize, AEAD_AES_GCM_CHUNK_SIZE);
+    if (!EVP_CipherUpdate ((EVP_CIPHER_CTX *)AesGcmContext, NULL, &TempOutSize, AData, (INT32)ChunkSize)) {
+      return FALSE;
+    }
+
+    AData     += ChunkSize;
+    ADataSize -= ChunkSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-GCM message.
+
+  The data may be passed in parts of any size; DataOut receives exactly
+  DataInSize bytes. Payloads larger than INT_MAX are processed in chunks.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context.
+  @param[in]   DataIn         Pointer to the input data buffer.
+  @param[in]   DataInSize     Size of the input data buffer in bytes.
+  @param[out]  DataOut        Pointer to a buffer of DataInSize bytes that
+                              receives the output.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The data could not be processed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmUpdate (
+  IN   VOID         *AesGcmContext,
+  IN   CONST UINT8  *DataIn,
+  IN   UINTN        DataInSize,
+  OUT  UINT8        *DataOut
+  )
+{
+  INT32  TempOutSize;
+  UINTN  ChunkSize;
+
+  if ((AesGcmContext == NULL) || (((DataIn == NULL) || (DataOut == NULL)) && (DataInSize != 0))) {
+    return FALSE;
+  }
+
+  while (DataInSize > 0) {
+    ChunkSize = MIN (DataInSize, AEAD_AES_GCM_CHUNK_SIZE);
+    if (!EVP_CipherUpdate ((EVP_CIPHER_CTX *)AesGcmContext, DataOut, &TempOutSize, DataIn, (INT32)ChunkSize) ||
+        ((UINTN)TempOutSize != ChunkSize))
+    {
+      return FALSE;
+    }
+
+    DataIn     += ChunkSize;
+    DataOut    += ChunkSize;
+    DataInSize -= ChunkSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Completes the current AES-GCM encryption and retrieves the authentication tag.
+
+  TagSize must be 12, 13, 14, 15, 16, otherwise FALSE is returned.
+
+  @param[in]   AesGcmContext  Pointer to the AES-GCM context started for encryption.
+  @param[out]  TagOut         Pointer to a buffer that receives the authentication tag output.
+  @param[in]   TagSize        Size of the authentication tag in bytes.
+
+  @retval TRUE   AEAD AES-GCM authenticated encryption succeeded.
+  @retval FALSE  AEAD AES-GCM authenticated encryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmEncryptFinal (
+  IN   VOID   *AesGcmContext,
+  OUT  UINT8  *TagOut,
+  IN   UINTN  TagSize
+  )
+{
+  EVP_CIPHER_CTX  *Ctx;
+  INT32           TempOutSize;
+
+  if ((AesGcmContext == NULL) || (TagOut == NULL) ||
+      ((TagSize != 12) && (TagSize != 13) && (TagSize != 14) && (TagSize != 15) && (TagSize != 16)))
+  {
+    return FALSE;
+  }
+
+  Ctx = (EVP_CIPHER_CTX *)AesGcmContext;
+  if (!EVP_CIPHER_CTX_is_encrypting (Ctx)) {
+    return FALSE;
+  }
+
+  if (!EVP_EncryptFinal_ex (Ctx, NULL, &TempOutSize)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)EVP_CIPHER_CTX_ctrl (Ctx, EVP_CTRL_GCM_GET_TAG, (INT32)TagSize, (VOID *)TagOut);
+}
+
+/**
+  Completes the current AES-GCM decryption and verifies the authentication tag.
+
+  The plaintext returned by AeadAesGcmUpdate() must not be trusted unless this
+  function returns TRUE.
+
+  TagSize must be 12, 13, 14, 15, 16, otherwise FALSE is returned.
+  If additional authenticated data verification fails, FALSE is returned.
+
+  @param[in]  AesGcmContext  Pointer to the AES-GCM context started for decryption.
+  @param[in]  Tag            Pointer to a buffer that contains the authentication tag.
+  @param[in]  TagSize        Size of the authentication tag in bytes.
+
+  @retval TRUE   AEAD AES-GCM authenticated decryption succeeded.
+  @retval FALSE  AEAD AES-GCM authenticated decryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AeadAesGcmDecryptFinal (
+  IN  VOID         *AesGcmContext,
+  IN  CONST UINT8  *Tag,
+  IN  UINTN        TagSize
+  )
+{
+  EVP_CIPHER_CTX  *Ctx;
+  INT32           TempOutSize;
+
+  if ((AesGcmContext == NULL) || (Tag == NULL) ||
+      ((TagSize != 12) && (TagSize != 13) && (TagSize != 14) && (TagSize != 15) && (TagSize != 16)))
+  {
+    return FALSE;
+  }
+
+  Ctx = (EVP_CIPHER_CTX *)AesGcmContext;
+  if (EVP_CIPHER_CTX_is_encrypting (Ctx)) {
+    return FALSE;
+  }
+
+  if (!EVP_CIPHER_CTX_ctrl (Ctx, EVP_CTRL_GCM_SET_TAG, (INT32)TagSize, (VOID *)Tag)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)EVP_DecryptFinal_ex (Ctx, NULL, &TempOutSize);
+}
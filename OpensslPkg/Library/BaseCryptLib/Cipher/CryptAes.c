@@ -8,6 +8,129 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "InternalCryptLib.h"
 #include <openssl/aes.h>
+#include <openssl/evp.h>
+
+///
+/// AES context initialized by AesInit(). Short inputs run on the encryption
+/// and decryption key schedules expanded here; longer ones go through a
+/// short-lived EVP cipher context keyed from Key.
+///
+typedef struct {
+  AES_KEY    EncryptKey;
+  AES_KEY    DecryptKey;
+  UINT8      Key[32];
+  UINT32     KeySize;
+} OPENSSL_AES_CONTEXT;
+
+///
+/// Smallest CBC input handed to EVP. Below it, setting up the EVP cipher
+/// context costs more than the faster EVP implementation saves, so the key
+/// schedules kept in the AES context are used directly.
+///
+#define AES_CBC_EVP_MIN_SIZE  (4 * AES_BLOCK_SIZE)
+
+///
+/// Largest part of a stream handed to EVP in one call, kept a multiple of the
+/// block size.
+///
+#define AES_STREAM_CHUNK_SIZE  (INT_MAX & ~(AES_BLOCK_SIZE - 1))
+
+///
+/// AES-XTS context returned by AesXtsNew(), keyed once for each direction.
+///
+typedef struct {
+  EVP_CIPHER_CTX    *EncryptCtx;
+  EVP_CIPHER_CTX    *DecryptCtx;
+} OPENSSL_AES_XTS_CONTEXT;
+
+/**
+  Performs AES-CBC encryption or decryption, without padding.
+
+  Inputs of at least AES_CBC_EVP_MIN_SIZE bytes go through EVP, which picks
+  the AES-NI (pipelined CBC decrypt), bsaes or vpaes implementation available
+  on the platform instead of the generic AES_cbc_encrypt() code. That cipher
+  context lives only for this call, so concurrent callers share no state.
+  Shorter inputs use AES_cbc_encrypt() on the key schedules of the AES context.
+
+  @param[in]   AesContext  Pointer to the AES context.
+  @param[in]   Input       Pointer to the input buffer.
+  @param[in]   InputSize   Size of the Input buffer in bytes, a multiple of the
+                           block size and at most INT_MAX.
+  @param[in]   Ivec        Pointer to initialization vector.
+  @param[out]  Output      Pointer to a buffer that receives the output.
+  @param[in]   Encrypt     TRUE for encryption, FALSE for decryption.
+
+  @retval TRUE   The operation succeeded.
+  @retval FALSE  The operation failed.
+
+**/
+STATIC
+BOOLEAN
+AesCbcCrypt (
+  IN   CONST OPENSSL_AES_CONTEXT  *AesContext,
+  IN   CONST UINT8                *Input,
+  IN   UINTN                      InputSize,
+  IN   CONST UINT8                *Ivec,
+  OUT  UINT8                      *Output,
+  IN   BOOLEAN                    Encrypt
+  )
+{
+  EVP_CIPHER_CTX    *Ctx;
+  CONST EVP_CIPHER  *Cipher;
+  INT32             OutSize;
+  BOOLEAN           Result;
+  UINT8             IvecBuffer[AES_BLOCK_SIZE];
+
+  if (InputSize < AES_CBC_EVP_MIN_SIZE) {
+    CopyMem (IvecBuffer, Ivec, AES_BLOCK_SIZE);
+    if (Encrypt) {
+      AES_cbc_encrypt (Input, Output, InputSize, &AesContext->EncryptKey, IvecBuffer, AES_ENCRYPT);
+    } else {
+      AES_cbc_encrypt (Input, Output, InputSize, &AesContext->DecryptKey, IvecBuffer, AES_DECRYPT);
+    }
+
+    return TRUE;
+  }
+
+  switch (AesContext->KeySize) {
+    case 16:
+      Cipher = EVP_aes_128_cbc ();
+      break;
+    case 24:
+      Cipher = EVP_aes_192_cbc ();
+      break;
+    case 32:
+      Cipher = EVP_aes_256_cbc ();
+      break;
+    default:
+      return FALSE;
+  }
+
+  Ctx = EVP_CIPHER_CTX_new ();
+  if (Ctx == NULL) {
+    return FALSE;
+  }
+
+  Result = FALSE;
+  if (!EVP_CipherInit_ex (Ctx, Cipher, NULL, AesContext->Key, Ivec, Encrypt ? 1 : 0) ||
+      !EVP_CIPHER_CTX_set_padding (Ctx, 0))
+  {
+    goto _Exit;
+  }
+
+  if (!EVP_CipherUpdate (Ctx, Output, &OutSize, Input, (INT32)InputSize)) {
+    goto _Exit;
+  }
+
+  Result = (BOOLEAN)((UINTN)OutSize == InputSize);
+
+_Exit:
+  //
+  // EVP_CIPHER_CTX_free() cleanses the expanded key schedule.
+  //
+  EVP_CIPHER_CTX_free (Ctx);
+  return Result;
+}
 
 /**
   Retrieves the size, in bytes, of the context buffer required for AES operations.
@@ -22,10 +145,10 @@ AesGetContextSize (
   )
 {
   //
-  // AES uses different key contexts for encryption and decryption, so here memory
-  // for 2 copies of AES_KEY is allocated.
+  // AES uses different key schedules for encryption and decryption, and EVP
+  // expands its own from the key kept next to them.
   //
-  return (UINTN)(2 * sizeof (AES_KEY));
+  return (UINTN)(sizeof (OPENSSL_AES_CONTEXT));
 }
 
 /**
@@ -56,7 +179,7 @@ AesInit (
   IN   UINTN        KeyLength
   )
 {
-  AES_KEY  *AesKey;
+  OPENSSL_AES_CONTEXT  *Context;
 
   //
   // Check input parameters.
@@ -66,17 +189,22 @@ AesInit (
   }
 
   //
-  // Initialize AES encryption & decryption key schedule.
+  // Initialize AES encryption & decryption key schedule, and keep the key
+  // for the EVP path.
   //
-  AesKey = (AES_KEY *)AesContext;
-  if (AES_set_encrypt_key (Key, (UINT32)KeyLength, AesKey) != 0) {
+  Context = (OPENSSL_AES_CONTEXT *)AesContext;
+  ZeroMem (Context, sizeof (OPENSSL_AES_CONTEXT));
+  if (AES_set_encrypt_key (Key, (UINT32)KeyLength, &Context->EncryptKey) != 0) {
     return FALSE;
   }
 
-  if (AES_set_decrypt_key (Key, (UINT32)KeyLength, AesKey + 1) != 0) {
+  if (AES_set_decrypt_key (Key, (UINT32)KeyLength, &Context->DecryptKey) != 0) {
     return FALSE;
   }
 
+  CopyMem (Context->Key, Key, KeyLength / 8);
+  Context->KeySize = (UINT32)(KeyLength / 8);
+
   return TRUE;
 }
 
@@ -117,9 +245,6 @@ AesCbcEncrypt (
   OUT  UINT8        *Output
   )
 {
-  AES_KEY  *AesKey;
-  UINT8    IvecBuffer[AES_BLOCK_SIZE];
-
   //
   // Check input parameters.
   //
@@ -131,15 +256,10 @@ AesCbcEncrypt (
     return FALSE;
   }
 
-  AesKey = (AES_KEY *)AesContext;
-  CopyMem (IvecBuffer, Ivec, AES_BLOCK_SIZE);
-
   //
   // Perform AES data encryption with CBC mode
   //
-  AES_cbc_encrypt (Input, Output, (UINT32)InputSize, AesKey, IvecBuffer, AES_ENCRYPT);
-
-  return TRUE;
+  return AesCbcCrypt ((CONST OPENSSL_AES_CONTEXT *)AesContext, Input, InputSize, Ivec, Output, TRUE);
 }
 
 /**
@@ -179,9 +299,6 @@ AesCbcDecrypt (
   OUT  UINT8        *Output
   )
 {
-  AES_KEY  *AesKey;
-  UINT8    IvecBuffer[AES_BLOCK_SIZE];
-
   //
   // Check input parameters.
   //
@@ -193,13 +310,491 @@ AesCbcDecrypt (
     return FALSE;
   }
 
-  AesKey = (AES_KEY *)AesContext;
-  CopyMem (IvecBuffer, Ivec, AES_BLOCK_SIZE);
-
   //
   // Perform AES data decryption with CBC mode
   //
-  AES_cbc_encrypt (Input, Output, (UINT32)InputSize, AesKey + 1, IvecBuffer, AES_DECRYPT);
+  return AesCbcCrypt ((CONST OPENSSL_AES_CONTEXT *)AesContext, Input, InputSize, Ivec, Output, FALSE);
+}
+
+/**
+  Allocates and initializes one AES-CTR context for subsequent use.
+
+  The key schedule is expanded once here and reused by every stream started
+  with AesCtrInit(). Use AesCtrFree() to release the context.
+
+  KeySize must be 16, 24 or 32, otherwise NULL is returned.
+
+  @param[in]  Key      Pointer to the user-supplied AES key.
+  @param[in]  KeySize  Size of the AES key in bytes.
+
+  @return  Pointer to the AES-CTR context that has been initialized.
+           If the allocation fails, AesCtrNew() returns NULL.
+
+**/
+VOID *
+EFIAPI
+AesCtrNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  EVP_CIPHER_CTX    *Ctx;
+  CONST EVP_CIPHER  *Cipher;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  switch (KeySize) {
+    case 16:
+      Cipher = EVP_aes_128_ctr ();
+      break;
+    case 24:
+      Cipher = EVP_aes_192_ctr ();
+      break;
+    case 32:
+      Cipher = EVP_aes_256_ctr ();
+      break;
+    default:
+      return NULL;
+  }
+
+  Ctx = EVP_CIPHER_CTX_new ();
+  if (Ctx == NULL) {
+    return NULL;
+  }
+
+  if (!EVP_EncryptInit_ex (Ctx, Cipher, NULL, Key, NULL)) {
+    EVP_CIPHER_CTX_free (Ctx);
+    return NULL;
+  }
+
+  return (VOID *)Ctx;
+}
+
+/**
+  Release the specified AES-CTR context.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context to be released.
+
+**/
+VOID
+EFIAPI
+AesCtrFree (
+  IN  VOID  *AesCtrContext
+  )
+{
+  EVP_CIPHER_CTX_free ((EVP_CIPHER_CTX *)AesCtrContext);
+}
+
+/**
+  Starts a new AES-CTR key stream on a context returned by AesCtrNew().
+
+  Iv is the initial 16-byte counter block. It is incremented as a 128-bit
+  big-endian integer for every block of key stream.
+
+  IvSize must be 16, otherwise FALSE is returned.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]  Iv             Pointer to the initial counter block.
+  @param[in]  IvSize         Size of the initial counter block in bytes.
+
+  @retval TRUE   The key stream was started.
+  @retval FALSE  The key stream could not be started.
+
+**/
+BOOLEAN
+EFIAPI
+AesCtrInit (
+  IN  VOID         *AesCtrContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize
+  )
+{
+  if ((AesCtrContext == NULL) || (Iv == NULL) || (IvSize != AES_BLOCK_SIZE)) {
+    return FALSE;
+  }
+
+  //
+  // A NULL key keeps the key schedule already in the context.
+  //
+  return (BOOLEAN)EVP_EncryptInit_ex ((EVP_CIPHER_CTX *)AesCtrContext, NULL, NULL, NULL, Iv);
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-CTR stream.
+
+  The data may be passed in parts of any size; the key stream continues from
+  where the previous call stopped. Encryption and decryption are the same
+  operation. Payloads larger than INT_MAX are processed in chunks.
+
+  @param[in]   AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]   Input          Pointer to the input data buffer.
+  @param[in]   InputSize      Size of the input data buffer in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the output.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The data could not be processed.
+
+**/
+BOOLEAN
+EFIAPI
+AesCtrUpdate (
+  IN   VOID         *AesCtrContext,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  INT32  OutSize;
+  UINTN  ChunkSize;
+
+  if ((AesCtrContext == NULL) || (((Input == NULL) || (Output == NULL)) && (InputSize != 0))) {
+    return FALSE;
+  }
+
+  while (InputSize > 0) {
+    ChunkSize = MIN (InputSize, AES_STREAM_CHUNK_SIZE);
+    if (!EVP_EncryptUpdate ((EVP_CIPHER_CTX *)AesCtrContext, Output, &OutSize, Input, (INT32)ChunkSize) ||
+        ((UINTN)OutSize != ChunkSize))
+    {
+      return FALSE;
+    }
+
+    Input     += ChunkSize;
+    Output    += ChunkSize;
+    InputSize -= ChunkSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Allocates and initializes one AES-XTS context for subsequent use.
+
+  Key holds the data key followed by the tweak key, as defined by IEEE Std
+  1619. Both key schedules are expanded once here for encryption and for
+  decryption. Use AesXtsFree() to release the context.
+
+  KeySize must be 32 (AES-128-XTS) or 64 (AES-256-XTS), otherwise NULL is
+  returned. If the data key and the tweak key are equal, NULL is returned.
+
+  @param[in]  Key      Pointer to the concatenated data and tweak keys.
+  @param[in]  KeySize  Size of Key in bytes.
+
+  @return  Pointer to the AES-XTS context that has been initialized.
+           If the allocation fails, AesXtsNew() returns NULL.
+
+**/
+VOID *
+EFIAPI
+AesXtsNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  OPENSSL_AES_XTS_CONTEXT  *Context;
+  CONST EVP_CIPHER         *Cipher;
+
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  switch (KeySize) {
+    case 32:
+      Cipher = EVP_aes_128_xts ();
+      break;
+    case 64:
+      Cipher = EVP_aes_256_xts ();
+      break;
+    default:
+      return NULL;
+  }
+
+  if (CompareMem (Key, Key + KeySize / 2, KeySize / 2) == 0) {
+    return NULL;
+  }
+
+  Context = AllocateZeroPool (sizeof (OPENSSL_AES_XTS_CONTEXT));
+  if (Context == NULL) {
+    return NULL;
+  }
+
+  Context->EncryptCtx = EVP_CIPHER_CTX_new ();
+  Context->DecryptCtx = EVP_CIPHER_CTX_new ();
+  if ((Context->EncryptCtx == NULL) || (Context->DecryptCtx == NULL) ||
+      !EVP_EncryptInit_ex (Context->EncryptCtx, Cipher, NULL, Key, NULL) ||
+      !EVP_DecryptInit_ex (Context->DecryptCtx, Cipher, NULL, Key, NULL))
+  {
+    AesXtsFree (Context);
+    return NULL;
+  }
+
+  return (VOID *)Context;
+}
+
+/**
+  Release the specified AES-XTS context.
+
+  @param[in]  AesXtsContext  Pointer to the AES-XTS context to be released.
+
+**/
+VOID
+EFIAPI
+AesXtsFree (
+  IN  VOID  *AesXtsContext
+  )
+{
+  OPENSSL_AES_XTS_CONTEXT  *Context;
+
+  if (AesXtsContext == NULL) {
+    return;
+  }
+
+  Context = (OPENSSL_AES_XTS_CONTEXT *)AesXtsContext;
+  EVP_CIPHER_CTX_free (Context->EncryptCtx);
+  EVP_CIPHER_CTX_free (Context->DecryptCtx);
+  FreePool (Context);
+}
+
+/**
+  Encrypts or decrypts one AES-XTS data unit.
+
+  @param[in]   Ctx        EVP cipher context keyed for the direction.
+  @param[in]   Tweak      Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input      Pointer to the data unit.
+  @param[in]   InputSize  Size of the data unit in bytes.
+  @param[out]  Output     Pointer to a buffer that receives the output.
+
+  @retval TRUE   The data unit was processed.
+  @retval FALSE  The data unit could not be processed.
+
+**/
+STATIC
+BOOLEAN
+AesXtsCryptDataUnit (
+  IN   EVP_CIPHER_CTX  *Ctx,
+  IN   CONST UINT8     *Tweak,
+  IN   CONST UINT8     *Input,
+  IN   UINTN           InputSize,
+  OUT  UINT8           *Output
+  )
+{
+  INT32  OutSize;
+
+  if ((InputSize < AES_BLOCK_SIZE) || (InputSize > INT_MAX)) {
+    return FALSE;
+  }
+
+  //
+  // A NULL key keeps the key schedules; only the tweak changes.
+  //
+  if (!EVP_CipherInit_ex (Ctx, NULL, NULL, NULL, Tweak, -1)) {
+    return FALSE;
+  }
+
+  if (!EVP_CipherUpdate (Ctx, Output, &OutSize, Input, (INT32)InputSize)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((UINTN)OutSize == InputSize);
+}
+
+/**
+  Encrypts or decrypts consecutive AES-XTS sectors.
+
+  @param[in]   Ctx          EVP cipher context keyed for the direction.
+  @param[in]   StartSector  Number of the first sector.
+  @param[in]   SectorSize   Size of one sector in bytes.
+  @param[in]   Input        Pointer to the sectors.
+  @param[in]   InputSize    Size of Input in bytes, a multiple of SectorSize.
+  @param[out]  Output       Pointer to a buffer that receives the output.
+
+  @retval TRUE   The sectors were processed.
+  @retval FALSE  The sectors could not be processed.
+
+**/
+STATIC
+BOOLEAN
+AesXtsCryptSectors (
+  IN   EVP_CIPHER_CTX  *Ctx,
+  IN   UINT64          StartSector,
+  IN   UINTN           SectorSize,
+  IN   CONST UINT8     *Input,
+  IN   UINTN           InputSize,
+  OUT  UINT8           *Output
+  )
+{
+  UINT8   Tweak[AES_BLOCK_SIZE];
+  UINT64  Sector;
+  UINTN   Index;
+
+  if ((SectorSize < AES_BLOCK_SIZE) || ((InputSize % SectorSize) != 0)) {
+    return FALSE;
+  }
+
+  for (Sector = StartSector; InputSize > 0; Sector++) {
+    //
+    // The tweak is the sector number as a 128-bit little-endian integer.
+    //
+    ZeroMem (Tweak, sizeof (Tweak));
+    for (Index = 0; Index < sizeof (UINT64); Index++) {
+      Tweak[Index] = (UINT8)RShiftU64 (Sector, Index * 8);
+    }
+
+    if (!AesXtsCryptDataUnit (Ctx, Tweak, Input, SectorSize, Output)) {
+      return FALSE;
+    }
+
+    Input     += SectorSize;
+    Output    += SectorSize;
+    InputSize -= SectorSize;
+  }
 
   return TRUE;
 }
+
+/**
+  Performs AES-XTS encryption of one data unit.
+
+  The data unit may be any size from one block (16 bytes) up to 16 MiB; a
+  partial last block is handled by ciphertext stealing.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be encrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval TRUE   AES-XTS encryption succeeded.
+  @retval FALSE  AES-XTS encryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsEncrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Tweak == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptDataUnit (((OPENSSL_AES_XTS_CONTEXT *)AesXtsContext)->EncryptCtx, Tweak, Input, InputSize, Output);
+}
+
+/**
+  Performs AES-XTS decryption of one data unit.
+
+  The data unit may be any size from one block (16 bytes) up to 16 MiB; a
+  partial last block is handled by ciphertext stealing.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be decrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval TRUE   AES-XTS decryption succeeded.
+  @retval FALSE  AES-XTS decryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsDecrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Tweak == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptDataUnit (((OPENSSL_AES_XTS_CONTEXT *)AesXtsContext)->DecryptCtx, Tweak, Input, InputSize, Output);
+}
+
+/**
+  Performs AES-XTS encryption of consecutive sectors.
+
+  Each sector is one data unit whose tweak is its sector number as a 128-bit
+  little-endian integer, as used by IEEE Std 1619 storage encryption.
+
+  If InputSize is not a multiple of SectorSize, then return FALSE.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be encrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval TRUE   AES-XTS encryption succeeded.
+  @retval FALSE  AES-XTS encryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsEncryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptSectors (((OPENSSL_AES_XTS_CONTEXT *)AesXtsContext)->EncryptCtx, StartSector, SectorSize, Input, InputSize, Output);
+}
+
+/**
+  Performs AES-XTS decryption of consecutive sectors.
+
+  Each sector is one data unit whose tweak is its sector number as a 128-bit
+  little-endian integer, as used by IEEE Std 1619 storage encryption.
+
+  If InputSize is not a multiple of SectorSize, then return FALSE.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be decrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval TRUE   AES-XTS decryption succeeded.
+  @retval FALSE  AES-XTS decryption failed.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsDecryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  if ((AesXtsContext == NULL) || (Input == NULL) || (Output == NULL)) {
+    return FALSE;
+  }
+
+  return AesXtsCryptSectors (((OPENSSL_AES_XTS_CONTEXT *)AesXtsContext)->DecryptCtx, StartSector, SectorSize, Input, InputSize, Output);
+}
@@ -105,3 +105,252 @@ AesCbcDecrypt (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Allocates and initializes one AES-CTR context for subsequent use.
+
+  Return NULL to indicate this interface is not supported.
+
+  @param[in]  Key      Pointer to the user-supplied AES key.
+  @param[in]  KeySize  Size of the AES key in bytes.
+
+  @retval NULL  This interface is not supported.
+
+**/
+VOID *
+EFIAPI
+AesCtrNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Release the specified AES-CTR context.
+
+  This function will do nothing.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context to be released.
+
+**/
+VOID
+EFIAPI
+AesCtrFree (
+  IN  VOID  *AesCtrContext
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Starts a new AES-CTR key stream on a context returned by AesCtrNew().
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]  Iv             Pointer to the initial counter block.
+  @param[in]  IvSize         Size of the initial counter block in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesCtrInit (
+  IN  VOID         *AesCtrContext,
+  IN  CONST UINT8  *Iv,
+  IN  UINTN        IvSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Encrypts or decrypts the next part of the current AES-CTR stream.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesCtrContext  Pointer to the AES-CTR context.
+  @param[in]   Input          Pointer to the input data buffer.
+  @param[in]   InputSize      Size of the input data buffer in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesCtrUpdate (
+  IN   VOID         *AesCtrContext,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Allocates and initializes one AES-XTS context for subsequent use.
+
+  Return NULL to indicate this interface is not supported.
+
+  @param[in]  Key      Pointer to the concatenated data and tweak keys.
+  @param[in]  KeySize  Size of Key in bytes.
+
+  @retval NULL  This interface is not supported.
+
+**/
+VOID *
+EFIAPI
+AesXtsNew (
+  IN  CONST UINT8  *Key,
+  IN  UINTN        KeySize
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Release the specified AES-XTS context.
+
+  This function will do nothing.
+
+  @param[in]  AesXtsContext  Pointer to the AES-XTS context to be released.
+
+**/
+VOID
+EFIAPI
+AesXtsFree (
+  IN  VOID  *AesXtsContext
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Performs AES-XTS encryption of one data unit.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be encrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsEncrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Performs AES-XTS decryption of one data unit.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   Tweak          Pointer to the 16-byte tweak of the data unit.
+  @param[in]   Input          Pointer to the data unit to be decrypted.
+  @param[in]   InputSize      Size of the data unit in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsDecrypt (
+  IN   VOID         *AesXtsContext,
+  IN   CONST UINT8  *Tweak,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Performs AES-XTS encryption of consecutive sectors.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be encrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS encryption output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsEncryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Performs AES-XTS decryption of consecutive sectors.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   AesXtsContext  Pointer to the AES-XTS context.
+  @param[in]   StartSector    Number of the first sector in Input.
+  @param[in]   SectorSize     Size of one sector in bytes, at least 16.
+  @param[in]   Input          Pointer to the sectors to be decrypted.
+  @param[in]   InputSize      Size of Input in bytes.
+  @param[out]  Output         Pointer to a buffer of InputSize bytes that
+                              receives the AES-XTS decryption output.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AesXtsDecryptSectors (
+  IN   VOID         *AesXtsContext,
+  IN   UINT64       StartSector,
+  IN   UINTN        SectorSize,
+  IN   CONST UINT8  *Input,
+  IN   UINTN        InputSize,
+  OUT  UINT8        *Output
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
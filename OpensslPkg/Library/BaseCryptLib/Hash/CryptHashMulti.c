@@ -0,0 +1,158 @@
+/** @file
+  Single-pass multi-algorithm digest Wrapper Implementation over OpenSSL.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalCryptLib.h"
+
+//
+// Size of the tiles the input is walked in. Every requested context consumes
+// a tile before moving on, so the tile is read from memory once and then stays
+// in the L1 data cache for the remaining algorithms.
+//
+#define HASH_MULTI_TILE_SIZE  SIZE_16KB
+
+///
+/// Digest algorithm that HashAllMulti() can compute, indexed by its bit in AlgMask.
+///
+typedef struct {
+  UINTN      (EFIAPI *GetContextSize)(
+    VOID
+    );
+  BOOLEAN    (EFIAPI *Init)(
+    OUT VOID  *HashContext
+    );
+  BOOLEAN    (EFIAPI *Update)(
+    IN OUT VOID        *HashContext,
+    IN     CONST VOID  *Data,
+    IN     UINTN       DataSize
+    );
+  BOOLEAN    (EFIAPI *Final)(
+    IN OUT VOID   *HashContext,
+    OUT    UINT8  *HashValue
+    );
+} HASH_MULTI_ALGORITHM;
+
+GLOBAL_REMOVE_IF_UNREFERENCED CONST HASH_MULTI_ALGORITHM  mHashMultiAlgorithms[] = {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+  { Sha1GetContextSize,   Sha1Init,   Sha1Update,   Sha1Final   },   // CRYPTO_HASH_MASK_SHA1
+ #else
+  { NULL,                 NULL,       NULL,         NULL        },   // CRYPTO_HASH_MASK_SHA1
+ #endif
+  { Sha256GetContextSize, Sha256Init, Sha256Update, Sha256Final },   // CRYPTO_HASH_MASK_SHA256
+  { Sha384GetContextSize, Sha384Init, Sha384Update, Sha384Final },   // CRYPTO_HASH_MASK_SHA384
+  { Sha512GetContextSize, Sha512Init, Sha512Update, Sha512Final },   // CRYPTO_HASH_MASK_SHA512
+  { Sm3GetContextSize,    Sm3Init,    Sm3Update,    Sm3Final    }    // CRYPTO_HASH_MASK_SM3_256
+};
+
+/**
+  Computes the digests of a input data buffer with several hash algorithms at
+  once, walking the data a single time.
+
+  This function performs the SHA-1, SHA-256, SHA-384, SHA-512 and SM3 hashes
+  selected by AlgMask over the same data, as needed to extend multiple PCR banks
+  with one event. The input is processed in cache-sized tiles and every
+  requested context consumes a tile before the next one is read, so large
+  buffers are streamed from memory once rather than once per algorithm.
+
+  AlgMask uses the CRYPTO_HASH_MASK_* bits, whose values match the TCG hash
+  algorithm bitmap used for PCR banks. Digests is indexed by the bit position
+  of each algorithm: Digests[0] receives the SHA-1 digest, Digests[1] the
+  SHA-256 digest and so on; entries for algorithms not in AlgMask are ignored.
+
+  If Data is NULL and DataSize is not zero, return FALSE.
+  If AlgMask is zero or has unsupported bits set, return FALSE.
+  If Digests or any entry selected by AlgMask is NULL, return FALSE.
+
+  @param[in]   Data      Pointer to the buffer containing the data to be hashed.
+  @param[in]   DataSize  Size of Data buffer in bytes.
+  @param[in]   AlgMask   Bitmap of CRYPTO_HASH_MASK_* algorithms to compute.
+  @param[out]  Digests   Array of pointers to the buffers receiving the digests,
+                         indexed by the bit position in AlgMask.
+
+  @retval TRUE   All requested digests were computed.
+  @retval FALSE  A parameter is invalid, or a requested algorithm is not
+                 supported, or a digest computation failed.
+
+**/
+BOOLEAN
+EFIAPI
+HashAllMulti (
+  IN   CONST VOID  *Data,
+  IN   UINTN       DataSize,
+  IN   UINT32      AlgMask,
+  OUT  UINT8       **Digests
+  )
+{
+  VOID         *Contexts[ARRAY_SIZE (mHashMultiAlgorithms)];
+  CONST UINT8  *Tile;
+  UINTN        Remaining;
+  UINTN        TileSize;
+  UINTN        Index;
+  BOOLEAN      Status;
+
+  //
+  // Check input parameters.
+  //
+  if (((Data == NULL) && (DataSize != 0)) || (Digests == NULL) ||
+      (AlgMask == 0) || ((AlgMask >> ARRAY_SIZE (mHashMultiAlgorithms)) != 0))
+  {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mHashMultiAlgorithms); Index++) {
+    if (((AlgMask & (1U << Index)) != 0) &&
+        ((Digests[Index] == NULL) || (mHashMultiAlgorithms[Index].GetContextSize == NULL)))
+    {
+      return FALSE;
+    }
+  }
+
+  ZeroMem (Contexts, sizeof (Contexts));
+  Status = FALSE;
+
+  for (Index = 0; Index < ARRAY_SIZE (mHashMultiAlgorithms); Index++) {
+    if ((AlgMask & (1U << Index)) == 0) {
+      continue;
+    }
+
+    Contexts[Index] = AllocatePool (mHashMultiAlgorithms[Index].GetContextSize ());
+    if ((Contexts[Index] == NULL) || !mHashMultiAlgorithms[Index].Init (Contexts[Index])) {
+      goto _Exit;
+    }
+  }
+
+  Tile      = (CONST UINT8 *)Data;
+  Remaining = DataSize;
+  while (Remaining > 0) {
+    TileSize = MIN (Remaining, HASH_MULTI_TILE_SIZE);
+    for (Index = 0; Index < ARRAY_SIZE (mHashMultiAlgorithms); Index++) {
+      if ((Contexts[Index] != NULL) && !mHashMultiAlgorithms[Index].Update (Contexts[Index], Tile, TileSize)) {
+        goto _Exit;
+      }
+    }
+
+    Tile      += TileSize;
+    Remaining -= TileSize;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mHashMultiAlgorithms); Index++) {
+    if ((Contexts[Index] != NULL) && !mHashMultiAlgorithms[Index].Final (Contexts[Index], Digests[Index])) {
+      goto _Exit;
+    }
+  }
+
+  Status = TRUE;
+
+_Exit:
+  for (Index = 0; Index < ARRAY_SIZE (mHashMultiAlgorithms); Index++) {
+    if (Contexts[Index] != NULL) {
+      FreePool (Contexts[Index]);
+    }
+  }
+
+  return Status;
+}
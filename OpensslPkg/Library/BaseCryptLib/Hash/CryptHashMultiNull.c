@@ -0,0 +1,37 @@
+/** @file
+  Single-pass multi-algorithm digest Wrapper Null Implementation.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalCryptLib.h"
+
+/**
+  Computes the digests of a input data buffer with several hash algorithms at
+  once, walking the data a single time.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   Data      Pointer to the buffer containing the data to be hashed.
+  @param[in]   DataSize  Size of Data buffer in bytes.
+  @param[in]   AlgMask   Bitmap of CRYPTO_HASH_MASK_* algorithms to compute.
+  @param[out]  Digests   Array of pointers to the buffers receiving the digests,
+                         indexed by the bit position in AlgMask.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashAllMulti (
+  IN   CONST VOID  *Data,
+  IN   UINTN       DataSize,
+  IN   UINT32      AlgMask,
+  OUT  UINT8       **Digests
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
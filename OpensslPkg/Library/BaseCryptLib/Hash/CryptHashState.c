@@ -0,0 +1,427 @@
+/** @file
+  Hash midstate export/import Wrapper Implementation over OpenSSL.
+
+  The exported state is a backend-independent serialization of a hash context
+  part way through a message: the chaining value, the number of bytes hashed
+  so far and the pending partial block. It can be stored or handed over to
+  another boot phase and imported into a fresh context, by either crypto
+  backend, to continue the same hash without reprocessing the prefix.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalCryptLib.h"
+#include <openssl/sha.h>
+#include "internal/sm3.h"
+
+#define HASH_EXPORTED_STATE_SIGNATURE  SIGNATURE_32 ('H', 'S', 'T', '1')
+
+///
+/// Exported hash state. All fields are little-endian except ChainingValue,
+/// which holds the state words in big-endian order as in the digest output.
+/// Only MessageLength modulo the block size bytes of Block are meaningful.
+///
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Algorithm;
+  UINT64    MessageLength;
+  UINT8     ChainingValue[SHA512_DIGEST_SIZE];
+  UINT8     Block[SHA512_CBLOCK];
+} HASH_EXPORTED_STATE;
+#pragma pack()
+
+///
+/// Backend-independent view of a hash context, used between the context and
+/// the exported state.
+///
+typedef struct {
+  UINT64    MessageLength;
+  UINT64    Words[8];
+  UINT8     *Block;
+  UINTN     WordCount;
+  UINTN     WordSize;
+  UINTN     BlockSize;
+} HASH_MIDSTATE;
+
+/**
+  Serializes the chaining value words of a midstate into big-endian bytes.
+
+  @param[in]   Midstate  Midstate holding the words.
+  @param[out]  Output    Buffer of Midstate->WordCount * Midstate->WordSize bytes.
+
+**/
+STATIC
+VOID
+HashMidstateStoreWords (
+  IN  CONST HASH_MIDSTATE  *Midstate,
+  OUT UINT8                *Output
+  )
+{
+  UINTN  Index;
+  UINTN  Byte;
+
+  for (Index = 0; Index < Midstate->WordCount; Index++) {
+    for (Byte = 0; Byte < Midstate->WordSize; Byte++) {
+      *Output++ = (UINT8)RShiftU64 (Midstate->Words[Index], (UINTN)(8 * (Midstate->WordSize - 1 - Byte)));
+    }
+  }
+}
+
+/**
+  Deserializes big-endian chaining value bytes into the words of a midstate.
+
+  @param[in, out]  Midstate  Midstate receiving the words.
+  @param[in]       Input     Buffer of Midstate->WordCount * Midstate->WordSize bytes.
+
+**/
+STATIC
+VOID
+HashMidstateLoadWords (
+  IN OUT HASH_MIDSTATE  *Midstate,
+  IN     CONST UINT8    *Input
+  )
+{
+  UINTN  Index;
+  UINTN  Byte;
+
+  for (Index = 0; Index < Midstate->WordCount; Index++) {
+    Midstate->Words[Index] = 0;
+    for (Byte = 0; Byte < Midstate->WordSize; Byte++) {
+      Midstate->Words[Index] = LShiftU64 (Midstate->Words[Index], 8) | *Input++;
+    }
+  }
+}
+
+/**
+  Describes the layout of a hash context of the given algorithm, without the
+  message length and chaining value.
+
+  @param[in]   HashAlg      CRYPTO_HASH_MASK_* bit of the algorithm.
+  @param[in]   HashContext  Pointer to the hash context.
+  @param[out]  Midstate     Midstate receiving the word and block layout and
+                            a pointer to the context's block buffer.
+
+  @retval TRUE   The algorithm is supported.
+  @retval FALSE  The algorithm is not supported.
+
+**/
+STATIC
+BOOLEAN
+HashMidstateLayout (
+  IN  UINT32         HashAlg,
+  IN  VOID           *HashContext,
+  OUT HASH_MIDSTATE  *Midstate
+  )
+{
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      Midstate->Block     = (UINT8 *)((SHA_CTX *)HashContext)->data;
+      Midstate->WordCount = 5;
+      Midstate->WordSize  = sizeof (SHA_LONG);
+      Midstate->BlockSize = SHA_CBLOCK;
+      return TRUE;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+      Midstate->Block     = (UINT8 *)((SHA256_CTX *)HashContext)->data;
+      Midstate->WordCount = 8;
+      Midstate->WordSize  = sizeof (SHA_LONG);
+      Midstate->BlockSize = SHA256_CBLOCK;
+      return TRUE;
+    case CRYPTO_HASH_MASK_SHA384:
+    case CRYPTO_HASH_MASK_SHA512:
+      Midstate->Block     = ((SHA512_CTX *)HashContext)->u.p;
+      Midstate->WordCount = 8;
+      Midstate->WordSize  = sizeof (SHA_LONG64);
+      Midstate->BlockSize = SHA512_CBLOCK;
+      return TRUE;
+    case CRYPTO_HASH_MASK_SM3_256:
+      Midstate->Block     = (UINT8 *)((SM3_CTX *)HashContext)->data;
+      Midstate->WordCount = 8;
+      Midstate->WordSize  = sizeof (SM3_WORD);
+      Midstate->BlockSize = SM3_CBLOCK;
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/**
+  Exports the midstate of a hash context in a portable, backend-independent
+  format.
+
+  The exported state captures everything needed to continue the hash: the
+  chaining value, the number of bytes hashed so far and the pending partial
+  block. It can be imported with HashImportState() into a context of the same
+  algorithm, in another boot phase or by the other crypto backend, so that an
+  already-hashed prefix never has to be reprocessed. The hash context itself
+  is not modified.
+
+  If HashContext or StateSize is NULL, then return FALSE.
+  If State is NULL or *StateSize is too small, then *StateSize is set to the
+  required size and FALSE is returned.
+
+  @param[in]       HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm of
+                                HashContext: SHA-1, SHA-256, SHA-384, SHA-512 or SM3.
+  @param[in]       HashContext  Pointer to the hash context to export.
+  @param[out]      State        Pointer to the buffer receiving the exported state.
+  @param[in, out]  StateSize    On input, the size of State in bytes. On output,
+                                the size of the exported state in bytes.
+
+  @retval TRUE   The state was exported.
+  @retval FALSE  A parameter is invalid, State is too small, or the algorithm
+                 is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashExportState (
+  IN      UINT32      HashAlg,
+  IN      CONST VOID  *HashContext,
+  OUT     VOID        *State,
+  IN OUT  UINTN       *StateSize
+  )
+{
+  HASH_EXPORTED_STATE  *Exported;
+  HASH_MIDSTATE        Midstate;
+  UINT64               BitCountLow;
+  UINT64               BitCountHigh;
+  UINTN                Buffered;
+  UINTN                Index;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashContext == NULL) || (StateSize == NULL)) {
+    return FALSE;
+  }
+
+  if ((State == NULL) || (*StateSize < sizeof (HASH_EXPORTED_STATE))) {
+    *StateSize = sizeof (HASH_EXPORTED_STATE);
+    return FALSE;
+  }
+
+  if (!HashMidstateLayout (HashAlg, (VOID *)HashContext, &Midstate)) {
+    return FALSE;
+  }
+
+  //
+  // Pull the chaining value, the message bit count and the number of buffered
+  // bytes out of the OpenSSL context.
+  //
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      Midstate.Words[0] = ((SHA_CTX *)HashContext)->h0;
+      Midstate.Words[1] = ((SHA_CTX *)HashContext)->h1;
+      Midstate.Words[2] = ((SHA_CTX *)HashContext)->h2;
+      Midstate.Words[3] = ((SHA_CTX *)HashContext)->h3;
+      Midstate.Words[4] = ((SHA_CTX *)HashContext)->h4;
+      BitCountLow       = ((SHA_CTX *)HashContext)->Nl;
+      BitCountHigh      = ((SHA_CTX *)HashContext)->Nh;
+      Buffered          = ((SHA_CTX *)HashContext)->num;
+      break;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+      if (((SHA256_CTX *)HashContext)->md_len != SHA256_DIGEST_LENGTH) {
+        return FALSE;
+      }
+
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        Midstate.Words[Index] = ((SHA256_CTX *)HashContext)->h[Index];
+      }
+
+      BitCountLow  = ((SHA256_CTX *)HashContext)->Nl;
+      BitCountHigh = ((SHA256_CTX *)HashContext)->Nh;
+      Buffered     = ((SHA256_CTX *)HashContext)->num;
+      break;
+    case CRYPTO_HASH_MASK_SHA384:
+    case CRYPTO_HASH_MASK_SHA512:
+      if (((SHA512_CTX *)HashContext)->md_len != ((HashAlg == CRYPTO_HASH_MASK_SHA384) ? SHA384_DIGEST_LENGTH : SHA512_DIGEST_LENGTH)) {
+        return FALSE;
+      }
+
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        Midstate.Words[Index] = ((SHA512_CTX *)HashContext)->h[Index];
+      }
+
+      //
+      // SHA-512 keeps a 128-bit bit count; only byte counts that fit in 64
+      // bits are representable.
+      //
+      if (RShiftU64 (((SHA512_CTX *)HashContext)->Nh, 61) != 0) {
+        return FALSE;
+      }
+
+      BitCountLow  = ((SHA512_CTX *)HashContext)->Nl;
+      BitCountHigh = ((SHA512_CTX *)HashContext)->Nh;
+      Buffered     = ((SHA512_CTX *)HashContext)->num;
+      break;
+    default:
+      Midstate.Words[0] = ((SM3_CTX *)HashContext)->A;
+      Midstate.Words[1] = ((SM3_CTX *)HashContext)->B;
+      Midstate.Words[2] = ((SM3_CTX *)HashContext)->C;
+      Midstate.Words[3] = ((SM3_CTX *)HashContext)->D;
+      Midstate.Words[4] = ((SM3_CTX *)HashContext)->E;
+      Midstate.Words[5] = ((SM3_CTX *)HashContext)->F;
+      Midstate.Words[6] = ((SM3_CTX *)HashContext)->G;
+      Midstate.Words[7] = ((SM3_CTX *)HashContext)->H;
+      BitCountLow       = ((SM3_CTX *)HashContext)->Nl;
+      BitCountHigh      = ((SM3_CTX *)HashContext)->Nh;
+      Buffered          = ((SM3_CTX *)HashContext)->num;
+      break;
+  }
+
+  //
+  // The 32-bit word hashes keep the bit count as two 32-bit halves, SHA-512
+  // as two 64-bit halves.
+  //
+  if (Midstate.WordSize == sizeof (SHA_LONG)) {
+    Midstate.MessageLength = RShiftU64 (LShiftU64 (BitCountHigh, 32) | BitCountLow, 3);
+  } else {
+    Midstate.MessageLength = LShiftU64 (BitCountHigh, 61) | RShiftU64 (BitCountLow, 3);
+  }
+
+  if ((Buffered >= Midstate.BlockSize) || ((Midstate.MessageLength & (Midstate.BlockSize - 1)) != Buffered)) {
+    return FALSE;
+  }
+
+  Exported = (HASH_EXPORTED_STATE *)State;
+  ZeroMem (Exported, sizeof (HASH_EXPORTED_STATE));
+  Exported->Signature     = HASH_EXPORTED_STATE_SIGNATURE;
+  Exported->Algorithm     = HashAlg;
+  Exported->MessageLength = Midstate.MessageLength;
+  HashMidstateStoreWords (&Midstate, Exported->ChainingValue);
+  CopyMem (Exported->Block, Midstate.Block, Buffered);
+
+  *StateSize = sizeof (HASH_EXPORTED_STATE);
+  return TRUE;
+}
+
+/**
+  Imports a midstate exported by HashExportState() into a hash context, so
+  that subsequent Update and Final calls continue the exported hash.
+
+  HashContext must be a buffer of at least the size returned by the
+  GetContextSize function of the algorithm; any previous content is replaced.
+
+  If HashContext or State is NULL, then return FALSE.
+  If State is not a valid exported state for HashAlg, then return FALSE.
+
+  @param[in]   HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm:
+                            SHA-1, SHA-256, SHA-384, SHA-512 or SM3.
+  @param[out]  HashContext  Pointer to the hash context to initialize.
+  @param[in]   State        Pointer to the exported state.
+  @param[in]   StateSize    Size of State in bytes.
+
+  @retval TRUE   The state was imported.
+  @retval FALSE  A parameter is invalid, State is malformed or was exported
+                 for another algorithm, or the algorithm is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashImportState (
+  IN   UINT32      HashAlg,
+  OUT  VOID        *HashContext,
+  IN   CONST VOID  *State,
+  IN   UINTN       StateSize
+  )
+{
+  CONST HASH_EXPORTED_STATE  *Exported;
+  HASH_MIDSTATE              Midstate;
+  UINT64                     BitCount;
+  UINTN                      Buffered;
+  UINTN                      Index;
+  BOOLEAN                    Status;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashContext == NULL) || (State == NULL) || (StateSize < sizeof (HASH_EXPORTED_STATE))) {
+    return FALSE;
+  }
+
+  Exported = (CONST HASH_EXPORTED_STATE *)State;
+  if ((Exported->Signature != HASH_EXPORTED_STATE_SIGNATURE) || (Exported->Algorithm != HashAlg)) {
+    return FALSE;
+  }
+
+  if (!HashMidstateLayout (HashAlg, HashContext, &Midstate)) {
+    return FALSE;
+  }
+
+  //
+  // The 32-bit word hashes count message bits in 64 bits.
+  //
+  if ((Midstate.WordSize == sizeof (SHA_LONG)) && (RShiftU64 (Exported->MessageLength, 61) != 0)) {
+    return FALSE;
+  }
+
+  Midstate.MessageLength = Exported->MessageLength;
+  HashMidstateLoadWords (&Midstate, Exported->ChainingValue);
+  Buffered = (UINTN)(Midstate.MessageLength & (Midstate.BlockSize - 1));
+  BitCount = LShiftU64 (Midstate.MessageLength, 3);
+
+  //
+  // Start from a freshly initialized context so that the fields not carried
+  // in the exported state (such as the digest length) are set, then overwrite
+  // the chaining value, bit count and partial block.
+  //
+  switch (HashAlg) {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+    case CRYPTO_HASH_MASK_SHA1:
+      Status = Sha1Init (HashContext);
+      ((SHA_CTX *)HashContext)->h0  = (SHA_LONG)Midstate.Words[0];
+      ((SHA_CTX *)HashContext)->h1  = (SHA_LONG)Midstate.Words[1];
+      ((SHA_CTX *)HashContext)->h2  = (SHA_LONG)Midstate.Words[2];
+      ((SHA_CTX *)HashContext)->h3  = (SHA_LONG)Midstate.Words[3];
+      ((SHA_CTX *)HashContext)->h4  = (SHA_LONG)Midstate.Words[4];
+      ((SHA_CTX *)HashContext)->Nl  = (SHA_LONG)BitCount;
+      ((SHA_CTX *)HashContext)->Nh  = (SHA_LONG)RShiftU64 (BitCount, 32);
+      ((SHA_CTX *)HashContext)->num = (unsigned int)Buffered;
+      break;
+ #endif
+    case CRYPTO_HASH_MASK_SHA256:
+      Status = Sha256Init (HashContext);
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        ((SHA256_CTX *)HashContext)->h[Index] = (SHA_LONG)Midstate.Words[Index];
+      }
+
+      ((SHA256_CTX *)HashContext)->Nl  = (SHA_LONG)BitCount;
+      ((SHA256_CTX *)HashContext)->Nh  = (SHA_LONG)RShiftU64 (BitCount, 32);
+      ((SHA256_CTX *)HashContext)->num = (unsigned int)Buffered;
+      break;
+    case CRYPTO_HASH_MASK_SHA384:
+    case CRYPTO_HASH_MASK_SHA512:
+      Status = (HashAlg == CRYPTO_HASH_MASK_SHA384) ? Sha384Init (HashContext) : Sha512Init (HashContext);
+      for (Index = 0; Index < Midstate.WordCount; Index++) {
+        ((SHA512_CTX *)HashContext)->h[Index] = Midstate.Words[Index];
+      }
+
+      ((SHA512_CTX *)HashContext)->Nl  = BitCount;
+      ((SHA512_CTX *)HashContext)->Nh  = RShiftU64 (Midstate.MessageLength, 61);
+      ((SHA512_CTX *)HashContext)->num = (unsigned int)Buffered;
+      break;
+    default:
+      Status = Sm3Init (HashContext);
+      ((SM3_CTX *)HashContext)->A   = (SM3_WORD)Midstate.Words[0];
+      ((SM3_CTX *)HashContext)->B   = (SM3_WORD)Midstate.Words[1];
+      ((SM3_CTX *)HashContext)->C   = (SM3_WORD)Midstate.Words[2];
+      ((SM3_CTX *)HashContext)->D   = (SM3_WORD)Midstate.Words[3];
+      ((SM3_CTX *)HashContext)->E   = (SM3_WORD)Midstate.Words[4];
+      ((SM3_CTX *)HashContext)->F   = (SM3_WORD)Midstate.Words[5];
+      ((SM3_CTX *)HashContext)->G   = (SM3_WORD)Midstate.Words[6];
+      ((SM3_CTX *)HashContext)->H   = (SM3_WORD)Midstate.Words[7];
+      ((SM3_CTX *)HashContext)->Nl  = (SM3_WORD)BitCount;
+      ((SM3_CTX *)HashContext)->Nh  = (SM3_WORD)RShiftU64 (BitCount, 32);
+      ((SM3_CTX *)HashContext)->num = (unsigned int)Buffered;
+      break;
+  }
+
+  CopyMem (Midstate.Block, Exported->Block, Buffered);
+  return Status;
+}
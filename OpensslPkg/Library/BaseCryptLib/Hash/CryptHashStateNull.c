@@ -0,0 +1,62 @@
+/** @file
+  Hash midstate export/import Wrapper Null Implementation.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalCryptLib.h"
+
+/**
+  Exports the midstate of a hash context in a portable, backend-independent
+  format.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]       HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm.
+  @param[in]       HashContext  Pointer to the hash context to export.
+  @param[out]      State        Pointer to the buffer receiving the exported state.
+  @param[in, out]  StateSize    Size of State in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashExportState (
+  IN      UINT32      HashAlg,
+  IN      CONST VOID  *HashContext,
+  OUT     VOID        *State,
+  IN OUT  UINTN       *StateSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Imports a midstate exported by HashExportState() into a hash context.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   HashAlg      CRYPTO_HASH_MASK_* bit identifying the algorithm.
+  @param[out]  HashContext  Pointer to the hash context to initialize.
+  @param[in]   State        Pointer to the exported state.
+  @param[in]   StateSize    Size of State in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HashImportState (
+  IN   UINT32      HashAlg,
+  OUT  VOID        *HashContext,
+  IN   CONST VOID  *State,
+  IN   UINTN       StateSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
@@ -235,6 +235,70 @@ Sha384HashAll (
   return TRUE;
 }
 
+/**
+  Computes the SHA-384 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha384Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-384 digest
+                              value (48 bytes).
+
+  @retval TRUE   SHA-384 digest computation succeeded.
+  @retval FALSE  SHA-384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha384HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  SHA512_CTX  Context;
+  UINTN       Index;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashValue == NULL) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  //
+  // OpenSSL SHA-384 Hash Computation.
+  //
+  if (!SHA384_Init (&Context)) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if (!SHA384_Update (&Context, Fragments[Index].Data, Fragments[Index].DataSize)) {
+      return FALSE;
+    }
+  }
+
+  if (!SHA384_Final (HashValue, &Context)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
   Retrieves the size, in bytes, of the context buffer required for SHA-512 hash operations.
 
@@ -460,3 +524,67 @@ Sha512HashAll (
 
   return TRUE;
 }
+
+/**
+  Computes the SHA-512 message digest of data held in several buffers.
+
+  This function hashes the fragments described by Fragments in array order, as
+  if they were one contiguous buffer, and places the digest value into the
+  specified memory. Callers do not need to coalesce the fragments into a
+  staging buffer or call Sha512Update() once per fragment.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[out]  HashValue      Pointer to a buffer that receives the SHA-512 digest
+                              value (64 bytes).
+
+  @retval TRUE   SHA-512 digest computation succeeded.
+  @retval FALSE  SHA-512 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Sha512HashAllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  OUT  UINT8                  *HashValue
+  )
+{
+  SHA512_CTX  Context;
+  UINTN       Index;
+
+  //
+  // Check input parameters.
+  //
+  if ((HashValue == NULL) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  //
+  // OpenSSL SHA-512 Hash Computation.
+  //
+  if (!SHA512_Init (&Context)) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if (!SHA512_Update (&Context, Fragments[Index].Data, Fragments[Index].DataSize)) {
+      return FALSE;
+    }
+  }
+
+  if (!SHA512_Final (HashValue, &Context)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
@@ -396,6 +396,85 @@ Done:
   return RetVal;
 }
 
+/**
+  Computes the HMAC digest of data held in several buffers.
+
+  @param[in]   MdName         Name of the digest to be used for HMAC.
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC digest value.
+
+  @retval TRUE   HMAC digest computation succeeded.
+  @retval FALSE  HMAC digest computation failed.
+
+**/
+STATIC
+BOOLEAN
+HmacMdAllSg (
+  IN   CONST CHAR8            *MdName,
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  EVP_MAC      *Mac;
+  EVP_MAC_CTX  *Ctx;
+  OSSL_PARAM   Params[2];
+  size_t       MacSize;
+  size_t       Length;
+  UINTN        Index;
+  BOOLEAN      RetVal;
+
+  //
+  // Check input parameters.
+  //
+  if ((Key == NULL) || (HmacValue == NULL) || (KeySize > INT_MAX) || ((Fragments == NULL) && (FragmentCount != 0))) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Data == NULL) && (Fragments[Index].DataSize != 0)) {
+      return FALSE;
+    }
+  }
+
+  Mac = EVP_MAC_fetch (NULL, "HMAC", NULL);
+  if (Mac == NULL) {
+    return FALSE;
+  }
+
+  Ctx = EVP_MAC_CTX_new (Mac);
+  EVP_MAC_free (Mac);
+  if (Ctx == NULL) {
+    return FALSE;
+  }
+
+  Params[0] = OSSL_PARAM_construct_utf8_string (
+                OSSL_MAC_PARAM_DIGEST,
+                (char *)MdName,
+                0
+                );
+  Params[1] = OSSL_PARAM_construct_end ();
+
+  RetVal = (BOOLEAN)(EVP_MAC_init (Ctx, Key, (UINTN)KeySize, Params) == 1);
+  for (Index = 0; RetVal && (Index < FragmentCount); Index++) {
+    RetVal = (BOOLEAN)(EVP_MAC_update (Ctx, Fragments[Index].Data, Fragments[Index].DataSize) == 1);
+  }
+
+  if (RetVal) {
+    MacSize = EVP_MAC_CTX_get_mac_size (Ctx);
+    RetVal  = (BOOLEAN)(EVP_MAC_final (Ctx, HmacValue, &Length, MacSize) == 1);
+  }
+
+  EVP_MAC_CTX_free (Ctx);
+
+  return RetVal;
+}
+
 /**
   Allocates and initializes one HMAC context for subsequent HMAC-SHA256 use.  // MU_CHANGE
 
@@ -567,6 +646,40 @@ HmacSha256All (
   return HmacMdAll ("SHA256", Data, DataSize, Key, KeySize, HmacValue);  // MU_CHANGE
 }
 
+/**
+  Computes the HMAC-SHA256 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA256 digest
+                              value (32 bytes).
+
+  @retval TRUE   HMAC-SHA256 digest computation succeeded.
+  @retval FALSE  HMAC-SHA256 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha256AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  return HmacMdAllSg ("SHA256", Fragments, FragmentCount, Key, KeySize, HmacValue);
+}
+
 /**
   Allocates and initializes one HMAC context for subsequent HMAC-SHA384 use.  // MU_CHANGE
 
@@ -745,3 +858,37 @@ HmacSha384All (
 {
   return HmacMdAll ("SHA384", Data, DataSize, Key, KeySize, HmacValue);  // MU_CHANGE
 }
+
+/**
+  Computes the HMAC-SHA384 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA384 digest
+                              value (48 bytes).
+
+  @retval TRUE   HMAC-SHA384 digest computation succeeded.
+  @retval FALSE  HMAC-SHA384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha384AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  return HmacMdAllSg ("SHA384", Fragments, FragmentCount, Key, KeySize, HmacValue);
+}
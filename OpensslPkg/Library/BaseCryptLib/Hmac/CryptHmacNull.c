@@ -172,6 +172,41 @@ HmacSha256All (
   return FALSE;
 }
 
+/**
+  Computes the HMAC-SHA256 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA256 digest
+                              value (32 bytes).
+
+  @retval TRUE   HMAC-SHA256 digest computation succeeded.
+  @retval FALSE  HMAC-SHA256 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha256AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
 /**
   Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA384 use.
 
@@ -357,3 +392,38 @@ HmacSha384All (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Computes the HMAC-SHA384 digest of data held in several buffers.
+
+  This function authenticates the fragments described by Fragments in array
+  order, as if they were one contiguous buffer, and places the digest value
+  into the specified memory.
+
+  If this interface is not supported, then return FALSE.
+
+  @param[in]   Fragments      Pointer to an array of data fragments.
+  @param[in]   FragmentCount  Number of entries in Fragments.
+  @param[in]   Key            Pointer to the user-supplied key.
+  @param[in]   KeySize        Key size in bytes.
+  @param[out]  HmacValue      Pointer to a buffer that receives the HMAC-SHA384 digest
+                              value (48 bytes).
+
+  @retval TRUE   HMAC-SHA384 digest computation succeeded.
+  @retval FALSE  HMAC-SHA384 digest computation failed.
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+HmacSha384AllSg (
+  IN   CONST CRYPTO_SG_ENTRY  *Fragments,
+  IN   UINTN                  FragmentCount,
+  IN   CONST UINT8            *Key,
+  IN   UINTN                  KeySize,
+  OUT  UINT8                  *HmacValue
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
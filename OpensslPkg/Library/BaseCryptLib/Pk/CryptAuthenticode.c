@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "InternalCryptLib.h"
+#include <IndustryStandard/PeImage.h>
 
 #include <openssl/objects.h>
 #include <openssl/x509.h>
@@ -191,3 +192,372 @@ _Exit:
 
   return Status;
 }
+
+///
+/// Byte range of a PE/COFF image covered by the Authenticode digest.
+///
+typedef struct {
+  UINTN    Offset;
+  UINTN    Size;
+} AUTHENTICODE_REGION;
+
+///
+/// Digest algorithm that AuthenticodeHashImage() can compute.
+///
+typedef struct {
+  UINTN      (EFIAPI *GetContextSize)(
+    VOID
+    );
+  BOOLEAN    (EFIAPI *Init)(
+    OUT VOID  *HashContext
+    );
+  BOOLEAN    (EFIAPI *Update)(
+    IN OUT VOID        *HashContext,
+    IN     CONST VOID  *Data,
+    IN     UINTN       DataSize
+    );
+  BOOLEAN    (EFIAPI *Final)(
+    IN OUT VOID   *HashContext,
+    OUT    UINT8  *HashValue
+    );
+} AUTHENTICODE_HASH_ALGORITHM;
+
+//
+// Algorithms in the order of the digest parameters of AuthenticodeHashImage().
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST AUTHENTICODE_HASH_ALGORITHM  mAuthenticodeHashAlgorithms[] = {
+ #ifndef DISABLE_SHA1_DEPRECATED_INTERFACES
+  { Sha1GetContextSize,   Sha1Init,   Sha1Update,   Sha1Final   },
+ #else
+  { NULL,                 NULL,       NULL,         NULL        },
+ #endif
+  { Sha256GetContextSize, Sha256Init, Sha256Update, Sha256Final },
+  { Sha384GetContextSize, Sha384Init, Sha384Update, Sha384Final }
+};
+
+//
+// Each region is hashed in chunks of this size by every requested algorithm
+// in turn, so the image is streamed from memory once for all of them.
+//
+#define AUTHENTICODE_HASH_CHUNK_SIZE  SIZE_64KB
+
+/**
+  Build the list of PE/COFF image regions covered by the Authenticode digest,
+  as described in "Windows Authenticode Portable Executable Signature Format":
+  the headers without the CheckSum field and the Certificate Table data
+  directory entry, the sections in PointerToRawData order, and any data that
+  follows the last section except the attribute certificate table.
+
+  Caution: This function may receive untrusted input.
+  PE/COFF image is external input, so this function will validate every offset
+  against ImageSize.
+
+  @param[in]   Image        Pointer to the PE/COFF image file in memory.
+  @param[in]   ImageSize    Size of the image in bytes.
+  @param[out]  Regions      Allocated array of regions. It's caller's
+                            responsibility to free it with FreePool().
+  @param[out]  RegionCount  Number of entries in Regions.
+
+  @retval TRUE   The region list was built.
+  @retval FALSE  The image is malformed or the list could not be allocated.
+
+**/
+STATIC
+BOOLEAN
+AuthenticodeGetImageRegions (
+  IN  CONST UINT8          *Image,
+  IN  UINTN                ImageSize,
+  OUT AUTHENTICODE_REGION  **Regions,
+  OUT UINTN                *RegionCount
+  )
+{
+  EFI_IMAGE_OPTIONAL_HEADER_PTR_UNION  Hdr;
+  EFI_IMAGE_SECTION_HEADER             *Section;
+  EFI_IMAGE_DATA_DIRECTORY             *SecDataDir;
+  AUTHENTICODE_REGION                  *List;
+  AUTHENTICODE_REGION                  Region;
+  UINTN                                PeCoffHeaderOffset;
+  UINTN                                OptionalHeaderOffset;
+  UINTN                                SectionHeaderOffset;
+  UINTN                                NumberOfSections;
+  UINTN                                NumberOfRvaAndSizes;
+  UINTN                                DataDirOffset;
+  UINTN                                CheckSumOffset;
+  UINTN                                SizeOfHeaders;
+  UINTN                                SumOfBytesHashed;
+  UINTN                                CertSize;
+  UINTN                                Count;
+  UINTN                                HeaderCount;
+  UINTN                                Index;
+  UINTN                                Pos;
+  UINT16                               Magic;
+
+  //
+  // Locate the PE header, after the optional DOS stub.
+  //
+  PeCoffHeaderOffset = 0;
+  if ((ImageSize >= sizeof (EFI_IMAGE_DOS_HEADER)) &&
+      (((EFI_IMAGE_DOS_HEADER *)Image)->e_magic == EFI_IMAGE_DOS_SIGNATURE))
+  {
+    PeCoffHeaderOffset = ((EFI_IMAGE_DOS_HEADER *)Image)->e_lfanew;
+  }
+
+  OptionalHeaderOffset = PeCoffHeaderOffset + OFFSET_OF (EFI_IMAGE_NT_HEADERS32, OptionalHeader);
+  if ((PeCoffHeaderOffset > ImageSize) ||
+      (ImageSize - PeCoffHeaderOffset < OFFSET_OF (EFI_IMAGE_NT_HEADERS32, OptionalHeader) + sizeof (UINT16)))
+  {
+    return FALSE;
+  }
+
+  Hdr.Pe32 = (EFI_IMAGE_NT_HEADERS32 *)(Image + PeCoffHeaderOffset);
+  if (Hdr.Pe32->Signature != EFI_IMAGE_NT_SIGNATURE) {
+    return FALSE;
+  }
+
+  //
+  // The optional header, with all the fields used below, must lie in the image.
+  //
+  Magic               = Hdr.Pe32->OptionalHeader.Magic;
+  SectionHeaderOffset = OptionalHeaderOffset + Hdr.Pe32->FileHeader.SizeOfOptionalHeader;
+  NumberOfSections    = Hdr.Pe32->FileHeader.NumberOfSections;
+  if (SectionHeaderOffset > ImageSize) {
+    return FALSE;
+  }
+
+  if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+    if (Hdr.Pe32->FileHeader.SizeOfOptionalHeader < OFFSET_OF (EFI_IMAGE_OPTIONAL_HEADER32, DataDirectory)) {
+      return FALSE;
+    }
+
+    CheckSumOffset      = OptionalHeaderOffset + OFFSET_OF (EFI_IMAGE_OPTIONAL_HEADER32, CheckSum);
+    SizeOfHeaders       = Hdr.Pe32->OptionalHeader.SizeOfHeaders;
+    NumberOfRvaAndSizes = Hdr.Pe32->OptionalHeader.NumberOfRvaAndSizes;
+    SecDataDir          = &Hdr.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY];
+  } else if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC) {
+    if (Hdr.Pe32->FileHeader.SizeOfOptionalHeader < OFFSET_OF (EFI_IMAGE_OPTIONAL_HEADER64, DataDirectory)) {
+      return FALSE;
+    }
+
+    CheckSumOffset      = OptionalHeaderOffset + OFFSET_OF (EFI_IMAGE_OPTIONAL_HEADER64, CheckSum);
+    SizeOfHeaders       = Hdr.Pe32Plus->OptionalHeader.SizeOfHeaders;
+    NumberOfRvaAndSizes = Hdr.Pe32Plus->OptionalHeader.NumberOfRvaAndSizes;
+    SecDataDir          = &Hdr.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY];
+  } else {
+    return FALSE;
+  }
+
+  //
+  // Only the data directory entries covered by SizeOfOptionalHeader exist.
+  //
+  DataDirOffset = (UINTN)((UINT8 *)SecDataDir - Image) - EFI_IMAGE_DIRECTORY_ENTRY_SECURITY * sizeof (EFI_IMAGE_DATA_DIRECTORY);
+  if (NumberOfRvaAndSizes > (SectionHeaderOffset - DataDirOffset) / sizeof (EFI_IMAGE_DATA_DIRECTORY)) {
+    return FALSE;
+  }
+
+  if ((SizeOfHeaders > ImageSize) || (SizeOfHeaders < SectionHeaderOffset) ||
+      (NumberOfSections > (ImageSize - SectionHeaderOffset) / sizeof (EFI_IMAGE_SECTION_HEADER)))
+  {
+    return FALSE;
+  }
+
+  //
+  // At most three header regions, one region per section and the trailer.
+  //
+  List = AllocatePool ((NumberOfSections + 4) * sizeof (AUTHENTICODE_REGION));
+  if (List == NULL) {
+    return FALSE;
+  }
+
+  Count = 0;
+
+  //
+  // Headers: skip the CheckSum field and, if present, the Certificate Table
+  // data directory entry.
+  //
+  List[Count].Offset = 0;
+  List[Count].Size   = CheckSumOffset;
+  Count++;
+
+  if (NumberOfRvaAndSizes <= EFI_IMAGE_DIRECTORY_ENTRY_SECURITY) {
+    List[Count].Offset = CheckSumOffset + sizeof (UINT32);
+    List[Count].Size   = SizeOfHeaders - List[Count].Offset;
+    Count++;
+    CertSize = 0;
+  } else {
+    List[Count].Offset = CheckSumOffset + sizeof (UINT32);
+    List[Count].Size   = (UINTN)((UINT8 *)SecDataDir - Image) - List[Count].Offset;
+    Count++;
+    List[Count].Offset = (UINTN)((UINT8 *)(SecDataDir + 1) - Image);
+    List[Count].Size   = SizeOfHeaders - List[Count].Offset;
+    Count++;
+    CertSize = SecDataDir->Size;
+  }
+
+  //
+  // Sections, sorted by PointerToRawData (insertion sort on the region list).
+  //
+  HeaderCount      = Count;
+  SumOfBytesHashed = SizeOfHeaders;
+  Section          = (EFI_IMAGE_SECTION_HEADER *)(Image + SectionHeaderOffset);
+  for (Index = 0; Index < NumberOfSections; Index++, Section++) {
+    if (Section->SizeOfRawData == 0) {
+      continue;
+    }
+
+    if ((Section->PointerToRawData > ImageSize) ||
+        (Section->SizeOfRawData > ImageSize - Section->PointerToRawData) ||
+        (Section->SizeOfRawData > ImageSize - SumOfBytesHashed))
+    {
+      FreePool (List);
+      return FALSE;
+    }
+
+    Region.Offset = Section->PointerToRawData;
+    Region.Size   = Section->SizeOfRawData;
+    for (Pos = Count; (Pos > HeaderCount) && (List[Pos - 1].Offset > Region.Offset); Pos--) {
+      List[Pos] = List[Pos - 1];
+    }
+
+    List[Pos] = Region;
+    Count++;
+    SumOfBytesHashed += Section->SizeOfRawData;
+  }
+
+  //
+  // Extra data after the last section, excluding the attribute certificate table.
+  //
+  if (ImageSize > SumOfBytesHashed) {
+    if (ImageSize - SumOfBytesHashed > CertSize) {
+      List[Count].Offset = SumOfBytesHashed;
+      List[Count].Size   = ImageSize - CertSize - SumOfBytesHashed;
+      Count++;
+    } else if (ImageSize - SumOfBytesHashed < CertSize) {
+      FreePool (List);
+      return FALSE;
+    }
+  }
+
+  *Regions     = List;
+  *RegionCount = Count;
+  return TRUE;
+}
+
+/**
+  Computes the Authenticode digest of a PE/COFF image, as described in "Windows
+  Authenticode Portable Executable Signature Format", for any combination of
+  SHA-1, SHA-256 and SHA-384 in a single pass over the image.
+
+  The digest covers the headers without the CheckSum field and the Certificate
+  Table entry, the sections in PointerToRawData order and any trailing data
+  except the attribute certificate table. The image is hashed in place through
+  a list of regions; nothing is copied. A digest is computed for each non-NULL
+  output buffer, so one call yields every hash needed for db/dbx lookups.
+
+  If Image is NULL, then return FALSE.
+  If all of Sha1Digest, Sha256Digest and Sha384Digest are NULL, then return FALSE.
+
+  Caution: This function may receive untrusted input.
+  PE/COFF image is external input, so this function will do basic check for
+  PE/COFF header and section table structure.
+
+  @param[in]   Image         Pointer to the PE/COFF image file in memory.
+  @param[in]   ImageSize     Size of the image in bytes.
+  @param[out]  Sha1Digest    Optional buffer of SHA1_DIGEST_SIZE bytes receiving
+                             the SHA-1 Authenticode digest.
+  @param[out]  Sha256Digest  Optional buffer of SHA256_DIGEST_SIZE bytes receiving
+                             the SHA-256 Authenticode digest.
+  @param[out]  Sha384Digest  Optional buffer of SHA384_DIGEST_SIZE bytes receiving
+                             the SHA-384 Authenticode digest.
+
+  @retval  TRUE   The requested digests were computed.
+  @retval  FALSE  The image is malformed, or a requested algorithm is not
+                  supported, or the digest computation failed.
+
+**/
+BOOLEAN
+EFIAPI
+AuthenticodeHashImage (
+  IN  CONST UINT8  *Image,
+  IN  UINTN        ImageSize,
+  OUT UINT8        *Sha1Digest   OPTIONAL,
+  OUT UINT8        *Sha256Digest OPTIONAL,
+  OUT UINT8        *Sha384Digest OPTIONAL
+  )
+{
+  UINT8                *Digests[ARRAY_SIZE (mAuthenticodeHashAlgorithms)];
+  VOID                 *Contexts[ARRAY_SIZE (mAuthenticodeHashAlgorithms)];
+  AUTHENTICODE_REGION  *Regions;
+  UINTN                RegionCount;
+  UINTN                Index;
+  UINTN                Alg;
+  UINTN                Offset;
+  UINTN                Remaining;
+  UINTN                ChunkSize;
+  BOOLEAN              Status;
+
+  if ((Image == NULL) || ((Sha1Digest == NULL) && (Sha256Digest == NULL) && (Sha384Digest == NULL))) {
+    return FALSE;
+  }
+
+  Digests[0] = Sha1Digest;
+  Digests[1] = Sha256Digest;
+  Digests[2] = Sha384Digest;
+  ZeroMem (Contexts, sizeof (Contexts));
+
+  if (!AuthenticodeGetImageRegions (Image, ImageSize, &Regions, &RegionCount)) {
+    return FALSE;
+  }
+
+  Status = FALSE;
+
+  for (Alg = 0; Alg < ARRAY_SIZE (mAuthenticodeHashAlgorithms); Alg++) {
+    if (Digests[Alg] == NULL) {
+      continue;
+    }
+
+    if (mAuthenticodeHashAlgorithms[Alg].GetContextSize == NULL) {
+      goto _Exit;
+    }
+
+    Contexts[Alg] = AllocatePool (mAuthenticodeHashAlgorithms[Alg].GetContextSize ());
+    if ((Contexts[Alg] == NULL) || !mAuthenticodeHashAlgorithms[Alg].Init (Contexts[Alg])) {
+      goto _Exit;
+    }
+  }
+
+  for (Index = 0; Index < RegionCount; Index++) {
+    Offset    = Regions[Index].Offset;
+    Remaining = Regions[Index].Size;
+    while (Remaining > 0) {
+      ChunkSize = MIN (Remaining, AUTHENTICODE_HASH_CHUNK_SIZE);
+      for (Alg = 0; Alg < ARRAY_SIZE (mAuthenticodeHashAlgorithms); Alg++) {
+        if ((Contexts[Alg] != NULL) &&
+            !mAuthenticodeHashAlgorithms[Alg].Update (Contexts[Alg], Image + Offset, ChunkSize))
+        {
+          goto _Exit;
+        }
+      }
+
+      Offset    += ChunkSize;
+      Remaining -= ChunkSize;
+    }
+  }
+
+  for (Alg = 0; Alg < ARRAY_SIZE (mAuthenticodeHashAlgorithms); Alg++) {
+    if ((Contexts[Alg] != NULL) && !mAuthenticodeHashAlgorithms[Alg].Final (Contexts[Alg], Digests[Alg])) {
+      goto _Exit;
+    }
+  }
+
+  Status = TRUE;
+
+_Exit:
+  for (Alg = 0; Alg < ARRAY_SIZE (mAuthenticodeHashAlgorithms); Alg++) {
+    if (Contexts[Alg] != NULL) {
+      FreePool (Contexts[Alg]);
+    }
+  }
+
+  FreePool (Regions);
+  return Status;
+}
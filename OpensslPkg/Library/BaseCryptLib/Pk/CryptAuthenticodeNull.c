@@ -43,3 +43,32 @@ AuthenticodeVerify (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Computes the Authenticode digest of a PE/COFF image for any combination of
+  SHA-1, SHA-256 and SHA-384 in a single pass over the image.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   Image         Pointer to the PE/COFF image file in memory.
+  @param[in]   ImageSize     Size of the image in bytes.
+  @param[out]  Sha1Digest    Optional buffer receiving the SHA-1 Authenticode digest.
+  @param[out]  Sha256Digest  Optional buffer receiving the SHA-256 Authenticode digest.
+  @param[out]  Sha384Digest  Optional buffer receiving the SHA-384 Authenticode digest.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+AuthenticodeHashImage (
+  IN  CONST UINT8  *Image,
+  IN  UINTN        ImageSize,
+  OUT UINT8        *Sha1Digest   OPTIONAL,
+  OUT UINT8        *Sha256Digest OPTIONAL,
+  OUT UINT8        *Sha384Digest OPTIONAL
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
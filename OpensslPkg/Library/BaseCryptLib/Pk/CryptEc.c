@@ -13,8 +13,8 @@
 // MU_CHANGE [BEGIN]
 #include <openssl/evp.h>
 #include <openssl/ecdsa.h>
-#include <openssl/param_build.h>
 #include <openssl/core_names.h>
+#include <Library/SynchronizationLib.h>
 #include "CryptEcPkeyCtx.h"
 // MU_CHANGE [END]
 
@@ -59,6 +59,232 @@ CryptoNidToOpensslNid (
   return Nid;
 }
 
+// MU_CHANGE [BEGIN]
+
+///
+/// Maximum number of pre-generated key pairs kept per curve.
+///
+#define EC_KEY_POOL_SIZE  4
+
+///
+/// Per-curve objects built once and shared by every EC context. Creating a
+/// group by curve name converts the curve constants and sets up Montgomery
+/// contexts for the field and the order on each call; duplicating a ready
+/// group, or generating a key from a ready parameter template, skips that.
+///
+/// Every field is only read or written by the owner of the curve cache, see
+/// EcCurveCacheTryLock(). Group and Params are created on first use by that
+/// owner and released by EcFreeKeyPool().
+///
+typedef struct {
+  INT32       Nid;                        ///< OpenSSL NID of the curve
+  EC_GROUP    *Group;                     ///< Duplicated by EcGroupInit()
+  EVP_PKEY    *Params;                    ///< Domain parameters for EVP keygen and peer keys
+  EVP_PKEY    *KeyPool[EC_KEY_POOL_SIZE]; ///< Key pairs generated by EcRefillKeyPool(), each handed out once
+  UINTN       KeyPoolCount;               ///< Number of valid entries in KeyPool
+} EC_CURVE_CACHE_ENTRY;
+
+STATIC EC_CURVE_CACHE_ENTRY  mEcCurveCache[] = {
+  { NID_X9_62_prime256v1, NULL, NULL },
+  { NID_secp384r1,        NULL, NULL },
+  { NID_secp521r1,        NULL, NULL },
+  { NID_brainpoolP512r1,  NULL, NULL },
+};
+
+///
+/// Non-zero while a processor owns the curve cache. Taken with
+/// EcCurveCacheTryLock(), which never waits: a caller that finds the cache
+/// owned builds the objects it needs by curve name instead, so neither an AP
+/// refill nor a caller interrupted while owning the cache can block another.
+///
+STATIC volatile UINT32  mEcCurveCacheBusy = 0;
+
+/**
+  Try to take ownership of the curve cache.
+
+  @retval TRUE   The caller owns the curve cache until EcCurveCacheUnlock().
+  @retval FALSE  Another processor, or an interrupted caller, owns it.
+**/
+STATIC
+BOOLEAN
+EcCurveCacheTryLock (
+  VOID
+  )
+{
+  return (BOOLEAN)(InterlockedCompareExchange32 (&mEcCurveCacheBusy, 0, 1) == 0);
+}
+
+/**
+  Release ownership of the curve cache taken with EcCurveCacheTryLock().
+**/
+STATIC
+VOID
+EcCurveCacheUnlock (
+  VOID
+  )
+{
+  InterlockedCompareExchange32 (&mEcCurveCacheBusy, 1, 0);
+}
+
+/**
+  Return the curve cache entry for an OpenSSL NID.
+
+  @param[in]  Nid  OpenSSL NID for the EC curve.
+
+  @return  Pointer to the cache entry, or NULL if the curve is not cached.
+**/
+STATIC
+EC_CURVE_CACHE_ENTRY *
+EcGetCurveCacheEntry (
+  IN INT32  Nid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mEcCurveCache); Index++) {
+    if (mEcCurveCache[Index].Nid == Nid) {
+      return &mEcCurveCache[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Create EC domain parameters for a curve by name.
+
+  @param[in]  CurveName  ASCII curve name.
+
+  @return  Pointer to the new parameters, to be freed with EVP_PKEY_free(),
+           or NULL on failure.
+**/
+STATIC
+EVP_PKEY *
+EcNewParams (
+  IN CONST CHAR8  *CurveName
+  )
+{
+  EVP_PKEY_CTX  *ParamCtx;
+  EVP_PKEY      *Params;
+
+  ParamCtx = EVP_PKEY_CTX_new_from_name (NULL, "EC", NULL);
+  if (ParamCtx == NULL) {
+    return NULL;
+  }
+
+  Params = NULL;
+  if ((EVP_PKEY_paramgen_init (ParamCtx) != 1) ||
+      (EVP_PKEY_CTX_set_group_name (ParamCtx, CurveName) != 1) ||
+      (EVP_PKEY_paramgen (ParamCtx, &Params) != 1))
+  {
+    Params = NULL;
+  }
+
+  EVP_PKEY_CTX_free (ParamCtx);
+  return Params;
+}
+
+/**
+  Return the cached EC domain parameters of a curve, creating them on first
+  use. Keys generated from this template, and peer keys that copy its
+  parameters, duplicate the cached group instead of building it by name.
+
+  The caller must own the curve cache. The parameters stay owned by the cache
+  and may only be used until the caller releases it.
+
+  @param[in]  Entry      Curve cache entry.
+  @param[in]  CurveName  ASCII curve name matching the entry.
+
+  @return  Pointer to the cached parameters, or NULL on failure.
+**/
+STATIC
+EVP_PKEY *
+EcGetCachedParams (
+  IN EC_CURVE_CACHE_ENTRY  *Entry,
+  IN CONST CHAR8           *CurveName
+  )
+{
+  if (Entry->Params == NULL) {
+    Entry->Params = EcNewParams (CurveName);
+  }
+
+  return Entry->Params;
+}
+
+/**
+  Generate a new EC key pair from domain parameters, so the new key
+  duplicates their ready-made group instead of rebuilding the curve by name.
+
+  @param[in]  Params  Domain parameters, or NULL.
+
+  @return  Pointer to the new key pair, or NULL on failure.
+**/
+STATIC
+EVP_PKEY *
+EcGenerateKeyPair (
+  IN EVP_PKEY  *Params
+  )
+{
+  EVP_PKEY_CTX  *KeyGenCtx;
+  EVP_PKEY      *Pkey;
+
+  if (Params == NULL) {
+    return NULL;
+  }
+
+  KeyGenCtx = EVP_PKEY_CTX_new_from_pkey (NULL, Params, NULL);
+  if (KeyGenCtx == NULL) {
+    return NULL;
+  }
+
+  Pkey = NULL;
+  if (EVP_PKEY_keygen_init (KeyGenCtx) == 1) {
+    EVP_PKEY_keygen (KeyGenCtx, &Pkey);
+  }
+
+  EVP_PKEY_CTX_free (KeyGenCtx);
+  return Pkey;
+}
+
+/**
+  Copy the EC domain parameters of a curve into a key, from the curve cache
+  when it is free, otherwise from parameters built by name for this call.
+
+  @param[in, out]  Pkey       Key receiving the parameters.
+  @param[in]       Nid        OpenSSL NID for the EC curve.
+  @param[in]       CurveName  ASCII curve name matching Nid.
+
+  @retval TRUE   The parameters were copied.
+  @retval FALSE  The parameters could not be created or copied.
+**/
+STATIC
+BOOLEAN
+EcCopyCurveParameters (
+  IN OUT EVP_PKEY     *Pkey,
+  IN     INT32        Nid,
+  IN     CONST CHAR8  *CurveName
+  )
+{
+  EC_CURVE_CACHE_ENTRY  *Entry;
+  EVP_PKEY              *Params;
+  BOOLEAN               Result;
+
+  Entry = EcGetCurveCacheEntry (Nid);
+  if ((Entry != NULL) && EcCurveCacheTryLock ()) {
+    Params = EcGetCachedParams (Entry, CurveName);
+    Result = (BOOLEAN)((Params != NULL) && (EVP_PKEY_copy_parameters (Pkey, Params) == 1));
+    EcCurveCacheUnlock ();
+    return Result;
+  }
+
+  Params = EcNewParams (CurveName);
+  Result = (BOOLEAN)((Params != NULL) && (EVP_PKEY_copy_parameters (Pkey, Params) == 1));
+  EVP_PKEY_free (Params);
+  return Result;
+}
+
+// MU_CHANGE [END]
+
 /**
   Initialize new opaque EcGroup object. This object represents an EC curve and
   and is used for calculation within this group. This object should be freed
@@ -76,7 +302,9 @@ EcGroupInit (
   IN UINTN  CryptoNid
   )
 {
-  INT32  Nid;
+  INT32                 Nid;
+  EC_CURVE_CACHE_ENTRY  *Entry; // MU_CHANGE
+  EC_GROUP              *Group; // MU_CHANGE
 
   Nid = CryptoNidToOpensslNid (CryptoNid);
 
@@ -84,6 +312,28 @@ EcGroupInit (
     return NULL;
   }
 
+  // MU_CHANGE [BEGIN]
+  // Duplicate the cached group, creating it on first use. While the curve
+  // cache is owned elsewhere, build the group by name instead.
+  Group = NULL;
+  Entry = EcGetCurveCacheEntry (Nid);
+  if ((Entry != NULL) && EcCurveCacheTryLock ()) {
+    if (Entry->Group == NULL) {
+      Entry->Group = EC_GROUP_new_by_curve_name (Nid);
+    }
+
+    if (Entry->Group != NULL) {
+      Group = EC_GROUP_dup (Entry->Group);
+    }
+
+    EcCurveCacheUnlock ();
+  }
+
+  if (Group != NULL) {
+    return Group;
+  }
+
+  // MU_CHANGE [END]
   return EC_GROUP_new_by_curve_name (Nid);
 }
 
@@ -415,7 +665,7 @@ EcPointSetCompressedCoordinates (
 // MU_CHANGE [BEGIN]
 
 /**
-  Map an OpenSSL NID to the curve name string used by EVP_PKEY_Q_keygen / OSSL_PARAM.
+  Map an OpenSSL NID to the curve name string used by EVP_PKEY_CTX_set_group_name.
 
   @param[in]  Nid  OpenSSL NID for the EC curve.
 
@@ -558,12 +808,14 @@ EcGenerateKey (
   )
 {
   // MU_CHANGE [BEGIN]
-  EC_PKEY_CTX  *EcPkeyCtx;
-  CONST CHAR8  *CurveName;
-  UINTN        HalfSize;
-  EVP_PKEY     *Pkey;
-  UINT8        PubKeyBuf[133];
-  UINTN        PubKeyBufLen;
+  EC_PKEY_CTX           *EcPkeyCtx;
+  CONST CHAR8           *CurveName;
+  UINTN                 HalfSize;
+  EVP_PKEY              *Pkey;
+  EVP_PKEY              *Params;
+  EC_CURVE_CACHE_ENTRY  *Entry;
+  UINT8                 PubKeyBuf[133];
+  UINTN                 PubKeyBufLen;
 
   // MU_CHANGE [END]
 
@@ -605,7 +857,30 @@ EcGenerateKey (
   }
 
   // MU_CHANGE [BEGIN]
-  Pkey = EVP_PKEY_Q_keygen (NULL, NULL, "EC", CurveName);
+  // Take a key pair pre-generated by EcRefillKeyPool() if there is one, so
+  // the scalar multiplication is not paid on this call. A pooled key is
+  // removed from the pool and never handed out again. Otherwise generate a
+  // key from the cached domain parameters. While the curve cache is owned
+  // elsewhere, generate a key from parameters built by name instead of
+  // waiting.
+  Pkey  = NULL;
+  Entry = EcGetCurveCacheEntry (EcPkeyCtx->Nid);
+  if ((Entry != NULL) && EcCurveCacheTryLock ()) {
+    if (Entry->KeyPoolCount > 0) {
+      Entry->KeyPoolCount--;
+      Pkey                                = Entry->KeyPool[Entry->KeyPoolCount];
+      Entry->KeyPool[Entry->KeyPoolCount] = NULL;
+    } else {
+      Pkey = EcGenerateKeyPair (EcGetCachedParams (Entry, CurveName));
+    }
+
+    EcCurveCacheUnlock ();
+  } else {
+    Params = EcNewParams (CurveName);
+    Pkey   = EcGenerateKeyPair (Params);
+    EVP_PKEY_free (Params);
+  }
+
   if (Pkey == NULL) {
     return FALSE;
     // MU_CHANGE [END]
@@ -641,6 +916,135 @@ EcGenerateKey (
   return TRUE;  // MU_CHANGE
 }
 
+// MU_CHANGE [BEGIN]
+
+/**
+  Pre-generates EC key pairs for the given curve, to be handed out by later
+  EcGenerateKey() calls on contexts of that curve.
+
+  Key generation costs a scalar multiplication, which sits on the critical
+  path of an ECDHE key exchange. Calling this function at idle time moves
+  that cost out of the exchange. Up to Count key pairs are generated, and the
+  pool never holds more than a small fixed number of them. Each pooled key
+  pair is used by exactly one EcGenerateKey() call and freed with the EC
+  context that received it. While the pool is empty, EcGenerateKey()
+  generates a new key pair as before.
+
+  The pools and the shared per-curve objects are owned by one caller at a
+  time. A refill that finds them owned by another processor returns FALSE
+  without generating anything, and an EcGenerateKey() call that finds them
+  owned generates a fresh key pair from parameters built by name. The lock
+  only protects the curve cache: the rest of BaseCryptLib is not MP-safe, so
+  a refill from an AP must not run at the same time as other crypto calls.
+
+  Pooled private keys stay in memory until they are handed out or released
+  with EcFreeKeyPool(). Call EcFreeKeyPool() before that memory is given up,
+  e.g. at ExitBootServices.
+
+  This function uses pseudo random number generator. The caller must make
+  sure RandomSeed() function was properly called before.
+
+  @param[in]  Nid    Identifying number for the ECC curve (Defined in
+                     BaseCryptLib.h).
+  @param[in]  Count  Maximum number of key pairs to generate.
+
+  @retval TRUE   The pool was refilled, or was already full.
+  @retval FALSE  The curve is not supported, or key generation failed.
+  @retval FALSE  The pools are in use by another caller.
+  @retval FALSE  This interface is not supported.
+**/
+BOOLEAN
+EFIAPI
+EcRefillKeyPool (
+  IN UINTN  Nid,
+  IN UINTN  Count
+  )
+{
+  INT32                 OpenSslNid;
+  CONST CHAR8           *CurveName;
+  EC_CURVE_CACHE_ENTRY  *Entry;
+  EVP_PKEY              *Pkey;
+  BOOLEAN               Result;
+
+  OpenSslNid = CryptoNidToOpensslNid (Nid);
+  if (OpenSslNid < 0) {
+    return FALSE;
+  }
+
+  CurveName = OpenSslNidToCurveName (OpenSslNid);
+  Entry     = EcGetCurveCacheEntry (OpenSslNid);
+  if ((CurveName == NULL) || (Entry == NULL)) {
+    return FALSE;
+  }
+
+  if (!EcCurveCacheTryLock ()) {
+    return FALSE;
+  }
+
+  Result = TRUE;
+  while ((Count > 0) && (Entry->KeyPoolCount < EC_KEY_POOL_SIZE)) {
+    Pkey = EcGenerateKeyPair (EcGetCachedParams (Entry, CurveName));
+    if (Pkey == NULL) {
+      Result = FALSE;
+      break;
+    }
+
+    Entry->KeyPool[Entry->KeyPoolCount] = Pkey;
+    Entry->KeyPoolCount++;
+    Count--;
+  }
+
+  EcCurveCacheUnlock ();
+  return Result;
+}
+
+/**
+  Releases every key pair pre-generated by EcRefillKeyPool(), and the EC
+  groups and domain parameters cached per curve.
+
+  The private scalar of each pooled key pair is cleared before its memory is
+  freed. Call this function before the memory holding the pools is given up,
+  e.g. from an ExitBootServices event, so that unused private keys do not
+  outlive the crypto provider. Later calls may fill the pools and the cache
+  again.
+
+  If another processor, or a caller this one interrupted, owns the pools,
+  this function returns without releasing anything. It never waits, so it is
+  safe to call from an event at any TPL.
+**/
+VOID
+EFIAPI
+EcFreeKeyPool (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  if (!EcCurveCacheTryLock ()) {
+    return;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mEcCurveCache); Index++) {
+    while (mEcCurveCache[Index].KeyPoolCount > 0) {
+      mEcCurveCache[Index].KeyPoolCount--;
+      //
+      // EVP_PKEY_free() clears the private scalar of an EC key.
+      //
+      EVP_PKEY_free (mEcCurveCache[Index].KeyPool[mEcCurveCache[Index].KeyPoolCount]);
+      mEcCurveCache[Index].KeyPool[mEcCurveCache[Index].KeyPoolCount] = NULL;
+    }
+
+    EC_GROUP_free (mEcCurveCache[Index].Group);
+    mEcCurveCache[Index].Group = NULL;
+    EVP_PKEY_free (mEcCurveCache[Index].Params);
+    mEcCurveCache[Index].Params = NULL;
+  }
+
+  EcCurveCacheUnlock ();
+}
+
+// MU_CHANGE [END]
+
 /**
   Gets the public key component from the established EC context.
   The Ec context should be correctly initialized by EcNewByNid, and successfully
@@ -778,15 +1182,12 @@ EcDhComputeKey (
   // MU_CHANGE [END]
   UINTN  HalfSize;
   // MU_CHANGE [BEGIN]
-  BOOLEAN         RetVal;
-  UINT8           PubKeyBuf[133];
-  UINTN           PubKeyLen;
-  OSSL_PARAM_BLD  *Bld;
-  OSSL_PARAM      *Params;
-  EVP_PKEY_CTX    *FromdataCtx;
-  EVP_PKEY        *PeerPkey;
-  EVP_PKEY_CTX    *DeriveCtx;
-  UINTN           DerivedLen;
+  BOOLEAN       RetVal;
+  UINT8         PubKeyBuf[133];
+  UINTN         PubKeyLen;
+  EVP_PKEY      *PeerPkey;
+  EVP_PKEY_CTX  *DeriveCtx;
+  UINTN         DerivedLen;
 
   // MU_CHANGE [END]
 
@@ -852,50 +1253,27 @@ EcDhComputeKey (
     PubKeyLen = 1 + HalfSize;
   }
 
-  RetVal      = FALSE;
-  Bld         = NULL;
-  Params      = NULL;
-  FromdataCtx = NULL;
-  PeerPkey    = NULL;
-  DeriveCtx   = NULL;
+  RetVal    = FALSE;
+  PeerPkey  = NULL;
+  DeriveCtx = NULL;
 
-  Bld = OSSL_PARAM_BLD_new ();
-  if (Bld == NULL) {
+  //
+  // Build the peer key on the cached domain parameters. Setting the encoded
+  // point decodes (and for compressed input, decompresses) it on that group.
+  //
+  PeerPkey = EVP_PKEY_new ();
+  if (PeerPkey == NULL) {
     goto fail;
   }
 
-  if (OSSL_PARAM_BLD_push_utf8_string (Bld, OSSL_PKEY_PARAM_GROUP_NAME, CurveName, 0) != 1) {
+  if (!EcCopyCurveParameters (PeerPkey, EcPkeyCtx->Nid, CurveName)) {
     goto fail;
   }
 
-  if (OSSL_PARAM_BLD_push_octet_string (Bld, OSSL_PKEY_PARAM_PUB_KEY, PubKeyBuf, PubKeyLen) != 1) {
+  if (EVP_PKEY_set1_encoded_public_key (PeerPkey, PubKeyBuf, PubKeyLen) != 1) {
     goto fail;
   }
 
-  Params = OSSL_PARAM_BLD_to_param (Bld);
-  if (Params == NULL) {
-    goto fail;
-    // MU_CHANGE [END]
-  }
-
-  // MU_CHANGE [BEGIN]
-  FromdataCtx = EVP_PKEY_CTX_new_from_name (NULL, "EC", NULL);
-  if (FromdataCtx == NULL) {
-    // MU_CHANGE [END]
-    goto fail;
-  }
-
-  if (EVP_PKEY_fromdata_init (FromdataCtx) != 1) {
-    // MU_CHANGE
-    goto fail;
-  }
-
-  if (EVP_PKEY_fromdata (FromdataCtx, &PeerPkey, EVP_PKEY_PUBLIC_KEY, Params) != 1) {
-    // MU_CHANGE
-    goto fail;
-  }
-
-  // MU_CHANGE [BEGIN]
   DeriveCtx = EVP_PKEY_CTX_new (EcPkeyCtx->Pkey, NULL);
   if (DeriveCtx == NULL) {
     goto fail;
@@ -921,9 +1299,6 @@ EcDhComputeKey (
 
 fail:
   // MU_CHANGE [BEGIN]
-  OSSL_PARAM_BLD_free (Bld);
-  OSSL_PARAM_free (Params);
-  EVP_PKEY_CTX_free (FromdataCtx);
   EVP_PKEY_free (PeerPkey);
   EVP_PKEY_CTX_free (DeriveCtx);
   // MU_CHANGE [END]
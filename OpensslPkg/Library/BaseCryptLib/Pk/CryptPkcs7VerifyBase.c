@@ -75,6 +75,75 @@ Pkcs7GetOctetString (
   return NULL;
 }
 
+/**
+  Extracts the attached content from a PKCS#7 context returned by Pkcs7Parse()
+  if existed.
+
+  If Pkcs7Context, Content, or ContentSize is NULL, then return FALSE.
+
+  @param[in]   Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out]  Content      Pointer to the extracted content from the PKCS#7 signedData.
+                            It's caller's responsibility to free the buffer with FreePool().
+  @param[out]  ContentSize  The size of the extracted content in bytes.
+
+  @retval     TRUE          The PKCS#7 context was correctly formatted for processing.
+  @retval     FALSE         The PKCS#7 context was not correctly formatted for processing.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetAttachedContent (
+  IN  VOID   *Pkcs7Context,
+  OUT VOID   **Content,
+  OUT UINTN  *ContentSize
+  )
+{
+  PKCS7              *Pkcs7;
+  ASN1_OCTET_STRING  *OctStr;
+
+  //
+  // Check input parameter.
+  //
+  if ((Pkcs7Context == NULL) || (Content == NULL) || (ContentSize == NULL)) {
+    return FALSE;
+  }
+
+  *Content = NULL;
+  Pkcs7    = (PKCS7 *)Pkcs7Context;
+
+  //
+  // Check for detached or attached content
+  //
+  if (PKCS7_get_detached (Pkcs7)) {
+    //
+    // No Content supplied for PKCS7 detached signedData
+    //
+    *Content     = NULL;
+    *ContentSize = 0;
+  } else {
+    //
+    // Retrieve the attached content in PKCS7 signedData
+    //
+    OctStr = Pkcs7GetOctetString (Pkcs7->d.sign->contents);
+    if (OctStr == NULL) {
+      return FALSE;
+    }
+
+    if ((OctStr->length > 0) && (OctStr->data != NULL)) {
+      *ContentSize = OctStr->length;
+      *Content     = AllocatePool (*ContentSize);
+      if (*Content == NULL) {
+        *ContentSize = 0;
+        return FALSE;
+      }
+
+      CopyMem (*Content, OctStr->data, *ContentSize);
+    }
+  }
+
+  return TRUE;
+}
+
 /**
   Extracts the attached content from a PKCS#7 signed data if existed. The input signed
   data could be wrapped in a ContentInfo structure.
@@ -104,13 +173,8 @@ Pkcs7GetAttachedContent (
   OUT UINTN        *ContentSize
   )
 {
-  BOOLEAN            Status;
-  PKCS7              *Pkcs7;
-  UINT8              *SignedData;
-  UINTN              SignedDataSize;
-  BOOLEAN            Wrapped;
-  CONST UINT8        *Temp;
-  ASN1_OCTET_STRING  *OctStr;
+  BOOLEAN  Status;
+  VOID     *Pkcs7Context;
 
   //
   // Check input parameter.
@@ -119,75 +183,223 @@ Pkcs7GetAttachedContent (
     return FALSE;
   }
 
-  *Content   = NULL;
-  Pkcs7      = NULL;
-  SignedData = NULL;
-  OctStr     = NULL;
+  *Content = NULL;
 
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &SignedData, &SignedDataSize);
-  if (!Status || (SignedDataSize > INT_MAX)) {
-    goto _Exit;
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
+    return FALSE;
   }
 
-  Status = FALSE;
+  Status = Pkcs7ParsedGetAttachedContent (Pkcs7Context, Content, ContentSize);
+
+  Pkcs7ParsedFree (Pkcs7Context);
+  return Status;
+}
+
+/**
+  Read the identifier and definite length of the next DER element and check
+  that it is the expected one.
+
+  @param[in, out]  Ptr          On input, the element to read. On output, its contents.
+  @param[in]       End          End of the enclosing element.
+  @param[in]       Tag          Expected tag number.
+  @param[in]       Class        Expected tag class.
+  @param[in]       Constructed  Whether the element is expected to be constructed.
+  @param[out]      Length       Length of the element contents in bytes.
+
+  @retval TRUE   The element matches and lies within End.
+  @retval FALSE  The element is malformed or not the expected one.
+**/
+STATIC
+BOOLEAN
+Pkcs7DerGetTag (
+  IN OUT CONST UINT8  **Ptr,
+  IN     CONST UINT8  *End,
+  IN     INT32        Tag,
+  IN     INT32        Class,
+  IN     BOOLEAN      Constructed,
+  OUT    UINTN        *Length
+  )
+{
+  long  ObjLength;
+  int   ObjTag;
+  int   ObjClass;
+  int   Ret;
+
+  if (*Ptr >= End) {
+    return FALSE;
+  }
+
+  Ret = ASN1_get_object (Ptr, &ObjLength, &ObjTag, &ObjClass, (long)(End - *Ptr));
 
   //
-  // Decoding PKCS#7 SignedData
+  // Reject errors, indefinite lengths (BER) and unexpected elements.
   //
-  Temp  = SignedData;
-  Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (int)SignedDataSize);
-  if (Pkcs7 == NULL) {
-    goto _Exit;
+  if (((Ret & 0x80) != 0) || ((Ret & 0x01) != 0) ||
+      (ObjTag != Tag) || (ObjClass != Class) ||
+      (((Ret & V_ASN1_CONSTRUCTED) != 0) != Constructed))
+  {
+    return FALSE;
   }
 
+  *Length = (UINTN)ObjLength;
+  return TRUE;
+}
+
+///
+/// PKCS#7 content types that OpenSSL decodes as structures. Like
+/// Pkcs7GetOctetString(), Pkcs7GetAttachedContentInPlace() returns content only
+/// for id-data, or for another content type encoded as an OCTET STRING.
+///
+STATIC CONST INT32  mPkcs7NonOctetContentNids[] = {
+  NID_pkcs7_signed,
+  NID_pkcs7_enveloped,
+  NID_pkcs7_signedAndEnveloped,
+  NID_pkcs7_digest,
+  NID_pkcs7_encrypted
+};
+
+/**
+  Locates the attached content of a PKCS#7 signed data without copying it. The
+  input signed data could be wrapped in a ContentInfo structure.
+
+  On success Content points into P7Data, so it stays valid as long as P7Data
+  does and must not be freed. Only the path down to the content is decoded;
+  the content must be a DER (primitive) OCTET STRING. Use
+  Pkcs7GetAttachedContent() for BER encoded signed data. As with
+  Pkcs7GetAttachedContent(), attached content of a signedData, envelopedData,
+  signedAndEnvelopedData, digestedData or encryptedData content type is
+  rejected.
+
+  If P7Data, Content, or ContentSize is NULL, then return FALSE. If P7Length overflow,
+  then return FALSE. If the P7Data is not correctly formatted, then return FALSE.
+
+  Caution: This function may receive untrusted input. So this function will do
+           basic check for PKCS#7 data structure.
+
+  @param[in]   P7Data       Pointer to the PKCS#7 signed data to process.
+  @param[in]   P7Length     Length of the PKCS#7 signed data in bytes.
+  @param[out]  Content      Pointer to the attached content inside P7Data, or NULL
+                            for detached signedData.
+  @param[out]  ContentSize  The size of the attached content in bytes.
+
+  @retval     TRUE          The P7Data was correctly formatted for processing.
+  @retval     FALSE         The P7Data was not correctly formatted for processing.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetAttachedContentInPlace (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  OUT CONST UINT8  **Content,
+  OUT UINTN        *ContentSize
+  )
+{
+  CONST UINT8        *Ptr;
+  CONST UINT8        *End;
+  UINTN              Length;
+  CONST ASN1_OBJECT  *SignedOid;
+  CONST ASN1_OBJECT  *TypeOid;
+  CONST UINT8        *ContentType;
+  UINTN              ContentTypeLength;
+  UINTN              Index;
+
   //
-  // The type of Pkcs7 must be signedData
+  // Check input parameter.
   //
-  if (!PKCS7_type_is_signed (Pkcs7)) {
-    goto _Exit;
+  if ((P7Data == NULL) || (P7Length > INT_MAX) || (Content == NULL) || (ContentSize == NULL)) {
+    return FALSE;
+  }
+
+  *Content     = NULL;
+  *ContentSize = 0;
+
+  Ptr = P7Data;
+  End = P7Data + P7Length;
+  if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_SEQUENCE, V_ASN1_UNIVERSAL, TRUE, &Length)) {
+    return FALSE;
   }
 
+  End = Ptr + Length;
+
   //
-  // Check for detached or attached content
+  // Step into the signedData content of a ContentInfo wrapper, if present.
   //
-  if (PKCS7_get_detached (Pkcs7)) {
-    //
-    // No Content supplied for PKCS7 detached signedData
-    //
-    *Content     = NULL;
-    *ContentSize = 0;
-  } else {
-    //
-    // Retrieve the attached content in PKCS7 signedData
-    //
-    OctStr = Pkcs7GetOctetString (Pkcs7->d.sign->contents);
-    if (OctStr == NULL) {
-      goto _Exit;
+  if ((Ptr < End) && (*Ptr == V_ASN1_OBJECT)) {
+    SignedOid = OBJ_nid2obj (NID_pkcs7_signed);
+    if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_OBJECT, V_ASN1_UNIVERSAL, FALSE, &Length) ||
+        (Length != (UINTN)OBJ_length (SignedOid)) ||
+        (CompareMem (Ptr, OBJ_get0_data (SignedOid), Length) != 0))
+    {
+      return FALSE;
     }
 
-    if ((OctStr->length > 0) && (OctStr->data != NULL)) {
-      *ContentSize = OctStr->length;
-      *Content     = AllocatePool (*ContentSize);
-      if (*Content == NULL) {
-        *ContentSize = 0;
-        goto _Exit;
-      }
-
-      CopyMem (*Content, OctStr->data, *ContentSize);
+    Ptr += Length;
+    if (!Pkcs7DerGetTag (&Ptr, End, 0, V_ASN1_CONTEXT_SPECIFIC, TRUE, &Length) ||
+        !Pkcs7DerGetTag (&Ptr, Ptr + Length, V_ASN1_SEQUENCE, V_ASN1_UNIVERSAL, TRUE, &Length))
+    {
+      return FALSE;
     }
+
+    End = Ptr + Length;
+  }
+
+  //
+  // SignedData: skip version and digestAlgorithms, then enter contentInfo.
+  //
+  if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_INTEGER, V_ASN1_UNIVERSAL, FALSE, &Length)) {
+    return FALSE;
+  }
+
+  Ptr += Length;
+  if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_SET, V_ASN1_UNIVERSAL, TRUE, &Length)) {
+    return FALSE;
+  }
+
+  Ptr += Length;
+  if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_SEQUENCE, V_ASN1_UNIVERSAL, TRUE, &Length)) {
+    return FALSE;
+  }
+
+  End = Ptr + Length;
+  if (!Pkcs7DerGetTag (&Ptr, End, V_ASN1_OBJECT, V_ASN1_UNIVERSAL, FALSE, &Length)) {
+    return FALSE;
   }
 
-  Status = TRUE;
+  ContentType       = Ptr;
+  ContentTypeLength = Length;
+
+  Ptr += Length;
+  if (Ptr == End) {
+    //
+    // No Content supplied for PKCS7 detached signedData
+    //
+    return TRUE;
+  }
 
-_Exit:
   //
-  // Release Resources
+  // Check the eContentType the same way Pkcs7GetOctetString() does.
   //
-  PKCS7_free (Pkcs7);
+  for (Index = 0; Index < ARRAY_SIZE (mPkcs7NonOctetContentNids); Index++) {
+    TypeOid = OBJ_nid2obj (mPkcs7NonOctetContentNids[Index]);
+    if ((ContentTypeLength == (UINTN)OBJ_length (TypeOid)) &&
+        (CompareMem (ContentType, OBJ_get0_data (TypeOid), ContentTypeLength) == 0))
+    {
+      return FALSE;
+    }
+  }
 
-  if (!Wrapped) {
-    OPENSSL_free (SignedData);
+  if (!Pkcs7DerGetTag (&Ptr, End, 0, V_ASN1_CONTEXT_SPECIFIC, TRUE, &Length) ||
+      !Pkcs7DerGetTag (&Ptr, Ptr + Length, V_ASN1_OCTET_STRING, V_ASN1_UNIVERSAL, FALSE, &Length))
+  {
+    return FALSE;
   }
 
-  return Status;
+  if (Length > 0) {
+    *Content     = Ptr;
+    *ContentSize = Length;
+  }
+
+  return TRUE;
 }
@@ -7,8 +7,8 @@
   This external input must be validated carefully to avoid security issue like
   buffer overflow, integer overflow.
 
-  WrapPkcs7Data(), Pkcs7GetSigners(), Pkcs7Verify() will get UEFI Authenticated
-  Variable and will do basic check for data structure.
+  Pkcs7IsContentInfo(), Pkcs7Parse(), Pkcs7GetSigners(), Pkcs7Verify() will get UEFI
+  Authenticated Variable and will do basic check for data structure.
 
 Copyright (c) 2009 - 2019, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
@@ -22,114 +22,40 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <openssl/x509v3.h>
 #include <openssl/pkcs7.h>
 
-GLOBAL_REMOVE_IF_UNREFERENCED const UINT8  mOidValue[9] = { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x02 };
-
 /**
-  Check input P7Data is a wrapped ContentInfo structure or not. If not construct
-  a new structure to wrap P7Data.
+  Check whether input P7Data is a ContentInfo structure, i.e. whether the outer
+  SEQUENCE starts with a contentType OBJECT IDENTIFIER rather than with the
+  version INTEGER of a bare SignedData.
 
   Caution: This function may receive untrusted input.
   UEFI Authenticated Variable is external input, so this function will do basic
   check for PKCS#7 data structure.
 
-  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Data       Pointer to the PKCS#7 message.
   @param[in]  P7Length     Length of the PKCS#7 message in bytes.
-  @param[out] WrapFlag     If TRUE P7Data is a ContentInfo structure, otherwise
-                           return FALSE.
-  @param[out] WrapData     If return status of this function is TRUE:
-                           1) when WrapFlag is TRUE, pointer to P7Data.
-                           2) when WrapFlag is FALSE, pointer to a new ContentInfo
-                           structure. It's caller's responsibility to free this
-                           buffer.
-  @param[out] WrapDataSize Length of ContentInfo structure in bytes.
-
-  @retval     TRUE         The operation is finished successfully.
-  @retval     FALSE        The operation is failed due to lack of resources.
+
+  @retval     TRUE         P7Data is a ContentInfo structure.
+  @retval     FALSE        P7Data is not a ContentInfo structure.
 
 **/
+STATIC
 BOOLEAN
-WrapPkcs7Data (
+Pkcs7IsContentInfo (
   IN  CONST UINT8  *P7Data,
-  IN  UINTN        P7Length,
-  OUT BOOLEAN      *WrapFlag,
-  OUT UINT8        **WrapData,
-  OUT UINTN        *WrapDataSize
+  IN  UINTN        P7Length
   )
 {
-  BOOLEAN  Wrapped;
-  UINT8    *SignedData;
-
-  //
-  // Check whether input P7Data is a wrapped ContentInfo structure or not.
-  //
-  Wrapped = FALSE;
-  if ((P7Data[4] == 0x06) && (P7Data[5] == 0x09)) {
-    if (CompareMem (P7Data + 6, mOidValue, sizeof (mOidValue)) == 0) {
-      if ((P7Data[15] == 0xA0) && (P7Data[16] == 0x82)) {
-        Wrapped = TRUE;
-      }
-    }
-  }
-
-  if (Wrapped) {
-    *WrapData     = (UINT8 *)P7Data;
-    *WrapDataSize = P7Length;
-  } else {
-    //
-    // Wrap PKCS#7 signeddata to a ContentInfo structure - add a header in 19 bytes.
-    //
-    *WrapDataSize = P7Length + 19;
-    *WrapData     = malloc (*WrapDataSize);
-    if (*WrapData == NULL) {
-      *WrapFlag = Wrapped;
-      return FALSE;
-    }
-
-    SignedData = *WrapData;
-
-    //
-    // Part1: 0x30, 0x82.
-    //
-    SignedData[0] = 0x30;
-    SignedData[1] = 0x82;
-
-    //
-    // Part2: Length1 = P7Length + 19 - 4, in big endian.
-    //
-    SignedData[2] = (UINT8)(((UINT16)(*WrapDataSize - 4)) >> 8);
-    SignedData[3] = (UINT8)(((UINT16)(*WrapDataSize - 4)) & 0xff);
-
-    //
-    // Part3: 0x06, 0x09.
-    //
-    SignedData[4] = 0x06;
-    SignedData[5] = 0x09;
-
-    //
-    // Part4: OID value -- 0x2A 0x86 0x48 0x86 0xF7 0x0D 0x01 0x07 0x02.
-    //
-    CopyMem (SignedData + 6, mOidValue, sizeof (mOidValue));
-
-    //
-    // Part5: 0xA0, 0x82.
-    //
-    SignedData[15] = 0xA0;
-    SignedData[16] = 0x82;
-
-    //
-    // Part6: Length2 = P7Length, in big endian.
-    //
-    SignedData[17] = (UINT8)(((UINT16)P7Length) >> 8);
-    SignedData[18] = (UINT8)(((UINT16)P7Length) & 0xff);
+  CONST UINT8  *Temp;
+  long         Length;
+  int          Tag;
+  int          Class;
 
-    //
-    // Part7: P7Data.
-    //
-    CopyMem (SignedData + 19, P7Data, P7Length);
+  Temp = P7Data;
+  if ((ASN1_get_object (&Temp, &Length, &Tag, &Class, (long)P7Length) & 0x80) != 0) {
+    return FALSE;
   }
 
-  *WrapFlag = Wrapped;
-  return TRUE;
+  return (BOOLEAN)((Tag == V_ASN1_SEQUENCE) && (Temp < P7Data + P7Length) && (*Temp == V_ASN1_OBJECT));
 }
 
 /**
@@ -222,19 +148,111 @@ _Exit:
 }
 
 /**
-  Get the signer's certificates from PKCS#7 signed data as described in "PKCS #7:
-  Cryptographic Message Syntax Standard". The input signed data could be wrapped
-  in a ContentInfo structure.
+  Parses a PKCS#7 signed data as described in "PKCS #7: Cryptographic Message
+  Syntax Standard" into a context that can be shared by the Pkcs7Parsed*()
+  queries. The input signed data could be wrapped in a ContentInfo structure.
 
-  If P7Data, CertStack, StackLength, TrustedCert or CertLength is NULL, then
-  return FALSE. If P7Length overflow, then return FALSE.
+  The signed data is decoded only once, so a caller that needs to
+  verify the signature, retrieve the signers and check EKUs on the same blob
+  should parse it once and issue every query against the returned context.
+
+  If P7Data is NULL, then return NULL. If P7Length overflow, then return NULL.
 
   Caution: This function may receive untrusted input.
   UEFI Authenticated Variable is external input, so this function will do basic
   check for PKCS#7 data structure.
 
-  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Data       Pointer to the PKCS#7 message to parse. The buffer
+                           must stay valid and unchanged until the context is
+                           released with Pkcs7ParsedFree().
   @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+
+  @return  Pointer to the parsed PKCS#7 context, or NULL if P7Data is not a
+           valid PKCS#7 signedData. It's caller's responsibility to release it
+           with Pkcs7ParsedFree().
+
+**/
+VOID *
+EFIAPI
+Pkcs7Parse (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length
+  )
+{
+  PKCS7         *Pkcs7;
+  PKCS7_SIGNED  *SignedData;
+  CONST UINT8   *Temp;
+
+  if ((P7Data == NULL) || (P7Length > INT_MAX)) {
+    return NULL;
+  }
+
+  //
+  // Retrieve PKCS#7 Data (DER encoding) directly from the caller's buffer.
+  //
+  Temp = P7Data;
+  if (Pkcs7IsContentInfo (P7Data, P7Length)) {
+    Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (int)P7Length);
+  } else {
+    //
+    // Bare SignedData: decode it in place and attach it to a ContentInfo
+    // built in memory, instead of copying P7Data behind a synthesized
+    // ContentInfo header.
+    //
+    SignedData = d2i_PKCS7_SIGNED (NULL, (const unsigned char **)&Temp, (int)P7Length);
+    if (SignedData == NULL) {
+      return NULL;
+    }
+
+    Pkcs7 = PKCS7_new ();
+    if (Pkcs7 == NULL) {
+      PKCS7_SIGNED_free (SignedData);
+      return NULL;
+    }
+
+    Pkcs7->type   = OBJ_nid2obj (NID_pkcs7_signed);
+    Pkcs7->d.sign = SignedData;
+  }
+
+  if (Pkcs7 == NULL) {
+    return NULL;
+  }
+
+  //
+  // Check if it's PKCS#7 Signed Data (for Authenticode Scenario)
+  //
+  if (!PKCS7_type_is_signed (Pkcs7)) {
+    PKCS7_free (Pkcs7);
+    return NULL;
+  }
+
+  return Pkcs7;
+}
+
+/**
+  Release the PKCS#7 context returned by Pkcs7Parse().
+
+  If Pkcs7Context is NULL, then do nothing.
+
+  @param[in]  Pkcs7Context  Pointer to the parsed PKCS#7 context to be released.
+
+**/
+VOID
+EFIAPI
+Pkcs7ParsedFree (
+  IN  VOID  *Pkcs7Context
+  )
+{
+  PKCS7_free ((PKCS7 *)Pkcs7Context);
+}
+
+/**
+  Get the signer's certificates from a PKCS#7 context returned by Pkcs7Parse().
+
+  If Pkcs7Context, CertStack, StackLength, TrustedCert or CertLength is NULL,
+  then return FALSE.
+
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
   @param[out] CertStack    Pointer to Signer's certificates retrieved from P7Data.
                            It's caller's responsibility to free the buffer with
                            Pkcs7FreeSigners().
@@ -251,21 +269,16 @@ _Exit:
 **/
 BOOLEAN
 EFIAPI
-Pkcs7GetSigners (
-  IN  CONST UINT8  *P7Data,
-  IN  UINTN        P7Length,
-  OUT UINT8        **CertStack,
-  OUT UINTN        *StackLength,
-  OUT UINT8        **TrustedCert,
-  OUT UINTN        *CertLength
+Pkcs7ParsedGetSigners (
+  IN  VOID   *Pkcs7Context,
+  OUT UINT8  **CertStack,
+  OUT UINTN  *StackLength,
+  OUT UINT8  **TrustedCert,
+  OUT UINTN  *CertLength
   )
 {
-  PKCS7        *Pkcs7;
-  BOOLEAN      Status;
-  UINT8        *SignedData;
-  CONST UINT8  *Temp;
-  UINTN        SignedDataSize;
-  BOOLEAN      Wrapped;
+  PKCS7    *Pkcs7;
+  BOOLEAN  Status;
 
   STACK_OF (X509)   *Stack;
   UINT8  Index;
@@ -276,44 +289,19 @@ Pkcs7GetSigners (
   UINT8  *SingleCert;
   UINTN  SingleCertSize;
 
-  if ((P7Data == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
-      (TrustedCert == NULL) || (CertLength == NULL) || (P7Length > INT_MAX))
+  if ((Pkcs7Context == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
+      (TrustedCert == NULL) || (CertLength == NULL))
   {
     return FALSE;
   }
 
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &SignedData, &SignedDataSize);
-  if (!Status) {
-    return Status;
-  }
-
+  Pkcs7      = (PKCS7 *)Pkcs7Context;
   Status     = FALSE;
-  Pkcs7      = NULL;
   Stack      = NULL;
   CertBuf    = NULL;
   OldBuf     = NULL;
   SingleCert = NULL;
 
-  //
-  // Retrieve PKCS#7 Data (DER encoding)
-  //
-  if (SignedDataSize > INT_MAX) {
-    goto _Exit;
-  }
-
-  Temp  = SignedData;
-  Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (int)SignedDataSize);
-  if (Pkcs7 == NULL) {
-    goto _Exit;
-  }
-
-  //
-  // Check if it's PKCS#7 Signed Data (for Authenticode Scenario)
-  //
-  if (!PKCS7_type_is_signed (Pkcs7)) {
-    goto _Exit;
-  }
-
   Stack = PKCS7_get0_signers (Pkcs7, NULL, PKCS7_BINARY);
   if (Stack == NULL) {
     goto _Exit;
@@ -383,14 +371,6 @@ _Exit:
   //
   // Release Resources
   //
-  if (!Wrapped) {
-    free (SignedData);
-  }
-
-  if (Pkcs7 != NULL) {
-    PKCS7_free (Pkcs7);
-  }
-
   if (Stack != NULL) {
     sk_X509_pop_free (Stack, X509_free);
   }
@@ -411,6 +391,65 @@ _Exit:
   return Status;
 }
 
+/**
+  Get the signer's certificates from PKCS#7 signed data as described in "PKCS #7:
+  Cryptographic Message Syntax Standard". The input signed data could be wrapped
+  in a ContentInfo structure.
+
+  If P7Data, CertStack, StackLength, TrustedCert or CertLength is NULL, then
+  return FALSE. If P7Length overflow, then return FALSE.
+
+  Caution: This function may receive untrusted input.
+  UEFI Authenticated Variable is external input, so this function will do basic
+  check for PKCS#7 data structure.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[out] CertStack    Pointer to Signer's certificates retrieved from P7Data.
+                           It's caller's responsibility to free the buffer with
+                           Pkcs7FreeSigners().
+                           This data structure is EFI_CERT_STACK type.
+  @param[out] StackLength  Length of signer's certificates in bytes.
+  @param[out] TrustedCert  Pointer to a trusted certificate from Signer's certificates.
+                           It's caller's responsibility to free the buffer with
+                           Pkcs7FreeSigners().
+  @param[out] CertLength   Length of the trusted certificate in bytes.
+
+  @retval  TRUE            The operation is finished successfully.
+  @retval  FALSE           Error occurs during the operation.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetSigners (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  OUT UINT8        **CertStack,
+  OUT UINTN        *StackLength,
+  OUT UINT8        **TrustedCert,
+  OUT UINTN        *CertLength
+  )
+{
+  VOID     *Pkcs7Context;
+  BOOLEAN  Status;
+
+  if ((P7Data == NULL) || (CertStack == NULL) || (StackLength == NULL) ||
+      (TrustedCert == NULL) || (CertLength == NULL) || (P7Length > INT_MAX))
+  {
+    return FALSE;
+  }
+
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
+    return FALSE;
+  }
+
+  Status = Pkcs7ParsedGetSigners (Pkcs7Context, CertStack, StackLength, TrustedCert, CertLength);
+
+  Pkcs7ParsedFree (Pkcs7Context);
+  return Status;
+}
+
 /**
   Wrap function to use free() to free allocated memory for certificates.
 
@@ -431,13 +470,11 @@ Pkcs7FreeSigners (
 }
 
 /**
-  Retrieves all embedded certificates from PKCS#7 signed data as described in "PKCS #7:
-  Cryptographic Message Syntax Standard", and outputs two certificate lists chained and
-  unchained to the signer's certificates.
-  The input signed data could be wrapped in a ContentInfo structure.
+  Retrieves all embedded certificates from a PKCS#7 context returned by
+  Pkcs7Parse(), and outputs two certificate lists chained and unchained to the
+  signer's certificates.
 
-  @param[in]  P7Data            Pointer to the PKCS#7 message.
-  @param[in]  P7Length          Length of the PKCS#7 message in bytes.
+  @param[in]  Pkcs7Context      Pointer to the parsed PKCS#7 context.
   @param[out] SignerChainCerts  Pointer to the certificates list chained to signer's
                                 certificate. It's caller's responsibility to free the buffer
                                 with Pkcs7FreeSigners().
@@ -454,20 +491,15 @@ Pkcs7FreeSigners (
 **/
 BOOLEAN
 EFIAPI
-Pkcs7GetCertificatesList (
-  IN  CONST UINT8  *P7Data,
-  IN  UINTN        P7Length,
-  OUT UINT8        **SignerChainCerts,
-  OUT UINTN        *ChainLength,
-  OUT UINT8        **UnchainCerts,
-  OUT UINTN        *UnchainLength
+Pkcs7ParsedGetCertificatesList (
+  IN  VOID   *Pkcs7Context,
+  OUT UINT8  **SignerChainCerts,
+  OUT UINTN  *ChainLength,
+  OUT UINT8  **UnchainCerts,
+  OUT UINTN  *UnchainLength
   )
 {
   BOOLEAN         Status;
-  UINT8           *NewP7Data;
-  CONST UINT8     *Temp;        // MU_CHANGE
-  UINTN           NewP7Length;
-  BOOLEAN         Wrapped;
   UINT8           Index;
   PKCS7           *Pkcs7;
   X509_STORE_CTX  *CertCtx;
@@ -477,6 +509,7 @@ Pkcs7GetCertificatesList (
   X509  *CtxCert;
 
   STACK_OF (X509)   *Signers;
+  STACK_OF (X509)   *Untrusted;
   X509       *Signer;
   X509       *Cert;
   X509       *Issuer;
@@ -492,8 +525,6 @@ Pkcs7GetCertificatesList (
   // Initializations
   //
   Status       = FALSE;
-  NewP7Data    = NULL;
-  Pkcs7        = NULL;
   CertCtx      = NULL;
   CtxChain     = NULL;
   CtxCert      = NULL;
@@ -503,12 +534,13 @@ Pkcs7GetCertificatesList (
   CertBuf      = NULL;
   OldBuf       = NULL;
   Signers      = NULL;
+  Untrusted    = NULL;
 
   //
   // Parameter Checking
   //
-  if ((P7Data == NULL) || (SignerChainCerts == NULL) || (ChainLength == NULL) ||
-      (UnchainCerts == NULL) || (UnchainLength == NULL) || (P7Length > INT_MAX))
+  if ((Pkcs7Context == NULL) || (SignerChainCerts == NULL) || (ChainLength == NULL) ||
+      (UnchainCerts == NULL) || (UnchainLength == NULL))
   {
     return Status;
   }
@@ -518,24 +550,7 @@ Pkcs7GetCertificatesList (
   *UnchainCerts     = NULL;
   *UnchainLength    = 0;
 
-  //
-  // Construct a new PKCS#7 data wrapping with ContentInfo structure if needed.
-  //
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &NewP7Data, &NewP7Length);
-  if (!Status || (NewP7Length > INT_MAX)) {
-    goto _Error;
-  }
-
-  //
-  // Decodes PKCS#7 SignedData
-  //
-  // MU_CHANGE [BEGIN]
-  Temp  = NewP7Data;
-  Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (int)NewP7Length);
-  // MU_CHANGE [END]
-  if ((Pkcs7 == NULL) || (!PKCS7_type_is_signed (Pkcs7))) {
-    goto _Error;
-  }
+  Pkcs7 = (PKCS7 *)Pkcs7Context;
 
   //
   // Obtains Signer's Certificate from PKCS#7 data
@@ -549,12 +564,21 @@ Pkcs7GetCertificatesList (
 
   Signer = sk_X509_value (Signers, 0);
 
+  //
+  // The chain walk below removes certificates from the untrusted stack. Work on
+  // a shallow copy so the certificate list of the shared context stays intact.
+  //
+  Untrusted = sk_X509_dup (Pkcs7->d.sign->cert);
+  if ((Untrusted == NULL) && (Pkcs7->d.sign->cert != NULL)) {
+    goto _Error;
+  }
+
   CertCtx = X509_STORE_CTX_new ();
   if (CertCtx == NULL) {
     goto _Error;
   }
 
-  if (!X509_STORE_CTX_init (CertCtx, NULL, Signer, Pkcs7->d.sign->cert)) {
+  if (!X509_STORE_CTX_init (CertCtx, NULL, Signer, Untrusted)) {
     goto _Error;
   }
 
@@ -719,14 +743,6 @@ _Error:
   //
   // Release Resources.
   //
-  if (!Wrapped && (NewP7Data != NULL)) {
-    free (NewP7Data);
-  }
-
-  if (Pkcs7 != NULL) {
-    PKCS7_free (Pkcs7);
-  }
-
   sk_X509_free (Signers);
 
   if (CertCtx != NULL) {
@@ -734,6 +750,8 @@ _Error:
     X509_STORE_CTX_free (CertCtx);
   }
 
+  sk_X509_free (Untrusted);
+
   if (SingleCert != NULL) {
     free (SingleCert);
   }
@@ -752,67 +770,85 @@ _Error:
 }
 
 /**
-  Verifies the validity of a PKCS#7 signed data as described in "PKCS #7:
-  Cryptographic Message Syntax Standard". The input signed data could be wrapped
-  in a ContentInfo structure.
-
-  If P7Data, TrustedCert or InData is NULL, then return FALSE.
-  If P7Length, CertLength or DataLength overflow, then return FALSE.
-
-  Caution: This function may receive untrusted input.
-  UEFI Authenticated Variable is external input, so this function will do basic
-  check for PKCS#7 data structure.
+  Retrieves all embedded certificates from PKCS#7 signed data as described in "PKCS #7:
+  Cryptographic Message Syntax Standard", and outputs two certificate lists chained and
+  unchained to the signer's certificates.
+  The input signed data could be wrapped in a ContentInfo structure.
 
-  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
-  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
-  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
-                           is used for certificate chain verification.
-  @param[in]  CertLength   Length of the trusted certificate in bytes.
-  @param[in]  InData       Pointer to the content to be verified.
-  @param[in]  DataLength   Length of InData in bytes.
+  @param[in]  P7Data            Pointer to the PKCS#7 message.
+  @param[in]  P7Length          Length of the PKCS#7 message in bytes.
+  @param[out] SignerChainCerts  Pointer to the certificates list chained to signer's
+                                certificate. It's caller's responsibility to free the buffer
+                                with Pkcs7FreeSigners().
+                                This data structure is EFI_CERT_STACK type.
+  @param[out] ChainLength       Length of the chained certificates list buffer in bytes.
+  @param[out] UnchainCerts      Pointer to the unchained certificates lists. It's caller's
+                                responsibility to free the buffer with Pkcs7FreeSigners().
+                                This data structure is EFI_CERT_STACK type.
+  @param[out] UnchainLength     Length of the unchained certificates list buffer in bytes.
 
-  @retval  TRUE  The specified PKCS#7 signed data is valid.
-  @retval  FALSE Invalid PKCS#7 signed data.
+  @retval  TRUE         The operation is finished successfully.
+  @retval  FALSE        Error occurs during the operation.
 
 **/
 BOOLEAN
 EFIAPI
-Pkcs7Verify (
+Pkcs7GetCertificatesList (
   IN  CONST UINT8  *P7Data,
   IN  UINTN        P7Length,
-  IN  CONST UINT8  *TrustedCert,
-  IN  UINTN        CertLength,
-  IN  CONST UINT8  *InData,
-  IN  UINTN        DataLength
+  OUT UINT8        **SignerChainCerts,
+  OUT UINTN        *ChainLength,
+  OUT UINT8        **UnchainCerts,
+  OUT UINTN        *UnchainLength
   )
 {
-  PKCS7        *Pkcs7;
-  BIO          *DataBio;
-  BOOLEAN      Status;
-  X509         *Cert;
-  X509_STORE   *CertStore;
-  UINT8        *SignedData;
-  CONST UINT8  *Temp;
-  UINTN        SignedDataSize;
-  BOOLEAN      Wrapped;
+  VOID     *Pkcs7Context;
+  BOOLEAN  Status;
 
   //
-  // Check input parameters.
+  // Parameter Checking
   //
-  if ((P7Data == NULL) || (TrustedCert == NULL) || (InData == NULL) ||
-      (P7Length > INT_MAX) || (CertLength > INT_MAX) || (DataLength > INT_MAX))
+  if ((P7Data == NULL) || (SignerChainCerts == NULL) || (ChainLength == NULL) ||
+      (UnchainCerts == NULL) || (UnchainLength == NULL) || (P7Length > INT_MAX))
   {
     return FALSE;
   }
 
-  Pkcs7     = NULL;
-  DataBio   = NULL;
-  Cert      = NULL;
-  CertStore = NULL;
+  *SignerChainCerts = NULL;
+  *ChainLength      = 0;
+  *UnchainCerts     = NULL;
+  *UnchainLength    = 0;
 
-  //
-  // Register & Initialize necessary digest algorithms for PKCS#7 Handling
-  //
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
+    return FALSE;
+  }
+
+  Status = Pkcs7ParsedGetCertificatesList (
+             Pkcs7Context,
+             SignerChainCerts,
+             ChainLength,
+             UnchainCerts,
+             UnchainLength
+             );
+
+  Pkcs7ParsedFree (Pkcs7Context);
+  return Status;
+}
+
+/**
+  Register & Initialize necessary digest algorithms for PKCS#7 Handling.
+
+  @retval  TRUE   The digest algorithms are registered.
+  @retval  FALSE  Failed to register one of the digest algorithms.
+
+**/
+STATIC
+BOOLEAN
+Pkcs7AddDigests (
+  VOID
+  )
+{
   if (EVP_add_digest (EVP_md5 ()) == 0) {
     return FALSE;
   }
@@ -837,32 +873,31 @@ Pkcs7Verify (
     return FALSE;
   }
 
-  Status = WrapPkcs7Data (P7Data, P7Length, &Wrapped, &SignedData, &SignedDataSize);
-  if (!Status) {
-    return Status;
-  }
+  return TRUE;
+}
 
-  Status = FALSE;
+/**
+  Create an X509 store holding one trusted certificate, set up for PKCS#7
+  verification.
 
-  //
-  // Retrieve PKCS#7 Data (DER encoding)
-  //
-  if (SignedDataSize > INT_MAX) {
-    goto _Exit;
-  }
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
 
-  Temp  = SignedData;
-  Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (int)SignedDataSize);
-  if (Pkcs7 == NULL) {
-    goto _Exit;
-  }
+  @return  Pointer to the X509 store, or NULL on failure. It's caller's
+           responsibility to release it with X509_STORE_free().
 
-  //
-  // Check if it's PKCS#7 Signed Data (for Authenticode Scenario)
-  //
-  if (!PKCS7_type_is_signed (Pkcs7)) {
-    goto _Exit;
-  }
+**/
+STATIC
+X509_STORE *
+Pkcs7CreateTrustedStore (
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength
+  )
+{
+  X509         *Cert;
+  X509_STORE   *CertStore;
+  CONST UINT8  *Temp;
 
   //
   // Read DER-encoded root certificate and Construct X509 Certificate
@@ -870,29 +905,20 @@ Pkcs7Verify (
   Temp = TrustedCert;
   Cert = d2i_X509 (NULL, &Temp, (long)CertLength);
   if (Cert == NULL) {
-    goto _Exit;
+    return NULL;
   }
 
   //
   // Setup X509 Store for trusted certificate
   //
   CertStore = X509_STORE_new ();
-  if (CertStore == NULL) {
-    goto _Exit;
-  }
-
-  if (!(X509_STORE_add_cert (CertStore, Cert))) {
-    goto _Exit;
+  if ((CertStore == NULL) || !(X509_STORE_add_cert (CertStore, Cert))) {
+    X509_STORE_free (CertStore);
+    X509_free (Cert);
+    return NULL;
   }
 
-  //
-  // For generic PKCS#7 handling, InData may be NULL if the content is present
-  // in PKCS#7 structure. So ignore NULL checking here.
-  //
-  DataBio = BIO_new_mem_buf (InData, (int)DataLength);
-  if (DataBio == NULL) {
-    goto _Exit;
-  }
+  X509_free (Cert);
 
   //
   // Allow partial certificate chains, terminated by a non-self-signed but
@@ -910,23 +936,417 @@ Pkcs7Verify (
   //
   X509_STORE_set_purpose (CertStore, X509_PURPOSE_ANY);
 
+  return CertStore;
+}
+
+/**
+  Verifies the validity of a PKCS#7 context returned by Pkcs7Parse().
+
+  If Pkcs7Context, TrustedCert or InData is NULL, then return FALSE.
+  If CertLength or DataLength overflow, then return FALSE.
+
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+  @param[in]  InData       Pointer to the content to be verified.
+  @param[in]  DataLength   Length of InData in bytes.
+
+  @retval  TRUE  The specified PKCS#7 signed data is valid.
+  @retval  FALSE Invalid PKCS#7 signed data.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedVerify (
+  IN  VOID         *Pkcs7Context,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength,
+  IN  CONST UINT8  *InData,
+  IN  UINTN        DataLength
+  )
+{
+  BIO         *DataBio;
+  BOOLEAN     Status;
+  X509_STORE  *CertStore;
+
+  //
+  // Check input parameters.
+  //
+  if ((Pkcs7Context == NULL) || (TrustedCert == NULL) || (InData == NULL) ||
+      (CertLength > INT_MAX) || (DataLength > INT_MAX))
+  {
+    return FALSE;
+  }
+
+  Status  = FALSE;
+  DataBio = NULL;
+
+  if (!Pkcs7AddDigests ()) {
+    return FALSE;
+  }
+
+  CertStore = Pkcs7CreateTrustedStore (TrustedCert, CertLength);
+  if (CertStore == NULL) {
+    goto _Exit;
+  }
+
+  //
+  // For generic PKCS#7 handling, InData may be NULL if the content is present
+  // in PKCS#7 structure. So ignore NULL checking here.
+  //
+  DataBio = BIO_new_mem_buf (InData, (int)DataLength);
+  if (DataBio == NULL) {
+    goto _Exit;
+  }
+
   //
   // Verifies the PKCS#7 signedData structure
   //
-  Status = (BOOLEAN)PKCS7_verify (Pkcs7, NULL, CertStore, DataBio, NULL, PKCS7_BINARY);
+  Status = (BOOLEAN)PKCS7_verify ((PKCS7 *)Pkcs7Context, NULL, CertStore, DataBio, NULL, PKCS7_BINARY);
 
 _Exit:
   //
   // Release Resources
   //
   BIO_free (DataBio);
-  X509_free (Cert);
   X509_STORE_free (CertStore);
-  PKCS7_free (Pkcs7);
 
-  if (!Wrapped) {
-    OPENSSL_free (SignedData);
+  return Status;
+}
+
+/**
+  Verifies the validity of a PKCS#7 signed data as described in "PKCS #7:
+  Cryptographic Message Syntax Standard". The input signed data could be wrapped
+  in a ContentInfo structure.
+
+  If P7Data, TrustedCert or InData is NULL, then return FALSE.
+  If P7Length, CertLength or DataLength overflow, then return FALSE.
+
+  Caution: This function may receive untrusted input.
+  UEFI Authenticated Variable is external input, so this function will do basic
+  check for PKCS#7 data structure.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+  @param[in]  InData       Pointer to the content to be verified.
+  @param[in]  DataLength   Length of InData in bytes.
+
+  @retval  TRUE  The specified PKCS#7 signed data is valid.
+  @retval  FALSE Invalid PKCS#7 signed data.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7Verify (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength,
+  IN  CONST UINT8  *InData,
+  IN  UINTN        DataLength
+  )
+{
+  VOID     *Pkcs7Context;
+  BOOLEAN  Status;
+
+  //
+  // Check input parameters.
+  //
+  if ((P7Data == NULL) || (TrustedCert == NULL) || (InData == NULL) ||
+      (P7Length > INT_MAX) || (CertLength > INT_MAX) || (DataLength > INT_MAX))
+  {
+    return FALSE;
   }
 
+  Pkcs7Context = Pkcs7Parse (P7Data, P7Length);
+  if (Pkcs7Context == NULL) {
+    return FALSE;
+  }
+
+  Status = Pkcs7ParsedVerify (Pkcs7Context, TrustedCert, CertLength, InData, DataLength);
+
+  Pkcs7ParsedFree (Pkcs7Context);
   return Status;
 }
+
+///
+/// Context of a streaming PKCS#7 verification started by Pkcs7VerifyInit().
+///
+typedef struct {
+  ///
+  /// Parsed PKCS#7 signedData.
+  ///
+  PKCS7             *Pkcs7;
+  ///
+  /// Signer certificates, in SignerInfo order, already verified against the
+  /// trusted certificate.
+  ///
+  STACK_OF (X509)   *Signers;
+  ///
+  /// Chain of message digest BIOs, one per digest algorithm of the signedData,
+  /// terminated by a null sink. Content written to it is hashed and dropped.
+  ///
+  BIO               *DigestBio;
+  ///
+  /// Set once Pkcs7VerifyFinal() has run.
+  ///
+  BOOLEAN           Finished;
+} PKCS7_STREAM_VERIFY_CTX;
+
+/**
+  Starts an incremental verification of a PKCS#7 signed data with detached
+  content as described in "PKCS #7: Cryptographic Message Syntax Standard".
+  The input signed data could be wrapped in a ContentInfo structure.
+
+  The signer certificates are verified against TrustedCert here. The detached
+  content is then fed in chunks with Pkcs7VerifyUpdate() and hashed as it
+  arrives, so it never has to be resident in one buffer, and the signatures
+  are checked by Pkcs7VerifyFinal().
+
+  If P7Data or TrustedCert is NULL, then return NULL.
+  If P7Length or CertLength overflow, then return NULL.
+
+  Caution: This function may receive untrusted input.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify. The buffer
+                           must stay valid and unchanged until the context is
+                           released with Pkcs7VerifyFree().
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+
+  @return  Pointer to the verification context, or NULL if P7Data is not a valid
+           PKCS#7 signedData or its signers are not trusted. It's caller's
+           responsibility to release it with Pkcs7VerifyFree().
+
+**/
+VOID *
+EFIAPI
+Pkcs7VerifyInit (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength
+  )
+{
+  PKCS7_STREAM_VERIFY_CTX  *VerifyCtx;
+  X509_STORE               *CertStore;
+  BIO                      *EmptyBio;
+  BIO                      *SinkBio;
+  BOOLEAN                  Status;
+
+  if ((P7Data == NULL) || (TrustedCert == NULL) ||
+      (P7Length > INT_MAX) || (CertLength > INT_MAX))
+  {
+    return NULL;
+  }
+
+  if (!Pkcs7AddDigests ()) {
+    return NULL;
+  }
+
+  VerifyCtx = AllocateZeroPool (sizeof (PKCS7_STREAM_VERIFY_CTX));
+  if (VerifyCtx == NULL) {
+    return NULL;
+  }
+
+  Status    = FALSE;
+  CertStore = NULL;
+  EmptyBio  = NULL;
+
+  VerifyCtx->Pkcs7 = Pkcs7Parse (P7Data, P7Length);
+  if (VerifyCtx->Pkcs7 == NULL) {
+    goto _Exit;
+  }
+
+  CertStore = Pkcs7CreateTrustedStore (TrustedCert, CertLength);
+  if (CertStore == NULL) {
+    goto _Exit;
+  }
+
+  //
+  // Verify the signer certificate chains now. The signatures are skipped, so
+  // an empty content BIO is enough to satisfy PKCS7_verify().
+  //
+  EmptyBio = BIO_new (BIO_s_mem ());
+  if (EmptyBio == NULL) {
+    goto _Exit;
+  }
+
+  if (PKCS7_verify (VerifyCtx->Pkcs7, NULL, CertStore, EmptyBio, NULL, PKCS7_BINARY | PKCS7_NOSIGS) != 1) {
+    goto _Exit;
+  }
+
+  VerifyCtx->Signers = PKCS7_get0_signers (VerifyCtx->Pkcs7, NULL, PKCS7_BINARY);
+  if (VerifyCtx->Signers == NULL) {
+    goto _Exit;
+  }
+
+  //
+  // Build the message digest BIO chain over a null sink. On success the chain
+  // owns SinkBio.
+  //
+  SinkBio = BIO_new (BIO_s_null ());
+  if (SinkBio == NULL) {
+    goto _Exit;
+  }
+
+  VerifyCtx->DigestBio = PKCS7_dataInit (VerifyCtx->Pkcs7, SinkBio);
+  if (VerifyCtx->DigestBio == NULL) {
+    BIO_free (SinkBio);
+    goto _Exit;
+  }
+
+  Status = TRUE;
+
+_Exit:
+  BIO_free (EmptyBio);
+  X509_STORE_free (CertStore);
+
+  if (!Status) {
+    Pkcs7VerifyFree (VerifyCtx);
+    return NULL;
+  }
+
+  return VerifyCtx;
+}
+
+/**
+  Hashes the next chunk of the detached content into a verification context
+  returned by Pkcs7VerifyInit().
+
+  If Pkcs7VerifyContext is NULL, then return FALSE.
+  If Data is NULL and DataSize is not zero, then return FALSE.
+  If Pkcs7VerifyFinal() was already called on the context, then return FALSE.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+  @param[in]  Data                Pointer to the next chunk of content.
+  @param[in]  DataSize            Size of Data in bytes.
+
+  @retval  TRUE   The content chunk was hashed.
+  @retval  FALSE  The content chunk could not be hashed.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyUpdate (
+  IN  VOID        *Pkcs7VerifyContext,
+  IN  CONST VOID  *Data,
+  IN  UINTN       DataSize
+  )
+{
+  PKCS7_STREAM_VERIFY_CTX  *VerifyCtx;
+  CONST UINT8              *Chunk;
+  INTN                     ChunkSize;
+
+  if ((Pkcs7VerifyContext == NULL) || ((Data == NULL) && (DataSize != 0))) {
+    return FALSE;
+  }
+
+  VerifyCtx = (PKCS7_STREAM_VERIFY_CTX *)Pkcs7VerifyContext;
+  Chunk     = (CONST UINT8 *)Data;
+  if (VerifyCtx->Finished) {
+    return FALSE;
+  }
+
+  while (DataSize > 0) {
+    ChunkSize = (INTN)MIN (DataSize, INT_MAX);
+    if (BIO_write (VerifyCtx->DigestBio, Chunk, (int)ChunkSize) != ChunkSize) {
+      return FALSE;
+    }
+
+    Chunk    += ChunkSize;
+    DataSize -= ChunkSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Completes the verification started by Pkcs7VerifyInit(): checks the signed
+  attributes message digest against the hashed content, and the signature of
+  every signer.
+
+  The context is not released; call Pkcs7VerifyFree() afterwards.
+
+  If Pkcs7VerifyContext is NULL, then return FALSE.
+  If Pkcs7VerifyFinal() was already called on the context, then return FALSE.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+
+  @retval  TRUE  The specified PKCS#7 signed data is valid for the content.
+  @retval  FALSE Invalid PKCS#7 signed data.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyFinal (
+  IN  VOID  *Pkcs7VerifyContext
+  )
+{
+  PKCS7_STREAM_VERIFY_CTX       *VerifyCtx;
+  STACK_OF (PKCS7_SIGNER_INFO)  *SignerInfos;
+  INTN                          Index;
+
+  if (Pkcs7VerifyContext == NULL) {
+    return FALSE;
+  }
+
+  VerifyCtx = (PKCS7_STREAM_VERIFY_CTX *)Pkcs7VerifyContext;
+  if (VerifyCtx->Finished) {
+    return FALSE;
+  }
+
+  VerifyCtx->Finished = TRUE;
+
+  SignerInfos = PKCS7_get_signer_info (VerifyCtx->Pkcs7);
+  if ((SignerInfos == NULL) || (sk_X509_num (VerifyCtx->Signers) <= 0)) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < sk_X509_num (VerifyCtx->Signers); Index++) {
+    if (PKCS7_signatureVerify (
+          VerifyCtx->DigestBio,
+          VerifyCtx->Pkcs7,
+          sk_PKCS7_SIGNER_INFO_value (SignerInfos, (int)Index),
+          sk_X509_value (VerifyCtx->Signers, (int)Index)
+          ) <= 0)
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Release the verification context returned by Pkcs7VerifyInit().
+
+  If Pkcs7VerifyContext is NULL, then do nothing.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context to be released.
+
+**/
+VOID
+EFIAPI
+Pkcs7VerifyFree (
+  IN  VOID  *Pkcs7VerifyContext
+  )
+{
+  PKCS7_STREAM_VERIFY_CTX  *VerifyCtx;
+
+  if (Pkcs7VerifyContext == NULL) {
+    return;
+  }
+
+  VerifyCtx = (PKCS7_STREAM_VERIFY_CTX *)Pkcs7VerifyContext;
+  BIO_free_all (VerifyCtx->DigestBio);
+  sk_X509_free (VerifyCtx->Signers);
+  Pkcs7ParsedFree (VerifyCtx->Pkcs7);
+  FreePool (VerifyCtx);
+}
@@ -333,22 +333,14 @@ Exit:
 }
 
 /**
-  This function receives a PKCS#7 formatted signature blob,
-  looks for the EKU SEQUENCE blob, and if found then looks
-  for all the required EKUs. This function was created so that
-  the Surface team can cut down on the number of Certificate
-  Authorities (CA's) by checking EKU's on leaf signers for
-  a specific product. This prevents one product's certificate
-  from signing another product's firmware or unlock blobs.
+  This function receives a PKCS#7 context returned by Pkcs7Parse(), and looks
+  for all the required EKUs in the leaf signer. It is the parsed counterpart of
+  VerifyEKUsInPkcs7Signature() for callers that already hold the context.
 
   Note that this function does not validate the certificate chain.
   That needs to be done before using this function.
 
-  @param[in]  Pkcs7Signature       The PKCS#7 signed information content block. An array
-                                   containing the content block with both the signature,
-                                   the signer's certificate, and any necessary intermediate
-                                   certificates.
-  @param[in]  Pkcs7SignatureSize   Number of bytes in Pkcs7Signature.
+  @param[in]  Pkcs7Context         Pointer to the parsed PKCS#7 context.
   @param[in]  RequiredEKUs         Array of null-terminated strings listing OIDs of
                                    required EKUs that must be present in the signature.
   @param[in]  RequiredEKUsSize     Number of elements in the RequiredEKUs string array.
@@ -364,9 +356,8 @@ Exit:
 **/
 EFI_STATUS
 EFIAPI
-VerifyEKUsInPkcs7Signature (
-  IN CONST UINT8   *Pkcs7Signature,
-  IN CONST UINT32  SignatureSize,
+Pkcs7ParsedVerifyEKUs (
+  IN VOID          *Pkcs7Context,
   IN CONST CHAR8   *RequiredEKUs[],
   IN CONST UINT32  RequiredEKUsSize,
   IN BOOLEAN       RequireAllPresent
@@ -376,73 +367,30 @@ VerifyEKUsInPkcs7Signature (
   PKCS7       *Pkcs7;
 
   STACK_OF (X509)    *CertChain;
-  INT32    SignatureType;
-  INT32    NumberCertsInSignature;
-  X509     *SignerCert;
-  UINT8    *SignedData;
-  UINT8    *Temp;
-  UINTN    SignedDataSize;
-  BOOLEAN  IsWrapped;
-  BOOLEAN  Ok;
-
-  Status                 = EFI_SUCCESS;
-  Pkcs7                  = NULL;
+  INT32  SignatureType;
+  INT32  NumberCertsInSignature;
+  X509   *SignerCert;
+
   CertChain              = NULL;
   SignatureType          = 0;
   NumberCertsInSignature = 0;
   SignerCert             = NULL;
-  SignedData             = NULL;
-  SignedDataSize         = 0;
-  IsWrapped              = FALSE;
-  Ok                     = FALSE;
 
   //
   // Validate the input parameters.
   //
-  if ((Pkcs7Signature   == NULL) ||
-      (SignatureSize    == 0) ||
+  if ((Pkcs7Context     == NULL) ||
       (RequiredEKUs     == NULL) ||
       (RequiredEKUsSize == 0))
   {
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
 
   if (RequiredEKUsSize == 1) {
     RequireAllPresent = TRUE;
   }
 
-  //
-  // Wrap the PKCS7 data if needed.
-  //
-  Ok = WrapPkcs7Data (
-         Pkcs7Signature,
-         SignatureSize,
-         &IsWrapped,
-         &SignedData,
-         &SignedDataSize
-         );
-  if (!Ok) {
-    //
-    // Fail to Wrap the PKCS7 data.
-    //
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
-  }
-
-  Temp = SignedData;
-
-  //
-  // Create the PKCS7 object.
-  //
-  Pkcs7 = d2i_PKCS7 (NULL, (const unsigned char **)&Temp, (INT32)SignedDataSize);
-  if (Pkcs7 == NULL) {
-    //
-    // Fail to read PKCS7 data.
-    //
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
-  }
+  Pkcs7 = (PKCS7 *)Pkcs7Context;
 
   //
   // Get the certificate chain.
@@ -472,8 +420,7 @@ VerifyEKUsInPkcs7Signature (
     //
     // Fail to get the certificate stack from signature.
     //
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
 
   //
@@ -485,8 +432,7 @@ VerifyEKUsInPkcs7Signature (
     //
     // Fail to find any certificates in signature.
     //
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
 
   //
@@ -497,30 +443,79 @@ VerifyEKUsInPkcs7Signature (
     //
     // Fail to get the end-entity leaf signer certificate.
     //
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
 
-  Status = CheckEKUs (SignerCert, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
-  if (Status != EFI_SUCCESS) {
-    goto Exit;
-  }
+  return CheckEKUs (SignerCert, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
+}
 
-Exit:
+/**
+  This function receives a PKCS#7 formatted signature blob,
+  looks for the EKU SEQUENCE blob, and if found then looks
+  for all the required EKUs. This function was created so that
+  the Surface team can cut down on the number of Certificate
+  Authorities (CA's) by checking EKU's on leaf signers for
+  a specific product. This prevents one product's certificate
+  from signing another product's firmware or unlock blobs.
+
+  Note that this function does not validate the certificate chain.
+  That needs to be done before using this function.
+
+  @param[in]  Pkcs7Signature       The PKCS#7 signed information content block. An array
+                                   containing the content block with both the signature,
+                                   the signer's certificate, and any necessary intermediate
+                                   certificates.
+  @param[in]  Pkcs7SignatureSize   Number of bytes in Pkcs7Signature.
+  @param[in]  RequiredEKUs         Array of null-terminated strings listing OIDs of
+                                   required EKUs that must be present in the signature.
+  @param[in]  RequiredEKUsSize     Number of elements in the RequiredEKUs string array.
+  @param[in]  RequireAllPresent    If this is TRUE, then all of the specified EKU's
+                                   must be present in the leaf signer.  If it is
+                                   FALSE, then we will succeed if we find any
+                                   of the specified EKU's.
+
+  @retval EFI_SUCCESS              The required EKUs were found in the signature.
+  @retval EFI_INVALID_PARAMETER    A parameter was invalid.
+  @retval EFI_NOT_FOUND            One or more EKU's were not found in the signature.
+
+**/
+EFI_STATUS
+EFIAPI
+VerifyEKUsInPkcs7Signature (
+  IN CONST UINT8   *Pkcs7Signature,
+  IN CONST UINT32  SignatureSize,
+  IN CONST CHAR8   *RequiredEKUs[],
+  IN CONST UINT32  RequiredEKUsSize,
+  IN BOOLEAN       RequireAllPresent
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Pkcs7Context;
 
   //
-  // Release Resources
-  //
-  // If the signature was not wrapped, then the call to WrapData() will allocate
-  // the data and add a header to it
+  // Validate the input parameters.
   //
-  if (!IsWrapped && SignedData) {
-    free (SignedData);
+  if ((Pkcs7Signature   == NULL) ||
+      (SignatureSize    == 0) ||
+      (RequiredEKUs     == NULL) ||
+      (RequiredEKUsSize == 0))
+  {
+    return EFI_INVALID_PARAMETER;
   }
 
-  if (Pkcs7 != NULL) {
-    PKCS7_free (Pkcs7);
+  //
+  // Create the PKCS7 object, wrapping the PKCS7 data if needed.
+  //
+  Pkcs7Context = Pkcs7Parse (Pkcs7Signature, SignatureSize);
+  if (Pkcs7Context == NULL) {
+    //
+    // Fail to read PKCS7 data.
+    //
+    return EFI_INVALID_PARAMETER;
   }
 
+  Status = Pkcs7ParsedVerifyEKUs (Pkcs7Context, RequiredEKUs, RequiredEKUsSize, RequireAllPresent);
+
+  Pkcs7ParsedFree (Pkcs7Context);
   return Status;
 }
@@ -161,3 +161,272 @@ Pkcs7GetAttachedContent (
   ASSERT (FALSE);
   return FALSE;
 }
+
+/**
+  Parses a PKCS#7 signed data into a context that can be shared by the
+  Pkcs7Parsed*() queries.
+
+  Return NULL to indicate this interface is not supported.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to parse.
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+
+  @retval NULL  This interface is not supported.
+
+**/
+VOID *
+EFIAPI
+Pkcs7Parse (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Release the PKCS#7 context returned by Pkcs7Parse().
+
+  If the interface is not supported, then ASSERT().
+
+  @param[in]  Pkcs7Context  Pointer to the parsed PKCS#7 context to be released.
+
+**/
+VOID
+EFIAPI
+Pkcs7ParsedFree (
+  IN  VOID  *Pkcs7Context
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Get the signer's certificates from a PKCS#7 context returned by Pkcs7Parse().
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out] CertStack    Pointer to Signer's certificates retrieved from P7Data.
+  @param[out] StackLength  Length of signer's certificates in bytes.
+  @param[out] TrustedCert  Pointer to a trusted certificate from Signer's certificates.
+  @param[out] CertLength   Length of the trusted certificate in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetSigners (
+  IN  VOID   *Pkcs7Context,
+  OUT UINT8  **CertStack,
+  OUT UINTN  *StackLength,
+  OUT UINT8  **TrustedCert,
+  OUT UINTN  *CertLength
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Retrieves all embedded certificates from a PKCS#7 context returned by
+  Pkcs7Parse(), and outputs two certificate lists chained and unchained to the
+  signer's certificates.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  Pkcs7Context      Pointer to the parsed PKCS#7 context.
+  @param[out] SignerChainCerts  Pointer to the certificates list chained to signer's
+                                certificate.
+  @param[out] ChainLength       Length of the chained certificates list buffer in bytes.
+  @param[out] UnchainCerts      Pointer to the unchained certificates lists.
+  @param[out] UnchainLength     Length of the unchained certificates list buffer in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetCertificatesList (
+  IN  VOID   *Pkcs7Context,
+  OUT UINT8  **SignerChainCerts,
+  OUT UINTN  *ChainLength,
+  OUT UINT8  **UnchainCerts,
+  OUT UINTN  *UnchainLength
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Verifies the validity of a PKCS#7 context returned by Pkcs7Parse().
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+  @param[in]  InData       Pointer to the content to be verified.
+  @param[in]  DataLength   Length of InData in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedVerify (
+  IN  VOID         *Pkcs7Context,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength,
+  IN  CONST UINT8  *InData,
+  IN  UINTN        DataLength
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Extracts the attached content from a PKCS#7 context returned by Pkcs7Parse()
+  if existed.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   Pkcs7Context Pointer to the parsed PKCS#7 context.
+  @param[out]  Content      Pointer to the extracted content from the PKCS#7 signedData.
+                            It's caller's responsibility to free the buffer with FreePool().
+  @param[out]  ContentSize  The size of the extracted content in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7ParsedGetAttachedContent (
+  IN  VOID   *Pkcs7Context,
+  OUT VOID   **Content,
+  OUT UINTN  *ContentSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Starts an incremental verification of a PKCS#7 signed data with detached
+  content.
+
+  Return NULL to indicate this interface is not supported.
+
+  @param[in]  P7Data       Pointer to the PKCS#7 message to verify.
+  @param[in]  P7Length     Length of the PKCS#7 message in bytes.
+  @param[in]  TrustedCert  Pointer to a trusted/root certificate encoded in DER, which
+                           is used for certificate chain verification.
+  @param[in]  CertLength   Length of the trusted certificate in bytes.
+
+  @retval NULL  This interface is not supported.
+
+**/
+VOID *
+EFIAPI
+Pkcs7VerifyInit (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Hashes the next chunk of the detached content into a verification context.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+  @param[in]  Data                Pointer to the next chunk of content.
+  @param[in]  DataSize            Size of Data in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyUpdate (
+  IN  VOID        *Pkcs7VerifyContext,
+  IN  CONST VOID  *Data,
+  IN  UINTN       DataSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Completes an incremental PKCS#7 verification.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7VerifyFinal (
+  IN  VOID  *Pkcs7VerifyContext
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+/**
+  Release an incremental PKCS#7 verification context.
+
+  If the interface is not supported, then ASSERT().
+
+  @param[in]  Pkcs7VerifyContext  Pointer to the verification context to be released.
+
+**/
+VOID
+EFIAPI
+Pkcs7VerifyFree (
+  IN  VOID  *Pkcs7VerifyContext
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Locates the attached content of a PKCS#7 signed data without copying it.
+
+  Return FALSE to indicate this interface is not supported.
+
+  @param[in]   P7Data       Pointer to the PKCS#7 signed data to process.
+  @param[in]   P7Length     Length of the PKCS#7 signed data in bytes.
+  @param[out]  Content      Pointer to the attached content inside P7Data.
+  @param[out]  ContentSize  The size of the attached content in bytes.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetAttachedContentInPlace (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  OUT CONST UINT8  **Content,
+  OUT UINTN        *ContentSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
@@ -27,7 +27,113 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "CryptRsaPkeyCtx.h"
 
 /**
-  Invalidate (free) the cached EVP_PKEY in the RSA context.
+  Free a cached verify context.
+
+  @param[in,out]  Cache  Pointer to the verify context cache entry to clear.
+
+**/
+STATIC
+VOID
+RsaFreeVerifyCtx (
+  IN OUT  RSA_VERIFY_CTX_CACHE  *Cache
+  )
+{
+  if (Cache->Ctx != NULL) {
+    EVP_PKEY_CTX_free (Cache->Ctx);
+  }
+
+  Cache->Ctx     = NULL;
+  Cache->Md      = NULL;
+  Cache->SaltLen = 0;
+}
+
+/**
+  Return a verify context on the cached EVP_PKEY, initialized for the given
+  padding mode, digest and salt length.
+
+  @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX holding key components.
+  @param[in]      Padding     RSA_PKCS1_PADDING or RSA_PKCS1_PSS_PADDING.
+  @param[in]      Md          Signature digest (also used for MGF1 with PSS).
+  @param[in]      SaltLen     PSS salt length, ignored for RSA_PKCS1_PADDING.
+
+  @return  Pointer to the verify context owned by RsaPkeyCtx, or NULL on failure.
+
+**/
+EVP_PKEY_CTX *
+RsaGetVerifyCtx (
+  IN OUT  RSA_PKEY_CTX  *RsaPkeyCtx,
+  IN      INT32         Padding,
+  IN      CONST EVP_MD  *Md,
+  IN      INT32         SaltLen
+  )
+{
+  RSA_VERIFY_CTX_CACHE  *Cache;
+  EVP_PKEY              *Pkey;
+  EVP_PKEY_CTX          *PkeyCtx;
+
+  if (Padding == RSA_PKCS1_PSS_PADDING) {
+    Cache = &RsaPkeyCtx->PssVerify;
+  } else if (Padding == RSA_PKCS1_PADDING) {
+    Cache   = &RsaPkeyCtx->Pkcs1Verify;
+    SaltLen = 0;
+  } else {
+    return NULL;
+  }
+
+  if ((Cache->Ctx != NULL) && (Cache->Md == Md) && (Cache->SaltLen == SaltLen)) {
+    return Cache->Ctx;
+  }
+
+  RsaFreeVerifyCtx (Cache);
+
+  //
+  // Build EVP_PKEY from stored key components.
+  //
+  Pkey = RsaBuildEvpPkey (RsaPkeyCtx);
+  if (Pkey == NULL) {
+    return NULL;
+  }
+
+  PkeyCtx = EVP_PKEY_CTX_new_from_pkey (NULL, Pkey, NULL);
+  if (PkeyCtx == NULL) {
+    return NULL;
+  }
+
+  if (EVP_PKEY_verify_init (PkeyCtx) != 1) {
+    goto _Error;
+  }
+
+  if (EVP_PKEY_CTX_set_rsa_padding (PkeyCtx, Padding) <= 0) {
+    goto _Error;
+  }
+
+  if (EVP_PKEY_CTX_set_signature_md (PkeyCtx, Md) <= 0) {
+    goto _Error;
+  }
+
+  if (Padding == RSA_PKCS1_PSS_PADDING) {
+    if (EVP_PKEY_CTX_set_rsa_pss_saltlen (PkeyCtx, SaltLen) <= 0) {
+      goto _Error;
+    }
+
+    if (EVP_PKEY_CTX_set_rsa_mgf1_md (PkeyCtx, Md) <= 0) {
+      goto _Error;
+    }
+  }
+
+  Cache->Ctx     = PkeyCtx;
+  Cache->Md      = Md;
+  Cache->SaltLen = SaltLen;
+  return PkeyCtx;
+
+_Error:
+  EVP_PKEY_CTX_free (PkeyCtx);
+  return NULL;
+}
+
+/**
+  Invalidate (free) the cached EVP_PKEY in the RSA context, along with the
+  verify contexts built on it.
 
   @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX whose cache to invalidate.
 
@@ -37,12 +143,246 @@ RsaInvalidatePkey (
   IN OUT  RSA_PKEY_CTX  *RsaPkeyCtx
   )
 {
+  RsaFreeVerifyCtx (&RsaPkeyCtx->Pkcs1Verify);
+  RsaFreeVerifyCtx (&RsaPkeyCtx->PssVerify);
+
   if (RsaPkeyCtx->Pkey != NULL) {
     EVP_PKEY_free (RsaPkeyCtx->Pkey);
     RsaPkeyCtx->Pkey = NULL;
   }
 }
 
+/**
+  Recover the prime factors of N from the public and private exponents.
+
+  Uses the procedure of NIST SP 800-56B Appendix C: D * E - 1 is a multiple of
+  lcm (p - 1, q - 1), so for most bases G some power G^(R * 2^i) mod N is a
+  non-trivial square root of 1, and gcd (that root - 1, N) is a prime factor.
+
+  @param[in]   N      Public modulus.
+  @param[in]   E      Public exponent.
+  @param[in]   D      Private exponent.
+  @param[out]  P      Receives the larger prime factor.
+  @param[out]  Q      Receives the smaller prime factor.
+  @param[in]   BnCtx  BN context for temporaries.
+
+  @retval  TRUE   The factors were recovered.
+  @retval  FALSE  N could not be factored from (E, D).
+
+**/
+STATIC
+BOOLEAN
+RsaRecoverPrimeFactors (
+  IN      CONST BIGNUM  *N,
+  IN      CONST BIGNUM  *E,
+  IN      CONST BIGNUM  *D,
+  OUT     BIGNUM        *P,
+  OUT     BIGNUM        *Q,
+  IN OUT  BN_CTX        *BnCtx
+  )
+{
+  STATIC CONST UINT8  Bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53 };
+  BIGNUM              *R;
+  BIGNUM              *NMinus1;
+  BIGNUM              *Y;
+  BIGNUM              *X;
+  BIGNUM              *Rem;
+  UINTN               T;
+  UINTN               BaseIndex;
+  UINTN               Iter;
+  BOOLEAN             Found;
+
+  Found = FALSE;
+  BN_CTX_start (BnCtx);
+  R       = BN_CTX_get (BnCtx);
+  NMinus1 = BN_CTX_get (BnCtx);
+  Y       = BN_CTX_get (BnCtx);
+  X       = BN_CTX_get (BnCtx);
+  Rem     = BN_CTX_get (BnCtx);
+  if (Rem == NULL) {
+    goto _Exit;
+  }
+
+  //
+  // D * E - 1 = R * 2^T with R odd.
+  //
+  if ((BN_mul (R, D, E, BnCtx) != 1) || (BN_sub_word (R, 1) != 1) || BN_is_zero (R) || BN_is_odd (R)) {
+    goto _Exit;
+  }
+
+  for (T = 0; !BN_is_odd (R); T++) {
+    if (BN_rshift1 (R, R) != 1) {
+      goto _Exit;
+    }
+  }
+
+  if ((BN_copy (NMinus1, N) == NULL) || (BN_sub_word (NMinus1, 1) != 1)) {
+    goto _Exit;
+  }
+
+  //
+  // R is derived from D, so raise the bases to it in constant time.
+  //
+  BN_set_flags (R, BN_FLG_CONSTTIME);
+
+  for (BaseIndex = 0; (BaseIndex < ARRAY_SIZE (Bases)) && !Found; BaseIndex++) {
+    if ((BN_set_word (X, Bases[BaseIndex]) != 1) || (BN_mod_exp_mont_consttime (Y, X, R, N, BnCtx, NULL) != 1)) {
+      goto _Exit;
+    }
+
+    if (BN_is_one (Y) || (BN_cmp (Y, NMinus1) == 0)) {
+      continue;
+    }
+
+    for (Iter = 0; Iter < T; Iter++) {
+      if (BN_mod_sqr (X, Y, N, BnCtx) != 1) {
+        goto _Exit;
+      }
+
+      if (BN_is_one (X)) {
+        //
+        // Y is a non-trivial square root of 1 modulo N.
+        //
+        if ((BN_sub_word (Y, 1) != 1) || (BN_gcd (P, Y, N, BnCtx) != 1)) {
+          goto _Exit;
+        }
+
+        if (BN_is_one (P) || (BN_div (Q, Rem, N, P, BnCtx) != 1) || !BN_is_zero (Rem) || BN_is_one (Q)) {
+          goto _Exit;
+        }
+
+        Found = TRUE;
+        break;
+      }
+
+      if ((BN_cmp (X, NMinus1) == 0) || (BN_copy (Y, X) == NULL)) {
+        break;
+      }
+    }
+  }
+
+  if (Found && (BN_cmp (P, Q) < 0)) {
+    BN_swap (P, Q);
+  }
+
+_Exit:
+  BN_CTX_end (BnCtx);
+  return Found;
+}
+
+/**
+  Derive the prime factors and CRT parameters missing from a private key that
+  was set as (N, E, D) into RsaPkeyCtx->Derived. The components set by the
+  caller are left as they are, so RsaGetKey() only reports those.
+
+  Derivation is best effort: if it fails, nothing is derived and the key is
+  used without CRT.
+
+  @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX holding key components.
+
+**/
+STATIC
+VOID
+RsaDeriveCrtParams (
+  IN OUT  RSA_PKEY_CTX  *RsaPkeyCtx
+  )
+{
+  BN_CTX  *BnCtx;
+  BIGNUM  *P;
+  BIGNUM  *Q;
+  BIGNUM  *Dp;
+  BIGNUM  *Dq;
+  BIGNUM  *QInv;
+  BIGNUM  *Tmp;
+
+  //
+  // Only derive for a private key with no CRT component supplied; a partial
+  // set from the caller is passed through untouched.
+  //
+  if ((RsaPkeyCtx->D == NULL) || (RsaPkeyCtx->P != NULL) || (RsaPkeyCtx->Q != NULL) ||
+      (RsaPkeyCtx->Dp != NULL) || (RsaPkeyCtx->Dq != NULL) || (RsaPkeyCtx->QInv != NULL) ||
+      (RsaPkeyCtx->Derived.P != NULL))
+  {
+    return;
+  }
+
+  BnCtx = BN_CTX_new ();
+  P     = BN_secure_new ();
+  Q     = BN_secure_new ();
+  Dp    = BN_secure_new ();
+  Dq    = BN_secure_new ();
+  QInv  = BN_secure_new ();
+  Tmp   = BN_new ();
+  if ((BnCtx == NULL) || (P == NULL) || (Q == NULL) || (Dp == NULL) ||
+      (Dq == NULL) || (QInv == NULL) || (Tmp == NULL))
+  {
+    goto _Error;
+  }
+
+  if (!RsaRecoverPrimeFactors (RsaPkeyCtx->N, RsaPkeyCtx->E, RsaPkeyCtx->D, P, Q, BnCtx)) {
+    goto _Error;
+  }
+
+  //
+  // Dp = D mod (P - 1), Dq = D mod (Q - 1), QInv = Q^-1 mod P.
+  //
+  if ((BN_copy (Tmp, P) == NULL) || (BN_sub_word (Tmp, 1) != 1) ||
+      (BN_mod (Dp, RsaPkeyCtx->D, Tmp, BnCtx) != 1))
+  {
+    goto _Error;
+  }
+
+  if ((BN_copy (Tmp, Q) == NULL) || (BN_sub_word (Tmp, 1) != 1) ||
+      (BN_mod (Dq, RsaPkeyCtx->D, Tmp, BnCtx) != 1))
+  {
+    goto _Error;
+  }
+
+  if (BN_mod_inverse (QInv, Q, P, BnCtx) == NULL) {
+    goto _Error;
+  }
+
+  RsaPkeyCtx->Derived.P    = P;
+  RsaPkeyCtx->Derived.Q    = Q;
+  RsaPkeyCtx->Derived.Dp   = Dp;
+  RsaPkeyCtx->Derived.Dq   = Dq;
+  RsaPkeyCtx->Derived.QInv = QInv;
+
+  BN_free (Tmp);
+  BN_CTX_free (BnCtx);
+  return;
+
+_Error:
+  BN_clear_free (P);
+  BN_clear_free (Q);
+  BN_clear_free (Dp);
+  BN_clear_free (Dq);
+  BN_clear_free (QInv);
+  BN_clear_free (Tmp);
+  BN_CTX_free (BnCtx);
+}
+
+/**
+  Release the CRT components that RsaDeriveCrtParams() derived, so they are not
+  reused once the key components they were computed from change.
+
+  @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX holding key components.
+
+**/
+STATIC
+VOID
+RsaDropDerivedCrtParams (
+  IN OUT  RSA_PKEY_CTX  *RsaPkeyCtx
+  )
+{
+  BN_clear_free (RsaPkeyCtx->Derived.P);
+  BN_clear_free (RsaPkeyCtx->Derived.Q);
+  BN_clear_free (RsaPkeyCtx->Derived.Dp);
+  BN_clear_free (RsaPkeyCtx->Derived.Dq);
+  BN_clear_free (RsaPkeyCtx->Derived.QInv);
+  ZeroMem (&RsaPkeyCtx->Derived, sizeof (RsaPkeyCtx->Derived));
+}
+
 /**
   Build (or return cached) EVP_PKEY from the stored BIGNUM components.
 
@@ -61,6 +401,11 @@ RsaBuildEvpPkey (
   EVP_PKEY_CTX    *PkeyCtx;
   EVP_PKEY        *Pkey;
   INT32           Selection;
+  BIGNUM          *P;
+  BIGNUM          *Q;
+  BIGNUM          *Dp;
+  BIGNUM          *Dq;
+  BIGNUM          *QInv;
 
   if (RsaPkeyCtx->Pkey != NULL) {
     return RsaPkeyCtx->Pkey;
@@ -73,6 +418,25 @@ RsaBuildEvpPkey (
     return NULL;
   }
 
+  //
+  // A private key set as (N, E, D) alone would run without CRT; recover the
+  // factors and CRT parameters once so every private operation uses CRT.
+  //
+  RsaDeriveCrtParams (RsaPkeyCtx);
+  if (RsaPkeyCtx->Derived.P != NULL) {
+    P    = RsaPkeyCtx->Derived.P;
+    Q    = RsaPkeyCtx->Derived.Q;
+    Dp   = RsaPkeyCtx->Derived.Dp;
+    Dq   = RsaPkeyCtx->Derived.Dq;
+    QInv = RsaPkeyCtx->Derived.QInv;
+  } else {
+    P    = RsaPkeyCtx->P;
+    Q    = RsaPkeyCtx->Q;
+    Dp   = RsaPkeyCtx->Dp;
+    Dq   = RsaPkeyCtx->Dq;
+    QInv = RsaPkeyCtx->QInv;
+  }
+
   ParamBld = NULL;
   Params   = NULL;
   PkeyCtx  = NULL;
@@ -98,32 +462,32 @@ RsaBuildEvpPkey (
       goto _Exit;
     }
 
-    if (RsaPkeyCtx->P != NULL) {
-      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_FACTOR1, RsaPkeyCtx->P) != 1) {
+    if (P != NULL) {
+      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_FACTOR1, P) != 1) {
         goto _Exit;
       }
     }
 
-    if (RsaPkeyCtx->Q != NULL) {
-      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_FACTOR2, RsaPkeyCtx->Q) != 1) {
+    if (Q != NULL) {
+      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_FACTOR2, Q) != 1) {
         goto _Exit;
       }
     }
 
-    if (RsaPkeyCtx->Dp != NULL) {
-      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_EXPONENT1, RsaPkeyCtx->Dp) != 1) {
+    if (Dp != NULL) {
+      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_EXPONENT1, Dp) != 1) {
         goto _Exit;
       }
     }
 
-    if (RsaPkeyCtx->Dq != NULL) {
-      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_EXPONENT2, RsaPkeyCtx->Dq) != 1) {
+    if (Dq != NULL) {
+      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_EXPONENT2, Dq) != 1) {
         goto _Exit;
       }
     }
 
-    if (RsaPkeyCtx->QInv != NULL) {
-      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_COEFFICIENT1, RsaPkeyCtx->QInv) != 1) {
+    if (QInv != NULL) {
+      if (OSSL_PARAM_BLD_push_BN (ParamBld, OSSL_PKEY_PARAM_RSA_COEFFICIENT1, QInv) != 1) {
         goto _Exit;
       }
     }
@@ -212,6 +576,8 @@ RsaExtractBigNums (
   RsaPkeyCtx->Dq   = NULL;
   RsaPkeyCtx->QInv = NULL;
 
+  RsaDropDerivedCrtParams (RsaPkeyCtx);
+
   //
   // Extract public components (required).
   //
@@ -333,11 +699,9 @@ RsaFree (
   RsaPkeyCtx = (RSA_PKEY_CTX *)RsaContext;
 
   //
-  // Free cached EVP_PKEY.  // MU_CHANGE
+  // Free cached EVP_PKEY and the verify contexts built on it.  // MU_CHANGE
   //
-  if (RsaPkeyCtx->Pkey != NULL) {
-    EVP_PKEY_free (RsaPkeyCtx->Pkey);
-  }
+  RsaInvalidatePkey (RsaPkeyCtx);
 
   //
   // Free public components.
@@ -354,6 +718,7 @@ RsaFree (
   BN_clear_free (RsaPkeyCtx->Dp);
   BN_clear_free (RsaPkeyCtx->Dq);
   BN_clear_free (RsaPkeyCtx->QInv);
+  RsaDropDerivedCrtParams (RsaPkeyCtx);
 
   FreePool (RsaPkeyCtx);
   // MU_CHANGE [END]
@@ -408,9 +773,11 @@ RsaSetKey (
   RsaPkeyCtx = (RSA_PKEY_CTX *)RsaContext;
 
   //
-  // Invalidate cached EVP_PKEY since a key component is changing.
+  // Invalidate cached EVP_PKEY since a key component is changing. CRT
+  // parameters derived from the old components are no longer valid either.
   //
   RsaInvalidatePkey (RsaPkeyCtx);
+  RsaDropDerivedCrtParams (RsaPkeyCtx);
 
   //
   // Select the target BIGNUM pointer based on key tag.
@@ -518,11 +885,8 @@ RsaPkcs1Verify (
   )
 {
   // MU_CHANGE [BEGIN]
-  RSA_PKEY_CTX  *RsaPkeyCtx;
-  EVP_PKEY      *Pkey;
   EVP_PKEY_CTX  *PkeyCtx;
   CONST EVP_MD  *Md;
-  BOOLEAN       Result;
 
   // MU_CHANGE [END]
 
@@ -546,44 +910,15 @@ RsaPkcs1Verify (
     return FALSE;
   }
 
-  RsaPkeyCtx = (RSA_PKEY_CTX *)RsaContext;
-  Result     = FALSE;
-  PkeyCtx    = NULL;
-
   //
-  // Build EVP_PKEY from stored key components.
+  // Reuse the verify context cached in the RSA context; it is only rebuilt
+  // when the key or the digest changes.
   //
-  Pkey = RsaBuildEvpPkey (RsaPkeyCtx);
-  if (Pkey == NULL) {
-    return FALSE;
-  }
-
-  PkeyCtx = EVP_PKEY_CTX_new_from_pkey (NULL, Pkey, NULL);
+  PkeyCtx = RsaGetVerifyCtx ((RSA_PKEY_CTX *)RsaContext, RSA_PKCS1_PADDING, Md, 0);
   if (PkeyCtx == NULL) {
-    goto _Exit;
-  }
-
-  if (EVP_PKEY_verify_init (PkeyCtx) != 1) {
-    goto _Exit;
-  }
-
-  if (EVP_PKEY_CTX_set_rsa_padding (PkeyCtx, RSA_PKCS1_PADDING) <= 0) {
-    goto _Exit;
-  }
-
-  if (EVP_PKEY_CTX_set_signature_md (PkeyCtx, Md) <= 0) {
-    goto _Exit;
-  }
-
-  if (EVP_PKEY_verify (PkeyCtx, Signature, SigSize, MessageHash, HashSize) == 1) {
-    Result = TRUE;
-  }
-
-_Exit:
-  if (PkeyCtx != NULL) {
-    EVP_PKEY_CTX_free (PkeyCtx);
+    return FALSE;
   }
 
-  return Result;
+  return (BOOLEAN)(EVP_PKEY_verify (PkeyCtx, Signature, SigSize, MessageHash, HashSize) == 1);
   // MU_CHANGE [END]
 }
@@ -18,20 +18,46 @@
 #include <openssl/evp.h>
 #include <openssl/bn.h>
 
+///
+/// Signature verification context initialized for one padding mode and digest.
+/// The context is reused across verify calls until the key or parameters change.
+///
+typedef struct {
+  EVP_PKEY_CTX    *Ctx;    ///< NULL until first use
+  CONST EVP_MD    *Md;     ///< Signature digest Ctx was set up with
+  INT32           SaltLen; ///< PSS salt length Ctx was set up with (0 for PKCS#1 v1.5)
+} RSA_VERIFY_CTX_CACHE;
+
+///
+/// Prime factors and CRT parameters derived from (N, E, D) for a private key
+/// set without them. They are only used to build the EVP_PKEY and are never
+/// reported as key components set by the caller.
+///
+typedef struct {
+  BIGNUM    *P;    ///< Derived prime factor p, NULL if not derived
+  BIGNUM    *Q;    ///< Derived prime factor q
+  BIGNUM    *Dp;   ///< Derived d mod (p-1)
+  BIGNUM    *Dq;   ///< Derived d mod (q-1)
+  BIGNUM    *QInv; ///< Derived 1/q mod p
+} RSA_DERIVED_CRT;
+
 ///
 /// Internal RSA key context that holds individual BIGNUM key components
 /// and a cached EVP_PKEY built from those components.
 ///
 typedef struct {
-  EVP_PKEY    *Pkey;
-  BIGNUM      *N;     ///< Public modulus
-  BIGNUM      *E;     ///< Public exponent
-  BIGNUM      *D;     ///< Private exponent
-  BIGNUM      *P;     ///< Secret prime factor p
-  BIGNUM      *Q;     ///< Secret prime factor q
-  BIGNUM      *Dp;    ///< p's CRT exponent (d mod (p-1))
-  BIGNUM      *Dq;    ///< q's CRT exponent (d mod (q-1))
-  BIGNUM      *QInv;  ///< CRT coefficient (1/q mod p)
+  EVP_PKEY                *Pkey;
+  RSA_VERIFY_CTX_CACHE    Pkcs1Verify; ///< RSASSA-PKCS1-v1_5 verify context on Pkey
+  RSA_VERIFY_CTX_CACHE    PssVerify;   ///< RSASSA-PSS verify context on Pkey
+  BIGNUM                  *N;          ///< Public modulus
+  BIGNUM                  *E;          ///< Public exponent
+  BIGNUM                  *D;          ///< Private exponent
+  BIGNUM                  *P;          ///< Secret prime factor p
+  BIGNUM                  *Q;          ///< Secret prime factor q
+  BIGNUM                  *Dp;         ///< p's CRT exponent (d mod (p-1))
+  BIGNUM                  *Dq;         ///< q's CRT exponent (d mod (q-1))
+  BIGNUM                  *QInv;       ///< CRT coefficient (1/q mod p)
+  RSA_DERIVED_CRT         Derived;     ///< CRT components derived from (N, E, D) for Pkey
 } RSA_PKEY_CTX;
 
 /**
@@ -39,7 +65,10 @@ typedef struct {
 
   If the EVP_PKEY is already cached and valid, return it directly.
   Otherwise, construct a new EVP_PKEY using OSSL_PARAM_BLD and
-  EVP_PKEY_fromdata.
+  EVP_PKEY_fromdata. For a private key given only as (N, E, D), the prime
+  factors and CRT parameters are derived first and kept in the context, apart
+  from the components set by the caller, so private key operations always take
+  the CRT path.
 
   @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX holding key components.
 
@@ -68,7 +97,31 @@ RsaExtractBigNums (
   );
 
 /**
-  Invalidate (free) the cached EVP_PKEY in the RSA context.
+  Return a verify context on the cached EVP_PKEY, initialized for the given
+  padding mode, digest and salt length.
+
+  The context is kept in RSA_PKEY_CTX and returned as-is while the key and the
+  requested parameters stay the same, so repeated verifications with one key
+  skip context creation, verify init and parameter setup.
+
+  @param[in,out]  RsaPkeyCtx  Pointer to RSA_PKEY_CTX holding key components.
+  @param[in]      Padding     RSA_PKCS1_PADDING or RSA_PKCS1_PSS_PADDING.
+  @param[in]      Md          Signature digest (also used for MGF1 with PSS).
+  @param[in]      SaltLen     PSS salt length, ignored for RSA_PKCS1_PADDING.
+
+  @return  Pointer to the verify context owned by RsaPkeyCtx, or NULL on failure.
+**/
+EVP_PKEY_CTX *
+RsaGetVerifyCtx (
+  IN OUT  RSA_PKEY_CTX  *RsaPkeyCtx,
+  IN      INT32         Padding,
+  IN      CONST EVP_MD  *Md,
+  IN      INT32         SaltLen
+  );
+
+/**
+  Invalidate (free) the cached EVP_PKEY in the RSA context, along with the
+  verify contexts built on it.
 
   Called when key components change so the EVP_PKEY will be rebuilt
   on next use.
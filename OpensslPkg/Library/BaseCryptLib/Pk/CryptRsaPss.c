@@ -83,17 +83,13 @@ RsaPssVerify (
   IN  UINT16       SaltLen
   )
 {
-  BOOLEAN       Result;
-  EVP_PKEY      *Pkey;  // MU_CHANGE
-  EVP_MD_CTX    *EvpVerifyCtx;
+  // MU_CHANGE [BEGIN]
   EVP_PKEY_CTX  *KeyCtx;
   CONST EVP_MD  *HashAlg;
+  UINT8         Digest[EVP_MAX_MD_SIZE];
+  UINT32        DigestSize;
 
-  Result       = FALSE;
-  Pkey         = NULL;  // MU_CHANGE
-  EvpVerifyCtx = NULL;
-  KeyCtx       = NULL;
-  HashAlg      = NULL;
+  // MU_CHANGE [END]
 
   if (RsaContext == NULL) {
     return FALSE;
@@ -119,48 +115,20 @@ RsaPssVerify (
 
   // MU_CHANGE [BEGIN]
   //
-  // Build EVP_PKEY from the RSA_PKEY_CTX key components.
+  // Reuse the PSS verify context cached in the RSA context; it is only rebuilt
+  // when the key, the digest or the salt length changes. The message is hashed
+  // here and the digest verified on that context, which is equivalent to a
+  // DigestVerify pass but keeps no per-message state in the cached context.
   //
-  Pkey = RsaBuildEvpPkey ((RSA_PKEY_CTX *)RsaContext);
-  if (Pkey == NULL) {
-    return FALSE;
-    // MU_CHANGE [END]
-  }
-
-  EvpVerifyCtx = EVP_MD_CTX_new ();  // MU_CHANGE
-  if (EvpVerifyCtx == NULL) {
-    goto _Exit;
-  }
-
-  Result = EVP_DigestVerifyInit (EvpVerifyCtx, &KeyCtx, HashAlg, NULL, Pkey) > 0;  // MU_CHANGE
+  KeyCtx = RsaGetVerifyCtx ((RSA_PKEY_CTX *)RsaContext, RSA_PKCS1_PSS_PADDING, HashAlg, SaltLen);
   if (KeyCtx == NULL) {
-    goto _Exit;
-  }
-
-  if (Result) {
-    Result = EVP_PKEY_CTX_set_rsa_padding (KeyCtx, RSA_PKCS1_PSS_PADDING) > 0;
-  }
-
-  if (Result) {
-    Result = EVP_PKEY_CTX_set_rsa_pss_saltlen (KeyCtx, SaltLen) > 0;
-  }
-
-  if (Result) {
-    Result = EVP_PKEY_CTX_set_rsa_mgf1_md (KeyCtx, HashAlg) > 0;
-  }
-
-  if (Result) {
-    Result = EVP_DigestVerifyUpdate (EvpVerifyCtx, Message, (UINT32)MsgSize) > 0;
-  }
-
-  if (Result) {
-    Result = EVP_DigestVerifyFinal (EvpVerifyCtx, Signature, (UINT32)SigSize) > 0;
+    return FALSE;
   }
 
-_Exit:
-  if (EvpVerifyCtx != NULL) {
-    EVP_MD_CTX_free (EvpVerifyCtx);  // MU_CHANGE
+  if (EVP_Digest (Message, MsgSize, Digest, &DigestSize, HashAlg, NULL) != 1) {
+    return FALSE;
   }
 
-  return Result;
+  return (BOOLEAN)(EVP_PKEY_verify (KeyCtx, Signature, SigSize, Digest, DigestSize) == 1);
+  // MU_CHANGE [END]
 }
@@ -83,9 +83,6 @@ extern "C" {
 # ifndef OPENSSL_NO_CAST
 #  define OPENSSL_NO_CAST
 # endif
-# ifndef OPENSSL_NO_CHACHA
-#  define OPENSSL_NO_CHACHA
-# endif
 # ifndef OPENSSL_NO_CMAC
 #  define OPENSSL_NO_CMAC
 # endif
@@ -242,18 +239,12 @@ extern "C" {
 # ifndef OPENSSL_NO_OCB
 #  define OPENSSL_NO_OCB
 # endif
-# ifndef OPENSSL_NO_OCSP
-#  define OPENSSL_NO_OCSP
-# endif
 # ifndef OPENSSL_NO_PADLOCKENG
 #  define OPENSSL_NO_PADLOCKENG
 # endif
 # ifndef OPENSSL_NO_PIE
 #  define OPENSSL_NO_PIE
 # endif
-# ifndef OPENSSL_NO_POLY1305
-#  define OPENSSL_NO_POLY1305
-# endif
 # ifndef OPENSSL_NO_POSIX_IO
 #  define OPENSSL_NO_POSIX_IO
 # endif
@@ -341,9 +332,6 @@ extern "C" {
 # ifndef OPENSSL_NO_TLS_DEPRECATED_EC
 #  define OPENSSL_NO_TLS_DEPRECATED_EC
 # endif
-# ifndef OPENSSL_NO_TLS1_3
-#  define OPENSSL_NO_TLS1_3
-# endif
 # ifndef OPENSSL_NO_TRACE
 #  define OPENSSL_NO_TRACE
 # endif
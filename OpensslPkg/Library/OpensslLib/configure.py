@@ -27,7 +27,6 @@ def openssl_configure(openssldir, target, ec = True):
         'no-camellia',
         'no-capieng',
         'no-cast',
-        'no-chacha',
         'no-cmac',
         'no-cmp',
         'no-cms',
@@ -60,9 +59,7 @@ def openssl_configure(openssldir, target, ec = True):
         'no-pic',
         'no-psk',
         'no-ocb',
-        'no-ocsp',
         'no-padlockeng',
-        'no-poly1305',
         'no-posix-io',
         'no-quic',
         'no-rc2',
@@ -87,7 +84,6 @@ def openssl_configure(openssldir, target, ec = True):
         'no-static-engine',
         'no-stdio',
         'no-threads',
-        'no-tls1_3',
         'no-ts',
         'no-ui-console',
         'no-whirlpool',
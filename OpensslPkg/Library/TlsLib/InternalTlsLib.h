@@ -19,11 +19,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/SafeIntLib.h>
 #include <Protocol/Tls.h>
 #include <IndustryStandard/Tls1.h>
+#include <Guid/ImageAuthentication.h>
 #include <Library/PcdLib.h>
 #include <openssl/obj_mac.h>
 #include <openssl/ssl.h>
 #include <openssl/bio.h>
 #include <openssl/err.h>
+#include <openssl/ocsp.h>
 
 ///
 /// TLS Minimum security level
@@ -35,26 +37,100 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MAX_SECURITY_LEVEL  5
 ///
 
+///
+/// Size of the stack buffer that plaintext read and discarded by
+/// TlsHandleAlert() goes through, a piece at a time.
+///
+#define TLS_SCRATCH_BUFFER_SIZE  256
+
+///
+/// Default number of verified OCSP responses cached per TLS context.
+///
+#define TLS_OCSP_CACHE_SIZE  8
+
+///
+/// Allowed clock skew, in seconds, when checking the validity period of an
+/// OCSP response.
+///
+#define TLS_OCSP_MAX_SKEW  300
+
 typedef struct {
   //
   // Main SSL Connection which is created by a server or a client
   // per established connection.
   //
-  SSL    *Ssl;
+  SSL            *Ssl;
   //
   // Memory BIO for the TLS/SSL Reading operations.
   //
-  BIO    *InBio;
+  BIO            *InBio;
   //
   // Memory BIO for the TLS/SSL Writing operations.
   //
-  BIO    *OutBio;
+  BIO            *OutBio;
+  //
+  // Caller-owned receive window read by TlsReadDirect(), once the bytes
+  // already queued in InBio are consumed.
+  //
+  CONST UINT8    *DirectIn;
+  UINTN          DirectInSize;
+  //
+  // Caller-owned transmit window filled by TlsWriteDirect(); records that
+  // do not fit are queued in OutBio.
+  //
+  UINT8          *DirectOut;
+  UINTN          DirectOutSize;
+  //
+  // Maximum plaintext length of the records sent, as set by
+  // TlsSetMaxFragmentLength(); 0 if not limited.
+  //
+  UINTN          MaxSendFragment;
+  //
+  // TRUE if the handshake fails without a valid OCSP response for the
+  // server certificate, as set by TlsSetOcspStapling().
+  //
+  BOOLEAN        OcspRequired;
+  //
+  // Most recent resumable session of the connection. It is added to the
+  // client session cache of the TLS context only when the connection is shut
+  // down with TlsShutdown() or TlsCloseNotify().
+  //
+  SSL_SESSION    *PendingSession;
 } TLS_CONNECTION;
 
+///
+/// Maximum number of client sessions kept on a TLS context for resumption.
+///
+#define TLS_SESSION_CACHE_SIZE  16
+
 /* This is a context that we pass to callbacks */
 typedef struct {
   BIO      *BioDebug;
   INT32    Ack;
 } TLS_EXT_CTX;
 
+/**
+  Offer a session from the client session cache of the TLS context for
+  resumption on a connection that is about to start its handshake.
+
+  @param[in]  Ssl    Pointer to the SSL object of the connection.
+
+**/
+VOID
+TlsResumeCachedSession (
+  IN     SSL  *Ssl
+  );
+
+/**
+  Add the pending session of a connection that is being shut down to the
+  client session cache of its TLS context.
+
+  @param[in,out]  TlsConn    Pointer to the TLS connection.
+
+**/
+VOID
+TlsCachePendingSession (
+  IN OUT TLS_CONNECTION  *TlsConn
+  );
+
 #endif
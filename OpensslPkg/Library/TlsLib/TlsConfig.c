@@ -94,6 +94,13 @@ TlsSetVersion (
       SSL_set_min_proto_version (TlsConn->Ssl, TLS1_2_VERSION);
       SSL_set_max_proto_version (TlsConn->Ssl, TLS1_2_VERSION);
       break;
+    case TLS1_3_VERSION:
+      //
+      // TLS 1.3
+      //
+      SSL_set_min_proto_version (TlsConn->Ssl, TLS1_3_VERSION);
+      SSL_set_max_proto_version (TlsConn->Ssl, TLS1_3_VERSION);
+      break;
     default:
       //
       // Unsupported Protocol Version
@@ -104,6 +111,53 @@ TlsSetVersion (
   return EFI_SUCCESS;
 }
 
+/**
+  Set the range of TLS/SSL protocol versions a particular TLS object may
+  negotiate.
+
+  Unlike TlsSetVersion(), which pins the TLS object to one version, this lets
+  the peers settle on the highest version both of them support within
+  [MinVersion, MaxVersion], e.g. TLS 1.3 with a fallback to TLS 1.2.
+
+  @param[in]  Tls         Pointer to a TLS object.
+  @param[in]  MinVersion  Lowest acceptable protocol version, with the major
+                          version in the high byte (e.g. 0x0303 for TLS 1.2).
+  @param[in]  MaxVersion  Highest acceptable protocol version, with the major
+                          version in the high byte (e.g. 0x0304 for TLS 1.3).
+
+  @retval  EFI_SUCCESS           The TLS/SSL version range was set successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_UNSUPPORTED       Unsupported TLS/SSL version range.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetVersionRange (
+  IN     VOID    *Tls,
+  IN     UINT16  MinVersion,
+  IN     UINT16  MaxVersion
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (MinVersion > MaxVersion)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((MinVersion < TLS1_VERSION) || (MaxVersion > TLS1_3_VERSION)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((SSL_set_min_proto_version (TlsConn->Ssl, MinVersion) != 1) ||
+      (SSL_set_max_proto_version (TlsConn->Ssl, MaxVersion) != 1))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Set TLS object to work in client or server mode.
 
@@ -148,11 +202,181 @@ TlsSetConnectionEnd (
   return EFI_SUCCESS;
 }
 
+/**
+  Build the colon-separated OpenSSL cipher string for the mapped ciphers that
+  belong to one protocol generation.
+
+  TLS 1.3 cipher suites are configured apart from the TLS 1.2-and-earlier
+  cipher list in OpenSSL, so the mapped ciphers are split on the key exchange,
+  which TLS 1.3 suites do not fix ("any").
+
+  @param[in]   MappedCipher       Array of mapped OpenSSL ciphers, in preference
+                                  order.
+  @param[in]   MappedCipherCount  The number of entries in MappedCipher.
+  @param[in]   Tls13              TRUE to collect the TLS 1.3 cipher suites,
+                                  FALSE to collect the other ciphers.
+  @param[out]  CipherString       On success, the NUL-terminated cipher string,
+                                  to be freed with FreePool() by the caller.
+
+  @retval  EFI_SUCCESS           CipherString was built successfully.
+  @retval  EFI_NOT_FOUND         No mapped cipher belongs to the requested
+                                 generation. CipherString is set to NULL.
+  @retval  EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+TlsBuildCipherString (
+  IN     CONST SSL_CIPHER  **MappedCipher,
+  IN     UINTN             MappedCipherCount,
+  IN     BOOLEAN           Tls13,
+  OUT    CHAR8             **CipherString
+  )
+{
+  EFI_STATUS        Status;
+  UINTN             CipherStringSize;
+  UINTN             CipherCount;
+  UINTN             Index;
+  CHAR8             *CipherStringPosition;
+  CONST SSL_CIPHER  *OpensslCipher;
+  CONST CHAR8       *OpensslCipherName;
+  UINTN             OpensslCipherNameLength;
+
+  *CipherString = NULL;
+
+  //
+  // Count the number of bytes for the full CipherString.
+  //
+  CipherCount      = 0;
+  CipherStringSize = 0;
+  for (Index = 0; Index < MappedCipherCount; Index++) {
+    OpensslCipher = MappedCipher[Index];
+    if ((SSL_CIPHER_get_kx_nid (OpensslCipher) == NID_kx_any) != Tls13) {
+      continue;
+    }
+
+    //
+    // Accumulate cipher name string length into CipherStringSize. If this
+    // is not the first cipher, account for a colon (":") prefix too.
+    //
+    if (CipherCount > 0) {
+      Status = SafeUintnAdd (CipherStringSize, 1, &CipherStringSize);
+      if (EFI_ERROR (Status)) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    Status = SafeUintnAdd (
+               CipherStringSize,
+               AsciiStrLen (SSL_CIPHER_get_name (OpensslCipher)),
+               &CipherStringSize
+               );
+    if (EFI_ERROR (Status)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    CipherCount++;
+  }
+
+  if (CipherCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Account for the terminating NUL character in CipherStringSize; allocate
+  // CipherString.
+  //
+  Status = SafeUintnAdd (CipherStringSize, 1, &CipherStringSize);
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *CipherString = AllocatePool (CipherStringSize);
+  if (*CipherString == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Go over the collected mappings and populate CipherString.
+  //
+  CipherStringPosition = *CipherString;
+  for (Index = 0; Index < MappedCipherCount; Index++) {
+    OpensslCipher = MappedCipher[Index];
+    if ((SSL_CIPHER_get_kx_nid (OpensslCipher) == NID_kx_any) != Tls13) {
+      continue;
+    }
+
+    OpensslCipherName       = SSL_CIPHER_get_name (OpensslCipher);
+    OpensslCipherNameLength = AsciiStrLen (OpensslCipherName);
+    //
+    // Append the colon (":") prefix except for the first cipher, then append
+    // OpensslCipherName.
+    //
+    if (CipherStringPosition > *CipherString) {
+      *(CipherStringPosition++) = ':';
+    }
+
+    CopyMem (
+      CipherStringPosition,
+      OpensslCipherName,
+      OpensslCipherNameLength
+      );
+    CipherStringPosition += OpensslCipherNameLength;
+  }
+
+  //
+  // NUL-terminate CipherString.
+  //
+  *(CipherStringPosition++) = '\0';
+  ASSERT (CipherStringPosition == *CipherString + CipherStringSize);
+
+  //
+  // Log CipherString for debugging. CipherString can be very long if the
+  // caller provided a large CipherId array, so log CipherString in segments of
+  // 79 non-newline characters. (MAX_DEBUG_MESSAGE_LENGTH is usually 0x100 in
+  // DebugLib instances.)
+  //
+  DEBUG_CODE_BEGIN ();
+  UINTN  FullLength;
+  UINTN  SegmentLength;
+
+  FullLength = CipherStringSize - 1;
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a:%a: %a={\n",
+    gEfiCallerBaseName,
+    __func__,
+    Tls13 ? "CipherSuites" : "CipherString"
+    ));
+  for (CipherStringPosition = *CipherString;
+       CipherStringPosition < *CipherString + FullLength;
+       CipherStringPosition += SegmentLength)
+  {
+    SegmentLength = FullLength - (CipherStringPosition - *CipherString);
+    if (SegmentLength > 79) {
+      SegmentLength = 79;
+    }
+
+    DEBUG ((DEBUG_VERBOSE, "%.*a\n", SegmentLength, CipherStringPosition));
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "}\n"));
+  DEBUG_CODE_END ();
+
+  return EFI_SUCCESS;
+}
+
 /**
   Set the ciphers list to be used by the TLS object.
 
   This function sets the ciphers for use by a specified TLS object.
 
+  TLS 1.3 cipher suites (0x13XX) and TLS 1.2-and-earlier ciphers in CipherId
+  are configured separately, each in the order given. If CipherId contains no
+  TLS 1.3 cipher suite, all TLS 1.3 cipher suites are disabled and the highest
+  version negotiated is TLS 1.2. If it contains only TLS 1.3 cipher suites, the
+  TLS 1.2-and-earlier ciphers keep their current configuration.
+
   @param[in]  Tls          Pointer to a TLS object.
   @param[in]  CipherId     Array of UINT16 cipher identifiers. Each UINT16
                            cipher identifier comes from the TLS Cipher Suite
@@ -162,7 +386,9 @@ TlsSetConnectionEnd (
 
   @retval  EFI_SUCCESS           The ciphers list was set successfully.
   @retval  EFI_INVALID_PARAMETER The parameter is invalid.
-  @retval  EFI_UNSUPPORTED       No supported TLS cipher was found in CipherId.
+  @retval  EFI_UNSUPPORTED       No supported TLS cipher was found in CipherId,
+                                 or the TLS object only allows TLS 1.3 and
+                                 CipherId has no TLS 1.3 cipher suite.
   @retval  EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
 **/
@@ -179,16 +405,13 @@ TlsSetCipherList (
   CONST SSL_CIPHER  **MappedCipher;
   UINTN             MappedCipherBytes;
   UINTN             MappedCipherCount;
-  UINTN             CipherStringSize;
   UINTN             Index;
   INT32             StackIdx;
   CHAR8             *CipherString;
-  CHAR8             *CipherStringPosition;
+  CHAR8             *CipherSuites;
 
   STACK_OF (SSL_CIPHER)      *OpensslCipherStack;
   CONST SSL_CIPHER  *OpensslCipher;
-  CONST CHAR8       *OpensslCipherName;
-  UINTN             OpensslCipherNameLength;
 
   TlsConn = (TLS_CONNECTION *)Tls;
   if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (CipherId == NULL)) {
@@ -216,11 +439,9 @@ TlsSetCipherList (
   OpensslCipherStack = SSL_get_ciphers (TlsConn->Ssl);
 
   //
-  // Map the cipher IDs, and count the number of bytes for the full
-  // CipherString.
+  // Map the cipher IDs.
   //
   MappedCipherCount = 0;
-  CipherStringSize  = 0;
   for (Index = 0; OpensslCipherStack != NULL && Index < CipherNum; Index++) {
     //
     // Look up the IANA-to-OpenSSL mapping.
@@ -248,29 +469,6 @@ TlsSetCipherList (
       continue;
     }
 
-    //
-    // Accumulate cipher name string length into CipherStringSize. If this
-    // is not the first successful mapping, account for a colon (":") prefix
-    // too.
-    //
-    if (MappedCipherCount > 0) {
-      Status = SafeUintnAdd (CipherStringSize, 1, &CipherStringSize);
-      if (EFI_ERROR (Status)) {
-        Status = EFI_OUT_OF_RESOURCES;
-        goto FreeMappedCipher;
-      }
-    }
-
-    Status = SafeUintnAdd (
-               CipherStringSize,
-               AsciiStrLen (SSL_CIPHER_get_name (OpensslCipher)),
-               &CipherStringSize
-               );
-    if (EFI_ERROR (Status)) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto FreeMappedCipher;
-    }
-
     //
     // Record the mapping.
     //
@@ -278,8 +476,7 @@ TlsSetCipherList (
   }
 
   //
-  // Verify that at least one IANA cipher ID could be mapped; account for the
-  // terminating NUL character in CipherStringSize; allocate CipherString.
+  // Verify that at least one IANA cipher ID could be mapped.
   //
   if (MappedCipherCount == 0) {
     DEBUG ((
@@ -292,98 +489,68 @@ TlsSetCipherList (
     goto FreeMappedCipher;
   }
 
-  Status = SafeUintnAdd (CipherStringSize, 1, &CipherStringSize);
-  if (EFI_ERROR (Status)) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto FreeMappedCipher;
-  }
-
-  CipherString = AllocatePool (CipherStringSize);
-  if (CipherString == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto FreeMappedCipher;
-  }
-
   //
-  // Go over the collected mappings and populate CipherString.
+  // Build the TLS 1.2-and-earlier cipher list and the TLS 1.3 cipher suites.
+  // At least one of them is present.
   //
-  CipherStringPosition = CipherString;
-  for (Index = 0; Index < MappedCipherCount; Index++) {
-    OpensslCipher           = MappedCipher[Index];
-    OpensslCipherName       = SSL_CIPHER_get_name (OpensslCipher);
-    OpensslCipherNameLength = AsciiStrLen (OpensslCipherName);
-    //
-    // Append the colon (":") prefix except for the first mapping, then append
-    // OpensslCipherName.
-    //
-    if (Index > 0) {
-      *(CipherStringPosition++) = ':';
-    }
-
-    CopyMem (
-      CipherStringPosition,
-      OpensslCipherName,
-      OpensslCipherNameLength
-      );
-    CipherStringPosition += OpensslCipherNameLength;
+  CipherSuites = NULL;
+  Status       = TlsBuildCipherString (MappedCipher, MappedCipherCount, FALSE, &CipherString);
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    goto FreeMappedCipher;
   }
 
-  //
-  // NUL-terminate CipherString.
-  //
-  *(CipherStringPosition++) = '\0';
-  ASSERT (CipherStringPosition == CipherString + CipherStringSize);
-
-  //
-  // Log CipherString for debugging. CipherString can be very long if the
-  // caller provided a large CipherId array, so log CipherString in segments of
-  // 79 non-newline characters. (MAX_DEBUG_MESSAGE_LENGTH is usually 0x100 in
-  // DebugLib instances.)
-  //
-  DEBUG_CODE_BEGIN ();
-  UINTN  FullLength;
-  UINTN  SegmentLength;
-
-  FullLength = CipherStringSize - 1;
-  DEBUG ((
-    DEBUG_VERBOSE,
-    "%a:%a: CipherString={\n",
-    gEfiCallerBaseName,
-    __func__
-    ));
-  for (CipherStringPosition = CipherString;
-       CipherStringPosition < CipherString + FullLength;
-       CipherStringPosition += SegmentLength)
-  {
-    SegmentLength = FullLength - (CipherStringPosition - CipherString);
-    if (SegmentLength > 79) {
-      SegmentLength = 79;
-    }
-
-    DEBUG ((DEBUG_VERBOSE, "%.*a\n", SegmentLength, CipherStringPosition));
+  Status = TlsBuildCipherString (MappedCipher, MappedCipherCount, TRUE, &CipherSuites);
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    goto FreeCipherString;
   }
 
-  DEBUG ((DEBUG_VERBOSE, "}\n"));
   //
-  // Restore the pre-debug value of CipherStringPosition by skipping over the
-  // trailing NUL.
+  // A TLS object pinned to TLS 1.3 cannot do without TLS 1.3 cipher suites.
   //
-  CipherStringPosition++;
-  ASSERT (CipherStringPosition == CipherString + CipherStringSize);
-  DEBUG_CODE_END ();
+  if ((CipherSuites == NULL) && (SSL_get_min_proto_version (TlsConn->Ssl) >= TLS1_3_VERSION)) {
+    Status = EFI_UNSUPPORTED;
+    goto FreeCipherString;
+  }
 
   //
   // Sets the ciphers for use by the Tls object.
   //
-  if (SSL_set_cipher_list (TlsConn->Ssl, CipherString) <= 0) {
+  if ((CipherString != NULL) && (SSL_set_cipher_list (TlsConn->Ssl, CipherString) <= 0)) {
     Status = EFI_UNSUPPORTED;
     goto FreeCipherString;
   }
 
+  if (CipherSuites != NULL) {
+    if (SSL_set_ciphersuites (TlsConn->Ssl, CipherSuites) <= 0) {
+      Status = EFI_UNSUPPORTED;
+      goto FreeCipherString;
+    }
+  } else {
+    //
+    // An explicit list without TLS 1.3 cipher suites must not leave the
+    // OpenSSL default TLS 1.3 suites enabled. OpenSSL also refuses to start
+    // a handshake whose highest version has no cipher, so stop at TLS 1.2.
+    //
+    if ((SSL_set_ciphersuites (TlsConn->Ssl, "") <= 0) ||
+        (((SSL_get_max_proto_version (TlsConn->Ssl) == 0) ||
+          (SSL_get_max_proto_version (TlsConn->Ssl) > TLS1_2_VERSION)) &&
+         (SSL_set_max_proto_version (TlsConn->Ssl, TLS1_2_VERSION) != 1)))
+    {
+      Status = EFI_UNSUPPORTED;
+      goto FreeCipherString;
+    }
+  }
+
   Status = EFI_SUCCESS;
 
 FreeCipherString:
-  FreePool (CipherString);
+  if (CipherString != NULL) {
+    FreePool (CipherString);
+  }
+
+  if (CipherSuites != NULL) {
+    FreePool (CipherSuites);
+  }
 
 FreeMappedCipher:
   FreePool ((VOID *)MappedCipher);
@@ -679,37 +846,96 @@ TlsSetSessionId (
 }
 
 /**
-  Adds the CA to the cert store when requesting Server or Client authentication.
+  Sets a TLS/SSL session to be resumed during TLS/SSL connect.
 
-  This function adds the CA certificate to the list of CAs when requesting
-  Server or Client authentication for the chosen TLS connection.
+  This function restores a session previously returned by TlsGetSession(),
+  possibly by another TLS object or in an earlier boot, so that the next
+  handshake of the TLS object offers it for resumption. It must be called
+  before the handshake starts. If the server declines the session, a full
+  handshake is performed.
 
   @param[in]  Tls         Pointer to the TLS object.
-  @param[in]  Data        Pointer to the data buffer of a DER-encoded binary
-                          X.509 certificate or PEM-encoded X.509 certificate.
-  @param[in]  DataSize    The size of data buffer in bytes.
+  @param[in]  Data        Pointer to the session data returned by
+                          TlsGetSession().
+  @param[in]  DataSize    The size of Data in bytes.
 
-  @retval  EFI_SUCCESS             The operation succeeded.
-  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
-  @retval  EFI_OUT_OF_RESOURCES    Required resources could not be allocated.
-  @retval  EFI_ABORTED             Invalid X.509 certificate.
+  @retval  EFI_SUCCESS           The session was set successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_ABORTED           Invalid session data, or the handshake has
+                                 already started.
 
 **/
 EFI_STATUS
 EFIAPI
-TlsSetCaCertificate (
+TlsSetSession (
   IN     VOID   *Tls,
-  IN     VOID   *Data,
+  IN     UINT8  *Data,
   IN     UINTN  DataSize
   )
 {
-  BIO             *BioCert;
-  X509            *Cert;
-  X509_STORE      *X509Store;
-  EFI_STATUS      Status;
+  TLS_CONNECTION       *TlsConn;
+  SSL_SESSION          *Session;
+  CONST unsigned char  *Ptr;
+  EFI_STATUS           Status;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (Data == NULL) || (DataSize == 0) || (DataSize > INT_MAX)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!SSL_in_before (TlsConn->Ssl)) {
+    return EFI_ABORTED;
+  }
+
+  Ptr     = (CONST unsigned char *)Data;
+  Session = d2i_SSL_SESSION (NULL, &Ptr, (long)DataSize);
+  if (Session == NULL) {
+    return EFI_ABORTED;
+  }
+
+  if (!SSL_SESSION_is_resumable (Session) || (SSL_set_session (TlsConn->Ssl, Session) != 1)) {
+    Status = EFI_ABORTED;
+  } else {
+    Status = EFI_SUCCESS;
+  }
+
+  SSL_SESSION_free (Session);
+  return Status;
+}
+
+/**
+  Adds the CA to the cert store when requesting Server or Client authentication.
+
+  This function adds the CA certificate to the list of CAs when requesting
+  Server or Client authentication for the chosen TLS connection.
+
+  @param[in]  Tls         Pointer to the TLS object.
+  @param[in]  Data        Pointer to the data buffer of a DER-encoded binary
+                          X.509 certificate or PEM-encoded X.509 certificate.
+  @param[in]  DataSize    The size of data buffer in bytes.
+
+  @retval  EFI_SUCCESS             The operation succeeded.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+  @retval  EFI_OUT_OF_RESOURCES    Required resources could not be allocated.
+  @retval  EFI_ABORTED             Invalid X.509 certificate.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetCaCertificate (
+  IN     VOID   *Tls,
+  IN     VOID   *Data,
+  IN     UINTN  DataSize
+  )
+{
+  BIO             *BioCert;
+  X509            *Cert;
+  X509_STORE      *X509Store;
+  EFI_STATUS      Status;
   TLS_CONNECTION  *TlsConn;
   SSL_CTX         *SslCtx;
   INTN            Ret;
+  INTN            ObjectCount;
 
   BioCert   = NULL;
   Cert      = NULL;
@@ -757,10 +983,18 @@ TlsSetCaCertificate (
   }
 
   //
-  // Add certificate to X509 store
+  // Add certificate to X509 store. A new trust anchor changes which servers
+  // are accepted, so the cached sessions are dropped. Adding a certificate
+  // that is already in the store, as done for every new connection, keeps
+  // them.
   //
-  Ret = X509_STORE_add_cert (X509Store, Cert);
-  if (Ret != 1) {
+  ObjectCount = sk_X509_OBJECT_num (X509_STORE_get0_objects (X509Store));
+  Ret         = X509_STORE_add_cert (X509Store, Cert);
+  if (Ret == 1) {
+    if (sk_X509_OBJECT_num (X509_STORE_get0_objects (X509Store)) != ObjectCount) {
+      SSL_CTX_flush_sessions_ex (SslCtx, 0);
+    }
+  } else {
     unsigned long  ErrorCode;
 
     ErrorCode = ERR_peek_last_error ();
@@ -787,6 +1021,352 @@ ON_EXIT:
   return Status;
 }
 
+/**
+  Checks whether a buffer holds a well-formed chain of EFI_SIGNATURE_LIST
+  structures, as stored in the TlsCaCertificate variable.
+
+  @param[in]  Data        Pointer to the data buffer.
+  @param[in]  DataSize    The size of data buffer in bytes.
+
+  @retval  TRUE   Data is a chain of EFI_SIGNATURE_LIST structures.
+  @retval  FALSE  Data is not a chain of EFI_SIGNATURE_LIST structures.
+
+**/
+STATIC
+BOOLEAN
+TlsIsSignatureListChain (
+  IN     CONST UINT8  *Data,
+  IN     UINTN        DataSize
+  )
+{
+  UINTN  ListSize;
+
+  while (DataSize > 0) {
+    if (DataSize < sizeof (EFI_SIGNATURE_LIST)) {
+      return FALSE;
+    }
+
+    ListSize = ReadUnaligned32 (&((CONST EFI_SIGNATURE_LIST *)Data)->SignatureListSize);
+    if ((ListSize < sizeof (EFI_SIGNATURE_LIST)) || (ListSize > DataSize)) {
+      return FALSE;
+    }
+
+    Data     += ListSize;
+    DataSize -= ListSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Adds one X.509 certificate to a CA certificate store.
+
+  @param[in]  X509Store   Pointer to the X509_STORE object.
+  @param[in]  Cert        Pointer to the X509 certificate.
+
+  @retval  TRUE   The certificate was added or was already in the store.
+  @retval  FALSE  The certificate could not be added.
+
+**/
+STATIC
+BOOLEAN
+TlsCaStoreAddCert (
+  IN     X509_STORE  *X509Store,
+  IN     X509        *Cert
+  )
+{
+  unsigned long  ErrorCode;
+
+  if (X509_STORE_add_cert (X509Store, Cert) == 1) {
+    return TRUE;
+  }
+
+  //
+  // Ignore "already in table" errors
+  //
+  ErrorCode = ERR_peek_last_error ();
+  return (BOOLEAN)((ERR_GET_LIB (ErrorCode) == ERR_LIB_X509) &&
+                   (ERR_GET_REASON (ErrorCode) == X509_R_CERT_ALREADY_IN_HASH_TABLE));
+}
+
+/**
+  Adds DER-encoded X.509 certificates to a CA certificate store.
+
+  @param[in]      X509Store   Pointer to the X509_STORE object.
+  @param[in]      Data        Pointer to one or more concatenated DER-encoded
+                              X.509 certificates.
+  @param[in]      DataSize    The size of data buffer in bytes.
+  @param[in,out]  CertCount   Incremented for every certificate added.
+
+  @retval  TRUE   All certificates were added.
+  @retval  FALSE  Data holds an invalid certificate, or a certificate could not
+                  be added.
+
+**/
+STATIC
+BOOLEAN
+TlsCaStoreAddDer (
+  IN     X509_STORE   *X509Store,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        DataSize,
+  IN OUT UINTN        *CertCount
+  )
+{
+  CONST UINT8  *End;
+  X509         *Cert;
+  BOOLEAN      Added;
+
+  End = Data + DataSize;
+  while (Data < End) {
+    Cert = d2i_X509 (NULL, &Data, (long)(End - Data));
+    if (Cert == NULL) {
+      return FALSE;
+    }
+
+    Added = TlsCaStoreAddCert (X509Store, Cert);
+    X509_free (Cert);
+    if (!Added) {
+      return FALSE;
+    }
+
+    (*CertCount)++;
+  }
+
+  return TRUE;
+}
+
+/**
+  Adds PEM-encoded X.509 certificates to a CA certificate store.
+
+  @param[in]      X509Store   Pointer to the X509_STORE object.
+  @param[in]      Data        Pointer to one or more concatenated PEM-encoded
+                              X.509 certificates.
+  @param[in]      DataSize    The size of data buffer in bytes.
+  @param[in,out]  CertCount   Incremented for every certificate added.
+
+  @retval  EFI_SUCCESS             All certificates were added.
+  @retval  EFI_OUT_OF_RESOURCES    Required resources could not be allocated.
+  @retval  EFI_ABORTED             Data holds an invalid certificate, or a
+                                   certificate could not be added.
+
+**/
+STATIC
+EFI_STATUS
+TlsCaStoreAddPem (
+  IN     X509_STORE   *X509Store,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        DataSize,
+  IN OUT UINTN        *CertCount
+  )
+{
+  BIO            *BioCert;
+  X509           *Cert;
+  BOOLEAN        Added;
+  EFI_STATUS     Status;
+  unsigned long  ErrorCode;
+
+  //
+  // A read-only memory BIO reads the bundle in place.
+  //
+  BioCert = BIO_new_mem_buf (Data, (INT32)DataSize);
+  if (BioCert == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+  while (TRUE) {
+    Cert = PEM_read_bio_X509 (BioCert, NULL, NULL, NULL);
+    if (Cert == NULL) {
+      //
+      // Running out of PEM blocks ends the bundle; anything else is a
+      // malformed certificate.
+      //
+      ErrorCode = ERR_peek_last_error ();
+      if ((ERR_GET_LIB (ErrorCode) != ERR_LIB_PEM) ||
+          (ERR_GET_REASON (ErrorCode) != PEM_R_NO_START_LINE))
+      {
+        Status = EFI_ABORTED;
+      }
+
+      ERR_clear_error ();
+      break;
+    }
+
+    Added = TlsCaStoreAddCert (X509Store, Cert);
+    X509_free (Cert);
+    if (!Added) {
+      Status = EFI_ABORTED;
+      break;
+    }
+
+    (*CertCount)++;
+  }
+
+  BIO_free (BioCert);
+  return Status;
+}
+
+/**
+  Loads a bundle of CA certificates into a CA certificate store in one pass.
+
+  The bundle is one of:
+  - a chain of EFI_SIGNATURE_LIST structures, as stored in the
+    TlsCaCertificate variable; only EFI_CERT_X509_GUID lists are loaded,
+  - concatenated PEM-encoded X.509 certificates,
+  - concatenated DER-encoded X.509 certificates.
+
+  The store keeps its certificates indexed by subject name, and candidate
+  issuers with the same subject are told apart by their subject key
+  identifier during chain building, so the size of the bundle does not add
+  a linear scan to each verification.
+
+  @param[in]   CaStore     Pointer to the CA certificate store created by
+                           TlsCaStoreNew().
+  @param[in]   Data        Pointer to the certificate bundle.
+  @param[in]   DataSize    The size of the certificate bundle in bytes.
+  @param[out]  CertCount   The number of certificates loaded from Data.
+                           Optional.
+
+  @retval  EFI_SUCCESS             All certificates in Data were loaded.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+  @retval  EFI_OUT_OF_RESOURCES    Required resources could not be allocated.
+  @retval  EFI_ABORTED             Data holds an invalid X.509 certificate or
+                                   no certificate at all. The certificates
+                                   preceding the invalid one were loaded.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsCaStoreLoad (
+  IN     VOID   *CaStore,
+  IN     VOID   *Data,
+  IN     UINTN  DataSize,
+  OUT    UINTN  *CertCount  OPTIONAL
+  )
+{
+  X509_STORE                *X509Store;
+  CONST UINT8               *Ptr;
+  CONST UINT8               *End;
+  CONST EFI_SIGNATURE_LIST  *CertList;
+  UINTN                     ListSize;
+  UINTN                     HeaderSize;
+  UINTN                     SignatureSize;
+  UINTN                     Offset;
+  UINTN                     Count;
+  EFI_STATUS                Status;
+
+  X509Store = (X509_STORE *)CaStore;
+  if ((X509Store == NULL) || (Data == NULL) || (DataSize == 0) || (DataSize > INT_MAX)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Count  = 0;
+  Status = EFI_SUCCESS;
+  Ptr    = (CONST UINT8 *)Data;
+  End    = Ptr + DataSize;
+
+  if (TlsIsSignatureListChain (Ptr, DataSize)) {
+    //
+    // Walk the X.509 signature lists; each EFI_SIGNATURE_DATA holds one
+    // DER-encoded certificate after its owner GUID.
+    //
+    for ( ; Ptr < End; Ptr += ListSize) {
+      CertList      = (CONST EFI_SIGNATURE_LIST *)Ptr;
+      ListSize      = ReadUnaligned32 (&CertList->SignatureListSize);
+      HeaderSize    = ReadUnaligned32 (&CertList->SignatureHeaderSize);
+      SignatureSize = ReadUnaligned32 (&CertList->SignatureSize);
+      if (!CompareGuid (&CertList->SignatureType, &gEfiCertX509Guid)) {
+        continue;
+      }
+
+      if ((SignatureSize <= sizeof (EFI_GUID)) ||
+          (HeaderSize > ListSize - sizeof (EFI_SIGNATURE_LIST)) ||
+          (((ListSize - sizeof (EFI_SIGNATURE_LIST) - HeaderSize) % SignatureSize) != 0))
+      {
+        Status = EFI_ABORTED;
+        break;
+      }
+
+      for (Offset = sizeof (EFI_SIGNATURE_LIST) + HeaderSize; Offset < ListSize; Offset += SignatureSize) {
+        if (!TlsCaStoreAddDer (
+               X509Store,
+               ((CONST EFI_SIGNATURE_DATA *)(Ptr + Offset))->SignatureData,
+               SignatureSize - sizeof (EFI_GUID),
+               &Count
+               ))
+        {
+          Status = EFI_ABORTED;
+          break;
+        }
+      }
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+  } else if (*Ptr == 0x30) {
+    //
+    // A DER-encoded certificate starts with an ASN.1 SEQUENCE tag.
+    //
+    if (!TlsCaStoreAddDer (X509Store, Ptr, DataSize, &Count)) {
+      Status = EFI_ABORTED;
+    }
+  } else {
+    //
+    // PEM bundles may carry comments or other text between the certificates.
+    //
+    Status = TlsCaStoreAddPem (X509Store, Ptr, DataSize, &Count);
+  }
+
+  if (!EFI_ERROR (Status) && (Count == 0)) {
+    Status = EFI_ABORTED;
+  }
+
+  if (CertCount != NULL) {
+    *CertCount = Count;
+  }
+
+  return Status;
+}
+
+/**
+  Makes a CA certificate store the trust store of a TLS context.
+
+  The TLS context takes its own reference on the store, so one store
+  populated with TlsCaStoreLoad() can be shared by any number of TLS
+  contexts. Connections created with TlsNew() afterwards verify the server
+  against the certificates of the store; TlsSetCaCertificate() then adds to
+  the shared store.
+
+  @param[in]  TlsCtx      Pointer to the SSL_CTX object.
+  @param[in]  CaStore     Pointer to the CA certificate store created by
+                          TlsCaStoreNew().
+
+  @retval  EFI_SUCCESS             The trust store was set successfully.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsCtxSetCaStore (
+  IN     VOID  *TlsCtx,
+  IN     VOID  *CaStore
+  )
+{
+  if ((TlsCtx == NULL) || (CaStore == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SSL_CTX_set1_cert_store ((SSL_CTX *)TlsCtx, (X509_STORE *)CaStore);
+
+  //
+  // Sessions of the context were verified against the previous trust store.
+  //
+  SSL_CTX_flush_sessions_ex ((SSL_CTX *)TlsCtx, 0);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Loads the local public certificate into the specified TLS object.
 
@@ -863,158 +1443,752 @@ ON_EXIT:
     BIO_free (BioCert);
   }
 
-  if (Cert != NULL) {
-    X509_free (Cert);
+  if (Cert != NULL) {
+    X509_free (Cert);
+  }
+
+  return Status;
+}
+
+/**
+  Adds the local private key to the specified TLS object.
+
+  This function adds the local private key (DER-encoded or PEM-encoded or PKCS#8 private
+  key) into the specified TLS object for TLS negotiation.
+
+  @param[in]  Tls         Pointer to the TLS object.
+  @param[in]  Data        Pointer to the data buffer of a DER-encoded or PEM-encoded
+                          or PKCS#8 private key.
+  @param[in]  DataSize    The size of data buffer in bytes.
+  @param[in]  Password    Pointer to NULL-terminated private key password, set it to NULL
+                          if private key not encrypted.
+
+  @retval  EFI_SUCCESS     The operation succeeded.
+  @retval  EFI_UNSUPPORTED This function is not supported.
+  @retval  EFI_ABORTED     Invalid private key data.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetHostPrivateKeyEx (
+  IN     VOID   *Tls,
+  IN     VOID   *Data,
+  IN     UINTN  DataSize,
+  IN     VOID   *Password  OPTIONAL
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  BIO             *Bio;
+  EVP_PKEY        *Pkey;
+  BOOLEAN         Verify;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (Data == NULL) || (DataSize == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Try to parse the private key in DER format or un-encrypted PKC#8
+  if (SSL_use_PrivateKey_ASN1 (
+        EVP_PKEY_RSA,
+        TlsConn->Ssl,
+        Data,
+        (long)DataSize
+        ) == 1)
+  {
+    goto verify;
+  }
+
+  if (SSL_use_PrivateKey_ASN1 (
+        EVP_PKEY_DSA,
+        TlsConn->Ssl,
+        Data,
+        (long)DataSize
+        ) == 1)
+  {
+    goto verify;
+  }
+
+  if (SSL_use_PrivateKey_ASN1 (
+        EVP_PKEY_EC,
+        TlsConn->Ssl,
+        Data,
+        (long)DataSize
+        ) == 1)
+  {
+    goto verify;
+  }
+
+  // Try to parse the private key in PEM format or encrypted PKC#8
+  Bio = BIO_new_mem_buf (Data, (int)DataSize);
+  if (Bio != NULL) {
+    Verify = FALSE;
+    Pkey   = PEM_read_bio_PrivateKey (Bio, NULL, NULL, Password);
+    if ((Pkey != NULL) && (SSL_use_PrivateKey (TlsConn->Ssl, Pkey) == 1)) {
+      Verify = TRUE;
+    }
+
+    EVP_PKEY_free (Pkey);
+    BIO_free (Bio);
+
+    if (Verify) {
+      goto verify;
+    }
+  }
+
+  return EFI_ABORTED;
+
+verify:
+  if (SSL_check_private_key (TlsConn->Ssl) == 1) {
+    return EFI_SUCCESS;
+  }
+
+  return EFI_ABORTED;
+}
+
+/**
+  Adds the local private key to the specified TLS object.
+
+  This function adds the local private key (DER-encoded or PEM-encoded or PKCS#8 private
+  key) into the specified TLS object for TLS negotiation.
+
+  @param[in]  Tls         Pointer to the TLS object.
+  @param[in]  Data        Pointer to the data buffer of a DER-encoded or PEM-encoded
+                          or PKCS#8 private key.
+  @param[in]  DataSize    The size of data buffer in bytes.
+
+  @retval  EFI_SUCCESS     The operation succeeded.
+  @retval  EFI_UNSUPPORTED This function is not supported.
+  @retval  EFI_ABORTED     Invalid private key data.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetHostPrivateKey (
+  IN     VOID   *Tls,
+  IN     VOID   *Data,
+  IN     UINTN  DataSize
+  )
+{
+  return TlsSetHostPrivateKeyEx (Tls, Data, DataSize, NULL);
+}
+
+/**
+  Adds the CA-supplied certificate revocation list for certificate validation.
+
+  This function adds the CA-supplied certificate revocation list data for
+  certificate validity checking.
+
+  @param[in]  Data        Pointer to the data buffer of a DER-encoded CRL data.
+  @param[in]  DataSize    The size of data buffer in bytes.
+
+  @retval  EFI_SUCCESS     The operation succeeded.
+  @retval  EFI_UNSUPPORTED This function is not supported.
+  @retval  EFI_ABORTED     Invalid CRL data.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetCertRevocationList (
+  IN     VOID   *Data,
+  IN     UINTN  DataSize
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+typedef struct {
+  //
+  // SHA-1 certificate ID of the certificate the response is for.
+  //
+  OCSP_CERTID       *CertId;
+  //
+  // Verified response, and the DER encoding it was stapled as.
+  //
+  OCSP_BASICRESP    *Response;
+  UINT8             *Der;
+  UINTN             DerSize;
+} TLS_OCSP_CACHE_ENTRY;
+
+typedef struct {
+  TLS_OCSP_CACHE_ENTRY    *Entries;
+  UINTN                   Capacity;
+  UINTN                   Count;
+  //
+  // Entry replaced next once the cache is full.
+  //
+  UINTN                   Next;
+} TLS_OCSP_CACHE;
+
+//
+// Index of the OCSP response cache in the ex_data of a TLS context.
+//
+STATIC INT32  mTlsOcspCacheIndex = -1;
+
+/**
+  Releases all entries of an OCSP response cache.
+
+  @param[in,out]  Cache    Pointer to the OCSP response cache.
+
+**/
+STATIC
+VOID
+TlsOcspCacheFlush (
+  IN OUT TLS_OCSP_CACHE  *Cache
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Cache->Count; Index++) {
+    OCSP_CERTID_free (Cache->Entries[Index].CertId);
+    OCSP_BASICRESP_free (Cache->Entries[Index].Response);
+    OPENSSL_free (Cache->Entries[Index].Der);
+  }
+
+  if (Cache->Entries != NULL) {
+    ZeroMem (Cache->Entries, Cache->Capacity * sizeof (TLS_OCSP_CACHE_ENTRY));
+  }
+
+  Cache->Count = 0;
+  Cache->Next  = 0;
+}
+
+/**
+  Frees the OCSP response cache of a TLS context when the context is freed.
+
+  @param[in]  Parent    Pointer to the TLS context.
+  @param[in]  Ptr       Pointer to the OCSP response cache, or NULL.
+  @param[in]  Ad        Pointer to the ex_data of the TLS context.
+  @param[in]  Index     Index of the OCSP response cache in the ex_data.
+  @param[in]  Argl      Unused.
+  @param[in]  Argp      Unused.
+
+**/
+STATIC
+VOID
+TlsOcspCacheFreeCallback (
+  IN     VOID            *Parent,
+  IN     VOID            *Ptr,
+  IN     CRYPTO_EX_DATA  *Ad,
+  IN     INT32           Index,
+  IN     long            Argl,
+  IN     VOID            *Argp
+  )
+{
+  TLS_OCSP_CACHE  *Cache;
+
+  Cache = (TLS_OCSP_CACHE *)Ptr;
+  if (Cache == NULL) {
+    return;
+  }
+
+  TlsOcspCacheFlush (Cache);
+  OPENSSL_free (Cache->Entries);
+  OPENSSL_free (Cache);
+}
+
+/**
+  Returns the OCSP response cache of a TLS context, creating it with
+  TLS_OCSP_CACHE_SIZE entries on first use.
+
+  @param[in]  SslCtx    Pointer to the TLS context.
+
+  @return  Pointer to the OCSP response cache, or NULL on failure.
+
+**/
+STATIC
+TLS_OCSP_CACHE *
+TlsOcspGetCache (
+  IN     SSL_CTX  *SslCtx
+  )
+{
+  TLS_OCSP_CACHE  *Cache;
+
+  if (mTlsOcspCacheIndex < 0) {
+    mTlsOcspCacheIndex = SSL_CTX_get_ex_new_index (0, NULL, NULL, NULL, TlsOcspCacheFreeCallback);
+    if (mTlsOcspCacheIndex < 0) {
+      return NULL;
+    }
+  }
+
+  Cache = (TLS_OCSP_CACHE *)SSL_CTX_get_ex_data (SslCtx, mTlsOcspCacheIndex);
+  if (Cache != NULL) {
+    return Cache;
+  }
+
+  Cache = (TLS_OCSP_CACHE *)OPENSSL_zalloc (sizeof (TLS_OCSP_CACHE));
+  if (Cache == NULL) {
+    return NULL;
+  }
+
+  Cache->Entries = (TLS_OCSP_CACHE_ENTRY *)OPENSSL_zalloc (TLS_OCSP_CACHE_SIZE * sizeof (TLS_OCSP_CACHE_ENTRY));
+  if ((Cache->Entries == NULL) || (SSL_CTX_set_ex_data (SslCtx, mTlsOcspCacheIndex, Cache) != 1)) {
+    OPENSSL_free (Cache->Entries);
+    OPENSSL_free (Cache);
+    return NULL;
+  }
+
+  Cache->Capacity = TLS_OCSP_CACHE_SIZE;
+  return Cache;
+}
+
+/**
+  Looks up the cached OCSP response for a certificate ID.
+
+  @param[in]  Cache     Pointer to the OCSP response cache.
+  @param[in]  CertId    SHA-1 certificate ID of the certificate.
+
+  @return  Pointer to the cache entry, or NULL if there is none.
+
+**/
+STATIC
+TLS_OCSP_CACHE_ENTRY *
+TlsOcspCacheLookup (
+  IN     TLS_OCSP_CACHE  *Cache,
+  IN     OCSP_CERTID     *CertId
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Cache->Count; Index++) {
+    if (OCSP_id_cmp (Cache->Entries[Index].CertId, CertId) == 0) {
+      return &Cache->Entries[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Removes an entry from the OCSP response cache.
+
+  @param[in,out]  Cache    Pointer to the OCSP response cache.
+  @param[in]      Entry    Pointer to the entry to remove.
+
+**/
+STATIC
+VOID
+TlsOcspCacheRemove (
+  IN OUT TLS_OCSP_CACHE        *Cache,
+  IN     TLS_OCSP_CACHE_ENTRY  *Entry
+  )
+{
+  TLS_OCSP_CACHE_ENTRY  *Last;
+
+  OCSP_CERTID_free (Entry->CertId);
+  OCSP_BASICRESP_free (Entry->Response);
+  OPENSSL_free (Entry->Der);
+
+  Cache->Count--;
+  Last = &Cache->Entries[Cache->Count];
+  if (Entry != Last) {
+    CopyMem (Entry, Last, sizeof (TLS_OCSP_CACHE_ENTRY));
+  }
+
+  ZeroMem (Last, sizeof (TLS_OCSP_CACHE_ENTRY));
+}
+
+/**
+  Stores a verified OCSP response in the cache, replacing the response cached
+  for the same certificate ID, or the oldest entry once the cache is full.
+  On success, the cache takes ownership of Response.
+
+  @param[in,out]  Cache       Pointer to the OCSP response cache.
+  @param[in]      CertId      SHA-1 certificate ID of the certificate.
+  @param[in]      Response    Pointer to the verified response.
+  @param[in]      Der         Pointer to the DER encoding of the response.
+  @param[in]      DerSize     Size of Der in bytes.
+
+  @retval  TRUE     The response was cached.
+  @retval  FALSE    Caching is disabled, or memory allocation failed.
+
+**/
+STATIC
+BOOLEAN
+TlsOcspCacheStore (
+  IN OUT TLS_OCSP_CACHE  *Cache,
+  IN     OCSP_CERTID     *CertId,
+  IN     OCSP_BASICRESP  *Response,
+  IN     CONST UINT8     *Der,
+  IN     UINTN           DerSize
+  )
+{
+  TLS_OCSP_CACHE_ENTRY  *Entry;
+  OCSP_CERTID           *IdCopy;
+  UINT8                 *DerCopy;
+
+  if (Cache->Capacity == 0) {
+    return FALSE;
+  }
+
+  IdCopy  = OCSP_CERTID_dup (CertId);
+  DerCopy = (UINT8 *)OPENSSL_memdup (Der, DerSize);
+  if ((IdCopy == NULL) || (DerCopy == NULL)) {
+    OCSP_CERTID_free (IdCopy);
+    OPENSSL_free (DerCopy);
+    return FALSE;
+  }
+
+  Entry = TlsOcspCacheLookup (Cache, CertId);
+  if (Entry == NULL) {
+    if (Cache->Count < Cache->Capacity) {
+      Entry = &Cache->Entries[Cache->Count];
+      Cache->Count++;
+    } else {
+      Entry       = &Cache->Entries[Cache->Next];
+      Cache->Next = (Cache->Next + 1) % Cache->Capacity;
+    }
+  }
+
+  OCSP_CERTID_free (Entry->CertId);
+  OCSP_BASICRESP_free (Entry->Response);
+  OPENSSL_free (Entry->Der);
+
+  Entry->CertId   = IdCopy;
+  Entry->Response = Response;
+  Entry->Der      = DerCopy;
+  Entry->DerSize  = DerSize;
+  return TRUE;
+}
+
+/**
+  Finds the status of a certificate in an OCSP response, and checks that
+  the status is within its validity period.
+
+  Single responses may identify the certificate with any hash algorithm, so
+  the certificate ID is recomputed with the algorithm of each of them. Errors
+  raised by the lookup are not left in the OpenSSL error queue, where they
+  would fail the handshake even if the missing status is acceptable.
+
+  @param[in]   Response    Pointer to the OCSP response.
+  @param[in]   Cert        Pointer to the certificate.
+  @param[in]   Issuer      Pointer to the issuer of the certificate.
+  @param[out]  Status      V_OCSP_CERTSTATUS_* status of the certificate.
+
+  @retval  TRUE     A current status was found.
+  @retval  FALSE    The response has no status for the certificate, or the
+                    status is not current.
+
+**/
+STATIC
+BOOLEAN
+TlsOcspFindStatus (
+  IN     OCSP_BASICRESP  *Response,
+  IN     X509            *Cert,
+  IN     X509            *Issuer,
+  OUT    INT32           *Status
+  )
+{
+  INT32                 Index;
+  OCSP_SINGLERESP       *Single;
+  CONST OCSP_CERTID     *SingleId;
+  ASN1_OBJECT           *HashOid;
+  CONST EVP_MD          *Md;
+  OCSP_CERTID           *CertId;
+  INT32                 Reason;
+  ASN1_GENERALIZEDTIME  *ThisUpdate;
+  ASN1_GENERALIZEDTIME  *NextUpdate;
+  BOOLEAN               Found;
+
+  ERR_set_mark ();
+
+  Found = FALSE;
+  for (Index = 0; !Found && (Index < OCSP_resp_count (Response)); Index++) {
+    Single   = OCSP_resp_get0 (Response, Index);
+    SingleId = OCSP_SINGLERESP_get0_id (Single);
+    HashOid  = NULL;
+    if (OCSP_id_get0_info (NULL, &HashOid, NULL, NULL, (OCSP_CERTID *)SingleId) != 1) {
+      continue;
+    }
+
+    Md = EVP_get_digestbyobj (HashOid);
+    if (Md == NULL) {
+      continue;
+    }
+
+    CertId = OCSP_cert_to_id (Md, Cert, Issuer);
+    if (CertId == NULL) {
+      continue;
+    }
+
+    if (OCSP_id_cmp (CertId, SingleId) == 0) {
+      *Status = OCSP_single_get0_status (Single, &Reason, NULL, &ThisUpdate, &NextUpdate);
+      Found   = (BOOLEAN)(OCSP_check_validity (ThisUpdate, NextUpdate, TLS_OCSP_MAX_SKEW, -1) == 1);
+    }
+
+    OCSP_CERTID_free (CertId);
+  }
+
+  ERR_pop_to_mark ();
+
+  return Found;
+}
+
+/**
+  Callback invoked by OpenSSL on the client once the server certificate has
+  been verified, to check the OCSP response stapled by the server.
+
+  A stapled response is accepted only if it is signed by the issuer of the
+  server certificate, or by a responder the issuer delegated to, and is
+  current. Verified responses are cached in the TLS context, so that a
+  response stapled again does not need to be verified again, and a cached
+  response that is still current covers a server that did not staple one.
+
+  @param[in]  Ssl    Pointer to the SSL object of the connection.
+  @param[in]  Arg    Unused.
+
+  @retval  1    The server certificate is not revoked, or its status is not
+                required and unknown.
+  @retval  0    The server certificate is revoked, the stapled response is
+                invalid, or a required status is unknown.
+  @retval  -1   An internal error occurred.
+
+**/
+STATIC
+INT32
+TlsOcspStatusCallback (
+  IN     SSL   *Ssl,
+  IN     VOID  *Arg
+  )
+{
+  TLS_CONNECTION        *TlsConn;
+  STACK_OF (X509)       *Chain;
+  X509                  *Cert;
+  X509                  *Issuer;
+  OCSP_CERTID           *CertId;
+  TLS_OCSP_CACHE        *Cache;
+  TLS_OCSP_CACHE_ENTRY  *Entry;
+  CONST UINT8           *Der;
+  CONST UINT8           *Ptr;
+  long                  DerSize;
+  OCSP_RESPONSE         *OcspResponse;
+  OCSP_BASICRESP        *Response;
+  BOOLEAN               Found;
+  INT32                 Status;
+  INT32                 Result;
+
+  TlsConn = (TLS_CONNECTION *)SSL_get_app_data (Ssl);
+  if (TlsConn == NULL) {
+    return -1;
+  }
+
+  //
+  // A resumed TLS 1.3 session has no server certificate to check; its status
+  // was checked by the handshake that established the session.
+  //
+  if (SSL_session_reused (Ssl)) {
+    return 1;
+  }
+
+  //
+  // The certificate ID is built from the issuer's name and key, so the
+  // status can only be checked against a verified chain.
+  //
+  Chain = SSL_get0_verified_chain (Ssl);
+  if ((Chain == NULL) || (sk_X509_num (Chain) < 2)) {
+    return TlsConn->OcspRequired ? 0 : 1;
+  }
+
+  Cert   = sk_X509_value (Chain, 0);
+  Issuer = sk_X509_value (Chain, 1);
+  CertId = OCSP_cert_to_id (NULL, Cert, Issuer);
+  Cache  = TlsOcspGetCache (SSL_get_SSL_CTX (Ssl));
+  if ((CertId == NULL) || (Cache == NULL)) {
+    OCSP_CERTID_free (CertId);
+    return -1;
+  }
+
+  Entry    = TlsOcspCacheLookup (Cache, CertId);
+  Response = NULL;
+  Der      = NULL;
+  DerSize  = SSL_get_tlsext_status_ocsp_resp (Ssl, &Der);
+  if ((Der != NULL) && (DerSize > 0) &&
+      ((Entry == NULL) || (Entry->DerSize != (UINTN)DerSize) ||
+       (CompareMem (Entry->Der, Der, Entry->DerSize) != 0)))
+  {
+    //
+    // A stapled response other than the one verified earlier.
+    //
+    Entry        = NULL;
+    Ptr          = Der;
+    OcspResponse = d2i_OCSP_RESPONSE (NULL, &Ptr, DerSize);
+    if ((OcspResponse != NULL) &&
+        (OCSP_response_status (OcspResponse) == OCSP_RESPONSE_STATUS_SUCCESSFUL))
+    {
+      Response = OCSP_response_get1_basic (OcspResponse);
+    }
+
+    OCSP_RESPONSE_free (OcspResponse);
+    if ((Response == NULL) ||
+        (OCSP_basic_verify (Response, Chain, SSL_CTX_get_cert_store (SSL_get_SSL_CTX (Ssl)), 0) != 1))
+    {
+      DEBUG ((DEBUG_ERROR, "%a: invalid stapled OCSP response\n", __func__));
+      OCSP_BASICRESP_free (Response);
+      OCSP_CERTID_free (CertId);
+      return 0;
+    }
+  }
+
+  if ((Response == NULL) && (Entry != NULL)) {
+    Response = Entry->Response;
+  }
+
+  Found  = FALSE;
+  Status = V_OCSP_CERTSTATUS_UNKNOWN;
+  if (Response != NULL) {
+    Found = TlsOcspFindStatus (Response, Cert, Issuer, &Status);
+  }
+
+  if (!Found) {
+    //
+    // No current status for the certificate.
+    //
+    Result = TlsConn->OcspRequired ? 0 : 1;
+  } else if (Status == V_OCSP_CERTSTATUS_GOOD) {
+    Result = 1;
+  } else if (Status == V_OCSP_CERTSTATUS_REVOKED) {
+    DEBUG ((DEBUG_ERROR, "%a: server certificate is revoked\n", __func__));
+    Result = 0;
+  } else {
+    Result = TlsConn->OcspRequired ? 0 : 1;
+  }
+
+  if (Entry != NULL) {
+    //
+    // A cached response that is no longer current is of no further use.
+    //
+    if (!Found) {
+      TlsOcspCacheRemove (Cache, Entry);
+    }
+  } else if (Response != NULL) {
+    //
+    // Keep a newly verified response that vouches for the certificate; the
+    // cache takes ownership of it.
+    //
+    if ((Result != 1) || !Found || !TlsOcspCacheStore (Cache, CertId, Response, Der, (UINTN)DerSize)) {
+      OCSP_BASICRESP_free (Response);
+    }
   }
 
-  return Status;
+  OCSP_CERTID_free (CertId);
+  return Result;
 }
 
 /**
-  Adds the local private key to the specified TLS object.
+  Enables OCSP stapling on the specified TLS connection.
 
-  This function adds the local private key (DER-encoded or PEM-encoded or PKCS#8 private
-  key) into the specified TLS object for TLS negotiation.
+  This function requests the status_request extension (RFC 6066), asking the
+  server to staple an OCSP response for its certificate to the handshake, and
+  checks the status of the server certificate once it has been verified. A
+  server certificate that is revoked, or a stapled response that is invalid,
+  makes the handshake fail. Revocation is checked against one small signed
+  response per handshake, instead of a complete certificate revocation list.
+
+  Verified responses are cached in the TLS context of the connection, keyed
+  by certificate ID, see TlsCtxSetOcspCacheSize(). A cached response that is
+  still current is used when the server does not staple one.
+
+  This function must be called before the handshake starts.
 
   @param[in]  Tls         Pointer to the TLS object.
-  @param[in]  Data        Pointer to the data buffer of a DER-encoded or PEM-encoded
-                          or PKCS#8 private key.
-  @param[in]  DataSize    The size of data buffer in bytes.
-  @param[in]  Password    Pointer to NULL-terminated private key password, set it to NULL
-                          if private key not encrypted.
+  @param[in]  Required    TRUE to make the handshake also fail when no
+                          current status is available for the server
+                          certificate, FALSE to accept the certificate in
+                          that case.
 
-  @retval  EFI_SUCCESS     The operation succeeded.
-  @retval  EFI_UNSUPPORTED This function is not supported.
-  @retval  EFI_ABORTED     Invalid private key data.
+  @retval  EFI_SUCCESS             OCSP stapling was enabled successfully.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+  @retval  EFI_ABORTED             The handshake has already started.
 
 **/
 EFI_STATUS
 EFIAPI
-TlsSetHostPrivateKeyEx (
-  IN     VOID   *Tls,
-  IN     VOID   *Data,
-  IN     UINTN  DataSize,
-  IN     VOID   *Password  OPTIONAL
+TlsSetOcspStapling (
+  IN     VOID     *Tls,
+  IN     BOOLEAN  Required
   )
 {
   TLS_CONNECTION  *TlsConn;
-  BIO             *Bio;
-  EVP_PKEY        *Pkey;
-  BOOLEAN         Verify;
+  SSL_CTX         *SslCtx;
 
   TlsConn = (TLS_CONNECTION *)Tls;
-
-  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (Data == NULL) || (DataSize == 0)) {
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  // Try to parse the private key in DER format or un-encrypted PKC#8
-  if (SSL_use_PrivateKey_ASN1 (
-        EVP_PKEY_RSA,
-        TlsConn->Ssl,
-        Data,
-        (long)DataSize
-        ) == 1)
-  {
-    goto verify;
-  }
-
-  if (SSL_use_PrivateKey_ASN1 (
-        EVP_PKEY_DSA,
-        TlsConn->Ssl,
-        Data,
-        (long)DataSize
-        ) == 1)
-  {
-    goto verify;
+  if (!SSL_in_before (TlsConn->Ssl)) {
+    return EFI_ABORTED;
   }
 
-  if (SSL_use_PrivateKey_ASN1 (
-        EVP_PKEY_EC,
-        TlsConn->Ssl,
-        Data,
-        (long)DataSize
-        ) == 1)
+  SslCtx = SSL_get_SSL_CTX (TlsConn->Ssl);
+  if ((TlsOcspGetCache (SslCtx) == NULL) ||
+      (SSL_CTX_set_tlsext_status_cb (SslCtx, TlsOcspStatusCallback) != 1) ||
+      (SSL_set_tlsext_status_type (TlsConn->Ssl, TLSEXT_STATUSTYPE_ocsp) != 1))
   {
-    goto verify;
-  }
-
-  // Try to parse the private key in PEM format or encrypted PKC#8
-  Bio = BIO_new_mem_buf (Data, (int)DataSize);
-  if (Bio != NULL) {
-    Verify = FALSE;
-    Pkey   = PEM_read_bio_PrivateKey (Bio, NULL, NULL, Password);
-    if ((Pkey != NULL) && (SSL_use_PrivateKey (TlsConn->Ssl, Pkey) == 1)) {
-      Verify = TRUE;
-    }
-
-    EVP_PKEY_free (Pkey);
-    BIO_free (Bio);
-
-    if (Verify) {
-      goto verify;
-    }
+    return EFI_ABORTED;
   }
 
-  return EFI_ABORTED;
-
-verify:
-  if (SSL_check_private_key (TlsConn->Ssl) == 1) {
-    return EFI_SUCCESS;
-  }
+  TlsConn->OcspRequired = Required;
 
-  return EFI_ABORTED;
+  return EFI_SUCCESS;
 }
 
 /**
-  Adds the local private key to the specified TLS object.
+  Sets the number of OCSP responses cached by the specified TLS context.
 
-  This function adds the local private key (DER-encoded or PEM-encoded or PKCS#8 private
-  key) into the specified TLS object for TLS negotiation.
+  This function flushes the OCSP responses cached so far, and sets the number
+  of verified responses the connections of the context with OCSP stapling
+  enabled keep for reuse. The default is TLS_OCSP_CACHE_SIZE responses.
 
-  @param[in]  Tls         Pointer to the TLS object.
-  @param[in]  Data        Pointer to the data buffer of a DER-encoded or PEM-encoded
-                          or PKCS#8 private key.
-  @param[in]  DataSize    The size of data buffer in bytes.
+  @param[in]  TlsCtx       Pointer to the TLS context.
+  @param[in]  CacheSize    Maximum number of cached responses, 0 to disable
+                           the cache.
 
-  @retval  EFI_SUCCESS     The operation succeeded.
-  @retval  EFI_UNSUPPORTED This function is not supported.
-  @retval  EFI_ABORTED     Invalid private key data.
+  @retval  EFI_SUCCESS             The cache size was set successfully.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+  @retval  EFI_OUT_OF_RESOURCES    Memory allocation failed.
 
 **/
 EFI_STATUS
 EFIAPI
-TlsSetHostPrivateKey (
-  IN     VOID   *Tls,
-  IN     VOID   *Data,
-  IN     UINTN  DataSize
+TlsCtxSetOcspCacheSize (
+  IN     VOID   *TlsCtx,
+  IN     UINTN  CacheSize
   )
 {
-  return TlsSetHostPrivateKeyEx (Tls, Data, DataSize, NULL);
-}
+  TLS_OCSP_CACHE        *Cache;
+  TLS_OCSP_CACHE_ENTRY  *Entries;
+  UINTN                 Size;
+  EFI_STATUS            Status;
 
-/**
-  Adds the CA-supplied certificate revocation list for certificate validation.
+  if (TlsCtx == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-  This function adds the CA-supplied certificate revocation list data for
-  certificate validity checking.
+  Status = SafeUintnMult (CacheSize, sizeof (TLS_OCSP_CACHE_ENTRY), &Size);
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  @param[in]  Data        Pointer to the data buffer of a DER-encoded CRL data.
-  @param[in]  DataSize    The size of data buffer in bytes.
+  Cache = TlsOcspGetCache ((SSL_CTX *)TlsCtx);
+  if (Cache == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  @retval  EFI_SUCCESS     The operation succeeded.
-  @retval  EFI_UNSUPPORTED This function is not supported.
-  @retval  EFI_ABORTED     Invalid CRL data.
+  Entries = NULL;
+  if (Size != 0) {
+    Entries = (TLS_OCSP_CACHE_ENTRY *)OPENSSL_zalloc (Size);
+    if (Entries == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
 
-**/
-EFI_STATUS
-EFIAPI
-TlsSetCertRevocationList (
-  IN     VOID   *Data,
-  IN     UINTN  DataSize
-  )
-{
-  return EFI_UNSUPPORTED;
+  TlsOcspCacheFlush (Cache);
+  OPENSSL_free (Cache->Entries);
+  Cache->Entries  = Entries;
+  Cache->Capacity = CacheSize;
+
+  return EFI_SUCCESS;
 }
 
 /**
@@ -1124,18 +2298,57 @@ TlsSetSignatureAlgoList (
   return Status;
 }
 
+/**
+  Map an EC named curve to the corresponding OpenSSL NID.
+
+  @param[in]  Curve  An EC named curve as defined in section 5.1.1 of RFC 4492.
+
+  @return  The OpenSSL NID of the curve, or NID_undef if the curve is not
+           supported.
+
+**/
+STATIC
+INT32
+TlsEcCurveToNid (
+  IN     UINT32  Curve
+  )
+{
+  switch (Curve) {
+    case TlsEcNamedCurveSecp384r1:
+      return NID_secp384r1;
+    case TlsEcNamedCurveSecp521r1:
+      return NID_secp521r1;
+    case TlsEcNamedCurveX25519:
+      return NID_X25519;
+    case TlsEcNamedCurveX448:
+      return NID_X448;
+    default:
+      //
+      // TlsEcNamedCurveSecp256r1 is not supported either.
+      //
+      return NID_undef;
+  }
+}
+
 /**
   Set the EC curve to be used for TLS flows
 
   This function sets the EC curve to be used for TLS flows.
 
+  Data may also hold an ordered preference list of curves, most preferred
+  first. The list is offered as the supported groups, and a TLS 1.3 client
+  sends its key share for the first curve in the list. Unsupported curves in
+  a list are skipped.
+
   @param[in]  Tls                Pointer to a TLS object.
-  @param[in]  Data               An EC named curve as defined in section 5.1.1 of RFC 4492.
-  @param[in]  DataSize           Size of Data, it should be sizeof (UINT32)
+  @param[in]  Data               An EC named curve as defined in section 5.1.1 of RFC 4492,
+                                 or an array of them.
+  @param[in]  DataSize           Size of Data, it should be a non-zero multiple of sizeof (UINT32)
 
   @retval  EFI_SUCCESS           The EC curve was set successfully.
   @retval  EFI_INVALID_PARAMETER The parameters are invalid.
   @retval  EFI_UNSUPPORTED       The requested TLS EC curve is not supported
+  @retval  EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
 **/
 EFI_STATUS
@@ -1149,31 +2362,55 @@ TlsSetEcCurve (
   TLS_CONNECTION  *TlsConn;
   EC_KEY          *EcKey;
   INT32           Nid;
+  INT32           *GroupNids;
+  UINTN           GroupCount;
+  UINTN           Index;
   INT32           Ret;
 
   TlsConn = (TLS_CONNECTION *)Tls;
 
-  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (Data == NULL) || (DataSize != sizeof (UINT32))) {
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (Data == NULL) ||
+      (DataSize == 0) || ((DataSize % sizeof (UINT32)) != 0))
+  {
     return EFI_INVALID_PARAMETER;
   }
 
-  switch (*((UINT32 *)Data)) {
-    case TlsEcNamedCurveSecp256r1:
-      return EFI_UNSUPPORTED;
-    case TlsEcNamedCurveSecp384r1:
-      Nid = NID_secp384r1;
-      break;
-    case TlsEcNamedCurveSecp521r1:
-      Nid = NID_secp521r1;
-      break;
-    case TlsEcNamedCurveX25519:
-      Nid = NID_X25519;
-      break;
-    case TlsEcNamedCurveX448:
-      Nid = NID_X448;
-      break;
-    default:
+  if (DataSize > sizeof (UINT32)) {
+    //
+    // Ordered group list. Unsupported curves are skipped without changing the
+    // relative order of the others.
+    //
+    GroupNids = AllocatePool ((DataSize / sizeof (UINT32)) * sizeof (INT32));
+    if (GroupNids == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    GroupCount = 0;
+    for (Index = 0; Index < DataSize / sizeof (UINT32); Index++) {
+      Nid = TlsEcCurveToNid (((UINT32 *)Data)[Index]);
+      if (Nid != NID_undef) {
+        GroupNids[GroupCount++] = Nid;
+      }
+    }
+
+    if (GroupCount == 0) {
+      Ret = 0;
+    } else {
+      Ret = (INT32)SSL_set1_groups (TlsConn->Ssl, GroupNids, (INT32)GroupCount);
+    }
+
+    FreePool (GroupNids);
+
+    if (Ret != 1) {
       return EFI_UNSUPPORTED;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  Nid = TlsEcCurveToNid (*((UINT32 *)Data));
+  if (Nid == NID_undef) {
+    return EFI_UNSUPPORTED;
   }
 
   if (SSL_set1_curves (TlsConn->Ssl, &Nid, 1) != 1) {
@@ -1235,6 +2472,74 @@ TlsSetSecurityLevel (
   return EFI_SUCCESS;
 }
 
+/**
+  Limits the size of the TLS records of the specified TLS connection.
+
+  This function requests the maximum_fragment_length extension (RFC 6066) in
+  the ClientHello, so that a server supporting it sends records of at most
+  MaxFragmentLength bytes of plaintext, and limits the records sent on the
+  connection to the same size. Once the limit is negotiated, OpenSSL sizes
+  the record read and write buffers of the connection accordingly.
+
+  This function must be called before the handshake starts.
+
+  @param[in]  Tls                  Pointer to the TLS object.
+  @param[in]  MaxFragmentLength    Maximum plaintext length of a record in
+                                   bytes: 512, 1024, 2048 or 4096.
+
+  @retval  EFI_SUCCESS             The limit was set successfully.
+  @retval  EFI_INVALID_PARAMETER   The parameter is invalid.
+  @retval  EFI_UNSUPPORTED         The requested length is not supported.
+  @retval  EFI_ABORTED             The handshake has already started.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetMaxFragmentLength (
+  IN     VOID    *Tls,
+  IN     UINT16  MaxFragmentLength
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  UINT8           Mode;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  switch (MaxFragmentLength) {
+    case 512:
+      Mode = TLSEXT_max_fragment_length_512;
+      break;
+    case 1024:
+      Mode = TLSEXT_max_fragment_length_1024;
+      break;
+    case 2048:
+      Mode = TLSEXT_max_fragment_length_2048;
+      break;
+    case 4096:
+      Mode = TLSEXT_max_fragment_length_4096;
+      break;
+    default:
+      return EFI_UNSUPPORTED;
+  }
+
+  if (!SSL_in_before (TlsConn->Ssl)) {
+    return EFI_ABORTED;
+  }
+
+  if ((SSL_set_tlsext_max_fragment_length (TlsConn->Ssl, Mode) != 1) ||
+      (SSL_set_max_send_fragment (TlsConn->Ssl, MaxFragmentLength) != 1))
+  {
+    return EFI_ABORTED;
+  }
+
+  TlsConn->MaxSendFragment = MaxFragmentLength;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Gets the protocol version used by the specified TLS connection.
 
@@ -1437,6 +2742,75 @@ TlsGetSessionId (
   return EFI_SUCCESS;
 }
 
+/**
+  Gets the TLS/SSL session established by the specified TLS connection.
+
+  This function serializes the session of the TLS connection into an opaque
+  buffer that can later be passed to TlsSetSession() to resume the session
+  on another connection to the same server. The data contains the session
+  secrets and must be protected accordingly by the caller.
+
+  A TLS 1.3 session only becomes resumable once the server has sent a
+  NewSessionTicket message, which happens after the handshake; it is
+  processed by TlsRead().
+
+  @param[in]      Tls         Pointer to the TLS object.
+  @param[out]     Data        Buffer to contain the returned session data.
+  @param[in,out]  DataSize    The size of Data in bytes. On output, the size
+                              of the session data.
+
+  @retval  EFI_SUCCESS           The session data was returned successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_NOT_FOUND         The TLS connection has no resumable session.
+  @retval  EFI_BUFFER_TOO_SMALL  The Data is too small to hold the session
+                                 data. DataSize is updated with the required
+                                 size.
+  @retval  EFI_ABORTED           The session could not be serialized.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsGetSession (
+  IN     VOID   *Tls,
+  OUT    UINT8  *Data  OPTIONAL,
+  IN OUT UINTN  *DataSize
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  SSL_SESSION     *Session;
+  unsigned char   *Ptr;
+  INT32           Length;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (DataSize == NULL) || ((Data == NULL) && (*DataSize != 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Session = SSL_get_session (TlsConn->Ssl);
+  if ((Session == NULL) || !SSL_SESSION_is_resumable (Session)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Length = i2d_SSL_SESSION (Session, NULL);
+  if (Length <= 0) {
+    return EFI_ABORTED;
+  }
+
+  if (*DataSize < (UINTN)Length) {
+    *DataSize = (UINTN)Length;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Ptr    = Data;
+  Length = i2d_SSL_SESSION (Session, &Ptr);
+  if (Length <= 0) {
+    return EFI_ABORTED;
+  }
+
+  *DataSize = (UINTN)Length;
+  return EFI_SUCCESS;
+}
+
 /**
   Gets the client random data used in the specified TLS connection.
 
@@ -67,10 +67,369 @@ TlsCtxFree (
   }
 }
 
+//
+// Index of the verification key in the ex_data of a client session.
+//
+STATIC INT32  mTlsSessionKeyIndex = -1;
+
+/**
+  Copies the verification key of a session when the session is duplicated.
+
+  @param[in]      To        Pointer to the ex_data of the new session.
+  @param[in]      From      Pointer to the ex_data of the original session.
+  @param[in,out]  FromData  On input, pointer to the key of the original
+                            session. On output, pointer to the copy for the
+                            new session.
+  @param[in]      Index     Index of the key in the ex_data.
+  @param[in]      Argl      Unused.
+  @param[in]      Argp      Unused.
+
+  @retval  1    The key was copied.
+  @retval  0    Memory allocation failed.
+
+**/
+STATIC
+INT32
+TlsSessionKeyDupCallback (
+  IN     CRYPTO_EX_DATA        *To,
+  IN     CONST CRYPTO_EX_DATA  *From,
+  IN OUT VOID                  **FromData,
+  IN     INT32                 Index,
+  IN     long                  Argl,
+  IN     VOID                  *Argp
+  )
+{
+  if (*FromData != NULL) {
+    *FromData = OPENSSL_memdup (*FromData, SHA256_DIGEST_LENGTH);
+    if (*FromData == NULL) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/**
+  Frees the verification key of a session when the session is freed.
+
+  @param[in]  Parent    Pointer to the session.
+  @param[in]  Ptr       Pointer to the key, or NULL.
+  @param[in]  Ad        Pointer to the ex_data of the session.
+  @param[in]  Index     Index of the key in the ex_data.
+  @param[in]  Argl      Unused.
+  @param[in]  Argp      Unused.
+
+**/
+STATIC
+VOID
+TlsSessionKeyFreeCallback (
+  IN     VOID            *Parent,
+  IN     VOID            *Ptr,
+  IN     CRYPTO_EX_DATA  *Ad,
+  IN     INT32           Index,
+  IN     long            Argl,
+  IN     VOID            *Argp
+  )
+{
+  OPENSSL_free (Ptr);
+}
+
+/**
+  Computes the verification key of a connection: a SHA-256 digest of the
+  settings that decide whether the server certificate is accepted, so that a
+  session verified under one configuration is not resumed under another.
+
+  The trust store is not part of the key; the session cache is flushed
+  instead when TlsSetCaCertificate() or TlsCtxSetCaStore() change it.
+
+  @param[in]   Ssl    Pointer to the SSL object of the connection.
+  @param[out]  Key    Buffer receiving the SHA256_DIGEST_LENGTH byte key.
+
+  @retval  TRUE   The key was computed.
+  @retval  FALSE  The key could not be computed.
+
+**/
+STATIC
+BOOLEAN
+TlsGetSessionKey (
+  IN     SSL    *Ssl,
+  OUT    UINT8  *Key
+  )
+{
+  TLS_CONNECTION     *TlsConn;
+  X509_VERIFY_PARAM  *VerifyParam;
+  EVP_MD_CTX         *MdCtx;
+  CHAR8              *IpAddress;
+  CONST CHAR8        *Host;
+  UINT32             Settings[3];
+  BOOLEAN            Result;
+
+  TlsConn     = (TLS_CONNECTION *)SSL_get_app_data (Ssl);
+  VerifyParam = SSL_get0_param (Ssl);
+  if ((TlsConn == NULL) || (VerifyParam == NULL)) {
+    return FALSE;
+  }
+
+  Settings[0] = (UINT32)SSL_get_verify_mode (Ssl);
+  Settings[1] = (UINT32)X509_VERIFY_PARAM_get_hostflags (VerifyParam);
+  Settings[2] = (UINT32)TlsConn->OcspRequired;
+  Host        = X509_VERIFY_PARAM_get0_host (VerifyParam, 0);
+
+  //
+  // X509_VERIFY_PARAM_get1_ip_asc() raises an error when no address is set.
+  // Do not leave it in the error queue, where SSL_get_error() would take it
+  // for a failure of the next TLS I/O operation.
+  //
+  ERR_set_mark ();
+  IpAddress = X509_VERIFY_PARAM_get1_ip_asc (VerifyParam);
+  ERR_pop_to_mark ();
+
+  Result = FALSE;
+  MdCtx  = EVP_MD_CTX_new ();
+  if (MdCtx == NULL) {
+    goto ON_EXIT;
+  }
+
+  //
+  // The terminating NUL characters keep the host and the address apart.
+  //
+  if ((EVP_DigestInit_ex (MdCtx, EVP_sha256 (), NULL) != 1) ||
+      (EVP_DigestUpdate (MdCtx, Settings, sizeof (Settings)) != 1) ||
+      (EVP_DigestUpdate (MdCtx, (Host != NULL) ? Host : "", (Host != NULL) ? AsciiStrSize (Host) : 1) != 1) ||
+      (EVP_DigestUpdate (MdCtx, (IpAddress != NULL) ? IpAddress : "", (IpAddress != NULL) ? AsciiStrSize (IpAddress) : 1) != 1) ||
+      (EVP_DigestFinal_ex (MdCtx, Key, NULL) != 1))
+  {
+    goto ON_EXIT;
+  }
+
+  Result = TRUE;
+
+ON_EXIT:
+  EVP_MD_CTX_free (MdCtx);
+  OPENSSL_free (IpAddress);
+  return Result;
+}
+
+/**
+  Callback invoked by OpenSSL when a client session becomes available for
+  resumption, at the end of a TLS 1.2 handshake or on receipt of a TLS 1.3
+  NewSessionTicket message.
+
+  The session is tagged with the server name sent in the handshake and the
+  verification key of the connection, and kept on the connection as its
+  pending session. It only enters the client session cache of the TLS context
+  when the connection is closed with a close_notify: when TlsCloseNotify()
+  sends one, or when TlsShutdown() is called after the peer's close_notify was
+  received. A connection torn down without a close_notify, e.g. after a
+  truncation, is never resumed. Sessions of connections without a server
+  name, or whose server certificate was not verified, are not kept.
+
+  @param[in]  Ssl        Pointer to the SSL object of the connection.
+  @param[in]  Session    Pointer to the new session.
+
+  @retval  0    OpenSSL keeps ownership of the session reference.
+  @retval  1    The reference is kept as the pending session.
+
+**/
+STATIC
+INT32
+TlsNewSessionCallback (
+  IN     SSL          *Ssl,
+  IN     SSL_SESSION  *Session
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  CONST CHAR8     *HostName;
+  UINT8           Key[SHA256_DIGEST_LENGTH];
+  UINT8           *SessionKey;
+
+  TlsConn  = (TLS_CONNECTION *)SSL_get_app_data (Ssl);
+  HostName = SSL_get_servername (Ssl, TLSEXT_NAMETYPE_host_name);
+  if ((TlsConn == NULL) || (HostName == NULL) || !SSL_SESSION_is_resumable (Session)) {
+    return 0;
+  }
+
+  if (((SSL_get_verify_mode (Ssl) & SSL_VERIFY_PEER) == 0) ||
+      (SSL_get_verify_result (Ssl) != X509_V_OK))
+  {
+    return 0;
+  }
+
+  if ((SSL_SESSION_get0_hostname (Session) == NULL) &&
+      (SSL_SESSION_set1_hostname (Session, HostName) != 1))
+  {
+    return 0;
+  }
+
+  if ((mTlsSessionKeyIndex < 0) || !TlsGetSessionKey (Ssl, Key)) {
+    return 0;
+  }
+
+  SessionKey = OPENSSL_memdup (Key, sizeof (Key));
+  if (SessionKey == NULL) {
+    return 0;
+  }
+
+  //
+  // A session duplicated from an earlier ticket of this connection carries a
+  // copy of the key already.
+  //
+  OPENSSL_free (SSL_SESSION_get_ex_data (Session, mTlsSessionKeyIndex));
+  if (SSL_SESSION_set_ex_data (Session, mTlsSessionKeyIndex, SessionKey) != 1) {
+    OPENSSL_free (SessionKey);
+    return 0;
+  }
+
+  SSL_SESSION_free (TlsConn->PendingSession);
+  TlsConn->PendingSession = Session;
+  return 1;
+}
+
+/**
+  Add the pending session of a connection that is being shut down to the
+  client session cache of its TLS context.
+
+  @param[in,out]  TlsConn    Pointer to the TLS connection.
+
+**/
+VOID
+TlsCachePendingSession (
+  IN OUT TLS_CONNECTION  *TlsConn
+  )
+{
+  if (TlsConn->PendingSession == NULL) {
+    return;
+  }
+
+  if (SSL_SESSION_is_resumable (TlsConn->PendingSession)) {
+    SSL_CTX_add_session (SSL_get_SSL_CTX (TlsConn->Ssl), TlsConn->PendingSession);
+  }
+
+  SSL_SESSION_free (TlsConn->PendingSession);
+  TlsConn->PendingSession = NULL;
+}
+
+typedef struct {
+  //
+  // Server name to look up.
+  //
+  CONST CHAR8    *HostName;
+  //
+  // Verification key of the connection looking up a session.
+  //
+  UINT8          Key[SHA256_DIGEST_LENGTH];
+  //
+  // Most recent matching session found so far.
+  //
+  SSL_SESSION    *Session;
+} TLS_SESSION_LOOKUP;
+
+/**
+  Session cache iterator that records the most recent resumable session
+  issued for the server name and verification key being looked up.
+
+  @param[in]      Session    Pointer to a cached session.
+  @param[in,out]  Arg        Pointer to the TLS_SESSION_LOOKUP state.
+
+**/
+STATIC
+VOID
+TlsFindSessionCallback (
+  IN     SSL_SESSION  *Session,
+  IN OUT VOID         *Arg
+  )
+{
+  TLS_SESSION_LOOKUP  *Lookup;
+  CONST CHAR8         *HostName;
+  CONST UINT8         *Key;
+
+  Lookup   = (TLS_SESSION_LOOKUP *)Arg;
+  HostName = SSL_SESSION_get0_hostname (Session);
+  Key      = (CONST UINT8 *)SSL_SESSION_get_ex_data (Session, mTlsSessionKeyIndex);
+  if ((HostName == NULL) || (AsciiStrCmp (HostName, Lookup->HostName) != 0) ||
+      (Key == NULL) || (CompareMem (Key, Lookup->Key, sizeof (Lookup->Key)) != 0) ||
+      !SSL_SESSION_is_resumable (Session))
+  {
+    return;
+  }
+
+  if ((Lookup->Session == NULL) ||
+      (SSL_SESSION_get_time_ex (Session) > SSL_SESSION_get_time_ex (Lookup->Session)))
+  {
+    Lookup->Session = Session;
+  }
+}
+
+/**
+  Offer a session from the client session cache of the TLS context for
+  resumption on a connection that is about to start its handshake.
+
+  Nothing is done if the connection has already started, already has a
+  session (e.g. set by TlsSetSession()), or has no server name. Only sessions
+  verified under the same settings are offered. If the server declines the
+  session, a full handshake is performed.
+
+  @param[in]  Ssl    Pointer to the SSL object of the connection.
+
+**/
+VOID
+TlsResumeCachedSession (
+  IN     SSL  *Ssl
+  )
+{
+  SSL_CTX             *SslCtx;
+  SSL_SESSION         *Session;
+  TLS_SESSION_LOOKUP  Lookup;
+
+  if (!SSL_in_before (Ssl) || (SSL_get_session (Ssl) != NULL)) {
+    return;
+  }
+
+  Lookup.HostName = SSL_get_servername (Ssl, TLSEXT_NAMETYPE_host_name);
+  Lookup.Session  = NULL;
+  if ((Lookup.HostName == NULL) || (mTlsSessionKeyIndex < 0) || !TlsGetSessionKey (Ssl, Lookup.Key)) {
+    return;
+  }
+
+  SslCtx = SSL_get_SSL_CTX (Ssl);
+  SSL_CTX_flush_sessions_ex (SslCtx, time (NULL));
+  OPENSSL_LH_doall_arg (
+    (OPENSSL_LHASH *)SSL_CTX_sessions (SslCtx),
+    (OPENSSL_LH_DOALL_FUNCARG)TlsFindSessionCallback,
+    &Lookup
+    );
+  if (Lookup.Session == NULL) {
+    return;
+  }
+
+  //
+  // TLS 1.3 tickets are meant to be used once (RFC 8446, Appendix C.4); the
+  // server sends fresh ones after the resumed handshake. Removing a session
+  // from the cache also marks it as not resumable, so offer a copy. TLS 1.2
+  // sessions stay cached since a resumed TLS 1.2 handshake does not renew
+  // them.
+  //
+  if (SSL_SESSION_get_protocol_version (Lookup.Session) < TLS1_3_VERSION) {
+    SSL_set_session (Ssl, Lookup.Session);
+    return;
+  }
+
+  Session = SSL_SESSION_dup (Lookup.Session);
+  SSL_CTX_remove_session (SslCtx, Lookup.Session);
+  if (Session != NULL) {
+    SSL_set_session (Ssl, Session);
+    SSL_SESSION_free (Session);
+  }
+}
+
 /**
   Creates a new SSL_CTX object as framework to establish TLS/SSL enabled
   connections.
 
+  MajorVer/MinorVer is the lowest version accepted. The highest version is
+  TLS 1.2, unless TLS 1.3 is given here or is enabled later on the TLS object
+  with TlsSetVersion() or TlsSetVersionRange().
+
   @param[in]  MajorVer    Major Version of TLS/SSL Protocol.
   @param[in]  MinorVer    Minor Version of TLS/SSL Protocol.
 
@@ -106,9 +465,259 @@ TlsCtxNew (
   //
   SSL_CTX_set_min_proto_version (TlsCtx, ProtoVersion);
 
+  //
+  // Do not offer TLS 1.3 unless the caller asks for it, either here or with
+  // TlsSetVersion()/TlsSetVersionRange() on the TLS object.
+  //
+  SSL_CTX_set_max_proto_version (TlsCtx, MAX (ProtoVersion, TLS1_2_VERSION));
+
+  //
+  // Keep resumable client sessions (TLS 1.2 sessions and tickets, TLS 1.3
+  // PSK tickets) of connections that were shut down on the context, so that
+  // later connections to the same server created with TlsNew() resume
+  // instead of doing a full handshake. OpenSSL does not look up client
+  // sessions itself; the cache is consulted in TlsResumeCachedSession().
+  //
+  if (mTlsSessionKeyIndex < 0) {
+    mTlsSessionKeyIndex = SSL_SESSION_get_ex_new_index (0, NULL, NULL, TlsSessionKeyDupCallback, TlsSessionKeyFreeCallback);
+  }
+
+  SSL_CTX_set_session_cache_mode (TlsCtx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_cache_size (TlsCtx, TLS_SESSION_CACHE_SIZE);
+  SSL_CTX_sess_set_new_cb (TlsCtx, TlsNewSessionCallback);
+
+  //
+  // Free the record read and write buffers of idle connections, instead of
+  // keeping more than 34 KB per connection allocated for its whole lifetime.
+  //
+  SSL_CTX_set_mode (TlsCtx, SSL_MODE_RELEASE_BUFFERS);
+
   return (VOID *)TlsCtx;
 }
 
+/**
+  Creates a new CA certificate store that can be shared by TLS contexts.
+
+  @return  Pointer to an allocated X509_STORE object.
+           If the creation failed, TlsCaStoreNew() returns NULL.
+
+**/
+VOID *
+EFIAPI
+TlsCaStoreNew (
+  VOID
+  )
+{
+  X509_STORE  *X509Store;
+
+  X509Store = X509_STORE_new ();
+  if (X509Store == NULL) {
+    return NULL;
+  }
+
+  //
+  // Set X509_STORE flags used in certificate validation, as TlsNew() does
+  // for the default store.
+  //
+  X509_STORE_set_flags (X509Store, X509_V_FLAG_PARTIAL_CHAIN);
+
+  return (VOID *)X509Store;
+}
+
+/**
+  Releases a CA certificate store.
+
+  The store is freed once the last TLS context using it is freed as well.
+  If CaStore is NULL, nothing is done.
+
+  @param[in]  CaStore    Pointer to the CA certificate store to be released.
+
+**/
+VOID
+EFIAPI
+TlsCaStoreFree (
+  IN     VOID  *CaStore
+  )
+{
+  if (CaStore == NULL) {
+    return;
+  }
+
+  X509_STORE_free ((X509_STORE *)CaStore);
+}
+
+//
+// Method of the pass-through BIO connecting a TLS object to its memory BIOs
+// and to the caller windows of TlsReadDirect() and TlsWriteDirect().
+//
+STATIC BIO_METHOD  *mTlsDirectBioMethod = NULL;
+
+/**
+  Reads TLS records for OpenSSL, first from the bytes queued in InBio, then
+  from the caller-owned receive window.
+
+  @param[in]   Bio         Pointer to the pass-through BIO.
+  @param[out]  Data        Pointer to the buffer receiving the bytes.
+  @param[in]   Size        The size of Data in bytes.
+  @param[out]  ReadBytes   The number of bytes read.
+
+  @retval  1    Some bytes were read.
+  @retval  0    No bytes are available yet; the retry flag is set.
+
+**/
+STATIC
+INT32
+TlsDirectBioRead (
+  IN     BIO     *Bio,
+  OUT    CHAR8   *Data,
+  IN     size_t  Size,
+  OUT    size_t  *ReadBytes
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  UINTN           Length;
+
+  TlsConn = (TLS_CONNECTION *)BIO_get_data (Bio);
+  BIO_clear_retry_flags (Bio);
+  *ReadBytes = 0;
+
+  if (BIO_ctrl_pending (TlsConn->InBio) > 0) {
+    return BIO_read_ex (TlsConn->InBio, Data, Size, ReadBytes);
+  }
+
+  if (TlsConn->DirectInSize == 0) {
+    BIO_set_retry_read (Bio);
+    return 0;
+  }
+
+  Length = MIN (Size, TlsConn->DirectInSize);
+  CopyMem (Data, TlsConn->DirectIn, Length);
+  TlsConn->DirectIn     += Length;
+  TlsConn->DirectInSize -= Length;
+  *ReadBytes             = Length;
+  return 1;
+}
+
+/**
+  Writes TLS records from OpenSSL into the caller-owned transmit window, and
+  queues whatever does not fit in OutBio.
+
+  @param[in]   Bio           Pointer to the pass-through BIO.
+  @param[in]   Data          Pointer to the bytes to write.
+  @param[in]   Size          The size of Data in bytes.
+  @param[out]  WrittenBytes  The number of bytes written.
+
+  @retval  1    All bytes were written.
+  @retval  0    The bytes could not be queued.
+
+**/
+STATIC
+INT32
+TlsDirectBioWrite (
+  IN     BIO          *Bio,
+  IN     CONST CHAR8  *Data,
+  IN     size_t       Size,
+  OUT    size_t       *WrittenBytes
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  UINTN           Length;
+  size_t          Queued;
+
+  TlsConn = (TLS_CONNECTION *)BIO_get_data (Bio);
+  BIO_clear_retry_flags (Bio);
+  *WrittenBytes = 0;
+
+  //
+  // Bytes already queued in OutBio go out first, so only write to the
+  // window while OutBio is empty.
+  //
+  Length = 0;
+  if ((TlsConn->DirectOutSize > 0) && (BIO_ctrl_pending (TlsConn->OutBio) == 0)) {
+    Length = MIN (Size, TlsConn->DirectOutSize);
+    CopyMem (TlsConn->DirectOut, Data, Length);
+    TlsConn->DirectOut     += Length;
+    TlsConn->DirectOutSize -= Length;
+  }
+
+  if ((Length < Size) && !BIO_write_ex (TlsConn->OutBio, Data + Length, Size - Length, &Queued)) {
+    return 0;
+  }
+
+  *WrittenBytes = Size;
+  return 1;
+}
+
+/**
+  Control callback of the pass-through BIO.
+
+  @param[in]  Bio     Pointer to the pass-through BIO.
+  @param[in]  Cmd     The control command.
+  @param[in]  Num     Numeric argument of the command.
+  @param[in]  Ptr     Pointer argument of the command.
+
+  @return  The result of the command, 0 for unsupported commands.
+
+**/
+STATIC
+long
+TlsDirectBioCtrl (
+  IN     BIO    *Bio,
+  IN     INT32  Cmd,
+  IN     long   Num,
+  IN     VOID   *Ptr
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+
+  TlsConn = (TLS_CONNECTION *)BIO_get_data (Bio);
+  switch (Cmd) {
+    case BIO_CTRL_PENDING:
+      return (long)(BIO_ctrl_pending (TlsConn->InBio) + TlsConn->DirectInSize);
+    case BIO_CTRL_WPENDING:
+      return (long)BIO_ctrl_pending (TlsConn->OutBio);
+    case BIO_CTRL_FLUSH:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/**
+  Returns the method of the pass-through BIO, creating it on first use.
+
+  @return  Pointer to the BIO method, or NULL on failure.
+
+**/
+STATIC
+BIO_METHOD *
+TlsGetDirectBioMethod (
+  VOID
+  )
+{
+  BIO_METHOD  *Method;
+
+  if (mTlsDirectBioMethod != NULL) {
+    return mTlsDirectBioMethod;
+  }
+
+  Method = BIO_meth_new (BIO_get_new_index () | BIO_TYPE_SOURCE_SINK, "TLS direct I/O");
+  if (Method == NULL) {
+    return NULL;
+  }
+
+  if (!BIO_meth_set_read_ex (Method, TlsDirectBioRead) ||
+      !BIO_meth_set_write_ex (Method, TlsDirectBioWrite) ||
+      !BIO_meth_set_ctrl (Method, TlsDirectBioCtrl))
+  {
+    BIO_meth_free (Method);
+    return NULL;
+  }
+
+  mTlsDirectBioMethod = Method;
+  return mTlsDirectBioMethod;
+}
+
 /**
   Free an allocated TLS object.
 
@@ -134,10 +743,19 @@ TlsFree (
   //
   // Free the internal TLS and related BIO objects.
   //
+  //
+  // A session still pending was not followed by a shutdown of the connection
+  // and is not cached.
+  //
+  SSL_SESSION_free (TlsConn->PendingSession);
+
   if (TlsConn->Ssl != NULL) {
     SSL_free (TlsConn->Ssl);
   }
 
+  BIO_free (TlsConn->InBio);
+  BIO_free (TlsConn->OutBio);
+
   OPENSSL_free (Tls);
 }
 
@@ -163,19 +781,19 @@ TlsNew (
   TLS_CONNECTION  *TlsConn;
   SSL_CTX         *SslCtx;
   X509_STORE      *X509Store;
+  BIO_METHOD      *Method;
+  BIO             *DirectBio;
 
   TlsConn = NULL;
 
   //
   // Allocate one new TLS_CONNECTION object
   //
-  TlsConn = (TLS_CONNECTION *)OPENSSL_malloc (sizeof (TLS_CONNECTION));
+  TlsConn = (TLS_CONNECTION *)OPENSSL_zalloc (sizeof (TLS_CONNECTION));
   if (TlsConn == NULL) {
     return NULL;
   }
 
-  TlsConn->Ssl = NULL;
-
   //
   // Create a new SSL Object
   //
@@ -232,9 +850,31 @@ TlsNew (
   ASSERT (TlsConn->Ssl != NULL && TlsConn->InBio != NULL && TlsConn->OutBio != NULL);
 
   //
-  // Connects the InBio and OutBio for the read and write operations.
+  // Connects the InBio and OutBio for the read and write operations, through
+  // a pass-through BIO that also serves the caller-owned windows of
+  // TlsReadDirect() and TlsWriteDirect(). The TLS object keeps ownership of
+  // InBio and OutBio.
+  //
+  Method = TlsGetDirectBioMethod ();
+  if (Method == NULL) {
+    TlsFree ((VOID *)TlsConn);
+    return NULL;
+  }
+
+  DirectBio = BIO_new (Method);
+  if (DirectBio == NULL) {
+    TlsFree ((VOID *)TlsConn);
+    return NULL;
+  }
+
+  BIO_set_data (DirectBio, TlsConn);
+  BIO_set_init (DirectBio, 1);
+  SSL_set_bio (TlsConn->Ssl, DirectBio, DirectBio);
+
+  //
+  // Let OpenSSL callbacks find the TLS object from the SSL object.
   //
-  SSL_set_bio (TlsConn->Ssl, TlsConn->InBio, TlsConn->OutBio);
+  SSL_set_app_data (TlsConn->Ssl, TlsConn);
 
   //
   // Create new X509 store if needed
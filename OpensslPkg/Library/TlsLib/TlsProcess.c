@@ -10,8 +10,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "InternalTlsLib.h"
 
-#define MAX_BUFFER_SIZE  32768
-
 /**
   Checks if the TLS handshake was done.
 
@@ -105,6 +103,7 @@ TlsDoHandshake (
     PendingBufferSize = (UINTN)BIO_ctrl_pending (TlsConn->OutBio);
     if (PendingBufferSize == 0) {
       SSL_set_connect_state (TlsConn->Ssl);
+      TlsResumeCachedSession (TlsConn->Ssl);
       Ret               = SSL_do_handshake (TlsConn->Ssl);
       PendingBufferSize = (UINTN)BIO_ctrl_pending (TlsConn->OutBio);
     }
@@ -209,12 +208,11 @@ TlsHandleAlert (
 {
   TLS_CONNECTION  *TlsConn;
   UINTN           PendingBufferSize;
-  UINT8           *TempBuffer;
   INTN            Ret;
+  UINT8           ScratchBuffer[TLS_SCRATCH_BUFFER_SIZE];
 
   TlsConn           = (TLS_CONNECTION *)Tls;
   PendingBufferSize = 0;
-  TempBuffer        = NULL;
   Ret               = 0;
 
   if ((TlsConn == NULL) || \
@@ -234,15 +232,18 @@ TlsHandleAlert (
       return EFI_ABORTED;
     }
 
-    TempBuffer = (UINT8 *)OPENSSL_malloc (MAX_BUFFER_SIZE);
-
     //
     // ssl3_send_alert() will be called in ssl3_read_bytes() function.
-    // TempBuffer is invalid since it's a Alert message, so just ignore it.
+    // The scratch buffer is invalid since it's a Alert message, so just ignore it.
+    // Plaintext of a record read here is discarded in full, as a piece left
+    // in the TLS connection would be returned by the next TlsRead(), and
+    // wiped from the stack afterwards.
     //
-    SSL_read (TlsConn->Ssl, TempBuffer, MAX_BUFFER_SIZE);
+    do {
+      Ret = SSL_read (TlsConn->Ssl, ScratchBuffer, sizeof (ScratchBuffer));
+    } while ((Ret > 0) && (SSL_pending (TlsConn->Ssl) > 0));
 
-    OPENSSL_free (TempBuffer);
+    ZeroMem (ScratchBuffer, sizeof (ScratchBuffer));
 
     PendingBufferSize = (UINTN)BIO_ctrl_pending (TlsConn->OutBio);
   }
@@ -264,6 +265,9 @@ TlsHandleAlert (
 /**
   Build the CloseNotify packet.
 
+  Once the close_notify alert is sent, the session of the connection becomes
+  available for resumption by later connections of the same TLS context.
+
   @param[in]       Tls            Pointer to the TLS object for state checking.
   @param[in, out]  Buffer         Pointer to the buffer to hold the built packet.
   @param[in, out]  BufferSize     Pointer to the buffer size in bytes. On input, it is
@@ -310,6 +314,10 @@ TlsCloseNotify (
     PendingBufferSize = (UINTN)BIO_ctrl_pending (TlsConn->OutBio);
   }
 
+  if ((SSL_get_shutdown (TlsConn->Ssl) & SSL_SENT_SHUTDOWN) != 0) {
+    TlsCachePendingSession (TlsConn);
+  }
+
   if (PendingBufferSize > *BufferSize) {
     *BufferSize = PendingBufferSize;
     return EFI_BUFFER_TOO_SMALL;
@@ -466,12 +474,248 @@ TlsWrite (
   return SSL_write (TlsConn->Ssl, Buffer, (UINT32)BufferSize);
 }
 
+/**
+  Returns the maximum plaintext length of the records sent on the specified
+  TLS connection.
+
+  @param[in]  TlsConn    Pointer to the TLS connection.
+
+  @return  The maximum plaintext length of a record in bytes.
+
+**/
+STATIC
+UINTN
+TlsGetMaxSendFragment (
+  IN     TLS_CONNECTION  *TlsConn
+  )
+{
+  SSL_SESSION  *Session;
+  UINT8        Mode;
+
+  //
+  // A negotiated maximum_fragment_length takes precedence, as in OpenSSL.
+  //
+  Session = SSL_get_session (TlsConn->Ssl);
+  if (Session != NULL) {
+    Mode = SSL_SESSION_get_max_fragment_length (Session);
+    if ((Mode >= TLSEXT_max_fragment_length_512) && (Mode <= TLSEXT_max_fragment_length_4096)) {
+      return (UINTN)512 << (Mode - TLSEXT_max_fragment_length_512);
+    }
+  }
+
+  if (TlsConn->MaxSendFragment != 0) {
+    return TlsConn->MaxSendFragment;
+  }
+
+  return SSL3_RT_MAX_PLAIN_LENGTH;
+}
+
+/**
+  Decrypts TLS records directly from a caller-owned receive buffer.
+
+  This function feeds the TLS records in RecordIn to the TLS connection
+  without staging them in the connection's memory BIO, and places the
+  application data they carry in Buffer. Records may be split arbitrarily
+  across calls; a partial record is kept by the TLS connection until the
+  rest arrives. Bytes queued earlier with TlsCtrlTrafficIn() are processed
+  first.
+
+  @param[in]      Tls             Pointer to the TLS connection.
+  @param[in]      RecordIn        Pointer to the received TLS records.
+                                  Optional if RecordInSize is 0.
+  @param[in,out]  RecordInSize    On input, the size of RecordIn in bytes. On
+                                  output, the number of bytes consumed. Bytes
+                                  left over when Buffer fills up must be
+                                  passed again on the next call.
+  @param[out]     Buffer          Pointer to the buffer receiving the
+                                  application data.
+  @param[in,out]  BufferSize      On input, the size of Buffer in bytes. On
+                                  output, the number of bytes of application
+                                  data placed in Buffer.
+
+  @retval  EFI_SUCCESS            The records were processed. BufferSize may
+                                  be 0 if no complete record was received.
+  @retval  EFI_INVALID_PARAMETER  One or more of the parameters is invalid.
+  @retval  EFI_END_OF_FILE        The peer closed the connection with a
+                                  close_notify alert and no application data
+                                  was returned.
+  @retval  EFI_ABORTED            A TLS error occurred.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsReadDirect (
+  IN     VOID         *Tls,
+  IN     CONST UINT8  *RecordIn  OPTIONAL,
+  IN OUT UINTN        *RecordInSize,
+  OUT    UINT8        *Buffer,
+  IN OUT UINTN        *BufferSize
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  UINTN           Produced;
+  size_t          ReadBytes;
+  INT32           Error;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (RecordInSize == NULL) ||
+      ((RecordIn == NULL) && (*RecordInSize != 0)) || (Buffer == NULL) || (BufferSize == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  TlsConn->DirectIn     = RecordIn;
+  TlsConn->DirectInSize = *RecordInSize;
+
+  //
+  // SSL_get_error() only reports the result of SSL_read_ex() correctly when
+  // the error queue was empty beforehand.
+  //
+  ERR_clear_error ();
+
+  Produced = 0;
+  Error    = SSL_ERROR_NONE;
+  while (Produced < *BufferSize) {
+    if (!SSL_read_ex (TlsConn->Ssl, Buffer + Produced, *BufferSize - Produced, &ReadBytes)) {
+      Error = SSL_get_error (TlsConn->Ssl, 0);
+      break;
+    }
+
+    Produced += ReadBytes;
+  }
+
+  *RecordInSize        -= TlsConn->DirectInSize;
+  *BufferSize           = Produced;
+  TlsConn->DirectIn     = NULL;
+  TlsConn->DirectInSize = 0;
+
+  switch (Error) {
+    case SSL_ERROR_NONE:
+    case SSL_ERROR_WANT_READ:
+      return EFI_SUCCESS;
+    case SSL_ERROR_ZERO_RETURN:
+      return (Produced > 0) ? EFI_SUCCESS : EFI_END_OF_FILE;
+    default:
+      return EFI_ABORTED;
+  }
+}
+
+/**
+  Encrypts application data directly into a caller-owned transmit buffer.
+
+  This function seals the application data in Buffer into TLS records
+  written straight to RecordOut, without staging them in the connection's
+  memory BIO. Only as much data as is guaranteed to fit in RecordOut is
+  consumed. Records queued by earlier operations (e.g. a TLS 1.3 KeyUpdate)
+  are placed in RecordOut first; if they leave no room for a new record, no
+  data is consumed and the caller sends RecordOut before calling again.
+
+  @param[in]      Tls             Pointer to the TLS connection.
+  @param[in]      Buffer          Pointer to the application data.
+                                  Optional if BufferSize is 0.
+  @param[in,out]  BufferSize      On input, the size of Buffer in bytes. On
+                                  output, the number of bytes consumed.
+  @param[out]     RecordOut       Pointer to the buffer receiving the TLS
+                                  records.
+  @param[in,out]  RecordOutSize   On input, the size of RecordOut in bytes. On
+                                  output, the number of bytes of TLS records
+                                  placed in RecordOut.
+
+  @retval  EFI_SUCCESS            The data was processed. RecordOutSize
+                                  bytes of TLS records must be sent even if
+                                  not all data was consumed.
+  @retval  EFI_INVALID_PARAMETER  One or more of the parameters is invalid.
+  @retval  EFI_BUFFER_TOO_SMALL   RecordOut is too small to hold a record. No
+                                  data was consumed and no TLS records were
+                                  placed in RecordOut.
+  @retval  EFI_ABORTED            A TLS error occurred.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsWriteDirect (
+  IN     VOID         *Tls,
+  IN     CONST UINT8  *Buffer  OPTIONAL,
+  IN OUT UINTN        *BufferSize,
+  OUT    UINT8        *RecordOut,
+  IN OUT UINTN        *RecordOutSize
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  EFI_STATUS      Status;
+  UINTN           Consumed;
+  UINTN           Chunk;
+  UINTN           MaxFragment;
+  size_t          Written;
+  INT32           Ret;
+
+  TlsConn = (TLS_CONNECTION *)Tls;
+  if ((TlsConn == NULL) || (TlsConn->Ssl == NULL) || (BufferSize == NULL) ||
+      ((Buffer == NULL) && (*BufferSize != 0)) || (RecordOut == NULL) || (RecordOutSize == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Drain the records queued earlier so that they go out first.
+  //
+  Ret = 0;
+  if (BIO_ctrl_pending (TlsConn->OutBio) > 0) {
+    Ret = BIO_read (TlsConn->OutBio, RecordOut, (INT32)MIN (*RecordOutSize, INT_MAX));
+    if (Ret < 0) {
+      Ret = 0;
+    }
+  }
+
+  TlsConn->DirectOut     = RecordOut + Ret;
+  TlsConn->DirectOutSize = *RecordOutSize - Ret;
+
+  //
+  // Seal one record per SSL_write_ex() call, with only as much data as fits
+  // in the rest of the window after the worst-case record expansion.
+  //
+  Status      = EFI_SUCCESS;
+  Consumed    = 0;
+  MaxFragment = TlsGetMaxSendFragment (TlsConn);
+  while ((Consumed < *BufferSize) && (BIO_ctrl_pending (TlsConn->OutBio) == 0) &&
+         (TlsConn->DirectOutSize > SSL3_RT_HEADER_LENGTH + SSL3_RT_MAX_ENCRYPTED_OVERHEAD))
+  {
+    Chunk = MIN (*BufferSize - Consumed, MaxFragment);
+    Chunk = MIN (Chunk, TlsConn->DirectOutSize - (SSL3_RT_HEADER_LENGTH + SSL3_RT_MAX_ENCRYPTED_OVERHEAD));
+    if (!SSL_write_ex (TlsConn->Ssl, Buffer + Consumed, Chunk, &Written)) {
+      Status = EFI_ABORTED;
+      break;
+    }
+
+    Consumed += Written;
+  }
+
+  *RecordOutSize        -= TlsConn->DirectOutSize;
+  TlsConn->DirectOut     = NULL;
+  TlsConn->DirectOutSize = 0;
+
+  //
+  // Records placed in RecordOut must reach the caller, so running out of room
+  // is only reported when nothing at all was done.
+  //
+  if (!EFI_ERROR (Status) && (Consumed == 0) && (*BufferSize > 0) && (*RecordOutSize == 0)) {
+    Status = EFI_BUFFER_TOO_SMALL;
+  }
+
+  *BufferSize = Consumed;
+  return Status;
+}
+
 /**
   Shutdown a TLS connection.
 
   Shutdown the TLS connection without releasing the resources, meaning a new
   connection can be started without calling TlsNew() and without setting
-  certificates etc.
+  certificates etc. The session of the connection becomes available for
+  resumption by later connections of the same TLS context only if the peer's
+  close_notify was received before this call, or TlsCloseNotify() sent one. A
+  connection torn down without a close_notify, e.g. after a truncation, or
+  freed with TlsFree() does not share its session.
 
   @param[in]       Tls            Pointer to the TLS object to shutdown.
 
@@ -493,7 +737,18 @@ TlsShutdown (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // Only a connection closed by the peer's close_notify, and not one that was
+  // truncated or failed, makes its session available for resumption. This is
+  // checked first, because a quiet shutdown marks both directions as shut
+  // down whatever happened on the wire.
+  //
+  if ((SSL_get_shutdown (TlsConn->Ssl) & SSL_RECEIVED_SHUTDOWN) != 0) {
+    TlsCachePendingSession (TlsConn);
+  }
+
   SSL_set_quiet_shutdown (TlsConn->Ssl, 1);
   SSL_shutdown (TlsConn->Ssl);
+
   return SSL_clear (TlsConn->Ssl) == 1 ? EFI_SUCCESS : EFI_PROTOCOL_ERROR;
 }
@@ -0,0 +1,662 @@
+/** @file
+  Host-based benchmark for TlsLib handshakes and record I/O.
+
+  Pairs a TlsLib client with an OpenSSL server in the same process. The two
+  ends exchange TLS records through memory buffers, so no network is needed
+  and the numbers can be repeated on any build host. The benchmark reports:
+
+  - client time spent in TlsDoHandshake() for full and resumed handshakes;
+  - OpenSSL allocations per client connection, from TlsNew() to TlsFree();
+  - client record throughput for several record sizes and cipher suites,
+    both through the memory BIO path (TlsWrite/TlsCtrlTrafficOut and
+    TlsCtrlTrafficIn/TlsRead) and through TlsWriteDirect/TlsReadDirect.
+
+  Only the time spent in TlsLib calls is counted. The server side runs
+  between those calls and is not part of the numbers.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Protocol/Tls.h>
+  #include <Library/TlsLib.h>
+
+  //
+  // The server end uses the OpenSSL interface from OpensslLib directly. Its
+  // objects are treated as opaque pointers.
+  //
+  typedef struct TLS_BENCH_OPAQUE  TLS_BENCH_OPAQUE;
+
+  #define TLS_BENCH_CTRL_SET_MIN_PROTO_VERSION  123
+  #define TLS_BENCH_CTRL_SET_MAX_PROTO_VERSION  124
+  #define TLS_BENCH_PKEY_EC                     408
+
+  const TLS_BENCH_OPAQUE *
+  TLS_server_method (
+    void
+    );
+
+  TLS_BENCH_OPAQUE *
+  SSL_CTX_new (
+    const TLS_BENCH_OPAQUE  *Method
+    );
+
+  void
+  SSL_CTX_free (
+    TLS_BENCH_OPAQUE  *Ctx
+    );
+
+  long
+  SSL_CTX_ctrl (
+    TLS_BENCH_OPAQUE  *Ctx,
+    int               Cmd,
+    long              Larg,
+    void              *Parg
+    );
+
+  int
+  SSL_CTX_use_certificate_ASN1 (
+    TLS_BENCH_OPAQUE     *Ctx,
+    int                  Length,
+    const unsigned char  *Data
+    );
+
+  int
+  SSL_CTX_use_PrivateKey_ASN1 (
+    int                  Type,
+    TLS_BENCH_OPAQUE     *Ctx,
+    const unsigned char  *Data,
+    long                 Length
+    );
+
+  TLS_BENCH_OPAQUE *
+  SSL_new (
+    TLS_BENCH_OPAQUE  *Ctx
+    );
+
+  void
+  SSL_free (
+    TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  void
+  SSL_set_bio (
+    TLS_BENCH_OPAQUE  *Ssl,
+    TLS_BENCH_OPAQUE  *ReadBio,
+    TLS_BENCH_OPAQUE  *WriteBio
+    );
+
+  void
+  SSL_set_accept_state (
+    TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_do_handshake (
+    TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_is_init_finished (
+    const TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_session_reused (
+    const TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_read (
+    TLS_BENCH_OPAQUE  *Ssl,
+    void              *Buffer,
+    int               Length
+    );
+
+  int
+  SSL_write (
+    TLS_BENCH_OPAQUE  *Ssl,
+    const void        *Buffer,
+    int               Length
+    );
+
+  void
+  SSL_set_quiet_shutdown (
+    TLS_BENCH_OPAQUE  *Ssl,
+    int               Mode
+    );
+
+  int
+  SSL_shutdown (
+    TLS_BENCH_OPAQUE  *Ssl
+    );
+
+  const TLS_BENCH_OPAQUE *
+  BIO_s_mem (
+    void
+    );
+
+  TLS_BENCH_OPAQUE *
+  BIO_new (
+    const TLS_BENCH_OPAQUE  *Method
+    );
+
+  int
+  BIO_read (
+    TLS_BENCH_OPAQUE  *Bio,
+    void              *Buffer,
+    int               Length
+    );
+
+  int
+  BIO_write (
+    TLS_BENCH_OPAQUE  *Bio,
+    const void        *Buffer,
+    int               Length
+    );
+
+  size_t
+  BIO_ctrl_pending (
+    TLS_BENCH_OPAQUE  *Bio
+    );
+
+  int
+  CRYPTO_set_mem_functions (
+    void *( *MallocFn )(size_t, const char *, int),
+    void *( *ReallocFn )(void *, size_t, const char *, int),
+    void ( *FreeFn )(void *, const char *, int)
+    );
+}
+
+#define TLS_BENCH_HOST_NAME       "bench.example"
+#define TLS_BENCH_HANDSHAKES      200
+#define TLS_BENCH_MIN_SECONDS     0.25
+#define TLS_BENCH_RECORD_BUFFER   (64 * 1024)
+
+//
+// Self-signed ECDSA P-256 certificate for TLS_BENCH_HOST_NAME, and its key.
+//
+STATIC CONST UINT8  mServerCert[] = {
+  0x30, 0x82, 0x01, 0x86, 0x30, 0x82, 0x01, 0x2B, 0xA0, 0x03, 0x02, 0x01,
+  0x02, 0x02, 0x14, 0x62, 0xC2, 0x45, 0xF3, 0x48, 0x5D, 0x77, 0xCF, 0x6D,
+  0xAA, 0x21, 0x1F, 0x27, 0xC9, 0xB3, 0x39, 0x01, 0x47, 0x9E, 0x3A, 0x30,
+  0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+  0x18, 0x31, 0x16, 0x30, 0x14, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x0D,
+  0x62, 0x65, 0x6E, 0x63, 0x68, 0x2E, 0x65, 0x78, 0x61, 0x6D, 0x70, 0x6C,
+  0x65, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x36, 0x31, 0x30, 0x31, 0x36, 0x32,
+  0x30, 0x35, 0x33, 0x34, 0x35, 0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30,
+  0x31, 0x33, 0x32, 0x30, 0x35, 0x33, 0x34, 0x35, 0x5A, 0x30, 0x18, 0x31,
+  0x16, 0x30, 0x14, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x0D, 0x62, 0x65,
+  0x6E, 0x63, 0x68, 0x2E, 0x65, 0x78, 0x61, 0x6D, 0x70, 0x6C, 0x65, 0x30,
+  0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+  0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42,
+  0x00, 0x04, 0xE5, 0x72, 0x83, 0x22, 0x3B, 0x03, 0xB5, 0x9F, 0x62, 0x3C,
+  0x09, 0xF9, 0xC4, 0x2A, 0xE8, 0xE1, 0xDD, 0x83, 0x74, 0xC0, 0xD9, 0x28,
+  0x44, 0xDB, 0x61, 0x62, 0xCF, 0x50, 0xC9, 0xC6, 0x0B, 0xE9, 0x39, 0x2E,
+  0x1C, 0x10, 0x90, 0xD6, 0x1E, 0x83, 0xFB, 0x5F, 0x68, 0xEF, 0x45, 0x7B,
+  0xAA, 0x31, 0x66, 0x44, 0xAF, 0x76, 0xB8, 0x51, 0xF5, 0xF3, 0x9D, 0x85,
+  0x54, 0x15, 0x5E, 0x43, 0x85, 0x36, 0xA3, 0x53, 0x30, 0x51, 0x30, 0x1D,
+  0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x0E, 0x4A, 0x66,
+  0x5D, 0xFB, 0x38, 0x5F, 0xC6, 0x6E, 0xCA, 0x4F, 0x3B, 0x65, 0xBF, 0x26,
+  0x55, 0xB6, 0x49, 0xC1, 0x66, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23,
+  0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0x0E, 0x4A, 0x66, 0x5D, 0xFB, 0x38,
+  0x5F, 0xC6, 0x6E, 0xCA, 0x4F, 0x3B, 0x65, 0xBF, 0x26, 0x55, 0xB6, 0x49,
+  0xC1, 0x66, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF,
+  0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0A, 0x06, 0x08, 0x2A,
+  0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x49, 0x00, 0x30, 0x46,
+  0x02, 0x21, 0x00, 0xC3, 0xAE, 0xB3, 0xA4, 0xDB, 0x27, 0xC9, 0xB9, 0xF2,
+  0xC4, 0xEF, 0x1F, 0x6F, 0xB5, 0xB6, 0xCB, 0xB5, 0xD7, 0xF0, 0x34, 0xF2,
+  0x0D, 0xB6, 0xFF, 0x88, 0x30, 0xAE, 0x92, 0x45, 0x36, 0x82, 0xB1, 0x02,
+  0x21, 0x00, 0xF4, 0x5A, 0x6D, 0x50, 0x6C, 0xC9, 0x8A, 0x4F, 0x5E, 0x68,
+  0xB4, 0x1F, 0x6C, 0xA2, 0x2D, 0xD9, 0xEE, 0x09, 0x01, 0xEA, 0x6F, 0x65,
+  0x53, 0xB3, 0xAD, 0xE0, 0xF7, 0x5A, 0xDB, 0x89, 0x47, 0x5D,
+};
+
+STATIC CONST UINT8  mServerKey[] = {
+  0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0xB4, 0xCA, 0x61, 0x10, 0xBE,
+  0xFA, 0x46, 0xDE, 0x67, 0x86, 0xC7, 0xF3, 0x5A, 0x29, 0x3C, 0x30, 0xB6,
+  0x7F, 0x0A, 0xA3, 0xF7, 0x23, 0x8D, 0xEE, 0xC2, 0xA6, 0x68, 0x56, 0xAC,
+  0x96, 0xDD, 0xA4, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0xE5, 0x72, 0x83,
+  0x22, 0x3B, 0x03, 0xB5, 0x9F, 0x62, 0x3C, 0x09, 0xF9, 0xC4, 0x2A, 0xE8,
+  0xE1, 0xDD, 0x83, 0x74, 0xC0, 0xD9, 0x28, 0x44, 0xDB, 0x61, 0x62, 0xCF,
+  0x50, 0xC9, 0xC6, 0x0B, 0xE9, 0x39, 0x2E, 0x1C, 0x10, 0x90, 0xD6, 0x1E,
+  0x83, 0xFB, 0x5F, 0x68, 0xEF, 0x45, 0x7B, 0xAA, 0x31, 0x66, 0x44, 0xAF,
+  0x76, 0xB8, 0x51, 0xF5, 0xF3, 0x9D, 0x85, 0x54, 0x15, 0x5E, 0x43, 0x85,
+  0x36,
+};
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINT8          MinorVersion;
+  UINT16         CipherId;
+} TLS_BENCH_SUITE;
+
+STATIC CONST TLS_BENCH_SUITE  mSuites[] = {
+  { "TLS1.2 ECDHE-ECDSA-AES128-GCM-SHA256", 3, 0xC02B },
+  { "TLS1.2 ECDHE-ECDSA-AES128-SHA256",     3, 0xC023 },
+  { "TLS1.3 TLS_AES_128_GCM_SHA256",        4, 0x1301 },
+};
+
+//
+// OpenSSL allocations are counted while mCounting is set, i.e. while the
+// client is running.
+//
+STATIC BOOLEAN  mCounting;
+STATIC UINT64   mAllocations;
+STATIC BOOLEAN  mAllocationsCounted;
+
+STATIC void *
+CountingMalloc (
+  size_t      Size,
+  const char  *File,
+  int         Line
+  )
+{
+  if (mCounting) {
+    mAllocations++;
+  }
+
+  return malloc (Size);
+}
+
+STATIC void *
+CountingRealloc (
+  void        *Ptr,
+  size_t      Size,
+  const char  *File,
+  int         Line
+  )
+{
+  if (mCounting) {
+    mAllocations++;
+  }
+
+  return realloc (Ptr, Size);
+}
+
+STATIC void
+CountingFree (
+  void        *Ptr,
+  const char  *File,
+  int         Line
+  )
+{
+  free (Ptr);
+}
+
+class TlsBenchmark : public ::testing::Test {
+protected:
+  TLS_BENCH_OPAQUE *ServerCtx;
+  TLS_BENCH_OPAQUE *Server;
+  TLS_BENCH_OPAQUE *ServerIn;
+  TLS_BENCH_OPAQUE *ServerOut;
+  VOID *Client;
+  double ClientSeconds;
+  std::vector<UINT8> Records;
+  std::vector<UINT8> Data;
+
+  void
+  SetUp (
+    ) override
+  {
+    ASSERT_TRUE (TlsInitialize ());
+
+    ServerCtx = SSL_CTX_new (TLS_server_method ());
+    ASSERT_NE (ServerCtx, nullptr);
+    SSL_CTX_ctrl (ServerCtx, TLS_BENCH_CTRL_SET_MIN_PROTO_VERSION, 0x0303, NULL);
+    SSL_CTX_ctrl (ServerCtx, TLS_BENCH_CTRL_SET_MAX_PROTO_VERSION, 0x0304, NULL);
+    ASSERT_EQ (SSL_CTX_use_certificate_ASN1 (ServerCtx, sizeof (mServerCert), mServerCert), 1);
+    ASSERT_EQ (SSL_CTX_use_PrivateKey_ASN1 (TLS_BENCH_PKEY_EC, ServerCtx, mServerKey, sizeof (mServerKey)), 1);
+
+    Server = NULL;
+    Client = NULL;
+    Records.resize (TLS_BENCH_RECORD_BUFFER);
+    Data.resize (TLS_BENCH_RECORD_BUFFER);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    Disconnect (FALSE);
+    SSL_CTX_free (ServerCtx);
+  }
+
+  //
+  // Run a TlsLib call, adding its time to ClientSeconds and counting the
+  // OpenSSL allocations it makes.
+  //
+  template<typename Fn>
+  auto
+  ClientCall (
+    Fn  Operation
+    ) -> decltype (Operation ())
+  {
+    auto  Start = std::chrono::steady_clock::now ();
+
+    mCounting = TRUE;
+    auto  Result = Operation ();
+
+    mCounting      = FALSE;
+    ClientSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+    return Result;
+  }
+
+  //
+  // Create a client connection on TlsCtx and a fresh server connection.
+  //
+  void
+  Connect (
+    VOID                   *TlsCtx,
+    CONST TLS_BENCH_SUITE  *Suite
+    )
+  {
+    UINT16  CipherId;
+
+    Server    = SSL_new (ServerCtx);
+    ServerIn  = BIO_new (BIO_s_mem ());
+    ServerOut = BIO_new (BIO_s_mem ());
+    SSL_set_bio (Server, ServerIn, ServerOut);
+    SSL_set_accept_state (Server);
+
+    CipherId = Suite->CipherId;
+    Client   = ClientCall (
+                 [&]() {
+      VOID  *Tls = TlsNew (TlsCtx);
+
+      if (Tls != NULL) {
+        TlsSetConnectionEnd (Tls, FALSE);
+        TlsSetCipherList (Tls, &CipherId, 1);
+        TlsSetVerify (Tls, EFI_TLS_VERIFY_PEER);
+        TlsSetCaCertificate (Tls, (VOID *)mServerCert, sizeof (mServerCert));
+        TlsSetVerifyHost (Tls, 0, (CHAR8 *)TLS_BENCH_HOST_NAME);
+      }
+
+      return Tls;
+    }
+                 );
+    ASSERT_NE (Client, nullptr);
+  }
+
+  //
+  // Free both ends. A client that is shut down after the server's close_notify
+  // leaves its session for the next connection of the same TLS context to
+  // resume.
+  //
+  void
+  Disconnect (
+    BOOLEAN  Shutdown
+    )
+  {
+    if (Client != NULL) {
+      if (Shutdown && (Server != NULL)) {
+        SSL_shutdown (Server);
+        ServerToClient ();
+        ClientCall ([&]() { return TlsRead (Client, Data.data (), Data.size ()); });
+      }
+
+      ClientCall (
+        [&]() {
+        if (Shutdown) {
+          TlsShutdown (Client);
+        }
+
+        TlsFree (Client);
+        return 0;
+      }
+        );
+      Client = NULL;
+    }
+
+    if (Server != NULL) {
+      SSL_set_quiet_shutdown (Server, 1);
+      SSL_shutdown (Server);
+      SSL_free (Server);
+      Server = NULL;
+    }
+  }
+
+  //
+  // Move the pending server records to the client memory BIO.
+  //
+  VOID
+  ServerToClient (
+    VOID
+    )
+  {
+    int  Length;
+
+    while ((Length = BIO_read (ServerOut, Records.data (), (int)Records.size ())) > 0) {
+      ClientCall ([&]() { return TlsCtrlTrafficIn (Client, Records.data (), (UINTN)Length); });
+    }
+  }
+
+  BOOLEAN
+  Handshake (
+    VOID
+    )
+  {
+    EFI_STATUS  Status;
+    UINTN       Size;
+    int         Length;
+
+    Size   = Records.size ();
+    Status = ClientCall ([&]() { return TlsDoHandshake (Client, NULL, 0, Records.data (), &Size); });
+    for (UINTN Round = 0; !EFI_ERROR (Status) && Round < 16; Round++) {
+      if (Size > 0) {
+        BIO_write (ServerIn, Records.data (), (int)Size);
+      }
+
+      SSL_do_handshake (Server);
+      Length = BIO_read (ServerOut, Records.data (), (int)Records.size ());
+      if (Length <= 0) {
+        if (!ClientCall ([&]() { return TlsInHandshake (Client); }) && SSL_is_init_finished (Server)) {
+          return TRUE;
+        }
+
+        return FALSE;
+      }
+
+      Size   = Records.size ();
+      Status = ClientCall ([&]() { return TlsDoHandshake (Client, Records.data (), (UINTN)Length, Records.data (), &Size); });
+    }
+
+    return FALSE;
+  }
+
+  //
+  // Consume the post-handshake messages (TLS 1.3 session tickets) so that
+  // the session is complete before the connection is shut down.
+  //
+  VOID
+  ReadPostHandshake (
+    VOID
+    )
+  {
+    ServerToClient ();
+    ClientCall ([&]() { return TlsRead (Client, Data.data (), Data.size ()); });
+  }
+
+  static double
+  MegabytesPerSecond (
+    UINT64  Bytes,
+    double  Seconds
+    )
+  {
+    return (double)Bytes / Seconds / (1024.0 * 1024.0);
+  }
+};
+
+TEST_F (TlsBenchmark, Handshake) {
+  printf ("\nTLS handshake, client side (%u connections per row)\n", TLS_BENCH_HANDSHAKES);
+  printf ("%-38s %12s %12s %12s %12s\n", "Suite", "Full us", "Resumed us", "Full alloc", "Resumed alloc");
+
+  for (CONST TLS_BENCH_SUITE &Suite : mSuites) {
+    VOID    *FullCtx;
+    VOID    *ResumeCtx;
+    double  Seconds[2];
+    UINT64  Allocations[2];
+    UINTN   Reused[2];
+
+    FullCtx   = TlsCtxNew (3, Suite.MinorVersion);
+    ResumeCtx = TlsCtxNew (3, Suite.MinorVersion);
+    ASSERT_NE (FullCtx, nullptr);
+    ASSERT_NE (ResumeCtx, nullptr);
+
+    //
+    // Prime the resumption context with one session.
+    //
+    Connect (ResumeCtx, &Suite);
+    ASSERT_TRUE (Handshake ()) << Suite.Name;
+    ReadPostHandshake ();
+    Disconnect (TRUE);
+
+    for (UINTN Resume = 0; Resume < 2; Resume++) {
+      Seconds[Resume] = 0;
+      Reused[Resume]  = 0;
+      mAllocations    = 0;
+      for (UINTN Index = 0; Index < TLS_BENCH_HANDSHAKES; Index++) {
+        Connect ((Resume != 0) ? ResumeCtx : FullCtx, &Suite);
+        ClientSeconds = 0;
+        ASSERT_TRUE (Handshake ()) << Suite.Name;
+        Seconds[Resume] += ClientSeconds;
+        ReadPostHandshake ();
+        Reused[Resume] += SSL_session_reused (Server);
+        Disconnect (Resume != 0);
+      }
+
+      Allocations[Resume] = mAllocations;
+    }
+
+    EXPECT_EQ (Reused[0], 0u) << Suite.Name;
+    EXPECT_EQ (Reused[1], (UINTN)TLS_BENCH_HANDSHAKES) << Suite.Name;
+
+    printf (
+      "%-38s %12.1f %12.1f %12s %12s\n",
+      Suite.Name,
+      Seconds[0] * 1e6 / TLS_BENCH_HANDSHAKES,
+      Seconds[1] * 1e6 / TLS_BENCH_HANDSHAKES,
+      mAllocationsCounted ? std::to_string (Allocations[0] / TLS_BENCH_HANDSHAKES).c_str () : "n/a",
+      mAllocationsCounted ? std::to_string (Allocations[1] / TLS_BENCH_HANDSHAKES).c_str () : "n/a"
+      );
+
+    TlsCtxFree (FullCtx);
+    TlsCtxFree (ResumeCtx);
+  }
+}
+
+TEST_F (TlsBenchmark, Throughput) {
+  static const UINTN  Sizes[] = { 512, 4096, 16384 };
+
+  printf ("\nTLS record throughput, client side (MB/s)\n");
+  printf ("%-38s %6s %10s %10s %10s %10s\n", "Suite", "Bytes", "Write", "Read", "WriteDir", "ReadDir");
+
+  for (CONST TLS_BENCH_SUITE &Suite : mSuites) {
+    VOID  *TlsCtx;
+
+    TlsCtx = TlsCtxNew (3, Suite.MinorVersion);
+    ASSERT_NE (TlsCtx, nullptr);
+    Connect (TlsCtx, &Suite);
+    ASSERT_TRUE (Handshake ()) << Suite.Name;
+    ReadPostHandshake ();
+
+    for (UINTN Size : Sizes) {
+      std::vector<UINT8>  Plain (Size, 0x5A);
+      double              Result[4];
+
+      for (UINTN Mode = 0; Mode < 4; Mode++) {
+        UINT64  Bytes = 0;
+
+        ClientSeconds = 0;
+        do {
+          if ((Mode % 2) == 0) {
+            //
+            // Client to server.
+            //
+            UINTN  PlainSize  = Size;
+            UINTN  RecordSize = Records.size ();
+            INTN   Length;
+
+            if (Mode == 0) {
+              ASSERT_EQ (ClientCall ([&]() { return TlsWrite (Client, Plain.data (), Size); }), (INTN)Size);
+              Length = ClientCall ([&]() { return TlsCtrlTrafficOut (Client, Records.data (), Records.size ()); });
+            } else {
+              ASSERT_EQ (ClientCall ([&]() { return TlsWriteDirect (Client, Plain.data (), &PlainSize, Records.data (), &RecordSize); }), EFI_SUCCESS);
+              ASSERT_EQ (PlainSize, Size);
+              Length = (INTN)RecordSize;
+            }
+
+            ASSERT_GT (Length, 0);
+            BIO_write (ServerIn, Records.data (), (int)Length);
+            while (SSL_read (Server, Data.data (), (int)Data.size ()) > 0) {
+            }
+          } else {
+            //
+            // Server to client.
+            //
+            UINTN  Received = 0;
+
+            ASSERT_EQ (SSL_write (Server, Plain.data (), (int)Size), (int)Size);
+            if (Mode == 1) {
+              ServerToClient ();
+              while (Received < Size) {
+                INTN  Length = ClientCall ([&]() { return TlsRead (Client, Data.data (), Data.size ()); });
+                ASSERT_GT (Length, 0);
+                Received += (UINTN)Length;
+              }
+            } else {
+              int  Length = BIO_read (ServerOut, Records.data (), (int)Records.size ());
+
+              ASSERT_GT (Length, 0);
+              for (UINTN Offset = 0; Offset < (UINTN)Length;) {
+                UINTN  RecordSize = (UINTN)Length - Offset;
+                UINTN  DataSize   = Data.size ();
+
+                ASSERT_EQ (ClientCall ([&]() { return TlsReadDirect (Client, Records.data () + Offset, &RecordSize, Data.data (), &DataSize); }), EFI_SUCCESS);
+                Offset   += RecordSize;
+                Received += DataSize;
+              }
+            }
+
+            ASSERT_EQ (Received, Size);
+          }
+
+          Bytes += Size;
+        } while (ClientSeconds < TLS_BENCH_MIN_SECONDS);
+
+        Result[Mode] = MegabytesPerSecond (Bytes, ClientSeconds);
+      }
+
+      printf ("%-38s %6u %10.1f %10.1f %10.1f %10.1f\n", Suite.Name, (unsigned)Size, Result[0], Result[1], Result[2], Result[3]);
+    }
+
+    Disconnect (FALSE);
+    TlsCtxFree (TlsCtx);
+  }
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  //
+  // This only succeeds before OpenSSL makes its first allocation.
+  //
+  mAllocationsCounted = (CRYPTO_set_mem_functions (CountingMalloc, CountingRealloc, CountingFree) == 1);
+
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
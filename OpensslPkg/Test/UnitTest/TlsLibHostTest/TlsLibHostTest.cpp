@@ -0,0 +1,1025 @@
+/** @file
+  Host-based unit test for the OpenSSL based TlsLib.
+
+  Pairs a TlsLib client with an OpenSSL server in the same process. The two
+  ends exchange TLS records through memory buffers and each test checks the
+  TlsLib side of the exchange:
+
+  - TlsWriteDirect() hands out records queued before it was called;
+  - TlsShutdown() caches the session only after the server's close_notify;
+  - OCSP stapling accepts good responses, rejects revoked, forged and
+    expired ones, and reuses verified ones from its cache.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Protocol/Tls.h>
+  #include <Library/TlsLib.h>
+
+  //
+  // The server end uses the OpenSSL interface from OpensslLib directly. Its
+  // objects are treated as opaque pointers.
+  //
+  typedef struct TLS_TEST_OPAQUE  TLS_TEST_OPAQUE;
+
+  #define TLS_TEST_CTRL_SET_MIN_PROTO_VERSION  123
+  #define TLS_TEST_CTRL_SET_MAX_PROTO_VERSION  124
+  #define TLS_TEST_PKEY_EC                     408
+
+  const TLS_TEST_OPAQUE *
+  TLS_server_method (
+    void
+    );
+
+  TLS_TEST_OPAQUE *
+  SSL_CTX_new (
+    const TLS_TEST_OPAQUE  *Method
+    );
+
+  void
+  SSL_CTX_free (
+    TLS_TEST_OPAQUE  *Ctx
+    );
+
+  long
+  SSL_CTX_ctrl (
+    TLS_TEST_OPAQUE  *Ctx,
+    int              Cmd,
+    long             Larg,
+    void             *Parg
+    );
+
+  int
+  SSL_CTX_use_certificate_ASN1 (
+    TLS_TEST_OPAQUE      *Ctx,
+    int                  Length,
+    const unsigned char  *Data
+    );
+
+  int
+  SSL_CTX_use_PrivateKey_ASN1 (
+    int                  Type,
+    TLS_TEST_OPAQUE      *Ctx,
+    const unsigned char  *Data,
+    long                 Length
+    );
+
+  TLS_TEST_OPAQUE *
+  SSL_new (
+    TLS_TEST_OPAQUE  *Ctx
+    );
+
+  void
+  SSL_free (
+    TLS_TEST_OPAQUE  *Ssl
+    );
+
+  void
+  SSL_set_bio (
+    TLS_TEST_OPAQUE  *Ssl,
+    TLS_TEST_OPAQUE  *ReadBio,
+    TLS_TEST_OPAQUE  *WriteBio
+    );
+
+  void
+  SSL_set_accept_state (
+    TLS_TEST_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_do_handshake (
+    TLS_TEST_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_is_init_finished (
+    const TLS_TEST_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_session_reused (
+    const TLS_TEST_OPAQUE  *Ssl
+    );
+
+  int
+  SSL_read (
+    TLS_TEST_OPAQUE  *Ssl,
+    void             *Buffer,
+    int              Length
+    );
+
+  int
+  SSL_write (
+    TLS_TEST_OPAQUE  *Ssl,
+    const void       *Buffer,
+    int              Length
+    );
+
+  void
+  SSL_set_quiet_shutdown (
+    TLS_TEST_OPAQUE  *Ssl,
+    int              Mode
+    );
+
+  int
+  SSL_shutdown (
+    TLS_TEST_OPAQUE  *Ssl
+    );
+
+  const TLS_TEST_OPAQUE *
+  BIO_s_mem (
+    void
+    );
+
+  TLS_TEST_OPAQUE *
+  BIO_new (
+    const TLS_TEST_OPAQUE  *Method
+    );
+
+  int
+  BIO_read (
+    TLS_TEST_OPAQUE  *Bio,
+    void             *Buffer,
+    int              Length
+    );
+
+  int
+  BIO_write (
+    TLS_TEST_OPAQUE  *Bio,
+    const void       *Buffer,
+    int              Length
+    );
+
+  size_t
+  BIO_ctrl_pending (
+    TLS_TEST_OPAQUE  *Bio
+    );
+
+  long
+  SSL_CTX_callback_ctrl (
+    TLS_TEST_OPAQUE  *Ctx,
+    int              Cmd,
+    void (           *Callback )(void)
+    );
+
+  long
+  SSL_ctrl (
+    TLS_TEST_OPAQUE  *Ssl,
+    int              Cmd,
+    long             Larg,
+    void             *Parg
+    );
+
+  TLS_TEST_OPAQUE *
+  d2i_X509 (
+    TLS_TEST_OPAQUE      **Cert,
+    const unsigned char  **Data,
+    long                 Length
+    );
+
+  void
+  X509_free (
+    TLS_TEST_OPAQUE  *Cert
+    );
+
+  TLS_TEST_OPAQUE *
+  d2i_AutoPrivateKey (
+    TLS_TEST_OPAQUE      **Key,
+    const unsigned char  **Data,
+    long                 Length
+    );
+
+  void
+  EVP_PKEY_free (
+    TLS_TEST_OPAQUE  *Key
+    );
+
+  const TLS_TEST_OPAQUE *
+  EVP_sha256 (
+    void
+    );
+
+  TLS_TEST_OPAQUE *
+  X509_gmtime_adj (
+    TLS_TEST_OPAQUE  *Time,
+    long             Seconds
+    );
+
+  void
+  ASN1_TIME_free (
+    TLS_TEST_OPAQUE  *Time
+    );
+
+  TLS_TEST_OPAQUE *
+  OCSP_cert_to_id (
+    const TLS_TEST_OPAQUE  *Md,
+    const TLS_TEST_OPAQUE  *Cert,
+    const TLS_TEST_OPAQUE  *Issuer
+    );
+
+  void
+  OCSP_CERTID_free (
+    TLS_TEST_OPAQUE  *CertId
+    );
+
+  TLS_TEST_OPAQUE *
+  OCSP_BASICRESP_new (
+    void
+    );
+
+  void
+  OCSP_BASICRESP_free (
+    TLS_TEST_OPAQUE  *Response
+    );
+
+  TLS_TEST_OPAQUE *
+  OCSP_basic_add1_status (
+    TLS_TEST_OPAQUE  *Response,
+    TLS_TEST_OPAQUE  *CertId,
+    int              Status,
+    int              Reason,
+    TLS_TEST_OPAQUE  *RevocationTime,
+    TLS_TEST_OPAQUE  *ThisUpdate,
+    TLS_TEST_OPAQUE  *NextUpdate
+    );
+
+  int
+  OCSP_basic_sign (
+    TLS_TEST_OPAQUE        *Response,
+    TLS_TEST_OPAQUE        *Signer,
+    TLS_TEST_OPAQUE        *Key,
+    const TLS_TEST_OPAQUE  *Md,
+    TLS_TEST_OPAQUE        *Certs,
+    unsigned long          Flags
+    );
+
+  TLS_TEST_OPAQUE *
+  OCSP_response_create (
+    int              Status,
+    TLS_TEST_OPAQUE  *Response
+    );
+
+  void
+  OCSP_RESPONSE_free (
+    TLS_TEST_OPAQUE  *Response
+    );
+
+  int
+  i2d_OCSP_RESPONSE (
+    const TLS_TEST_OPAQUE  *Response,
+    unsigned char          **Der
+    );
+
+  void *
+  CRYPTO_malloc (
+    size_t      Size,
+    const char  *File,
+    int         Line
+    );
+
+  void
+  CRYPTO_free (
+    void        *Ptr,
+    const char  *File,
+    int         Line
+    );
+}
+
+#define TLS_TEST_CTRL_SET_STATUS_CB         63
+#define TLS_TEST_CTRL_SET_STATUS_OCSP_RESP  71
+#define TLS_TEST_EXT_OK                     0
+#define TLS_TEST_EXT_NOACK                  3
+#define TLS_TEST_OCSP_SUCCESSFUL            0
+#define TLS_TEST_OCSP_GOOD                  0
+#define TLS_TEST_OCSP_REVOKED               1
+#define TLS_TEST_OCSP_UNSPECIFIED           0
+
+#define TLS_TEST_HOST_NAME      "bench.example"
+#define TLS_TEST_RECORD_BUFFER  (64 * 1024)
+
+//
+// Self-signed ECDSA P-256 certificate for TLS_TEST_HOST_NAME, and its key.
+//
+STATIC CONST UINT8  mServerCert[] = {
+  0x30, 0x82, 0x01, 0x86, 0x30, 0x82, 0x01, 0x2B, 0xA0, 0x03, 0x02, 0x01,
+  0x02, 0x02, 0x14, 0x62, 0xC2, 0x45, 0xF3, 0x48, 0x5D, 0x77, 0xCF, 0x6D,
+  0xAA, 0x21, 0x1F, 0x27, 0xC9, 0xB3, 0x39, 0x01, 0x47, 0x9E, 0x3A, 0x30,
+  0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+  0x18, 0x31, 0x16, 0x30, 0x14, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x0D,
+  0x62, 0x65, 0x6E, 0x63, 0x68, 0x2E, 0x65, 0x78, 0x61, 0x6D, 0x70, 0x6C,
+  0x65, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x36, 0x31, 0x30, 0x31, 0x36, 0x32,
+  0x30, 0x35, 0x33, 0x34, 0x35, 0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30,
+  0x31, 0x33, 0x32, 0x30, 0x35, 0x33, 0x34, 0x35, 0x5A, 0x30, 0x18, 0x31,
+  0x16, 0x30, 0x14, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x0D, 0x62, 0x65,
+  0x6E, 0x63, 0x68, 0x2E, 0x65, 0x78, 0x61, 0x6D, 0x70, 0x6C, 0x65, 0x30,
+  0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+  0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42,
+  0x00, 0x04, 0xE5, 0x72, 0x83, 0x22, 0x3B, 0x03, 0xB5, 0x9F, 0x62, 0x3C,
+  0x09, 0xF9, 0xC4, 0x2A, 0xE8, 0xE1, 0xDD, 0x83, 0x74, 0xC0, 0xD9, 0x28,
+  0x44, 0xDB, 0x61, 0x62, 0xCF, 0x50, 0xC9, 0xC6, 0x0B, 0xE9, 0x39, 0x2E,
+  0x1C, 0x10, 0x90, 0xD6, 0x1E, 0x83, 0xFB, 0x5F, 0x68, 0xEF, 0x45, 0x7B,
+  0xAA, 0x31, 0x66, 0x44, 0xAF, 0x76, 0xB8, 0x51, 0xF5, 0xF3, 0x9D, 0x85,
+  0x54, 0x15, 0x5E, 0x43, 0x85, 0x36, 0xA3, 0x53, 0x30, 0x51, 0x30, 0x1D,
+  0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x0E, 0x4A, 0x66,
+  0x5D, 0xFB, 0x38, 0x5F, 0xC6, 0x6E, 0xCA, 0x4F, 0x3B, 0x65, 0xBF, 0x26,
+  0x55, 0xB6, 0x49, 0xC1, 0x66, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23,
+  0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0x0E, 0x4A, 0x66, 0x5D, 0xFB, 0x38,
+  0x5F, 0xC6, 0x6E, 0xCA, 0x4F, 0x3B, 0x65, 0xBF, 0x26, 0x55, 0xB6, 0x49,
+  0xC1, 0x66, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF,
+  0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0A, 0x06, 0x08, 0x2A,
+  0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x49, 0x00, 0x30, 0x46,
+  0x02, 0x21, 0x00, 0xC3, 0xAE, 0xB3, 0xA4, 0xDB, 0x27, 0xC9, 0xB9, 0xF2,
+  0xC4, 0xEF, 0x1F, 0x6F, 0xB5, 0xB6, 0xCB, 0xB5, 0xD7, 0xF0, 0x34, 0xF2,
+  0x0D, 0xB6, 0xFF, 0x88, 0x30, 0xAE, 0x92, 0x45, 0x36, 0x82, 0xB1, 0x02,
+  0x21, 0x00, 0xF4, 0x5A, 0x6D, 0x50, 0x6C, 0xC9, 0x8A, 0x4F, 0x5E, 0x68,
+  0xB4, 0x1F, 0x6C, 0xA2, 0x2D, 0xD9, 0xEE, 0x09, 0x01, 0xEA, 0x6F, 0x65,
+  0x53, 0xB3, 0xAD, 0xE0, 0xF7, 0x5A, 0xDB, 0x89, 0x47, 0x5D,
+};
+
+STATIC CONST UINT8  mServerKey[] = {
+  0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0xB4, 0xCA, 0x61, 0x10, 0xBE,
+  0xFA, 0x46, 0xDE, 0x67, 0x86, 0xC7, 0xF3, 0x5A, 0x29, 0x3C, 0x30, 0xB6,
+  0x7F, 0x0A, 0xA3, 0xF7, 0x23, 0x8D, 0xEE, 0xC2, 0xA6, 0x68, 0x56, 0xAC,
+  0x96, 0xDD, 0xA4, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0xE5, 0x72, 0x83,
+  0x22, 0x3B, 0x03, 0xB5, 0x9F, 0x62, 0x3C, 0x09, 0xF9, 0xC4, 0x2A, 0xE8,
+  0xE1, 0xDD, 0x83, 0x74, 0xC0, 0xD9, 0x28, 0x44, 0xDB, 0x61, 0x62, 0xCF,
+  0x50, 0xC9, 0xC6, 0x0B, 0xE9, 0x39, 0x2E, 0x1C, 0x10, 0x90, 0xD6, 0x1E,
+  0x83, 0xFB, 0x5F, 0x68, 0xEF, 0x45, 0x7B, 0xAA, 0x31, 0x66, 0x44, 0xAF,
+  0x76, 0xB8, 0x51, 0xF5, 0xF3, 0x9D, 0x85, 0x54, 0x15, 0x5E, 0x43, 0x85,
+  0x36,
+};
+
+//
+// For the OCSP checks: an ECDSA P-256 CA, a certificate it issued for
+// TLS_TEST_HOST_NAME, and a self-signed impostor with the CA's name. Each
+// comes with its key.
+//
+STATIC CONST UINT8  mOcspCaCert[] = {
+  0x30, 0x82, 0x01, 0x8B, 0x30, 0x82, 0x01, 0x31, 0xA0, 0x03, 0x02, 0x01,
+  0x02, 0x02, 0x14, 0x25, 0x81, 0x9F, 0xBB, 0xDF, 0x03, 0xD9, 0x38, 0x9A,
+  0x2F, 0x2B, 0x71, 0x25, 0x11, 0xF2, 0xC5, 0xE2, 0xC9, 0xEA, 0xD5, 0x30,
+  0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+  0x13, 0x31, 0x11, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x08,
+  0x62, 0x65, 0x6E, 0x63, 0x68, 0x20, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D,
+  0x32, 0x36, 0x31, 0x30, 0x31, 0x36, 0x32, 0x32, 0x31, 0x35, 0x34, 0x38,
+  0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30, 0x31, 0x33, 0x32, 0x32, 0x31,
+  0x35, 0x34, 0x38, 0x5A, 0x30, 0x13, 0x31, 0x11, 0x30, 0x0F, 0x06, 0x03,
+  0x55, 0x04, 0x03, 0x0C, 0x08, 0x62, 0x65, 0x6E, 0x63, 0x68, 0x20, 0x43,
+  0x41, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07,
+  0x03, 0x42, 0x00, 0x04, 0x74, 0x0F, 0x9F, 0x99, 0xC6, 0xE2, 0x1D, 0xB1,
+  0x64, 0x54, 0x8C, 0x7B, 0x38, 0x2B, 0x3E, 0x2C, 0xC2, 0x82, 0x0B, 0x63,
+  0xB7, 0x86, 0x39, 0x59, 0x9F, 0x80, 0x79, 0xC0, 0x9E, 0xD1, 0x26, 0x6D,
+  0x85, 0x6F, 0xB5, 0x0F, 0x70, 0xCE, 0xB7, 0x3D, 0x86, 0x9D, 0x60, 0xD6,
+  0x8B, 0x12, 0x43, 0xA8, 0x67, 0xEA, 0xA4, 0xA5, 0x7D, 0x7A, 0x11, 0x26,
+  0x86, 0x4E, 0x39, 0xCA, 0x7B, 0x17, 0x58, 0xCC, 0xA3, 0x63, 0x30, 0x61,
+  0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xF6,
+  0x30, 0xA3, 0xFF, 0xA2, 0x5B, 0xD9, 0x03, 0xF6, 0x61, 0x4A, 0xDF, 0xBB,
+  0x60, 0x5F, 0x76, 0x06, 0xF0, 0xDA, 0x2C, 0x30, 0x1F, 0x06, 0x03, 0x55,
+  0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0xF6, 0x30, 0xA3, 0xFF,
+  0xA2, 0x5B, 0xD9, 0x03, 0xF6, 0x61, 0x4A, 0xDF, 0xBB, 0x60, 0x5F, 0x76,
+  0x06, 0xF0, 0xDA, 0x2C, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01,
+  0x01, 0xFF, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0E, 0x06,
+  0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x01,
+  0x06, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03,
+  0x02, 0x03, 0x48, 0x00, 0x30, 0x45, 0x02, 0x20, 0x76, 0x3C, 0x1C, 0x0C,
+  0x5A, 0x21, 0xCC, 0x8A, 0x2E, 0x44, 0xDC, 0xDE, 0xA4, 0x24, 0x40, 0x28,
+  0xB2, 0x5C, 0x44, 0x9E, 0xA3, 0x33, 0x6F, 0x2F, 0xDA, 0x0B, 0x9E, 0x53,
+  0x9E, 0x2B, 0x90, 0x59, 0x02, 0x21, 0x00, 0xB6, 0x4F, 0xD7, 0xCA, 0xFF,
+  0x59, 0x2C, 0x9C, 0xBB, 0xD0, 0xCD, 0x10, 0x79, 0x10, 0x62, 0x5C, 0x77,
+  0x06, 0x85, 0x11, 0x7B, 0xA0, 0x62, 0x3B, 0xF3, 0x95, 0x74, 0x9C, 0x5E,
+  0x51, 0xE2, 0x23,
+};
+
+STATIC CONST UINT8  mOcspCaKey[] = {
+  0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0x88, 0x04, 0x90, 0xDA, 0x31,
+  0x9C, 0xAD, 0x55, 0x34, 0xC7, 0x4E, 0xA2, 0xEE, 0x29, 0x18, 0xE1, 0x3F,
+  0xBA, 0x0D, 0x82, 0x21, 0x62, 0x7F, 0xAC, 0xD6, 0xF9, 0x0D, 0xE1, 0x3E,
+  0x7D, 0xFB, 0x66, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x74, 0x0F, 0x9F,
+  0x99, 0xC6, 0xE2, 0x1D, 0xB1, 0x64, 0x54, 0x8C, 0x7B, 0x38, 0x2B, 0x3E,
+  0x2C, 0xC2, 0x82, 0x0B, 0x63, 0xB7, 0x86, 0x39, 0x59, 0x9F, 0x80, 0x79,
+  0xC0, 0x9E, 0xD1, 0x26, 0x6D, 0x85, 0x6F, 0xB5, 0x0F, 0x70, 0xCE, 0xB7,
+  0x3D, 0x86, 0x9D, 0x60, 0xD6, 0x8B, 0x12, 0x43, 0xA8, 0x67, 0xEA, 0xA4,
+  0xA5, 0x7D, 0x7A, 0x11, 0x26, 0x86, 0x4E, 0x39, 0xCA, 0x7B, 0x17, 0x58,
+  0xCC,
+};
+
+STATIC CONST UINT8  mOcspServerCert[] = {
+  0x30, 0x82, 0x01, 0xBA, 0x30, 0x82, 0x01, 0x61, 0xA0, 0x03, 0x02, 0x01,
+  0x02, 0x02, 0x14, 0x27, 0x61, 0x35, 0xA8, 0x7A, 0x5A, 0x95, 0x64, 0x80,
+  0x6A, 0x4E, 0x8D, 0x35, 0xE9, 0xEB, 0x29, 0xE4, 0x1C, 0x00, 0xF8, 0x30,
+  0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+  0x13, 0x31, 0x11, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x08,
+  0x62, 0x65, 0x6E, 0x63, 0x68, 0x20, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D,
+  0x32, 0x36, 0x31, 0x30, 0x31, 0x36, 0x32, 0x32, 0x31, 0x35, 0x34, 0x38,
+  0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30, 0x31, 0x33, 0x32, 0x32, 0x31,
+  0x35, 0x34, 0x38, 0x5A, 0x30, 0x18, 0x31, 0x16, 0x30, 0x14, 0x06, 0x03,
+  0x55, 0x04, 0x03, 0x0C, 0x0D, 0x62, 0x65, 0x6E, 0x63, 0x68, 0x2E, 0x65,
+  0x78, 0x61, 0x6D, 0x70, 0x6C, 0x65, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07,
+  0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48,
+  0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x3C, 0x3D, 0x4B,
+  0xEF, 0x58, 0xDC, 0xB4, 0xF6, 0xB2, 0x29, 0x32, 0xDC, 0x7D, 0x24, 0x77,
+  0x5B, 0x2C, 0x1D, 0x09, 0xC0, 0x10, 0x42, 0x48, 0x0E, 0x04, 0x43, 0x30,
+  0x4F, 0xE9, 0x43, 0x4A, 0x1A, 0xB9, 0x74, 0xE4, 0xD3, 0xA0, 0xE1, 0xB6,
+  0x61, 0xBA, 0x51, 0xF6, 0x61, 0x5D, 0xF3, 0x85, 0x9A, 0x18, 0x58, 0xB8,
+  0x34, 0x8A, 0x3D, 0xFD, 0x05, 0x89, 0xAF, 0xC7, 0x8E, 0x1A, 0x91, 0xFD,
+  0x37, 0xA3, 0x81, 0x8D, 0x30, 0x81, 0x8A, 0x30, 0x09, 0x06, 0x03, 0x55,
+  0x1D, 0x13, 0x04, 0x02, 0x30, 0x00, 0x30, 0x18, 0x06, 0x03, 0x55, 0x1D,
+  0x11, 0x04, 0x11, 0x30, 0x0F, 0x82, 0x0D, 0x62, 0x65, 0x6E, 0x63, 0x68,
+  0x2E, 0x65, 0x78, 0x61, 0x6D, 0x70, 0x6C, 0x65, 0x30, 0x0E, 0x06, 0x03,
+  0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x07, 0x80,
+  0x30, 0x13, 0x06, 0x03, 0x55, 0x1D, 0x25, 0x04, 0x0C, 0x30, 0x0A, 0x06,
+  0x08, 0x2B, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x01, 0x30, 0x1D, 0x06,
+  0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xD3, 0x7A, 0x79, 0x72,
+  0x15, 0x32, 0x56, 0xFE, 0xE6, 0xCD, 0xD8, 0x0C, 0xB2, 0x08, 0xE5, 0xD9,
+  0x02, 0xAE, 0xC2, 0x2C, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23, 0x04,
+  0x18, 0x30, 0x16, 0x80, 0x14, 0xF6, 0x30, 0xA3, 0xFF, 0xA2, 0x5B, 0xD9,
+  0x03, 0xF6, 0x61, 0x4A, 0xDF, 0xBB, 0x60, 0x5F, 0x76, 0x06, 0xF0, 0xDA,
+  0x2C, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03,
+  0x02, 0x03, 0x47, 0x00, 0x30, 0x44, 0x02, 0x20, 0x1A, 0x44, 0x80, 0x8E,
+  0x2B, 0xEC, 0x88, 0x72, 0x25, 0x15, 0x71, 0x6E, 0x09, 0x21, 0xA9, 0x0D,
+  0x7A, 0x1B, 0x62, 0x26, 0xDC, 0x30, 0x61, 0x68, 0xA0, 0xF0, 0x50, 0xE3,
+  0xFB, 0xE3, 0xD7, 0x0F, 0x02, 0x20, 0x68, 0x5E, 0x14, 0x32, 0x43, 0x95,
+  0x8F, 0xFA, 0xFB, 0xB5, 0xFC, 0x42, 0xBB, 0xB3, 0x31, 0x78, 0xAF, 0x52,
+  0x8B, 0x24, 0x1B, 0x2A, 0x36, 0x9A, 0xEB, 0xEB, 0x4E, 0x87, 0x59, 0x96,
+  0xA1, 0x50,
+};
+
+STATIC CONST UINT8  mOcspServerKey[] = {
+  0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0x58, 0xCD, 0x89, 0x68, 0xE1,
+  0x3C, 0x67, 0x2A, 0x76, 0x74, 0xCD, 0x12, 0x12, 0x15, 0xFB, 0x14, 0x61,
+  0xC7, 0x65, 0x9A, 0x41, 0x09, 0x3E, 0x4C, 0x2D, 0xD4, 0xCD, 0x15, 0x4C,
+  0x22, 0x94, 0xC6, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x3C, 0x3D, 0x4B,
+  0xEF, 0x58, 0xDC, 0xB4, 0xF6, 0xB2, 0x29, 0x32, 0xDC, 0x7D, 0x24, 0x77,
+  0x5B, 0x2C, 0x1D, 0x09, 0xC0, 0x10, 0x42, 0x48, 0x0E, 0x04, 0x43, 0x30,
+  0x4F, 0xE9, 0x43, 0x4A, 0x1A, 0xB9, 0x74, 0xE4, 0xD3, 0xA0, 0xE1, 0xB6,
+  0x61, 0xBA, 0x51, 0xF6, 0x61, 0x5D, 0xF3, 0x85, 0x9A, 0x18, 0x58, 0xB8,
+  0x34, 0x8A, 0x3D, 0xFD, 0x05, 0x89, 0xAF, 0xC7, 0x8E, 0x1A, 0x91, 0xFD,
+  0x37,
+};
+
+STATIC CONST UINT8  mOcspRogueCert[] = {
+  0x30, 0x82, 0x01, 0x7A, 0x30, 0x82, 0x01, 0x21, 0xA0, 0x03, 0x02, 0x01,
+  0x02, 0x02, 0x14, 0x2E, 0xB3, 0x23, 0x7E, 0xE3, 0xD8, 0xE8, 0x85, 0x68,
+  0xAB, 0x43, 0xBA, 0x99, 0xA2, 0x82, 0xD3, 0x25, 0x05, 0x0C, 0xEB, 0x30,
+  0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+  0x13, 0x31, 0x11, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x08,
+  0x62, 0x65, 0x6E, 0x63, 0x68, 0x20, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D,
+  0x32, 0x36, 0x31, 0x30, 0x31, 0x36, 0x32, 0x32, 0x31, 0x35, 0x34, 0x38,
+  0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30, 0x31, 0x33, 0x32, 0x32, 0x31,
+  0x35, 0x34, 0x38, 0x5A, 0x30, 0x13, 0x31, 0x11, 0x30, 0x0F, 0x06, 0x03,
+  0x55, 0x04, 0x03, 0x0C, 0x08, 0x62, 0x65, 0x6E, 0x63, 0x68, 0x20, 0x43,
+  0x41, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07,
+  0x03, 0x42, 0x00, 0x04, 0x23, 0xB7, 0x3A, 0xD0, 0xE0, 0x58, 0x58, 0xFE,
+  0xDA, 0xFE, 0xAC, 0x42, 0xEA, 0xDD, 0x01, 0x53, 0xD8, 0x2D, 0xA1, 0x9B,
+  0x2F, 0xA8, 0xE9, 0x5D, 0xB7, 0x42, 0xE3, 0x40, 0xF7, 0xA3, 0xEE, 0xAF,
+  0x04, 0x83, 0x47, 0xF6, 0x26, 0x87, 0x1C, 0xA8, 0x46, 0xDD, 0xEB, 0x41,
+  0xA4, 0x3A, 0x44, 0x35, 0x25, 0x20, 0x88, 0x8F, 0xA2, 0xD9, 0x1F, 0x68,
+  0x56, 0xA6, 0xE7, 0x86, 0x7B, 0xEC, 0x6E, 0x02, 0xA3, 0x53, 0x30, 0x51,
+  0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xE0,
+  0x04, 0x2E, 0x9F, 0xC3, 0x12, 0x3F, 0xD0, 0x6B, 0xD1, 0xEE, 0x6A, 0xE4,
+  0x95, 0x90, 0x72, 0x17, 0xE6, 0xC1, 0xD2, 0x30, 0x1F, 0x06, 0x03, 0x55,
+  0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0xE0, 0x04, 0x2E, 0x9F,
+  0xC3, 0x12, 0x3F, 0xD0, 0x6B, 0xD1, 0xEE, 0x6A, 0xE4, 0x95, 0x90, 0x72,
+  0x17, 0xE6, 0xC1, 0xD2, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01,
+  0x01, 0xFF, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0A, 0x06,
+  0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x47, 0x00,
+  0x30, 0x44, 0x02, 0x20, 0x0F, 0xA2, 0x55, 0xF2, 0x56, 0x37, 0xEF, 0x06,
+  0x2D, 0xCB, 0xD6, 0xE7, 0xD5, 0x93, 0x71, 0xD1, 0x0C, 0xB6, 0x9B, 0x79,
+  0x0D, 0xD9, 0x6A, 0x45, 0xD5, 0xF0, 0x77, 0x33, 0xAF, 0xE0, 0xE7, 0x29,
+  0x02, 0x20, 0x2A, 0x07, 0xC3, 0x05, 0xB0, 0x62, 0xCE, 0xE8, 0xD4, 0xC7,
+  0x87, 0x22, 0x7C, 0x60, 0xC5, 0xB7, 0xBA, 0x00, 0x02, 0x4E, 0xA4, 0xEA,
+  0xF9, 0x63, 0x76, 0xF3, 0x64, 0x2C, 0xEB, 0xE4, 0x44, 0xC9,
+};
+
+STATIC CONST UINT8  mOcspRogueKey[] = {
+  0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0x5A, 0x0F, 0x98, 0xA0, 0x54,
+  0x69, 0xE2, 0x71, 0xC7, 0x68, 0xF8, 0x97, 0x74, 0xCD, 0x25, 0xAF, 0x68,
+  0x7B, 0x88, 0x7C, 0x6A, 0x47, 0x2A, 0xDE, 0x67, 0xB5, 0x26, 0xE7, 0xE6,
+  0x09, 0x0F, 0x25, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+  0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x23, 0xB7, 0x3A,
+  0xD0, 0xE0, 0x58, 0x58, 0xFE, 0xDA, 0xFE, 0xAC, 0x42, 0xEA, 0xDD, 0x01,
+  0x53, 0xD8, 0x2D, 0xA1, 0x9B, 0x2F, 0xA8, 0xE9, 0x5D, 0xB7, 0x42, 0xE3,
+  0x40, 0xF7, 0xA3, 0xEE, 0xAF, 0x04, 0x83, 0x47, 0xF6, 0x26, 0x87, 0x1C,
+  0xA8, 0x46, 0xDD, 0xEB, 0x41, 0xA4, 0x3A, 0x44, 0x35, 0x25, 0x20, 0x88,
+  0x8F, 0xA2, 0xD9, 0x1F, 0x68, 0x56, 0xA6, 0xE7, 0x86, 0x7B, 0xEC, 0x6E,
+  0x02,
+};
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT8        MinorVersion;
+  UINT16       CipherId;
+} TLS_TEST_SUITE;
+
+STATIC CONST TLS_TEST_SUITE  mSuites[] = {
+  { "TLS1.2 ECDHE-ECDSA-AES128-GCM-SHA256", 3, 0xC02B },
+  { "TLS1.3 TLS_AES_128_GCM_SHA256",        4, 0x1301 },
+};
+
+class TlsLibTest : public ::testing::Test {
+protected:
+  TLS_TEST_OPAQUE *ServerCtx;
+  TLS_TEST_OPAQUE *Server;
+  TLS_TEST_OPAQUE *ServerIn;
+  TLS_TEST_OPAQUE *ServerOut;
+  VOID *Client;
+  CONST UINT8 *TrustedCert;
+  UINTN TrustedCertSize;
+  std::vector<UINT8> Records;
+  std::vector<UINT8> Data;
+
+  void
+  SetUp (
+    ) override
+  {
+    ASSERT_TRUE (TlsInitialize ());
+
+    ServerCtx = SSL_CTX_new (TLS_server_method ());
+    ASSERT_NE (ServerCtx, nullptr);
+    SSL_CTX_ctrl (ServerCtx, TLS_TEST_CTRL_SET_MIN_PROTO_VERSION, 0x0303, NULL);
+    SSL_CTX_ctrl (ServerCtx, TLS_TEST_CTRL_SET_MAX_PROTO_VERSION, 0x0304, NULL);
+    ASSERT_EQ (SSL_CTX_use_certificate_ASN1 (ServerCtx, sizeof (mServerCert), mServerCert), 1);
+    ASSERT_EQ (SSL_CTX_use_PrivateKey_ASN1 (TLS_TEST_PKEY_EC, ServerCtx, mServerKey, sizeof (mServerKey)), 1);
+
+    Server          = NULL;
+    Client          = NULL;
+    TrustedCert     = mServerCert;
+    TrustedCertSize = sizeof (mServerCert);
+    Records.resize (TLS_TEST_RECORD_BUFFER);
+    Data.resize (TLS_TEST_RECORD_BUFFER);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    Disconnect ();
+    SSL_CTX_free (ServerCtx);
+  }
+
+  //
+  // Create a client connection on TlsCtx and a fresh server connection.
+  //
+  void
+  Connect (
+    VOID                  *TlsCtx,
+    CONST TLS_TEST_SUITE  *Suite
+    )
+  {
+    UINT16  CipherId;
+
+    Server    = SSL_new (ServerCtx);
+    ServerIn  = BIO_new (BIO_s_mem ());
+    ServerOut = BIO_new (BIO_s_mem ());
+    SSL_set_bio (Server, ServerIn, ServerOut);
+    SSL_set_accept_state (Server);
+
+    CipherId = Suite->CipherId;
+    Client   = TlsNew (TlsCtx);
+    ASSERT_NE (Client, nullptr);
+    TlsSetConnectionEnd (Client, FALSE);
+    TlsSetCipherList (Client, &CipherId, 1);
+    TlsSetVerify (Client, EFI_TLS_VERIFY_PEER);
+    TlsSetCaCertificate (Client, (VOID *)TrustedCert, TrustedCertSize);
+    TlsSetVerifyHost (Client, 0, (CHAR8 *)TLS_TEST_HOST_NAME);
+  }
+
+  //
+  // Free both ends without a shutdown.
+  //
+  void
+  Disconnect (
+    )
+  {
+    if (Client != NULL) {
+      TlsFree (Client);
+      Client = NULL;
+    }
+
+    if (Server != NULL) {
+      SSL_set_quiet_shutdown (Server, 1);
+      SSL_shutdown (Server);
+      SSL_free (Server);
+      Server = NULL;
+    }
+  }
+
+  //
+  // Move the pending server records to the client memory BIO.
+  //
+  VOID
+  ServerToClient (
+    VOID
+    )
+  {
+    int  Length;
+
+    while ((Length = BIO_read (ServerOut, Records.data (), (int)Records.size ())) > 0) {
+      TlsCtrlTrafficIn (Client, Records.data (), (UINTN)Length);
+    }
+  }
+
+  //
+  // Pass the post-handshake messages (TLS 1.3 session tickets) to the client,
+  // followed by a close_notify from the server if Close is set.
+  //
+  VOID
+  ReadFromServer (
+    BOOLEAN  Close
+    )
+  {
+    if (Close) {
+      SSL_shutdown (Server);
+    }
+
+    ServerToClient ();
+    TlsRead (Client, Data.data (), Data.size ());
+  }
+
+  BOOLEAN
+  Handshake (
+    VOID
+    )
+  {
+    EFI_STATUS  Status;
+    UINTN       Size;
+    int         Length;
+
+    Size   = Records.size ();
+    Status = TlsDoHandshake (Client, NULL, 0, Records.data (), &Size);
+    for (UINTN Round = 0; !EFI_ERROR (Status) && Round < 16; Round++) {
+      if (Size > 0) {
+        BIO_write (ServerIn, Records.data (), (int)Size);
+      }
+
+      SSL_do_handshake (Server);
+      Length = BIO_read (ServerOut, Records.data (), (int)Records.size ());
+      if (Length <= 0) {
+        return (BOOLEAN)(!TlsInHandshake (Client) && SSL_is_init_finished (Server));
+      }
+
+      Size   = Records.size ();
+      Status = TlsDoHandshake (Client, Records.data (), (UINTN)Length, Records.data (), &Size);
+    }
+
+    return FALSE;
+  }
+
+  //
+  // Run Check once per entry of mSuites, each on a new TLS context.
+  //
+  template<typename Fn>
+  void
+  ForEachSuite (
+    Fn  Check
+    )
+  {
+    for (CONST TLS_TEST_SUITE &Suite : mSuites) {
+      VOID  *TlsCtx = TlsCtxNew (3, Suite.MinorVersion);
+
+      ASSERT_NE (TlsCtx, nullptr);
+      SCOPED_TRACE (Suite.Name);
+      Check (TlsCtx, &Suite);
+      Disconnect ();
+      TlsCtxFree (TlsCtx);
+    }
+  }
+};
+
+TEST_F (TlsLibTest, WriteDirectReturnsQueuedRecords) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    static CONST CHAR8  Queued[] = "queued by TlsWrite";
+    static CONST CHAR8  Direct[] = "sealed by TlsWriteDirect";
+    std::vector<UINT8>  Sent;
+    EFI_STATUS          Status;
+    UINTN               BufferSize;
+    UINTN               RecordSize;
+    int                 Length;
+
+    Connect (TlsCtx, Suite);
+    ASSERT_TRUE (Handshake ());
+
+    //
+    // A record left in the connection's memory BIO comes out first, even
+    // through a window too small for a new record. Those calls succeed and
+    // consume no data.
+    //
+    ASSERT_EQ (TlsWrite (Client, (VOID *)Queued, sizeof (Queued)), (INTN)sizeof (Queued));
+    do {
+      BufferSize = sizeof (Direct);
+      RecordSize = 16;
+      Status     = TlsWriteDirect (Client, (CONST UINT8 *)Direct, &BufferSize, Records.data (), &RecordSize);
+      if (Status == EFI_SUCCESS) {
+        ASSERT_GT (RecordSize, 0u);
+        EXPECT_EQ (BufferSize, 0u);
+        Sent.insert (Sent.end (), Records.data (), Records.data () + RecordSize);
+      }
+    } while (Status == EFI_SUCCESS);
+
+    //
+    // Once it is out, the window is too small and nothing is done.
+    //
+    EXPECT_EQ (Status, EFI_BUFFER_TOO_SMALL);
+    EXPECT_EQ (RecordSize, 0u);
+    EXPECT_EQ (BufferSize, 0u);
+
+    BIO_write (ServerIn, Sent.data (), (int)Sent.size ());
+    Length = SSL_read (Server, Data.data (), (int)Data.size ());
+    ASSERT_EQ (Length, (int)sizeof (Queued));
+    EXPECT_EQ (memcmp (Data.data (), Queued, sizeof (Queued)), 0);
+
+    BufferSize = sizeof (Direct);
+    RecordSize = Records.size ();
+    ASSERT_EQ (TlsWriteDirect (Client, (CONST UINT8 *)Direct, &BufferSize, Records.data (), &RecordSize), EFI_SUCCESS);
+    EXPECT_EQ (BufferSize, sizeof (Direct));
+    BIO_write (ServerIn, Records.data (), (int)RecordSize);
+    Length = SSL_read (Server, Data.data (), (int)Data.size ());
+    ASSERT_EQ (Length, (int)sizeof (Direct));
+    EXPECT_EQ (memcmp (Data.data (), Direct, sizeof (Direct)), 0);
+  }
+    );
+}
+
+//
+// DER of the OCSP response the server staples; none if empty.
+//
+STATIC std::vector<UINT8>  mStapledResponse;
+
+STATIC int
+StapleCallback (
+  TLS_TEST_OPAQUE  *Ssl,
+  void             *Arg
+  )
+{
+  void  *Der;
+
+  if (mStapledResponse.empty ()) {
+    return TLS_TEST_EXT_NOACK;
+  }
+
+  //
+  // OpenSSL takes ownership of the response.
+  //
+  Der = CRYPTO_malloc (mStapledResponse.size (), __FILE__, __LINE__);
+  if (Der == NULL) {
+    return TLS_TEST_EXT_NOACK;
+  }
+
+  memcpy (Der, mStapledResponse.data (), mStapledResponse.size ());
+  SSL_ctrl (Ssl, TLS_TEST_CTRL_SET_STATUS_OCSP_RESP, (long)mStapledResponse.size (), Der);
+  return TLS_TEST_EXT_OK;
+}
+
+//
+// OCSP stapling checks. The server presents a certificate issued by the
+// trusted CA and staples the response set in mStapledResponse.
+//
+class TlsOcspTest : public TlsLibTest {
+protected:
+  TLS_TEST_OPAQUE *Ca;
+  TLS_TEST_OPAQUE *CaKey;
+  TLS_TEST_OPAQUE *Rogue;
+  TLS_TEST_OPAQUE *RogueKey;
+  TLS_TEST_OPAQUE *Leaf;
+
+  void
+  SetUp (
+    ) override
+  {
+    const unsigned char  *Ptr;
+
+    TlsLibTest::SetUp ();
+    ASSERT_EQ (SSL_CTX_use_certificate_ASN1 (ServerCtx, sizeof (mOcspServerCert), mOcspServerCert), 1);
+    ASSERT_EQ (SSL_CTX_use_PrivateKey_ASN1 (TLS_TEST_PKEY_EC, ServerCtx, mOcspServerKey, sizeof (mOcspServerKey)), 1);
+    SSL_CTX_callback_ctrl (ServerCtx, TLS_TEST_CTRL_SET_STATUS_CB, (void (*)(void))StapleCallback);
+    TrustedCert     = mOcspCaCert;
+    TrustedCertSize = sizeof (mOcspCaCert);
+    mStapledResponse.clear ();
+
+    Ptr      = mOcspCaCert;
+    Ca       = d2i_X509 (NULL, &Ptr, sizeof (mOcspCaCert));
+    Ptr      = mOcspCaKey;
+    CaKey    = d2i_AutoPrivateKey (NULL, &Ptr, sizeof (mOcspCaKey));
+    Ptr      = mOcspRogueCert;
+    Rogue    = d2i_X509 (NULL, &Ptr, sizeof (mOcspRogueCert));
+    Ptr      = mOcspRogueKey;
+    RogueKey = d2i_AutoPrivateKey (NULL, &Ptr, sizeof (mOcspRogueKey));
+    Ptr      = mOcspServerCert;
+    Leaf     = d2i_X509 (NULL, &Ptr, sizeof (mOcspServerCert));
+    ASSERT_TRUE (Ca != NULL && CaKey != NULL && Rogue != NULL && RogueKey != NULL && Leaf != NULL);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    mStapledResponse.clear ();
+    X509_free (Ca);
+    EVP_PKEY_free (CaKey);
+    X509_free (Rogue);
+    EVP_PKEY_free (RogueKey);
+    X509_free (Leaf);
+    TlsLibTest::TearDown ();
+  }
+
+  //
+  // Build an OCSP response for the server certificate, valid from ThisUpdate
+  // to NextUpdate seconds from now, and signed by the CA or by the impostor.
+  //
+  std::vector<UINT8>
+  MakeResponse (
+    int      Status,
+    long     ThisUpdate,
+    long     NextUpdate,
+    BOOLEAN  Forged
+    )
+  {
+    std::vector<UINT8>  Result;
+    TLS_TEST_OPAQUE     *CertId;
+    TLS_TEST_OPAQUE     *Basic;
+    TLS_TEST_OPAQUE     *Response;
+    TLS_TEST_OPAQUE     *Times[3];
+    unsigned char       *Der;
+    int                 DerSize;
+
+    CertId   = OCSP_cert_to_id (NULL, Leaf, Ca);
+    Basic    = OCSP_BASICRESP_new ();
+    Times[0] = X509_gmtime_adj (NULL, -86400);
+    Times[1] = X509_gmtime_adj (NULL, ThisUpdate);
+    Times[2] = X509_gmtime_adj (NULL, NextUpdate);
+    Response = NULL;
+    Der      = NULL;
+    DerSize  = 0;
+    if ((OCSP_basic_add1_status (
+           Basic,
+           CertId,
+           Status,
+           TLS_TEST_OCSP_UNSPECIFIED,
+           (Status == TLS_TEST_OCSP_REVOKED) ? Times[0] : NULL,
+           Times[1],
+           Times[2]
+           ) != NULL) &&
+        (OCSP_basic_sign (Basic, Forged ? Rogue : Ca, Forged ? RogueKey : CaKey, EVP_sha256 (), NULL, 0) == 1))
+    {
+      Response = OCSP_response_create (TLS_TEST_OCSP_SUCCESSFUL, Basic);
+      DerSize  = (Response != NULL) ? i2d_OCSP_RESPONSE (Response, &Der) : 0;
+    }
+
+    if (DerSize > 0) {
+      Result.assign (Der, Der + DerSize);
+    }
+
+    CRYPTO_free (Der, __FILE__, __LINE__);
+    OCSP_RESPONSE_free (Response);
+    for (TLS_TEST_OPAQUE *Time : Times) {
+      ASN1_TIME_free (Time);
+    }
+
+    OCSP_BASICRESP_free (Basic);
+    OCSP_CERTID_free (CertId);
+    EXPECT_FALSE (Result.empty ());
+    return Result;
+  }
+
+  //
+  // Run one handshake on TlsCtx with OCSP stapling enabled on the client.
+  //
+  BOOLEAN
+  OcspHandshake (
+    VOID                  *TlsCtx,
+    CONST TLS_TEST_SUITE  *Suite,
+    BOOLEAN               Required
+    )
+  {
+    BOOLEAN  Result;
+
+    Connect (TlsCtx, Suite);
+    Result = (BOOLEAN)((Client != NULL) &&
+                       (TlsSetOcspStapling (Client, Required) == EFI_SUCCESS) &&
+                       Handshake ());
+    Disconnect ();
+    return Result;
+  }
+};
+
+TEST_F (TlsOcspTest, Good) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_GOOD, -60, 3600, FALSE);
+    EXPECT_TRUE (OcspHandshake (TlsCtx, Suite, TRUE));
+  }
+    );
+}
+
+TEST_F (TlsOcspTest, Revoked) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_REVOKED, -60, 3600, FALSE);
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, FALSE));
+  }
+    );
+}
+
+TEST_F (TlsOcspTest, Forged) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_GOOD, -60, 3600, TRUE);
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, FALSE));
+  }
+    );
+}
+
+TEST_F (TlsOcspTest, Expired) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    //
+    // A response that is no longer current gives no status: the handshake
+    // fails only when a status is required.
+    //
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_GOOD, -2 * 86400, -86400, FALSE);
+    EXPECT_TRUE (OcspHandshake (TlsCtx, Suite, FALSE));
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, TRUE));
+  }
+    );
+}
+
+TEST_F (TlsOcspTest, Cache) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    //
+    // Without a staple, a required status comes from the response verified
+    // by the previous connection of the context.
+    //
+    mStapledResponse.clear ();
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, TRUE));
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_GOOD, -60, 3600, FALSE);
+    EXPECT_TRUE (OcspHandshake (TlsCtx, Suite, TRUE));
+    mStapledResponse.clear ();
+    EXPECT_TRUE (OcspHandshake (TlsCtx, Suite, TRUE));
+
+    //
+    // Disabling the cache drops it.
+    //
+    EXPECT_EQ (TlsCtxSetOcspCacheSize (TlsCtx, 0), EFI_SUCCESS);
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, TRUE));
+    mStapledResponse = MakeResponse (TLS_TEST_OCSP_GOOD, -60, 3600, FALSE);
+    EXPECT_TRUE (OcspHandshake (TlsCtx, Suite, TRUE));
+    mStapledResponse.clear ();
+    EXPECT_FALSE (OcspHandshake (TlsCtx, Suite, TRUE));
+  }
+    );
+}
+
+TEST_F (TlsLibTest, SessionCachedOnlyAfterCloseNotify) {
+  ForEachSuite (
+    [&](VOID *TlsCtx, CONST TLS_TEST_SUITE *Suite) {
+    //
+    // A connection shut down without the server's close_notify, as after a
+    // truncation, leaves nothing to resume.
+    //
+    Connect (TlsCtx, Suite);
+    ASSERT_TRUE (Handshake ());
+    ReadFromServer (FALSE);
+    EXPECT_EQ (TlsShutdown (Client), EFI_SUCCESS);
+    Disconnect ();
+
+    Connect (TlsCtx, Suite);
+    ASSERT_TRUE (Handshake ());
+    EXPECT_EQ (SSL_session_reused (Server), 0);
+
+    //
+    // One shut down after it is resumed by the next connection.
+    //
+    ReadFromServer (TRUE);
+    EXPECT_EQ (TlsShutdown (Client), EFI_SUCCESS);
+    Disconnect ();
+
+    Connect (TlsCtx, Suite);
+    ASSERT_TRUE (Handshake ());
+    EXPECT_EQ (SSL_session_reused (Server), 1);
+  }
+    );
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}